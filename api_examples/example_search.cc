@@ -9,6 +9,10 @@
  * Part 2: Self-validating strand test. Verifies that opt_strand = true finds
  * reverse-complement hits, and opt_strand = false does not.
  *
+ * Part 4: Self-validating test of queries without unmasked k-mers (fully
+ * soft-masked, or shorter than the word length): they must still get
+ * candidates.
+ *
  * Build:  g++ -std=c++11 -O3 -I../src -o example_search example_search.cc ../src/libvsearch.a -lpthread -ldl
  * Run:    ./example_search
  * Verify: diff <(sort output.tsv) <(sort data/expected_search.tsv)
@@ -16,6 +20,7 @@
 
 #include "vsearch_api.h"
 
+#include <cctype>
 #include <cstdio>
 #include <cstring>
 #include <string>
@@ -348,6 +353,97 @@ static int run_strand_tests()
 }
 
 
+/* --- Part 4: Self-validating queries without unmasked k-mers --- */
+/* A query whose k-mers are all masked, or that is shorter than the word
+   length, requires no k-mer match: every database sequence is then a
+   candidate, and the query must still find the sequence it was cut from. */
+static int search_without_kmers(const char * label,
+                                const std::string & query,
+                                Masking qmask)
+{
+  struct Parameters parameters;
+  parameters.opt_wordlength = 8;
+  parameters.opt_id = 0.5;
+  parameters.opt_qmask = qmask;
+  parameters.opt_maxaccepts = 1;
+  parameters.opt_maxrejects = 32;
+  vsearch_session_begin(parameters);
+
+  std::vector<std::string> ref_labels, ref_seqs;
+  read_fasta("data/chimera_ref.fasta", ref_labels, ref_seqs);
+
+  Database db;
+  db.init();
+  for (size_t i = 0; i < ref_labels.size(); i++)
+    {
+      db.add(false, ref_labels[i].c_str(), ref_seqs[i].c_str(),
+             nullptr, ref_labels[i].size(), ref_seqs[i].size(), 1);
+    }
+  dust_all(db, parameters);
+  Dbindex dbindex;
+  dbindex.prepare(1, parameters.opt_dbmask, db, parameters);
+  dbindex.add_all_sequences(parameters.opt_dbmask, db, parameters);
+
+  struct search_session_s * ss = search_session_alloc();
+  search_session_init(ss, parameters, dbindex, db);
+
+  struct search_result_s results[4];
+  int count = 0;
+
+  search_session_single(ss,
+                        query.c_str(),
+                        label,
+                        static_cast<int>(query.size()),
+                        1,
+                        results,
+                        1,
+                        &count);
+
+  int failures = 0;
+  if ((count == 0) || !results[0].accepted)
+    {
+      std::fprintf(stderr, "FAIL: %s query found no candidate\n", label);
+      ++failures;
+    }
+  else
+    {
+      std::fprintf(stderr, "PASS: %s query matched %s\n",
+                   label, db.getheader(results[0].target));
+    }
+
+  search_session_cleanup(ss);
+  search_session_free(ss);
+  dbindex.clear();
+  db.clear();
+  vsearch_session_end();
+
+  return failures;
+}
+
+
+static int run_no_kmer_tests()
+{
+  std::vector<std::string> ref_labels, ref_seqs;
+  read_fasta("data/chimera_ref.fasta", ref_labels, ref_seqs);
+  if (ref_seqs.empty())
+    {
+      std::fprintf(stderr, "FAIL: data/chimera_ref.fasta not found\n");
+      return 1;
+    }
+
+  std::string masked = ref_seqs[0].substr(0, 200);
+  for (auto & symbol : masked)
+    {
+      symbol = static_cast<char>(std::tolower(symbol));
+    }
+
+  int failures = 0;
+  failures += search_without_kmers("soft-masked", masked, Masking::soft);
+  failures += search_without_kmers("short", ref_seqs[0].substr(20, 6), Masking::none);
+  return failures;
+}
+
+
 int main() {
     int rc = run_search_tsv();
     if (rc != 0)
@@ -358,5 +454,6 @@ int main() {
     int failures = 0;
     failures += run_batch_tests();
     failures += run_strand_tests();
+    failures += run_no_kmer_tests();
     return failures == 0 ? 0 : 1;
 }
@@ -0,0 +1,132 @@
+/*
+
+  VSEARCH: a versatile open source tool for metagenomics
+
+  Copyright (C) 2014-2026, Torbjorn Rognes, Frederic Mahe and Tomas Flouri
+  All rights reserved.
+
+  Contact: Torbjorn Rognes <torognes@ifi.uio.no>,
+  Department of Informatics, University of Oslo,
+  PO Box 1080 Blindern, NO-0316 Oslo, Norway
+
+  This software is dual-licensed and available under a choice
+  of one of two licenses, either under the terms of the GNU
+  General Public License version 3 or the BSD 2-Clause License.
+
+
+  GNU General Public License version 3
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+  The BSD 2-Clause License
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "arch/scan_symbols.hpp"
+#include "vsearch.h"
+#include <cstddef>  // std::size_t
+#include <cstdint>  // uint8_t
+
+
+// aarch64 backend: NEON intrinsics (arm_neon.h, via vsearch.h). Single
+// plain-named variant (no runtime dispatch off x86).
+
+// anonymous namespace: limit visibility and usage to this translation unit
+namespace {
+
+  constexpr std::size_t block_size = sizeof(uint8x16_t);
+
+
+  // 0xff for the bytes in the unsigned range [low, high]
+  auto in_range(uint8x16_t const bytes, uint8_t const low, uint8_t const high) -> uint8x16_t {
+    return vcleq_u8(vsubq_u8(bytes, vdupq_n_u8(low)),
+                    vdupq_n_u8(static_cast<uint8_t>(high - low)));
+  }
+
+
+  auto nucleotide_mask(uint8x16_t const bytes) -> uint8x16_t {
+    // fold to lowercase: only letters can land in the ranges below
+    auto const folded = vorrq_u8(bytes, vdupq_n_u8(0x20));
+    auto const abcd = in_range(folded, 'a', 'd');
+    auto const gh = in_range(folded, 'g', 'h');
+    auto const k = vceqq_u8(folded, vdupq_n_u8('k'));
+    auto const mn = in_range(folded, 'm', 'n');
+    auto const rstuvw = in_range(folded, 'r', 'w');
+    auto const y = vceqq_u8(folded, vdupq_n_u8('y'));
+    return vorrq_u8(vorrq_u8(vorrq_u8(abcd, gh), vorrq_u8(k, mn)),
+                    vorrq_u8(rstuvw, y));
+  }
+
+
+  auto quality_mask(uint8x16_t const bytes) -> uint8x16_t {
+    return in_range(bytes, '!', '~');
+  }
+
+
+  template <uint8x16_t (*mask)(uint8x16_t), bool (*is_valid)(char)>
+  auto count_symbols(char const * symbols, std::size_t const length) -> std::size_t {
+    static constexpr uint8_t all_valid = 0xff;
+    auto position = std::size_t{0};
+    while (position + block_size <= length)
+      {
+        auto const bytes = vld1q_u8(reinterpret_cast<uint8_t const *>(symbols + position));
+        if (vminvq_u8(mask(bytes)) != all_valid)
+          {
+            break;  // the scalar loop below finds the first invalid symbol
+          }
+        position += block_size;
+      }
+    while ((position < length) and is_valid(symbols[position]))
+      {
+        ++position;
+      }
+    return position;
+  }
+
+}  // end of anonymous namespace
+
+
+auto count_nucleotide_symbols(char const * symbols, std::size_t const length) -> std::size_t {
+  return count_symbols<nucleotide_mask, is_nucleotide_symbol>(symbols, length);
+}
+
+
+auto count_quality_symbols(char const * symbols, std::size_t const length) -> std::size_t {
+  return count_symbols<quality_mask, is_quality_symbol>(symbols, length);
+}
@@ -0,0 +1,138 @@
+/*
+
+  VSEARCH: a versatile open source tool for metagenomics
+
+  Copyright (C) 2014-2026, Torbjorn Rognes, Frederic Mahe and Tomas Flouri
+  All rights reserved.
+
+  Contact: Torbjorn Rognes <torognes@ifi.uio.no>,
+  Department of Informatics, University of Oslo,
+  PO Box 1080 Blindern, NO-0316 Oslo, Norway
+
+  This software is dual-licensed and available under a choice
+  of one of two licenses, either under the terms of the GNU
+  General Public License version 3 or the BSD 2-Clause License.
+
+
+  GNU General Public License version 3
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+  The BSD 2-Clause License
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "arch/scan_symbols.hpp"
+#include "vsearch.h"
+#include <cstddef>  // std::size_t
+#include <cstring>  // std::memcpy
+
+
+// ppc64le backend: AltiVec/VSX intrinsics (altivec.h, via vsearch.h). Single
+// plain-named variant (no runtime dispatch off x86).
+
+// anonymous namespace: limit visibility and usage to this translation unit
+namespace {
+
+  using bytes_t = __vector unsigned char;
+  using mask_t = __vector __bool char;
+
+  constexpr std::size_t block_size = sizeof(bytes_t);
+
+
+  // true for the bytes in the unsigned range [low, high]:
+  // low <= x <= high  <=>  min(x - low, high - low) == x - low
+  auto in_range(bytes_t const bytes, unsigned char const low, unsigned char const high) -> mask_t {
+    auto const shifted = vec_sub(bytes, vec_splats(low));
+    auto const span = vec_splats(static_cast<unsigned char>(high - low));
+    return vec_cmpeq(vec_min(shifted, span), shifted);
+  }
+
+
+  auto nucleotide_mask(bytes_t const bytes) -> mask_t {
+    // fold to lowercase: only letters can land in the ranges below
+    auto const folded = vec_or(bytes, vec_splats(static_cast<unsigned char>(0x20)));
+    auto const abcd = in_range(folded, 'a', 'd');
+    auto const gh = in_range(folded, 'g', 'h');
+    auto const k = in_range(folded, 'k', 'k');
+    auto const mn = in_range(folded, 'm', 'n');
+    auto const rstuvw = in_range(folded, 'r', 'w');
+    auto const y = in_range(folded, 'y', 'y');
+    return vec_or(vec_or(vec_or(abcd, gh), vec_or(k, mn)), vec_or(rstuvw, y));
+  }
+
+
+  auto quality_mask(bytes_t const bytes) -> mask_t {
+    return in_range(bytes, '!', '~');
+  }
+
+
+  template <mask_t (*mask)(bytes_t), bool (*is_valid)(char)>
+  auto count_symbols(char const * symbols, std::size_t const length) -> std::size_t {
+    bytes_t const zero = vec_splats(static_cast<unsigned char>(0));
+    mask_t const all_valid = vec_cmpeq(zero, zero);
+    auto position = std::size_t{0};
+    while (position + block_size <= length)
+      {
+        bytes_t bytes;
+        std::memcpy(&bytes, symbols + position, block_size);
+        if (not vec_all_eq(mask(bytes), all_valid))
+          {
+            break;  // the scalar loop below finds the first invalid symbol
+          }
+        position += block_size;
+      }
+    while ((position < length) and is_valid(symbols[position]))
+      {
+        ++position;
+      }
+    return position;
+  }
+
+}  // end of anonymous namespace
+
+
+auto count_nucleotide_symbols(char const * symbols, std::size_t const length) -> std::size_t {
+  return count_symbols<nucleotide_mask, is_nucleotide_symbol>(symbols, length);
+}
+
+
+auto count_quality_symbols(char const * symbols, std::size_t const length) -> std::size_t {
+  return count_symbols<quality_mask, is_quality_symbol>(symbols, length);
+}
@@ -0,0 +1,103 @@
+/*
+
+  VSEARCH: a versatile open source tool for metagenomics
+
+  Copyright (C) 2014-2026, Torbjorn Rognes, Frederic Mahe and Tomas Flouri
+  All rights reserved.
+
+  Contact: Torbjorn Rognes <torognes@ifi.uio.no>,
+  Department of Informatics, University of Oslo,
+  PO Box 1080 Blindern, NO-0316 Oslo, Norway
+
+  This software is dual-licensed and available under a choice
+  of one of two licenses, either under the terms of the GNU
+  General Public License version 3 or the BSD 2-Clause License.
+
+
+  GNU General Public License version 3
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+  The BSD 2-Clause License
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#pragma once
+
+#include <cstddef>  // std::size_t
+
+
+/* Symbol scanners for the FASTA/FASTQ parsers: return the length of the
+   longest prefix of the range [symbols, symbols + length) made only of
+     count_nucleotide_symbols  IUPAC nucleotide symbols, either case
+                               (ABCDGHKMNRSTUVWY, abcdghkmnrstuvwy)
+     count_quality_symbols     printable quality symbols ('!' to '~')
+   that is, the symbols the parsers accept without further checks. The
+   parsers copy such a run in one step and apply the per-character rules
+   (warnings, stripping, errors, line counting) only to the symbol that
+   ends it. The SIMD implementation checks 16 symbols at a time and lives
+   in one backend per ISA under arch/, as for increment_counters:
+     arch/x86_64/SSE2/    - SSE2 intrinsics
+     arch/aarch64/        - NEON
+     arch/ppc64le/        - AltiVec
+     arch/simde/          - SSE2 intrinsics via SIMDE (portable fallback)
+   SSE2 is part of the x86_64 baseline, so every target builds a single
+   plain-named variant (no runtime dispatch). */
+
+auto count_nucleotide_symbols(char const * symbols, std::size_t length) -> std::size_t;
+
+auto count_quality_symbols(char const * symbols, std::size_t length) -> std::size_t;
+
+
+// scalar versions of the tests, for the tails shorter than a SIMD block
+inline auto is_nucleotide_symbol(char const symbol) -> bool {
+  switch (symbol | 0x20)  // fold to lowercase
+    {
+    case 'a': case 'b': case 'c': case 'd': case 'g': case 'h':
+    case 'k': case 'm': case 'n': case 'r': case 's': case 't':
+    case 'u': case 'v': case 'w': case 'y':
+      return true;
+    default:
+      return false;
+    }
+}
+
+inline auto is_quality_symbol(char const symbol) -> bool {
+  return (symbol >= '!') and (symbol <= '~');
+}
@@ -0,0 +1,118 @@
+/*
+
+  VSEARCH: a versatile open source tool for metagenomics
+
+  Copyright (C) 2014-2026, Torbjorn Rognes, Frederic Mahe and Tomas Flouri
+  All rights reserved.
+
+  Contact: Torbjorn Rognes <torognes@ifi.uio.no>,
+  Department of Informatics, University of Oslo,
+  PO Box 1080 Blindern, NO-0316 Oslo, Norway
+
+  This software is dual-licensed and available under a choice
+  of one of two licenses, either under the terms of the GNU
+  General Public License version 3 or the BSD 2-Clause License.
+
+
+  GNU General Public License version 3
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+  The BSD 2-Clause License
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#pragma once
+
+/* search16: the 16-bit global aligner of core/align_simd.cpp processes
+   several target sequences side by side, one per 16-bit vector lane. The
+   128-bit variant (8 channels) is built for every architecture as part of
+   core/align_simd.cpp. On x86_64 two wider variants are built from the
+   same kernel (core/align_simd_internal.hpp), each in its own single-ISA
+   backend:
+     arch/x86_64/AVX2/     - AVX2 intrinsics      -> 16 channels
+     arch/x86_64/AVX512/   - AVX-512BW intrinsics -> 32 channels
+   search16_init() is told the channel count chosen by
+   search16_select_channels() from cpu_features_detect(), and search16()
+   forwards to the matching variant. The same backends also instantiate
+   the kernel with 8-bit cells and no traceback, twice as many channels,
+   for the score bounds of search16_bounds(). */
+
+struct s16info_s;
+struct Database;
+
+
+#ifdef __x86_64__
+constexpr auto avx2_channels = 16;
+constexpr auto avx512_channels = 32;
+constexpr auto avx2_bounds_channels = 2 * avx2_channels;
+constexpr auto avx512_bounds_channels = 2 * avx512_channels;
+
+auto search16_avx2(s16info_s * searchinfo,
+                   unsigned int sequences,
+                   unsigned int const * seqnos,
+                   signed short * pscores,
+                   unsigned short * paligned,
+                   unsigned short * pmatches,
+                   unsigned short * pmismatches,
+                   unsigned short * pgaps,
+                   char * * pcigar,
+                   struct Database const & db) -> void;
+auto search16_avx512(s16info_s * searchinfo,
+                     unsigned int sequences,
+                     unsigned int const * seqnos,
+                     signed short * pscores,
+                     unsigned short * paligned,
+                     unsigned short * pmatches,
+                     unsigned short * pmismatches,
+                     unsigned short * pgaps,
+                     char * * pcigar,
+                     struct Database const & db) -> void;
+
+auto search16_bounds_avx2(s16info_s * searchinfo,
+                          unsigned int sequences,
+                          unsigned int const * seqnos,
+                          signed short * pbounds,
+                          struct Database const & db) -> void;
+auto search16_bounds_avx512(s16info_s * searchinfo,
+                            unsigned int sequences,
+                            unsigned int const * seqnos,
+                            signed short * pbounds,
+                            struct Database const & db) -> void;
+#endif
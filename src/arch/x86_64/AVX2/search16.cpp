@@ -0,0 +1,239 @@
+/*
+
+  VSEARCH: a versatile open source tool for metagenomics
+
+  Copyright (C) 2014-2026, Torbjorn Rognes, Frederic Mahe and Tomas Flouri
+  All rights reserved.
+
+  Contact: Torbjorn Rognes <torognes@ifi.uio.no>,
+  Department of Informatics, University of Oslo,
+  PO Box 1080 Blindern, NO-0316 Oslo, Norway
+
+  This software is dual-licensed and available under a choice
+  of one of two licenses, either under the terms of the GNU
+  General Public License version 3 or the BSD 2-Clause License.
+
+
+  GNU General Public License version 3
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+  The BSD 2-Clause License
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "arch/search16.hpp"
+#include "core/align_simd_internal.hpp"
+#include <immintrin.h>  // AVX2 intrinsics
+#include <array>
+#include <cstdint>  // uint32_t
+
+
+// AVX2 backend of search16: native x86_64, compiled with -mavx2. The
+// 256-bit vectors hold 16 alignments. Runtime-selected on CPUs with AVX2
+// support (see search16_select_channels).
+
+// anonymous namespace: limit visibility and usage to this translation unit
+namespace {
+
+  struct Simd_avx2 {
+    using cell = CELL;
+    using vector = __m256i;
+    using mask = uint32_t;
+    static constexpr int channels = avx2_channels;
+    static constexpr unsigned int mask_bits = 2;
+
+    static auto v_add(vector lhs, vector rhs) -> vector { return _mm256_adds_epi16(lhs, rhs); }
+    static auto v_sub(vector lhs, vector rhs) -> vector { return _mm256_subs_epi16(lhs, rhs); }
+    static auto v_sub_unsigned(vector lhs, vector rhs) -> vector { return _mm256_subs_epu16(lhs, rhs); }
+    static auto v_max(vector lhs, vector rhs) -> vector { return _mm256_max_epi16(lhs, rhs); }
+    static auto v_min(vector lhs, vector rhs) -> vector { return _mm256_min_epi16(lhs, rhs); }
+    static auto v_and(vector lhs, vector rhs) -> vector { return _mm256_and_si256(lhs, rhs); }
+    static auto v_xor(vector lhs, vector rhs) -> vector { return _mm256_xor_si256(lhs, rhs); }
+    static auto v_dup(short value) -> vector { return _mm256_set1_epi16(value); }
+    static auto v_zero() -> vector { return _mm256_setzero_si256(); }
+
+    /* shift by one cell across the two 128-bit lanes: the low lane takes
+       zeroes, the high lane the top cell of the low lane */
+    static auto v_shift_left(vector operand) -> vector {
+      return _mm256_alignr_epi8(operand, _mm256_permute2x128_si256(operand, operand, 0x08), 14);
+    }
+
+    static auto v_mask_gt(vector lhs, vector rhs) -> mask {
+      return static_cast<mask>(_mm256_movemask_epi8(_mm256_cmpgt_epi16(lhs, rhs)));
+    }
+
+    /* Same 8 x 8 transpose as dprofile_fill16, done in both 128-bit lanes
+       at once: the low lane handles channels 0-7, the high lane channels
+       8-15. */
+    static auto dprofile_fill(CELL * dprofile, CELL const * matrix, BYTE const * dseq) -> void {
+      for (int j = 0; j < CDEPTH; j++)
+        {
+          std::array<int, channels> d {{}};
+          for (int z = 0; z < channels; z++)
+            {
+              d[static_cast<size_t>(z)] = dseq[(j * channels) + z] << 4U;
+            }
+
+          for (int i = 0; i < matrix_size; i += 8)
+            {
+              std::array<vector, 8> rows;
+              for (size_t c = 0; c < 8; c++)
+                {
+                  auto const * low = reinterpret_cast<__m128i const *>(matrix + d[c] + i);
+                  auto const * high = reinterpret_cast<__m128i const *>(matrix + d[c + 8] + i);
+                  rows[c] = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_load_si128(low)),
+                                                    _mm_load_si128(high), 1);
+                }
+
+              std::array<vector, 8> m16;
+              for (size_t c = 0; c < 8; c += 2)
+                {
+                  m16[c] = _mm256_unpacklo_epi16(rows[c], rows[c + 1]);
+                  m16[c + 1] = _mm256_unpackhi_epi16(rows[c], rows[c + 1]);
+                }
+
+              std::array<vector, 8> const m32 = {{
+                  _mm256_unpacklo_epi32(m16[0], m16[2]),
+                  _mm256_unpackhi_epi32(m16[0], m16[2]),
+                  _mm256_unpacklo_epi32(m16[4], m16[6]),
+                  _mm256_unpackhi_epi32(m16[4], m16[6]),
+                  _mm256_unpacklo_epi32(m16[1], m16[3]),
+                  _mm256_unpackhi_epi32(m16[1], m16[3]),
+                  _mm256_unpacklo_epi32(m16[5], m16[7]),
+                  _mm256_unpackhi_epi32(m16[5], m16[7]) }};
+
+              std::array<vector, 8> const columns = {{
+                  _mm256_unpacklo_epi64(m32[0], m32[2]),
+                  _mm256_unpackhi_epi64(m32[0], m32[2]),
+                  _mm256_unpacklo_epi64(m32[1], m32[3]),
+                  _mm256_unpackhi_epi64(m32[1], m32[3]),
+                  _mm256_unpacklo_epi64(m32[4], m32[6]),
+                  _mm256_unpackhi_epi64(m32[4], m32[6]),
+                  _mm256_unpacklo_epi64(m32[5], m32[7]),
+                  _mm256_unpackhi_epi64(m32[5], m32[7]) }};
+
+              for (int k = 0; k < 8; k++)
+                {
+                  _mm256_store_si256(reinterpret_cast<vector *>(dprofile + (CDEPTH * channels * (i + k)) + (channels * j)),
+                                     columns[static_cast<size_t>(k)]);
+                }
+            }
+        }
+    }
+  };
+
+
+  /* The same kernel on 8-bit cells, 32 channels, for the score bounds
+     (no traceback, so v_mask_gt is never called) */
+  struct Simd_avx2_byte {
+    using cell = signed char;
+    using vector = __m256i;
+    using mask = uint32_t;
+    static constexpr int channels = avx2_bounds_channels;
+    static constexpr unsigned int mask_bits = 1;
+
+    static auto v_add(vector lhs, vector rhs) -> vector { return _mm256_adds_epi8(lhs, rhs); }
+    static auto v_sub(vector lhs, vector rhs) -> vector { return _mm256_subs_epi8(lhs, rhs); }
+    static auto v_sub_unsigned(vector lhs, vector rhs) -> vector { return _mm256_subs_epu8(lhs, rhs); }
+    static auto v_max(vector lhs, vector rhs) -> vector { return _mm256_max_epi8(lhs, rhs); }
+    static auto v_min(vector lhs, vector rhs) -> vector { return _mm256_min_epi8(lhs, rhs); }
+    static auto v_and(vector lhs, vector rhs) -> vector { return _mm256_and_si256(lhs, rhs); }
+    static auto v_xor(vector lhs, vector rhs) -> vector { return _mm256_xor_si256(lhs, rhs); }
+    static auto v_dup(signed char value) -> vector { return _mm256_set1_epi8(value); }
+    static auto v_zero() -> vector { return _mm256_setzero_si256(); }
+
+    static auto v_shift_left(vector operand) -> vector {
+      return _mm256_alignr_epi8(operand, _mm256_permute2x128_si256(operand, operand, 0x08), 15);
+    }
+
+    static auto v_mask_gt(vector lhs, vector rhs) -> mask {
+      return static_cast<mask>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(lhs, rhs)));
+    }
+
+    /* matrix is search16_init's transposed byte matrix: row k holds the
+       scores of query symbol k against the 16 target symbols, a shuffle
+       table indexed by the target symbols of each channel */
+    static auto dprofile_fill(cell * dprofile, cell const * matrix, BYTE const * dseq) -> void {
+      std::array<vector, CDEPTH> symbols;
+      for (size_t j = 0; j < CDEPTH; j++)
+        {
+          symbols[j] = _mm256_loadu_si256(reinterpret_cast<vector const *>(dseq + (channels * j)));
+        }
+
+      for (int k = 0; k < matrix_size; k++)
+        {
+          auto const scores = _mm256_broadcastsi128_si256(
+            _mm_load_si128(reinterpret_cast<__m128i const *>(matrix + (matrix_size * k))));
+          for (int j = 0; j < CDEPTH; j++)
+            {
+              _mm256_store_si256(reinterpret_cast<vector *>(dprofile + (CDEPTH * channels * k) + (channels * j)),
+                                 _mm256_shuffle_epi8(scores, symbols[static_cast<size_t>(j)]));
+            }
+        }
+    }
+  };
+
+}  // end of anonymous namespace
+
+
+auto search16_avx2(s16info_s * s,
+                   unsigned int sequences,
+                   unsigned int const * seqnos,
+                   CELL * pscores,
+                   unsigned short * paligned,
+                   unsigned short * pmatches,
+                   unsigned short * pmismatches,
+                   unsigned short * pgaps,
+                   char ** pcigar,
+                   struct Database const & db) -> void
+{
+  search16_kernel<Simd_avx2>(s, sequences, seqnos, pscores, paligned, pmatches,
+                             pmismatches, pgaps, pcigar, db);
+}
+
+
+auto search16_bounds_avx2(s16info_s * s,
+                          unsigned int sequences,
+                          unsigned int const * seqnos,
+                          CELL * pbounds,
+                          struct Database const & db) -> void
+{
+  search16_bounds_kernel<Simd_avx2_byte>(s, sequences, seqnos, pbounds, db);
+}
@@ -0,0 +1,233 @@
+/*
+
+  VSEARCH: a versatile open source tool for metagenomics
+
+  Copyright (C) 2014-2026, Torbjorn Rognes, Frederic Mahe and Tomas Flouri
+  All rights reserved.
+
+  Contact: Torbjorn Rognes <torognes@ifi.uio.no>,
+  Department of Informatics, University of Oslo,
+  PO Box 1080 Blindern, NO-0316 Oslo, Norway
+
+  This software is dual-licensed and available under a choice
+  of one of two licenses, either under the terms of the GNU
+  General Public License version 3 or the BSD 2-Clause License.
+
+
+  GNU General Public License version 3
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+  The BSD 2-Clause License
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "arch/search16.hpp"
+#include "core/align_simd_internal.hpp"
+#include <immintrin.h>  // AVX-512BW intrinsics
+#include <array>
+#include <cstdint>  // uint32_t, uint64_t
+
+
+// AVX-512BW backend of search16: native x86_64, compiled with -mavx512bw.
+// The 512-bit vectors hold 32 alignments. Runtime-selected on CPUs (and
+// operating systems) with AVX-512BW support (see search16_select_channels).
+
+// anonymous namespace: limit visibility and usage to this translation unit
+namespace {
+
+  /* vpermw indices moving each cell one position up (cell 0 is zeroed) */
+  alignas(64) constexpr std::array<short, avx512_channels> shift_left_index =
+    {{ 0,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+      15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30 }};
+
+  struct Simd_avx512 {
+    using cell = CELL;
+    using vector = __m512i;
+    using mask = uint32_t;
+    static constexpr int channels = avx512_channels;
+    static constexpr unsigned int mask_bits = 1;
+
+    static auto v_add(vector lhs, vector rhs) -> vector { return _mm512_adds_epi16(lhs, rhs); }
+    static auto v_sub(vector lhs, vector rhs) -> vector { return _mm512_subs_epi16(lhs, rhs); }
+    static auto v_sub_unsigned(vector lhs, vector rhs) -> vector { return _mm512_subs_epu16(lhs, rhs); }
+    static auto v_max(vector lhs, vector rhs) -> vector { return _mm512_max_epi16(lhs, rhs); }
+    static auto v_min(vector lhs, vector rhs) -> vector { return _mm512_min_epi16(lhs, rhs); }
+    static auto v_and(vector lhs, vector rhs) -> vector { return _mm512_and_si512(lhs, rhs); }
+    static auto v_xor(vector lhs, vector rhs) -> vector { return _mm512_xor_si512(lhs, rhs); }
+    static auto v_dup(short value) -> vector { return _mm512_set1_epi16(value); }
+    static auto v_zero() -> vector { return _mm512_setzero_si512(); }
+
+    static auto v_shift_left(vector operand) -> vector {
+      auto const index = _mm512_load_si512(shift_left_index.data());
+      return _mm512_maskz_permutexvar_epi16(0xfffffffeU, index, operand);
+    }
+
+    /* one bit per channel: AVX-512 compares straight into a mask register */
+    static auto v_mask_gt(vector lhs, vector rhs) -> mask {
+      return _mm512_cmpgt_epi16_mask(lhs, rhs);
+    }
+
+    /* Transpose 8 x 8 blocks of the score matrix as dprofile_fill16, in
+       the four 128-bit lanes at once: lane l handles channels 8l to 8l+7. */
+    static auto dprofile_fill(CELL * dprofile, CELL const * matrix, BYTE const * dseq) -> void {
+      for (int j = 0; j < CDEPTH; j++)
+        {
+          std::array<int, channels> d {{}};
+          for (int z = 0; z < channels; z++)
+            {
+              d[static_cast<size_t>(z)] = dseq[(j * channels) + z] << 4U;
+            }
+
+          for (int i = 0; i < matrix_size; i += 8)
+            {
+              std::array<vector, 8> rows;
+              for (size_t c = 0; c < 8; c++)
+                {
+                  auto row = _mm512_castsi128_si512(
+                    _mm_load_si128(reinterpret_cast<__m128i const *>(matrix + d[c] + i)));
+                  row = _mm512_inserti32x4(row, _mm_load_si128(reinterpret_cast<__m128i const *>(matrix + d[c + 8] + i)), 1);
+                  row = _mm512_inserti32x4(row, _mm_load_si128(reinterpret_cast<__m128i const *>(matrix + d[c + 16] + i)), 2);
+                  row = _mm512_inserti32x4(row, _mm_load_si128(reinterpret_cast<__m128i const *>(matrix + d[c + 24] + i)), 3);
+                  rows[c] = row;
+                }
+
+              /* three rounds of 16-bit interleaving transpose the 8 x 8
+                 blocks (only AVX-512BW unpacks needed) */
+              for (int round = 0; round < 3; round++)
+                {
+                  std::array<vector, 8> interleaved;
+                  for (size_t c = 0; c < 4; c++)
+                    {
+                      interleaved[2 * c] = _mm512_unpacklo_epi16(rows[c], rows[c + 4]);
+                      interleaved[(2 * c) + 1] = _mm512_unpackhi_epi16(rows[c], rows[c + 4]);
+                    }
+                  rows = interleaved;
+                }
+
+              for (int k = 0; k < 8; k++)
+                {
+                  _mm512_store_si512(dprofile + (CDEPTH * channels * (i + k)) + (channels * j),
+                                     rows[static_cast<size_t>(k)]);
+                }
+            }
+        }
+    }
+  };
+
+
+  /* The same kernel on 8-bit cells, 64 channels, for the score bounds
+     (no traceback, so v_mask_gt is never called) */
+  struct Simd_avx512_byte {
+    using cell = signed char;
+    using vector = __m512i;
+    using mask = uint64_t;
+    static constexpr int channels = avx512_bounds_channels;
+    static constexpr unsigned int mask_bits = 1;
+
+    static auto v_add(vector lhs, vector rhs) -> vector { return _mm512_adds_epi8(lhs, rhs); }
+    static auto v_sub(vector lhs, vector rhs) -> vector { return _mm512_subs_epi8(lhs, rhs); }
+    static auto v_sub_unsigned(vector lhs, vector rhs) -> vector { return _mm512_subs_epu8(lhs, rhs); }
+    static auto v_max(vector lhs, vector rhs) -> vector { return _mm512_max_epi8(lhs, rhs); }
+    static auto v_min(vector lhs, vector rhs) -> vector { return _mm512_min_epi8(lhs, rhs); }
+    static auto v_and(vector lhs, vector rhs) -> vector { return _mm512_and_si512(lhs, rhs); }
+    static auto v_xor(vector lhs, vector rhs) -> vector { return _mm512_xor_si512(lhs, rhs); }
+    static auto v_dup(signed char value) -> vector { return _mm512_set1_epi8(value); }
+    static auto v_zero() -> vector { return _mm512_setzero_si512(); }
+
+    /* without vpermb (AVX-512VBMI): rotate the vector up one 128-bit lane
+       (zeroing the lowest), then take the top byte of the lane below into
+       each lane. The zero-masking forms avoid the undefined pass-through
+       operand of the unmasked intrinsics (a GCC 12 warning). */
+    static auto v_shift_left(vector operand) -> vector {
+      return _mm512_alignr_epi8(operand, _mm512_maskz_alignr_epi64(0xfc, operand, operand, 6), 15);
+    }
+
+    static auto v_mask_gt(vector lhs, vector rhs) -> mask {
+      return _mm512_cmpgt_epi8_mask(lhs, rhs);
+    }
+
+    /* see Simd_avx2_byte::dprofile_fill */
+    static auto dprofile_fill(cell * dprofile, cell const * matrix, BYTE const * dseq) -> void {
+      std::array<vector, CDEPTH> symbols;
+      for (size_t j = 0; j < CDEPTH; j++)
+        {
+          symbols[j] = _mm512_loadu_si512(dseq + (channels * j));
+        }
+
+      for (int k = 0; k < matrix_size; k++)
+        {
+          auto const scores = _mm512_maskz_broadcast_i32x4(0xffff,
+            _mm_load_si128(reinterpret_cast<__m128i const *>(matrix + (matrix_size * k))));
+          for (int j = 0; j < CDEPTH; j++)
+            {
+              _mm512_store_si512(dprofile + (CDEPTH * channels * k) + (channels * j),
+                                 _mm512_shuffle_epi8(scores, symbols[static_cast<size_t>(j)]));
+            }
+        }
+    }
+  };
+
+}  // end of anonymous namespace
+
+
+auto search16_avx512(s16info_s * s,
+                     unsigned int sequences,
+                     unsigned int const * seqnos,
+                     CELL * pscores,
+                     unsigned short * paligned,
+                     unsigned short * pmatches,
+                     unsigned short * pmismatches,
+                     unsigned short * pgaps,
+                     char ** pcigar,
+                     struct Database const & db) -> void
+{
+  search16_kernel<Simd_avx512>(s, sequences, seqnos, pscores, paligned, pmatches,
+                               pmismatches, pgaps, pcigar, db);
+}
+
+
+auto search16_bounds_avx512(s16info_s * s,
+                            unsigned int sequences,
+                            unsigned int const * seqnos,
+                            CELL * pbounds,
+                            struct Database const & db) -> void
+{
+  search16_bounds_kernel<Simd_avx512_byte>(s, sequences, seqnos, pbounds, db);
+}
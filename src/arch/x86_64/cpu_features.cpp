@@ -108,6 +108,8 @@ auto cpu_features_detect(struct Parameters & parameters) -> void
   static constexpr unsigned int extended_features_leaf = 7U;
   static constexpr unsigned int bit_osxsave = 0x08000000U;  // CPUID.1:ECX bit 27
   static constexpr unsigned int xcr0_avx_state = 0x6U;  // XMM | YMM
+  static constexpr unsigned int xcr0_avx512_state = 0xe6U;  // XMM | YMM | opmask | ZMM
+  static constexpr unsigned int bit_avx512bw = 0x40000000U;  // CPUID.7:EBX bit 30
 
   cpuid_registers const leaf0 = get_cpuid(0U);
   unsigned int const maxlevel = leaf0.eax & basic_leaf_mask;
@@ -140,6 +142,13 @@ auto cpu_features_detect(struct Parameters & parameters) -> void
           cpuid_registers const leaf7 = get_cpuid(extended_features_leaf);
           bool const avx2_supported = (leaf7.ebx & bit_AVX2) != 0U;
           parameters.avx2_present = static_cast<int64_t>(avx2_supported and avx_os_enabled);
+
+          // AVX-512 additionally needs the opmask and upper ZMM state
+          // (XCR0 bits 5-7) to be enabled by the OS.
+          bool const avx512_os_enabled =
+            osxsave_present and ((read_xcr0() & xcr0_avx512_state) == xcr0_avx512_state);
+          bool const avx512bw_supported = (leaf7.ebx & bit_avx512bw) != 0U;
+          parameters.avx512bw_present = static_cast<int64_t>(avx512bw_supported and avx512_os_enabled);
         }
     }
 }
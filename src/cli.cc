@@ -419,8 +419,8 @@ namespace {
 
 
   static constexpr auto number_of_commands = std::size_t{51};
-  static constexpr auto number_of_options = std::size_t{254};
-  static constexpr auto max_number_of_options_per_command = std::size_t{100};
+  static constexpr auto number_of_options = std::size_t{258};
+  static constexpr auto max_number_of_options_per_command = std::size_t{101};
 
   enum
     {
@@ -534,6 +534,7 @@ namespace {
       option_fulldp,
       option_gapext,
       option_gapopen,
+      option_gzip_compress,
       option_gzip_decompress,
       option_h,
       option_hardmask,
@@ -605,6 +606,7 @@ namespace {
       option_otutabout,
       option_output,
       option_output_no_hits,
+      option_pack_index,
       option_pattern,
       option_profile,
       option_qmask,
@@ -648,6 +650,7 @@ namespace {
       option_tabbedout,
       option_target_cov,
       option_threads,
+      option_threads_per_query,
       option_top_hits_only,
       option_topn,
       option_tsegout,
@@ -661,6 +664,7 @@ namespace {
       option_uchimeout,
       option_uchimeout5,
       option_udb2fasta,
+      option_udb_mmap,
       option_udbinfo,
       option_udbstats,
       option_unoise_alpha,
@@ -809,6 +813,7 @@ namespace {
       {"fulldp",                     false },
       {"gapext",                     true },
       {"gapopen",                    true },
+      {"gzip_compress",              false },
       {"gzip_decompress",            false },
       {"h",                          false },
       {"hardmask",                   false },
@@ -880,6 +885,7 @@ namespace {
       {"otutabout",                  true },
       {"output",                     true },
       {"output_no_hits",             false },
+      {"pack_index",                 false },
       {"pattern",                    true },
       {"profile",                    true },
       {"qmask",                      true },
@@ -923,6 +929,7 @@ namespace {
       {"tabbedout",                  true },
       {"target_cov",                 true },
       {"threads",                    true },
+      {"threads_per_query",          true },
       {"top_hits_only",              false },
       {"topn",                       true },
       {"tsegout",                    true },
@@ -936,6 +943,7 @@ namespace {
       {"uchimeout",                  true },
       {"uchimeout5",                 false },
       {"udb2fasta",                  true },
+      {"udb_mmap",                   false },
       {"udbinfo",                    true },
       {"udbstats",                   true },
       {"unoise_alpha",               true },
@@ -996,6 +1004,7 @@ namespace {
         option_fulldp,
         option_gapext,
         option_gapopen,
+        option_gzip_compress,
         option_gzip_decompress,
         option_hardmask,
         option_hspw,
@@ -1106,6 +1115,7 @@ namespace {
         option_sizeout,
         option_tabbedout,
         option_threads,
+        option_threads_per_query,
         option_xee,
         option_xlength,
         option_xn,
@@ -1130,6 +1140,7 @@ namespace {
         option_fulldp,
         option_gapext,
         option_gapopen,
+        option_gzip_compress,
         option_gzip_decompress,
         option_hardmask,
         option_hspw,
@@ -1229,6 +1240,7 @@ namespace {
         option_fulldp,
         option_gapext,
         option_gapopen,
+        option_gzip_compress,
         option_gzip_decompress,
         option_hardmask,
         option_hspw,
@@ -1328,6 +1340,7 @@ namespace {
         option_fulldp,
         option_gapext,
         option_gapopen,
+        option_gzip_compress,
         option_gzip_decompress,
         option_hardmask,
         option_hspw,
@@ -1428,6 +1441,7 @@ namespace {
         option_fulldp,
         option_gapext,
         option_gapopen,
+        option_gzip_compress,
         option_gzip_decompress,
         option_hardmask,
         option_hspw,
@@ -1519,6 +1533,7 @@ namespace {
         option_fastaout_discarded,
         option_fastaout_discarded_rev,
         option_fastaout_rev,
+        option_gzip_compress,
         option_gzip_decompress,
         option_label_suffix,
         option_lengthout,
@@ -1542,6 +1557,7 @@ namespace {
       { option_derep_fulllength,
         option_bzip2_decompress,
         option_fasta_width,
+        option_gzip_compress,
         option_gzip_decompress,
         option_lengthout,
         option_log,
@@ -1573,6 +1589,7 @@ namespace {
       { option_derep_id,
         option_bzip2_decompress,
         option_fasta_width,
+        option_gzip_compress,
         option_gzip_decompress,
         option_label_suffix,
         option_lengthout,
@@ -1605,6 +1622,7 @@ namespace {
       { option_derep_prefix,
         option_bzip2_decompress,
         option_fasta_width,
+        option_gzip_compress,
         option_gzip_decompress,
         option_label_suffix,
         option_lengthout,
@@ -1641,6 +1659,7 @@ namespace {
         option_fastq_ascii,
         option_fastq_qmax,
         option_fastq_qmin,
+        option_gzip_compress,
         option_gzip_decompress,
         option_label_suffix,
         option_lengthout,
@@ -1672,6 +1691,7 @@ namespace {
         option_fastq_asciiout,
         option_fastq_qmaxout,
         option_fastqout,
+        option_gzip_compress,
         option_gzip_decompress,
         option_label_suffix,
         option_lengthout,
@@ -1711,6 +1731,7 @@ namespace {
         option_fastq_qmin,
         option_fastq_qminout,
         option_fastqout,
+        option_gzip_compress,
         option_gzip_decompress,
         option_label_suffix,
         option_lengthout,
@@ -1788,6 +1809,7 @@ namespace {
         option_fastqout_discarded,
         option_fastqout_discarded_rev,
         option_fastqout_rev,
+        option_gzip_compress,
         option_gzip_decompress,
         option_label_suffix,
         option_lengthout,
@@ -1819,6 +1841,7 @@ namespace {
         option_fastq_qmax,
         option_fastq_qmin,
         option_fastqout,
+        option_gzip_compress,
         option_gzip_decompress,
         option_join_padgap,
         option_join_padgapq,
@@ -1870,6 +1893,7 @@ namespace {
         option_fastqout,
         option_fastqout_notmerged_fwd,
         option_fastqout_notmerged_rev,
+        option_gzip_compress,
         option_gzip_decompress,
         option_label_suffix,
         option_lengthout,
@@ -1932,6 +1956,7 @@ namespace {
         option_fastqout_discarded,
         option_fastqout_discarded_rev,
         option_fastqout_rev,
+        option_gzip_compress,
         option_gzip_decompress,
         option_label_suffix,
         option_lengthout,
@@ -1964,6 +1989,7 @@ namespace {
         option_fastq_qmax,
         option_fastq_qmin,
         option_fastqout,
+        option_gzip_compress,
         option_gzip_decompress,
         option_label,
         option_label_substr_match,
@@ -1997,6 +2023,7 @@ namespace {
         option_fastq_qmax,
         option_fastq_qmin,
         option_fastqout,
+        option_gzip_compress,
         option_gzip_decompress,
         option_label,
         option_label_field,
@@ -2034,6 +2061,7 @@ namespace {
         option_fastq_qmax,
         option_fastq_qmin,
         option_fastqout,
+        option_gzip_compress,
         option_gzip_decompress,
         option_label,
         option_label_substr_match,
@@ -2069,6 +2097,7 @@ namespace {
         option_fastq_qmax,
         option_fastq_qmin,
         option_fastqout,
+        option_gzip_compress,
         option_gzip_decompress,
         option_hardmask,
         option_label_suffix,
@@ -2102,6 +2131,7 @@ namespace {
         option_fastq_qmax,
         option_fastq_qmin,
         option_fastqout,
+        option_gzip_compress,
         option_gzip_decompress,
         option_label_suffix,
         option_lengthout,
@@ -2133,6 +2163,7 @@ namespace {
         option_fastq_qmin,
         option_fastqout,
         option_fastqout_discarded,
+        option_gzip_compress,
         option_gzip_decompress,
         option_label_suffix,
         option_lengthout,
@@ -2171,6 +2202,7 @@ namespace {
         option_fastqout_orphans,
         option_fastqout_orphans_rev,
         option_fastqout_rev,
+        option_gzip_compress,
         option_gzip_decompress,
         option_log,
         option_no_progress,
@@ -2192,6 +2224,7 @@ namespace {
         option_fastq_qminout,
         option_fastq_qout_max,
         option_fastqout,
+        option_gzip_compress,
         option_gzip_decompress,
         option_label_suffix,
         option_lengthout,
@@ -2244,8 +2277,10 @@ namespace {
         option_no_progress,
         option_notrunclabels,
         option_output,
+        option_pack_index,
         option_quiet,
         option_threads,
+        option_udb_mmap,
         option_wordlength,
         -1 },
 
@@ -2287,6 +2322,7 @@ namespace {
         option_fasta_width,
         option_fastaout,
         option_fastqout,
+        option_gzip_compress,
         option_gzip_decompress,
         option_hardmask,
         option_label_suffix,
@@ -2349,6 +2385,7 @@ namespace {
         option_dbnotmatched,
         option_fasta_width,
         option_fastapairs,
+        option_gzip_compress,
         option_gzip_decompress,
         option_hardmask,
         option_label_suffix,
@@ -2410,6 +2447,7 @@ namespace {
         option_fastq_qmaxout,
         option_fastq_qminout,
         option_fastqout,
+        option_gzip_compress,
         option_label_suffix,
         option_lengthout,
         option_log,
@@ -2472,6 +2510,7 @@ namespace {
         option_minseqlength,
         option_no_progress,
         option_notrunclabels,
+        option_pack_index,
         option_quiet,
         option_randseed,
         option_sintax_cutoff,
@@ -2581,6 +2620,7 @@ namespace {
         option_sizein,
         option_sizeout,
         option_threads,
+        option_threads_per_query,
         option_uchimealns,
         option_uchimeout,
         option_uchimeout5,
@@ -2625,6 +2665,7 @@ namespace {
         option_sizein,
         option_sizeout,
         option_threads,
+        option_threads_per_query,
         option_uchimealns,
         option_uchimeout,
         option_uchimeout5,
@@ -2669,6 +2710,7 @@ namespace {
         option_sizein,
         option_sizeout,
         option_threads,
+        option_threads_per_query,
         option_uchimealns,
         option_uchimeout,
         option_uchimeout5,
@@ -2718,6 +2760,7 @@ namespace {
         option_sizeout,
         option_strand,
         option_threads,
+        option_threads_per_query,
         option_uchimealns,
         option_uchimeout,
         option_uchimeout5,
@@ -2777,6 +2820,7 @@ namespace {
         option_fulldp,
         option_gapext,
         option_gapopen,
+        option_gzip_compress,
         option_gzip_decompress,
         option_hardmask,
         option_hspw,
@@ -2821,6 +2865,7 @@ namespace {
         option_notrunclabels,
         option_otutabout,
         option_output_no_hits,
+        option_pack_index,
         option_pattern,
         option_qmask,
         option_qsegout,
@@ -2969,6 +3014,10 @@ namespace {
             parameters.opt_threads = static_cast<int64_t>(args_getdouble(optarg));
             break;
 
+          case option_threads_per_query:
+            parameters.opt_threads_per_query = args_getlong(optarg);
+            break;
+
           case option_gapopen:
             args_get_gap_penalty_string(optarg, true, parameters);
             break;
@@ -3685,6 +3734,10 @@ namespace {
             std::fprintf(stderr, "WARNING: Option --hspw is ignored\n");
             break;
 
+          case option_gzip_compress:
+            parameters.opt_gzip_compress = true;
+            break;
+
           case option_gzip_decompress:
             parameters.opt_gzip_decompress = true;
             break;
@@ -3757,6 +3810,14 @@ namespace {
             parameters.opt_udbstats = optarg;
             break;
 
+          case option_udb_mmap:
+            parameters.opt_udb_mmap = true;
+            break;
+
+          case option_pack_index:
+            parameters.opt_pack_index = true;
+            break;
+
           case option_cluster_unoise:
             parameters.opt_cluster_unoise = optarg;
             break;
@@ -4121,8 +4182,9 @@ namespace {
       }
 
     if ((parameters.opt_allpairs_global != nullptr) or (parameters.opt_cluster_fast != nullptr) or (parameters.opt_cluster_size != nullptr) or
-        (parameters.opt_cluster_smallmem != nullptr) or (parameters.opt_cluster_unoise != nullptr) or (parameters.opt_fastq_mergepairs != nullptr) or
-        (parameters.opt_fastx_mask != nullptr) or (parameters.opt_maskfasta != nullptr) or (parameters.opt_search_exact != nullptr) or (parameters.opt_sintax != nullptr) or
+        (parameters.opt_cluster_smallmem != nullptr) or (parameters.opt_cluster_unoise != nullptr) or (parameters.opt_derep_fulllength != nullptr) or
+        (parameters.opt_derep_id != nullptr) or (parameters.opt_fastq_filter != nullptr) or (parameters.opt_fastq_mergepairs != nullptr) or (parameters.opt_fastx_filter != nullptr) or (parameters.opt_fastx_mask != nullptr) or (parameters.opt_fastx_uniques != nullptr) or (parameters.opt_makeudb_usearch != nullptr) or (parameters.opt_maskfasta != nullptr) or (parameters.opt_search_exact != nullptr) or (parameters.opt_sintax != nullptr) or
+        (parameters.opt_chimeras_denovo != nullptr) or (parameters.opt_uchime_denovo != nullptr) or (parameters.opt_uchime2_denovo != nullptr) or (parameters.opt_uchime3_denovo != nullptr) or
         (parameters.opt_uchime_ref != nullptr) or (parameters.opt_usearch_global != nullptr))
       {
         if (parameters.opt_threads == 0)
@@ -4410,6 +4472,12 @@ namespace {
         fatal("The argument to chimeras_parts must be in the range 2 to 100");
       }
 
+    if (options_selected[option_threads_per_query] and
+        ((parameters.opt_threads_per_query < 1) or (parameters.opt_threads_per_query > n_threads_max)))
+      {
+        fatal("The argument to --threads_per_query must be in the range 1 to 1024");
+      }
+
     /* --fasta_width accepts 0 to disable line wrapping (documented);
        reject only negative values. */
     if (parameters.opt_fasta_width < 0)
@@ -64,6 +64,7 @@
 #include "core/linmemalign.hpp"
 #include "core/mask.hpp"
 #include "utils/fatal.hpp"
+#include "core/block_compress.hpp"  // compress_output
 #include "utils/open_file.hpp"
 #include "utils/threads.hpp"
 #include "utils/worker_loop.hpp"
@@ -362,7 +363,8 @@ static auto allpairs_thread_run(struct allpairs_state_s & state, uint64_t t) ->
                         state.parameters.opt_gap_extension_target_interior,
                         state.parameters.opt_gap_extension_query_right,
                         state.parameters.opt_gap_extension_target_right,
-                        state.parameters.opt_n_mismatch);
+                        state.parameters.opt_n_mismatch,
+                        search16_select_channels(state.parameters));
 
 
   struct Scoring scoring = scoring_from_options(state.parameters);
@@ -612,17 +614,17 @@ auto allpairs_global(struct Parameters const & parameters) -> void
   fp_userout = userout_handle.get();
   OutputFileHandle blast6out_handle = open_optional_output_file(parameters.opt_blast6out, OutputOption{"--blast6out"});
   fp_blast6out = blast6out_handle.get();
-  OutputFileHandle uc_handle = open_optional_output_file(parameters.opt_uc, OutputOption{"--uc"});
+  OutputFileHandle uc_handle = compress_output(open_optional_output_file(parameters.opt_uc, OutputOption{"--uc"}), parameters);
   fp_uc = uc_handle.get();
-  OutputFileHandle fastapairs_handle = open_optional_output_file(parameters.opt_fastapairs, OutputOption{"--fastapairs"});
+  OutputFileHandle fastapairs_handle = compress_output(open_optional_output_file(parameters.opt_fastapairs, OutputOption{"--fastapairs"}), parameters);
   fp_fastapairs = fastapairs_handle.get();
-  OutputFileHandle qsegout_handle = open_optional_output_file(parameters.opt_qsegout, OutputOption{"--qsegout"});
+  OutputFileHandle qsegout_handle = compress_output(open_optional_output_file(parameters.opt_qsegout, OutputOption{"--qsegout"}), parameters);
   fp_qsegout = qsegout_handle.get();
-  OutputFileHandle tsegout_handle = open_optional_output_file(parameters.opt_tsegout, OutputOption{"--tsegout"});
+  OutputFileHandle tsegout_handle = compress_output(open_optional_output_file(parameters.opt_tsegout, OutputOption{"--tsegout"}), parameters);
   fp_tsegout = tsegout_handle.get();
-  OutputFileHandle matched_handle = open_optional_output_file(parameters.opt_matched, OutputOption{"--matched"});
+  OutputFileHandle matched_handle = compress_output(open_optional_output_file(parameters.opt_matched, OutputOption{"--matched"}), parameters);
   fp_matched = matched_handle.get();
-  OutputFileHandle notmatched_handle = open_optional_output_file(parameters.opt_notmatched, OutputOption{"--notmatched"});
+  OutputFileHandle notmatched_handle = compress_output(open_optional_output_file(parameters.opt_notmatched, OutputOption{"--notmatched"}), parameters);
   fp_notmatched = notmatched_handle.get();
 
   state.db.read(parameters.opt_allpairs_global, 0, parameters);
@@ -61,6 +61,7 @@
 #include "vsearch.h"
 #include "utils/fatal.hpp"
 #include "utils/maps.hpp"
+#include "core/block_compress.hpp"  // compress_output
 #include "utils/open_file.hpp"
 #include "utils/progress.hpp"
 #include "utils/reverse_complement.hpp"
@@ -304,10 +305,10 @@ namespace {
     fastaout.discarded.forward.name = parameters.opt_fastaout_discarded;
     fastaout.cut.reverse.name = parameters.opt_fastaout_rev;
     fastaout.discarded.reverse.name = parameters.opt_fastaout_discarded_rev;
-    fastaout.cut.forward.handle = open_optional_output_file(fastaout.cut.forward.name, OutputOption{"--fastaout"});
-    fastaout.discarded.forward.handle = open_optional_output_file(fastaout.discarded.forward.name, OutputOption{"--fastaout_discarded"});
-    fastaout.cut.reverse.handle = open_optional_output_file(fastaout.cut.reverse.name, OutputOption{"--fastaout_rev"});
-    fastaout.discarded.reverse.handle = open_optional_output_file(fastaout.discarded.reverse.name, OutputOption{"--fastaout_discarded_rev"});
+    fastaout.cut.forward.handle = compress_output(open_optional_output_file(fastaout.cut.forward.name, OutputOption{"--fastaout"}), parameters);
+    fastaout.discarded.forward.handle = compress_output(open_optional_output_file(fastaout.discarded.forward.name, OutputOption{"--fastaout_discarded"}), parameters);
+    fastaout.cut.reverse.handle = compress_output(open_optional_output_file(fastaout.cut.reverse.name, OutputOption{"--fastaout_rev"}), parameters);
+    fastaout.discarded.reverse.handle = compress_output(open_optional_output_file(fastaout.discarded.reverse.name, OutputOption{"--fastaout_discarded_rev"}), parameters);
     return fastaout;
   }
 
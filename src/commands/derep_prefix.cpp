@@ -61,6 +61,7 @@
 #include "vsearch.h"
 #include "utils/progress.hpp"
 #include "utils/fatal.hpp"
+#include "core/block_compress.hpp"  // compress_output
 #include "utils/open_file.hpp"
 #include "utils/seqcmp.hpp"
 #include "utils/span.hpp"
@@ -182,9 +183,9 @@ auto derep_prefix(struct Parameters const & parameters) -> void
       fatal("Option '--strand both' not supported with --derep_prefix");
     }
 
-  auto output_handle = open_optional_output_file(parameters.opt_output, OutputOption{"--output"});
+  auto output_handle = compress_output(open_optional_output_file(parameters.opt_output, OutputOption{"--output"}), parameters);
   std::FILE * const fp_output = output_handle.get();
-  auto uc_handle = open_optional_output_file(parameters.opt_uc, OutputOption{"--uc"});
+  auto uc_handle = compress_output(open_optional_output_file(parameters.opt_uc, OutputOption{"--uc"}), parameters);
   std::FILE * const fp_uc = uc_handle.get();
 
   Database db;
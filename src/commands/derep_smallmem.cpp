@@ -63,6 +63,7 @@
 #include "vendored/city.h"
 #include "utils/fatal.hpp"
 #include "utils/maps.hpp"
+#include "core/block_compress.hpp"  // compress_output
 #include "utils/open_file.hpp"
 // #include "util.h"  // hash_cityhash128
 #include "utils/cityhash.hpp"
@@ -243,7 +244,7 @@ auto derep_smallmem(struct Parameters const & parameters) -> void
       fatal("The derep_smallmem command does not support input from a pipe.");
     }
 
-  auto const output_handle = open_mandatory_output_file(parameters.opt_fastaout, OutputOption{"--fastaout"});
+  auto const output_handle = compress_output(open_mandatory_output_file(parameters.opt_fastaout, OutputOption{"--fastaout"}), parameters);
   std::FILE * const fp_fastaout = output_handle.get();
 
   auto const filesize = fastx_get_size(h);
@@ -61,6 +61,7 @@
 #include "vsearch.h"
 #include "utils/fatal.hpp"
 #include "utils/maps.hpp"
+#include "core/block_compress.hpp"  // compress_output
 #include "utils/open_file.hpp"
 #include "utils/progress.hpp"
 #include <cassert>
@@ -75,7 +76,7 @@ auto fasta2fastq(struct Parameters const & parameters) -> void
   auto * fp_input = fasta_open(parameters.opt_fasta2fastq, parameters);
   assert(fp_input != nullptr);  // check performed in fasta_open(fastx_open())
 
-  auto const output_handle = open_mandatory_output_file(parameters.opt_fastqout, OutputOption{"--fastqout"});
+  auto const output_handle = compress_output(open_mandatory_output_file(parameters.opt_fastqout, OutputOption{"--fastqout"}), parameters);
   assert(parameters.opt_fastqout != nullptr);  // check performed above
 
   static constexpr auto initial_length = 1024U;
@@ -63,6 +63,7 @@
 #include "utils/progress.hpp"
 #include "utils/fatal.hpp"
 #include "utils/maps.hpp"
+#include "core/block_compress.hpp"  // compress_output
 #include "utils/open_file.hpp"
 #include <algorithm>  // std::max, std::min
 #include <cinttypes>  // macros PRIu64 and PRId64
@@ -81,7 +82,7 @@ auto fastq_convert(struct Parameters const & parameters) -> void
 
   auto const filesize = fastq_get_size(input_handle);
 
-  auto fastqout_handle = open_optional_output_file(parameters.opt_fastqout, OutputOption{"--fastqout"});
+  auto fastqout_handle = compress_output(open_optional_output_file(parameters.opt_fastqout, OutputOption{"--fastqout"}), parameters);
   std::FILE * const fp_fastqout = fastqout_handle.get();
 
 
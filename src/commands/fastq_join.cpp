@@ -64,6 +64,7 @@
 #include "utils/progress.hpp"
 #include "utils/fatal.hpp"
 #include "utils/maps.hpp"
+#include "core/block_compress.hpp"  // compress_output
 #include "utils/open_file.hpp"
 #include <algorithm>  // std::transform
 #include <cinttypes>  // macros PRIu64 and PRId64
@@ -129,8 +130,8 @@ namespace {
     struct output_files outfiles;
     outfiles.fasta.name = parameters.opt_fastaout;
     outfiles.fastq.name = parameters.opt_fastqout;
-    outfiles.fasta.handle = open_optional_output_file(outfiles.fasta.name, OutputOption{"--fastaout"});
-    outfiles.fastq.handle = open_optional_output_file(outfiles.fastq.name, OutputOption{"--fastqout"});
+    outfiles.fasta.handle = compress_output(open_optional_output_file(outfiles.fasta.name, OutputOption{"--fastaout"}), parameters);
+    outfiles.fastq.handle = compress_output(open_optional_output_file(outfiles.fastq.name, OutputOption{"--fastqout"}), parameters);
     return outfiles;
   }
 
@@ -66,6 +66,7 @@
 #include "utils/fatal.hpp"
 #include "utils/kmer_hash_struct.hpp"
 #include "utils/maps.hpp"
+#include "core/block_compress.hpp"  // compress_output
 #include "utils/open_file.hpp"
 #include "utils/span.hpp"
 #include "utils/threads.hpp"
@@ -1018,17 +1019,17 @@ auto fastq_mergepairs(struct Parameters const & parameters) -> void
 
   /* open output files */
 
-  OutputFileHandle fastqout_handle = open_optional_output_file(parameters.opt_fastqout, OutputOption{"--fastqout"});
+  OutputFileHandle fastqout_handle = compress_output(open_optional_output_file(parameters.opt_fastqout, OutputOption{"--fastqout"}), parameters);
   fp_fastqout = fastqout_handle.get();
-  OutputFileHandle fastaout_handle = open_optional_output_file(parameters.opt_fastaout, OutputOption{"--fastaout"});
+  OutputFileHandle fastaout_handle = compress_output(open_optional_output_file(parameters.opt_fastaout, OutputOption{"--fastaout"}), parameters);
   fp_fastaout = fastaout_handle.get();
-  OutputFileHandle fastqout_notmerged_fwd_handle = open_optional_output_file(parameters.opt_fastqout_notmerged_fwd, OutputOption{"--fastqout_notmerged_fwd"});
+  OutputFileHandle fastqout_notmerged_fwd_handle = compress_output(open_optional_output_file(parameters.opt_fastqout_notmerged_fwd, OutputOption{"--fastqout_notmerged_fwd"}), parameters);
   fp_fastqout_notmerged_fwd = fastqout_notmerged_fwd_handle.get();
-  OutputFileHandle fastqout_notmerged_rev_handle = open_optional_output_file(parameters.opt_fastqout_notmerged_rev, OutputOption{"--fastqout_notmerged_rev"});
+  OutputFileHandle fastqout_notmerged_rev_handle = compress_output(open_optional_output_file(parameters.opt_fastqout_notmerged_rev, OutputOption{"--fastqout_notmerged_rev"}), parameters);
   fp_fastqout_notmerged_rev = fastqout_notmerged_rev_handle.get();
-  OutputFileHandle fastaout_notmerged_fwd_handle = open_optional_output_file(parameters.opt_fastaout_notmerged_fwd, OutputOption{"--fastaout_notmerged_fwd"});
+  OutputFileHandle fastaout_notmerged_fwd_handle = compress_output(open_optional_output_file(parameters.opt_fastaout_notmerged_fwd, OutputOption{"--fastaout_notmerged_fwd"}), parameters);
   fp_fastaout_notmerged_fwd = fastaout_notmerged_fwd_handle.get();
-  OutputFileHandle fastaout_notmerged_rev_handle = open_optional_output_file(parameters.opt_fastaout_notmerged_rev, OutputOption{"--fastaout_notmerged_rev"});
+  OutputFileHandle fastaout_notmerged_rev_handle = compress_output(open_optional_output_file(parameters.opt_fastaout_notmerged_rev, OutputOption{"--fastaout_notmerged_rev"}), parameters);
   fp_fastaout_notmerged_rev = fastaout_notmerged_rev_handle.get();
   OutputFileHandle eetabbedout_handle = open_optional_output_file(parameters.opt_eetabbedout, OutputOption{"--eetabbedout"});
   fp_eetabbedout = eetabbedout_handle.get();
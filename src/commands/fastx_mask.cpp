@@ -62,6 +62,7 @@
 #include "commands/fastx_mask.hpp"
 #include "core/mask.hpp"
 #include "utils/fatal.hpp"
+#include "core/block_compress.hpp"  // compress_output
 #include "utils/open_file.hpp"
 #include "utils/progress.hpp"
 #include <cctype>  // std::isupper
@@ -75,8 +76,8 @@ auto fastx_mask(struct Parameters const & parameters) -> void
     fatal("Specify output files for masking with --fastaout and/or --fastqout");
   }
 
-  auto fp_fastaout = open_optional_output_file(parameters.opt_fastaout, OutputOption{"--fastaout"});
-  auto fp_fastqout = open_optional_output_file(parameters.opt_fastqout, OutputOption{"--fastqout"});
+  auto fp_fastaout = compress_output(open_optional_output_file(parameters.opt_fastaout, OutputOption{"--fastaout"}), parameters);
+  auto fp_fastqout = compress_output(open_optional_output_file(parameters.opt_fastqout, OutputOption{"--fastqout"}), parameters);
 
   Database db;
   db.read(parameters.opt_fastx_mask, 0, parameters);
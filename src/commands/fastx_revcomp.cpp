@@ -63,6 +63,7 @@
 #include "utils/progress.hpp"
 #include "utils/fatal.hpp"
 #include "utils/maps.hpp"
+#include "core/block_compress.hpp"  // compress_output
 #include "utils/open_file.hpp"
 #include "utils/reverse_complement.hpp"
 #include <cstdint>  // int64_t, uint64_t
@@ -97,8 +98,8 @@ auto fastx_revcomp(struct Parameters const & parameters) -> void
 
   auto const filesize = fastx_get_size(input_handle);
 
-  auto fastaout_handle = open_optional_output_file(parameters.opt_fastaout, OutputOption{"--fastaout"});
-  auto fastqout_handle = open_optional_output_file(parameters.opt_fastqout, OutputOption{"--fastqout"});
+  auto fastaout_handle = compress_output(open_optional_output_file(parameters.opt_fastaout, OutputOption{"--fastaout"}), parameters);
+  auto fastqout_handle = compress_output(open_optional_output_file(parameters.opt_fastqout, OutputOption{"--fastqout"}), parameters);
   std::FILE * const fp_fastaout = fastaout_handle.get();
   std::FILE * const fp_fastqout = fastqout_handle.get();
 
@@ -60,6 +60,7 @@
 
 #include "vsearch.h"
 #include "utils/fatal.hpp"
+#include "core/block_compress.hpp"  // compress_output
 #include "utils/open_file.hpp"
 #include "utils/progress.hpp"
 #include "utils/random.hpp"
@@ -141,11 +142,12 @@ struct file_types {
 //  maybe they use a better approach than the std::discrete_distribution?
 
 
-auto open_output_files(struct file_types & ouput_files) -> void {
-  ouput_files.fasta.kept.handle = open_optional_output_file(ouput_files.fasta.kept.name, OutputOption{"--fastaout"});
-  ouput_files.fasta.lost.handle = open_optional_output_file(ouput_files.fasta.lost.name, OutputOption{"--fastaout_discarded"});
-  ouput_files.fastq.kept.handle = open_optional_output_file(ouput_files.fastq.kept.name, OutputOption{"--fastqout"});
-  ouput_files.fastq.lost.handle = open_optional_output_file(ouput_files.fastq.lost.name, OutputOption{"--fastqout_discarded"});
+auto open_output_files(struct file_types & ouput_files,
+                       struct Parameters const & parameters) -> void {
+  ouput_files.fasta.kept.handle = compress_output(open_optional_output_file(ouput_files.fasta.kept.name, OutputOption{"--fastaout"}), parameters);
+  ouput_files.fasta.lost.handle = compress_output(open_optional_output_file(ouput_files.fasta.lost.name, OutputOption{"--fastaout_discarded"}), parameters);
+  ouput_files.fastq.kept.handle = compress_output(open_optional_output_file(ouput_files.fastq.kept.name, OutputOption{"--fastqout"}), parameters);
+  ouput_files.fastq.lost.handle = compress_output(open_optional_output_file(ouput_files.fastq.lost.name, OutputOption{"--fastqout_discarded"}), parameters);
 }
 
 
@@ -357,7 +359,7 @@ auto subsample(struct Parameters const & parameters) -> void {
   ouput_files.fasta.lost.name = parameters.opt_fastaout_discarded;
   ouput_files.fastq.kept.name = parameters.opt_fastqout;
   ouput_files.fastq.lost.name = parameters.opt_fastqout_discarded;
-  open_output_files(ouput_files);
+  open_output_files(ouput_files, parameters);
 
   Database db;
   db.read(parameters.opt_fastx_subsample, 0, parameters);
@@ -65,12 +65,14 @@
 #include "utils/progress.hpp"
 #include "utils/fatal.hpp"
 #include "utils/maps.hpp"  // chrmap_no_change()
+#include "core/block_compress.hpp"  // compress_output
 #include "utils/open_file.hpp"
 #include <cinttypes>  // macros PRIu64
 #include <cstdint>  // int64_t, uint64_t
 #include <cstdio>  // std::FILE, std::fprintf, std::fclose
 #include <string>
 #include <unordered_map>
+#include <utility>  // std::move
 #include <vector>
 
 
@@ -138,24 +140,25 @@ namespace {
   }
 
 
-  auto open_output(char * name, char const * option) -> output_file {
+  auto open_output(char * name, char const * option,
+                   struct Parameters const & parameters) -> output_file {
     output_file outfile;
     outfile.name = name;
-    outfile.handle = open_optional_output_file(name, OutputOption{option});
+    outfile.handle = compress_output(open_optional_output_file(name, OutputOption{option}), parameters);
     return outfile;
   }
 
 
   auto open_output_files(struct Parameters const & parameters) -> output_files {
     output_files outfiles;
-    outfiles.synced_fwd.fasta = open_output(parameters.opt_fastaout, "--fastaout");
-    outfiles.synced_fwd.fastq = open_output(parameters.opt_fastqout, "--fastqout");
-    outfiles.synced_rev.fasta = open_output(parameters.opt_fastaout_rev, "--fastaout_rev");
-    outfiles.synced_rev.fastq = open_output(parameters.opt_fastqout_rev, "--fastqout_rev");
-    outfiles.orphans_fwd.fasta = open_output(parameters.opt_fastaout_orphans, "--fastaout_orphans");
-    outfiles.orphans_fwd.fastq = open_output(parameters.opt_fastqout_orphans, "--fastqout_orphans");
-    outfiles.orphans_rev.fasta = open_output(parameters.opt_fastaout_orphans_rev, "--fastaout_orphans_rev");
-    outfiles.orphans_rev.fastq = open_output(parameters.opt_fastqout_orphans_rev, "--fastqout_orphans_rev");
+    outfiles.synced_fwd.fasta = open_output(parameters.opt_fastaout, "--fastaout", parameters);
+    outfiles.synced_fwd.fastq = open_output(parameters.opt_fastqout, "--fastqout", parameters);
+    outfiles.synced_rev.fasta = open_output(parameters.opt_fastaout_rev, "--fastaout_rev", parameters);
+    outfiles.synced_rev.fastq = open_output(parameters.opt_fastqout_rev, "--fastqout_rev", parameters);
+    outfiles.orphans_fwd.fasta = open_output(parameters.opt_fastaout_orphans, "--fastaout_orphans", parameters);
+    outfiles.orphans_fwd.fastq = open_output(parameters.opt_fastqout_orphans, "--fastqout_orphans", parameters);
+    outfiles.orphans_rev.fasta = open_output(parameters.opt_fastaout_orphans_rev, "--fastaout_orphans_rev", parameters);
+    outfiles.orphans_rev.fastq = open_output(parameters.opt_fastqout_orphans_rev, "--fastqout_orphans_rev", parameters);
     return outfiles;
   }
 
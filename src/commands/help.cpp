@@ -68,7 +68,7 @@
 
   /*       0         1         2         3         4         5         6         7          */
   /*       01234567890123456789012345678901234567890123456789012345678901234567890123456789 */
-  static constexpr std::size_t help_line_count = 492;
+  static constexpr std::size_t help_line_count = 499;
   static constexpr std::array<char const *, help_line_count> help_message =
     {{
       "\n",
@@ -77,6 +77,7 @@
       "General options\n",
       "  --bzip2_decompress          decompress input with bzip2 (required if pipe)\n",
       "  --fasta_width INT           width of FASTA seq lines, 0 for no wrap (80)\n",
+      "  --gzip_compress             write FASTA/FASTQ/UC output compressed (bgzip)\n",
       "  --gzip_decompress           decompress input with gzip (required if pipe)\n",
       "  --help | -h                 display help information\n",
       "  --log FILENAME              write messages, timing and memory info to file\n",
@@ -97,6 +98,7 @@
       "  --chimeras_parents_max INT  maximum number of parent sequences (3)\n",
       "  --chimeras_parts INT        number of parts to divide sequences (length/100)\n",
       "  --sizein                    propagate abundance annotation from input\n",
+      "  --threads_per_query INT     threads searching and aligning each query (1)\n",
       " Output\n",
       "  --alignwidth INT            width of alignments in alignment output file (60)\n",
       "  --alnout FILENAME           output chimera alignments to file\n",
@@ -127,6 +129,7 @@
       "  --sizein                    propagate abundance annotation from input\n",
       "  --self                      exclude identical labels for --uchime_ref\n",
       "  --selfid                    exclude identical sequences for --uchime_ref\n",
+      "  --threads_per_query INT     threads searching and aligning each query (1)\n",
       "  --xn REAL                   'no' vote weight (8.0)\n",
       " Output\n",
       "  --alignwidth INT            width of alignment in uchimealn output (80)\n",
@@ -422,6 +425,7 @@
       "  --minwordmatches INT        minimum number of word matches required (12)\n",
       "  --mismatch INT              score for mismatch (-4)\n",
       "  --n_mismatch                consider aligning with N's as mismatches\n",
+      "  --pack_index                store database index compactly, using less memory\n",
       "  --pattern STRING            option is ignored\n",
       "  --qmask none|dust|soft      mask query with dust, soft or no method (dust)\n",
       "  --query_cov REAL            reject if fraction of query seq. aligned lower\n",
@@ -504,6 +508,7 @@
       "  --sintax FILENAME           classify sequences in given FASTA/FASTQ file\n",
       " Parameters\n",
       "  --db FILENAME               taxonomic reference db in given FASTA or UDB file\n",
+      "  --pack_index                store database index compactly, using less memory\n",
       "  --randseed INT              seed for PRNG, zero to use random data source (0)\n",
       "  --sintax_cutoff REAL        confidence value cutoff level (0.0)\n",
       "  --sintax_random             use random sequence, not shortest, if equal match\n",
@@ -560,9 +565,11 @@
       " Parameters\n",
       "  --dbmask none|dust|soft     mask db with dust, soft or no method (dust)\n",
       "  --hardmask                  mask by replacing with N instead of lower case\n",
+      "  --pack_index                store word index compactly (with --udb_mmap)\n",
       "  --wordlength INT            length of words for database index 3-15 (8)\n",
       " Output\n",
       "  --output FILENAME           UDB or FASTA output file\n",
+      "  --udb_mmap                  write UDB file to be memory-mapped by vsearch\n",
     }};
 
 
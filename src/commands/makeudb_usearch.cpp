@@ -60,12 +60,17 @@
 
 #include "vsearch.h"
 #include "commands/makeudb_usearch.hpp"
+#include "core/attributes.hpp"
 #include "core/mask.hpp"
 #include "core/bitmap.hpp"
 #include "core/dbindex.hpp"
+#include "core/tax.hpp"
+#include "core/udb.hpp"
 #include "utils/fatal.hpp"
 #include "utils/progress.hpp"
-#include <algorithm>  // std::max
+#include "utils/taxonomic_fields.h"
+#include <algorithm>  // std::fill, std::max, std::min
+#include <array>
 #include <cstdint>  // uint64_t
 #include <cstring>  // std::memset
 #include <fstream>  // std::ofstream
@@ -99,6 +104,232 @@ namespace {
     return nbyte;
   }
 
+
+  /* call visit(kmer, list, length) with the list of sequence no's of
+     every word, expanding the words with a bitmap into buffer */
+  template <typename Function>
+  auto visit_kmer_lists(struct Dbindex const & dbindex, unsigned int const seqcount,
+                        std::vector<unsigned int> & buffer, Function visit) -> void
+  {
+    for (auto i = 0U; i < dbindex.hashsize; i++)
+      {
+        if (dbindex.kmerbitmap[i] != nullptr)
+          {
+            std::memset(buffer.data(), 0, 4 * dbindex.kmercount[i]);
+            auto elements = 0U;
+            for (auto j = 0U; j < seqcount; j++)
+              {
+                if (bitmap_get(dbindex.kmerbitmap[i], j) != 0U)
+                  {
+                    buffer[elements++] = j;
+                  }
+              }
+            visit(i, buffer.data(), elements);
+          }
+        else
+          {
+            if (dbindex.kmercount[i] > 0)
+              {
+                visit(i, dbindex.kmerindex + dbindex.kmerhash[i], dbindex.kmercount[i]);
+              }
+          }
+      }
+  }
+
+
+  auto write_kmer_lists(std::ostream & output, struct Dbindex const & dbindex,
+                        unsigned int const seqcount, std::vector<unsigned int> & buffer,
+                        uint64_t pos, Progress & progress_bar) -> uint64_t
+  {
+    /* lists of sequence no's with matches for all words */
+
+    auto const start = pos;
+    visit_kmer_lists(dbindex, seqcount, buffer,
+                     [&](unsigned int /* kmer */, unsigned int const * list, unsigned int const length) {
+                       pos += largewrite(output, list, 4 * static_cast<uint64_t>(length), pos, progress_bar);
+                     });
+    return pos - start;
+  }
+
+
+  /* the lists of all words packed as by Dbindex::pack(), with the byte
+     offset of each list in offsets */
+  auto pack_kmer_lists(struct Dbindex const & dbindex, unsigned int const seqcount,
+                       std::vector<unsigned int> & buffer,
+                       std::vector<uint64_t> & offsets) -> std::vector<unsigned char>
+  {
+    std::vector<unsigned char> packed;
+    std::fill(offsets.begin(), offsets.end(), 0);
+    visit_kmer_lists(dbindex, seqcount, buffer,
+                     [&](unsigned int const kmer, unsigned int const * list, unsigned int const length) {
+                       offsets[kmer] = packed.size();
+                       auto previous = 0U;
+                       for (auto j = 0U; j < length; j++)
+                         {
+                           std::array<unsigned char, packed_gap_max_bytes> code {{}};
+                           auto * const end = pack_gap(code.data(), list[j] - previous);
+                           packed.insert(packed.end(), code.data(), end);
+                           previous = list[j];
+                         }
+                     });
+    /* words without a list start where the next list does */
+    offsets[dbindex.hashsize] = packed.size();
+    for (auto kmer = dbindex.hashsize; kmer > 0; kmer--)
+      {
+        if (dbindex.kmercount[kmer - 1] == 0)
+          {
+            offsets[kmer - 1] = offsets[kmer];
+          }
+      }
+    return packed;
+  }
+
+
+  auto udb2_align(uint64_t const offset) -> uint64_t
+  {
+    return (offset + udb2_alignment - 1) / udb2_alignment * udb2_alignment;
+  }
+
+
+  auto write_padding(std::ostream & output, uint64_t const target,
+                     uint64_t const pos, Progress & progress_bar) -> uint64_t
+  {
+    /* zeros from pos up to the aligned offset target */
+
+    static constexpr std::array<char, udb2_table_offset> zeros {{}};
+    return largewrite(output, zeros.data(), target - pos, pos, progress_bar);
+  }
+
+
+  auto write_udb2(std::ostream & output, struct Database const & db,
+                  struct Dbindex const & dbindex, std::vector<unsigned int> & buffer,
+                  struct Parameters const & parameters) -> void
+  {
+    /* Write the UDB v2 layout (see core/udb.hpp): the arrays that
+       udb_read() builds from a UDB file, so that it can map them, and
+       the taxonomy if any header has a tax= annotation. */
+
+    auto const seqcount = static_cast<unsigned int>(db.getsequencecount());
+
+    Taxonomy taxonomy;
+    taxonomy.parse(db);
+    auto const has_taxonomy = (taxonomy.name_count() > 1);
+    auto const taxname_bytes = taxonomy.name_starts()[taxonomy.name_count()];
+
+    std::vector<uint64_t> kmerhash(dbindex.hashsize + 1);
+    uint64_t indexsize = 0;
+    for (auto i = 0U; i < dbindex.hashsize; i++)
+      {
+        kmerhash[i] = indexsize;
+        indexsize += dbindex.kmercount[i];
+      }
+    kmerhash[dbindex.hashsize] = indexsize;
+
+    std::vector<unsigned char> packed;
+    if (parameters.opt_pack_index)
+      {
+        packed = pack_kmer_lists(dbindex, seqcount, buffer, kmerhash);
+      }
+    auto const kmerindex_bytes = parameters.opt_pack_index ? packed.size() : 4 * indexsize;
+
+    /* headers first, then sequences, each zero-terminated */
+    std::vector<seqinfo_t> seqindex(seqcount);
+    uint64_t header_characters = 0;
+    for (auto i = 0U; i < seqcount; i++)
+      {
+        auto & info = seqindex[i];
+        info.header_p = header_characters;
+        info.headerlen = static_cast<unsigned int>(db.getheaderlen(i));
+        info.seqlen = static_cast<unsigned int>(db.getsequencelen(i));
+        auto const size = header_get_size(db.getheader(i), static_cast<int>(info.headerlen));
+        info.size = (size > 0) ? static_cast<uint64_t>(size) : 1;
+        header_characters += info.headerlen + 1;
+      }
+    auto sequence_p = header_characters;
+    for (auto & info : seqindex)
+      {
+        info.seq_p = sequence_p;
+        sequence_p += info.seqlen + 1;
+      }
+
+    udb2_table_s table {};
+    table.signature = udb2_signature;
+    table.seqcount = seqcount;
+    table.hashsize = dbindex.hashsize;
+    table.indexsize = indexsize;
+    table.nucleotides = db.getnucleotidecount();
+    table.datasize = sequence_p;
+    table.longest = db.getlongestsequence();
+    table.shortest = db.getshortestsequence();
+    table.longestheader = db.getlongestheader();
+    table.kmercount_offset = udb2_align(udb2_table_offset + sizeof(udb2_table_s));
+    table.kmerhash_offset = udb2_align(table.kmercount_offset + (4 * table.hashsize));
+    table.kmerindex_offset = udb2_align(table.kmerhash_offset + (8 * (table.hashsize + 1)));
+    table.seqindex_offset = udb2_align(table.kmerindex_offset + kmerindex_bytes);
+    table.data_offset = udb2_align(table.seqindex_offset + (sizeof(seqinfo_t) * seqcount));
+    table.filesize = table.data_offset + table.datasize;
+    table.flags = parameters.opt_pack_index ? udb2_flag_packed : 0;
+    if (has_taxonomy)
+      {
+        table.flags |= udb2_flag_taxonomy;
+        table.taxnames = taxonomy.name_count();
+        table.taxids_offset = udb2_align(table.filesize);
+        table.taxname_start_offset = udb2_align(table.taxids_offset + (4 * uint64_t{tax_levels} * seqcount));
+        table.taxname_data_offset = udb2_align(table.taxname_start_offset + (8 * (table.taxnames + 1)));
+        table.filesize = table.taxname_data_offset + taxname_bytes;
+      }
+
+    /* the main header of a UDB file, with its own signature */
+    std::fill(buffer.begin(), buffer.begin() + 50, 0U);
+    buffer[0]  = udb2_signature;
+    buffer[2]  = 32; /* bits */
+    buffer[4]  = dbindex.wordlength;
+    buffer[5]  = 1; /* dbstep */
+    buffer[6]  = 100; /* dbaccelpct % */
+    buffer[13] = seqcount;
+    buffer[17] = 0x0000746e; /* alphabet: "nt" */
+    buffer[49] = 0x55444266; /* fBDU UDBf */
+
+    Progress progress_bar("Writing UDB file", table.filesize, parameters);
+    uint64_t pos = 0;
+    pos += largewrite(output, buffer.data(), 50 * 4, pos, progress_bar);
+    pos += write_padding(output, udb2_table_offset, pos, progress_bar);
+    pos += largewrite(output, & table, sizeof(udb2_table_s), pos, progress_bar);
+    pos += write_padding(output, table.kmercount_offset, pos, progress_bar);
+    pos += largewrite(output, dbindex.kmercount, 4 * table.hashsize, pos, progress_bar);
+    pos += write_padding(output, table.kmerhash_offset, pos, progress_bar);
+    pos += largewrite(output, kmerhash.data(), 8 * (table.hashsize + 1), pos, progress_bar);
+    pos += write_padding(output, table.kmerindex_offset, pos, progress_bar);
+    if (parameters.opt_pack_index)
+      {
+        pos += largewrite(output, packed.data(), packed.size(), pos, progress_bar);
+      }
+    else
+      {
+        pos += write_kmer_lists(output, dbindex, seqcount, buffer, pos, progress_bar);
+      }
+    pos += write_padding(output, table.seqindex_offset, pos, progress_bar);
+    pos += largewrite(output, seqindex.data(), sizeof(seqinfo_t) * seqcount, pos, progress_bar);
+    pos += write_padding(output, table.data_offset, pos, progress_bar);
+    for (auto i = 0U; i < seqcount; i++)
+      {
+        pos += largewrite(output, db.getheader(i), seqindex[i].headerlen + 1, pos, progress_bar);
+      }
+    for (auto i = 0U; i < seqcount; i++)
+      {
+        pos += largewrite(output, db.getsequence(i), seqindex[i].seqlen + 1, pos, progress_bar);
+      }
+    if (has_taxonomy)
+      {
+        pos += write_padding(output, table.taxids_offset, pos, progress_bar);
+        pos += largewrite(output, taxonomy.ids(), 4 * uint64_t{tax_levels} * seqcount, pos, progress_bar);
+        pos += write_padding(output, table.taxname_start_offset, pos, progress_bar);
+        pos += largewrite(output, taxonomy.name_starts(), 8 * (table.taxnames + 1), pos, progress_bar);
+        pos += write_padding(output, table.taxname_data_offset, pos, progress_bar);
+        pos += largewrite(output, taxonomy.names(), taxname_bytes, pos, progress_bar);
+      }
+  }
+
 }  // end of anonymous namespace
 
 
@@ -111,6 +342,10 @@ auto makeudb_usearch(struct Parameters const & parameters) -> void
     fatal("UDB output file must be specified with --output");
   }
 
+  if (parameters.opt_pack_index and not parameters.opt_udb_mmap) {
+    fatal("The --pack_index option requires --udb_mmap");
+  }
+
   std::ofstream out_stream(parameters.opt_output, std::ios::binary | std::ios::trunc);
   if (not out_stream)
     {
@@ -165,6 +400,19 @@ auto makeudb_usearch(struct Parameters const & parameters) -> void
   uint64_t const buffersize = std::max(50U, seqcount);
   std::vector<unsigned int> buffer(buffersize);
 
+  if (parameters.opt_udb_mmap)
+    {
+      write_udb2(out_stream, db, dbindex, buffer, parameters);
+      out_stream.close();
+      if (not out_stream)
+        {
+          fatal("Unable to close UDB file");
+        }
+      dbindex.clear();
+      db.clear();
+      return;
+    }
+
   /* Header */
   buffer[0]  = 0x55444246; /* FBDU UDBF */
   buffer[2]  = 32; /* bits */
@@ -187,33 +435,7 @@ auto makeudb_usearch(struct Parameters const & parameters) -> void
     pos += largewrite(out_stream, buffer.data(), 1 * 4, pos, progress_bar);
 
     /* lists of sequence no's with matches for all words */
-    for (auto i = 0U; i < kmerhash_entries; i++)
-      {
-        if (dbindex.kmerbitmap[i] != nullptr)
-          {
-            std::memset(buffer.data(), 0, 4 * dbindex.kmercount[i]);
-            auto elements = 0U;
-            for (auto j = 0U; j < seqcount; j++)
-              {
-                if (bitmap_get(dbindex.kmerbitmap[i], j) != 0U)
-                  {
-                    buffer[elements++] = j;
-                  }
-              }
-            pos += largewrite(out_stream, buffer.data(), 4 * elements, pos, progress_bar);
-          }
-        else
-          {
-            if (dbindex.kmercount[i] > 0)
-              {
-                pos += largewrite(out_stream,
-                                  dbindex.kmerindex + dbindex.kmerhash[i],
-                                  4 * dbindex.kmercount[i],
-                                  pos,
-                                  progress_bar);
-              }
-          }
-      }
+    pos += write_kmer_lists(out_stream, dbindex, seqcount, buffer, pos, progress_bar);
 
     /* New header */
     buffer[0] = 0x55444234; /* 4BDU UDB4 */
@@ -66,7 +66,9 @@
 #include "core/unique.hpp"
 #include "utils/fatal.hpp"
 #include "utils/maps.hpp"
+#include "core/block_compress.hpp"  // compress_output
 #include "utils/open_file.hpp"
+#include "utils/pack_2bit.hpp"
 #include "utils/reverse_complement.hpp"
 #include <cassert>
 #include <cstdint>  // uint64_t
@@ -97,19 +99,7 @@ auto rc_kmer(unsigned int kmer, unsigned int wordlength) -> unsigned int
      width to match the index; reading parameters.opt_wordlength here would use
      the wrong width against a UDB index (mismatch, out-of-bounds when wider). */
   assert(wordlength * 2 <= 32);
-  auto fwd = kmer;
-  auto rev = 0U;
-
-  for (auto i = 0U; i < wordlength; ++i)
-    {
-      // compute complement of the last two bits
-      auto const complement_bits = (fwd & 3U) ^ 3U;
-      fwd = fwd >> 2U;
-      rev = rev << 2U;
-      rev |= complement_bits;
-    }
-
-  return rev;
+  return reverse_complement_kmer(kmer, wordlength);
 }
 
 
@@ -150,7 +140,7 @@ auto orient(struct Parameters const & parameters) -> void
 
   /* open output files */
 
-  fastaout_handle = open_optional_output_file(parameters.opt_fastaout, OutputOption{"--fastaout"});
+  fastaout_handle = compress_output(open_optional_output_file(parameters.opt_fastaout, OutputOption{"--fastaout"}), parameters);
   fp_fastaout = fastaout_handle.get();
 
   if (parameters.opt_fastqout != nullptr)
@@ -160,11 +150,11 @@ auto orient(struct Parameters const & parameters) -> void
           fatal("Cannot write FASTQ output with FASTA input");
         }
 
-      fastqout_handle = open_optional_output_file(parameters.opt_fastqout, OutputOption{"--fastqout"});
+      fastqout_handle = compress_output(open_optional_output_file(parameters.opt_fastqout, OutputOption{"--fastqout"}), parameters);
       fp_fastqout = fastqout_handle.get();
     }
 
-  notmatched_handle = open_optional_output_file(parameters.opt_notmatched, OutputOption{"--notmatched"});
+  notmatched_handle = compress_output(open_optional_output_file(parameters.opt_notmatched, OutputOption{"--notmatched"}), parameters);
   fp_notmatched = notmatched_handle.get();
   tabbedout_handle = open_optional_output_file(parameters.opt_tabbedout, OutputOption{"--tabbedout"});
   fp_tabbedout = tabbedout_handle.get();
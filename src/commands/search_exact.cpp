@@ -65,6 +65,7 @@
 #include "utils/fatal.hpp"
 #include "utils/maps.hpp"
 #include "utils/number_of_strands.hpp"
+#include "core/block_compress.hpp"  // compress_output
 #include "utils/open_file.hpp"
 #include "utils/threads.hpp"
 #include "utils/worker_loop.hpp"
@@ -695,21 +696,21 @@ auto search_exact(struct Parameters const & parameters) -> void
   state.fp_userout = userout_handle.get();
   OutputFileHandle blast6out_handle = open_optional_output_file(parameters.opt_blast6out, OutputOption{"--blast6out"});
   state.fp_blast6out = blast6out_handle.get();
-  OutputFileHandle uc_handle = open_optional_output_file(parameters.opt_uc, OutputOption{"--uc"});
+  OutputFileHandle uc_handle = compress_output(open_optional_output_file(parameters.opt_uc, OutputOption{"--uc"}), parameters);
   state.fp_uc = uc_handle.get();
-  OutputFileHandle fastapairs_handle = open_optional_output_file(parameters.opt_fastapairs, OutputOption{"--fastapairs"});
+  OutputFileHandle fastapairs_handle = compress_output(open_optional_output_file(parameters.opt_fastapairs, OutputOption{"--fastapairs"}), parameters);
   state.fp_fastapairs = fastapairs_handle.get();
-  OutputFileHandle qsegout_handle = open_optional_output_file(parameters.opt_qsegout, OutputOption{"--qsegout"});
+  OutputFileHandle qsegout_handle = compress_output(open_optional_output_file(parameters.opt_qsegout, OutputOption{"--qsegout"}), parameters);
   state.fp_qsegout = qsegout_handle.get();
-  OutputFileHandle tsegout_handle = open_optional_output_file(parameters.opt_tsegout, OutputOption{"--tsegout"});
+  OutputFileHandle tsegout_handle = compress_output(open_optional_output_file(parameters.opt_tsegout, OutputOption{"--tsegout"}), parameters);
   state.fp_tsegout = tsegout_handle.get();
-  OutputFileHandle matched_handle = open_optional_output_file(parameters.opt_matched, OutputOption{"--matched"});
+  OutputFileHandle matched_handle = compress_output(open_optional_output_file(parameters.opt_matched, OutputOption{"--matched"}), parameters);
   state.fp_matched = matched_handle.get();
-  OutputFileHandle notmatched_handle = open_optional_output_file(parameters.opt_notmatched, OutputOption{"--notmatched"});
+  OutputFileHandle notmatched_handle = compress_output(open_optional_output_file(parameters.opt_notmatched, OutputOption{"--notmatched"}), parameters);
   state.fp_notmatched = notmatched_handle.get();
-  OutputFileHandle dbmatched_handle = open_optional_output_file(parameters.opt_dbmatched, OutputOption{"--dbmatched"});
+  OutputFileHandle dbmatched_handle = compress_output(open_optional_output_file(parameters.opt_dbmatched, OutputOption{"--dbmatched"}), parameters);
   state.fp_dbmatched = dbmatched_handle.get();
-  OutputFileHandle dbnotmatched_handle = open_optional_output_file(parameters.opt_dbnotmatched, OutputOption{"--dbnotmatched"});
+  OutputFileHandle dbnotmatched_handle = compress_output(open_optional_output_file(parameters.opt_dbnotmatched, OutputOption{"--dbnotmatched"}), parameters);
   state.fp_dbnotmatched = dbnotmatched_handle.get();
   OutputFileHandle otutabout_handle = open_optional_output_file(parameters.opt_otutabout, OutputOption{"--otutabout"});
   state.fp_otutabout = otutabout_handle.get();
@@ -61,6 +61,7 @@
 #include "vsearch.h"
 #include "utils/progress.hpp"
 #include "utils/fatal.hpp"
+#include "core/block_compress.hpp"  // compress_output
 #include "utils/open_file.hpp"
 #include "utils/os_byteswap.hpp"
 #include <algorithm>  // std::min, std::max, std::transform
@@ -441,7 +442,7 @@ auto sff_convert(struct Parameters const & parameters) -> void
 
   auto fp_sff = open_input_file(parameters.opt_sff_convert);
   check_sff_input(parameters.opt_sff_convert, (not fp_sff));
-  auto const output_handle = open_mandatory_output_file(parameters.opt_fastqout, OutputOption{"--fastqout"});
+  auto const output_handle = compress_output(open_mandatory_output_file(parameters.opt_fastqout, OutputOption{"--fastqout"}), parameters);
   std::FILE * const fp_fastqout = output_handle.get();
 
 
@@ -99,12 +99,31 @@
 #include <array>
 #include <cstdint>  // int64_t, uint64_t
 #include <cstdio>  // std::FILE, std::fprintf, std::fclose, std::size_t
-#include <cstring>  // std::memset, std::strncmp, std::strcpy
+#include <cstring>  // std::memset, std::strcpy
+#include <limits>  // std::numeric_limits
 #include <mutex>  // std::mutex, std::lock_guard, std::unique_lock
+#include <vector>
 
 
 constexpr auto subset_size = 32;
 constexpr auto bootstrap_count = 100;
+constexpr auto block_size = 64U;  /* sequences per bitset word */
+
+/* The unique k-mers of one strand of a query as bitsets over the
+   indexed database sequences, gathered once and then used by all the
+   bootstraps of that strand instead of counting the k-mers of each
+   subset over the whole database. A frequent k-mer uses the bitmap of
+   the index, a rare one a bitset built from its list. The bootstraps
+   add the bitsets of their subset 64 sequences at a time, and skip the
+   blocks of 64 sequences containing too few of the query k-mers. */
+struct sintax_kmer_sets_s
+{
+  std::vector<unsigned char const *> bitsets;  /* one per unique query k-mer */
+  std::vector<unsigned char> rows;  /* the bitsets of the rare k-mers */
+  std::vector<unsigned int> block_total;  /* highest total of query k-mers in each block */
+  std::vector<unsigned int> block_order;  /* blocks by decreasing highest total */
+};
+
 
 /* Per-invocation state for a sintax run — previously ten file-static globals.
    Folding them into a struct that sintax() owns and threads through the helper
@@ -118,8 +137,10 @@ struct sintax_state_s
   struct Parameters const & parameters;
   struct Database db;  /* the sequence database this run owns (RAII); si->db points here */
   struct Dbindex dbindex;  /* the k-mer index this run owns (RAII); si->dbindex points here */
+  Taxonomy taxonomy;  /* the parsed tax= annotations of db */
   struct searchinfo_s * si_plus = nullptr;
   struct searchinfo_s * si_minus = nullptr;
+  std::vector<struct sintax_kmer_sets_s> kmer_sets;  /* per thread */
   int tophits = 0;   /* the maximum number of hits to keep */
   int seqcount = 0;  /* number of database sequences */
   fastx_handle query_fastx_h = nullptr;
@@ -145,8 +166,7 @@ static auto sintax_analyse(struct sintax_state_s & state,
 
   std::array<int, tax_levels> level_matchcount {{}};
   std::array<int, tax_levels> level_best {{}};
-  std::array<std::array<char const *, tax_levels>, bootstrap_count> cand_level_name_start {{}};
-  std::array<std::array<int, tax_levels>, bootstrap_count> cand_level_name_len {{}};
+  std::array<std::array<unsigned int, tax_levels>, bootstrap_count> cand_level_name {{}};
 
   /* Check number of successful bootstraps, must be at least half */
 
@@ -159,17 +179,13 @@ static auto sintax_analyse(struct sintax_state_s & state,
 
       for (auto i = 0; i < count ; i++)
         {
-          /* Split headers of all candidates by taxonomy ranks */
+          /* Names of all candidates by taxonomy ranks */
 
-          auto const seqno = all_seqno[i];
-          std::array<int, tax_levels> new_level_name_start {{}};
-          std::array<int, tax_levels> new_level_name_len {{}};
-          tax_split(seqno, new_level_name_start.data(), new_level_name_len.data(), state.db);
-          cand_level_name_len[static_cast<std::size_t>(i)] = new_level_name_len;
+          auto const seqno = static_cast<uint64_t>(all_seqno[i]);
           for (auto k = 0; k < tax_levels; k++)
             {
-              cand_level_name_start[static_cast<std::size_t>(i)][static_cast<std::size_t>(k)] =
-                state.db.getheader(static_cast<uint64_t>(seqno)) + new_level_name_start[static_cast<std::size_t>(k)];
+              cand_level_name[static_cast<std::size_t>(i)][static_cast<std::size_t>(k)] =
+                state.taxonomy.name_id(seqno, k);
             }
         }
 
@@ -196,10 +212,7 @@ static auto sintax_analyse(struct sintax_state_s & state,
                 if (cand_included[cand_j])
                   {
                     /* check match at current level */
-                    if ((cand_level_name_len[cand_i][level] == cand_level_name_len[cand_j][level]) &&
-                        (std::strncmp(cand_level_name_start[cand_i][level],
-                                           cand_level_name_start[cand_j][level],
-                                           static_cast<std::size_t>(cand_level_name_len[cand_i][level])) == 0))
+                    if (cand_level_name[cand_i][level] == cand_level_name[cand_j][level])
                       {
                         cand_match[cand_i] = j;
                         cand_matchcount[cand_j]++;
@@ -242,15 +255,15 @@ static auto sintax_analyse(struct sintax_state_s & state,
       for (auto j = 0; j < tax_levels; j++)
         {
           auto const level = static_cast<std::size_t>(j);
-          auto const best = static_cast<std::size_t>(level_best[level]);
-          if (cand_level_name_len[best][level] > 0)
+          auto const name = cand_level_name[static_cast<std::size_t>(level_best[level])][level];
+          if (state.taxonomy.name_length(name) > 0)
             {
               std::fprintf(fp_tabbedout,
                       "%s%c:%.*s(%.2f)",
                       (comma ? "," : ""),
                       taxonomic_fields[level],
-                      cand_level_name_len[best][level],
-                      cand_level_name_start[best][level],
+                      state.taxonomy.name_length(name),
+                      state.taxonomy.name(name),
                       1.0 * level_matchcount[level] / count);
               comma = true;
             }
@@ -265,16 +278,16 @@ static auto sintax_analyse(struct sintax_state_s & state,
           for (auto j = 0; j < tax_levels; j++)
             {
               auto const level = static_cast<std::size_t>(j);
-              auto const best = static_cast<std::size_t>(level_best[level]);
-              if ((cand_level_name_len[best][level] > 0) &&
+              auto const name = cand_level_name[static_cast<std::size_t>(level_best[level])][level];
+              if ((state.taxonomy.name_length(name) > 0) &&
                   (1.0 * level_matchcount[level] / count >= state.parameters.opt_sintax_cutoff))
                 {
                   std::fprintf(fp_tabbedout,
                           "%s%c:%.*s",
                           (comma_cutoff ? "," : ""),
                           taxonomic_fields[level],
-                          cand_level_name_len[best][level],
-                          cand_level_name_start[best][level]);
+                          state.taxonomy.name_length(name),
+                          state.taxonomy.name(name));
                   comma_cutoff = true;
                 }
             }
@@ -296,20 +309,8 @@ static auto sintax_analyse(struct sintax_state_s & state,
 }
 
 
-auto sintax_search_topscores(struct searchinfo_s * searchinfo,
-                             SplitMix64 & rng,
-                             struct Parameters const & parameters) -> void
+static auto sintax_count_kmers(struct searchinfo_s * searchinfo) -> void
 {
-  /*
-    Count the number of kmer hits in each database sequence and select
-    the database sequence with the highest number of matching kmers.
-    If several sequences have equally many kmer matches, choose one of
-    them according to the following rules: By default, choose the
-    shortest. If two are equally short, choose the one that comes
-    first in the database.  If the sintax_random option is in effect,
-    ties will instead be chosen randomly.
-  */
-
   /* count kmer hits in the database sequences */
   unsigned int const indexed_count = searchinfo->dbindex->getcount();
 
@@ -324,7 +325,7 @@ auto sintax_search_topscores(struct searchinfo_s * searchinfo,
       if (bitmap != nullptr)
         {
 #ifdef __x86_64__
-          if (parameters.ssse3_present != 0)
+          if (searchinfo->parameters->ssse3_present != 0)
             {
               increment_counters_from_bitmap_ssse3(searchinfo->kmers,
                                                    bitmap, indexed_count);
@@ -338,6 +339,17 @@ auto sintax_search_topscores(struct searchinfo_s * searchinfo,
           increment_counters_from_bitmap(searchinfo->kmers, bitmap, indexed_count);
 #endif
         }
+      else if (searchinfo->dbindex->is_packed())
+        {
+          auto const * packed = searchinfo->dbindex->getpackedlist(kmer);
+          auto const count = searchinfo->dbindex->getmatchcount(kmer);
+          auto indexed = 0U;
+          for (auto j = 0U; j < count; j++)
+            {
+              indexed += unpack_gap(packed);
+              searchinfo->kmers[indexed]++;
+            }
+        }
       else
         {
           auto const * list = searchinfo->dbindex->getmatchlist(kmer);
@@ -348,7 +360,71 @@ auto sintax_search_topscores(struct searchinfo_s * searchinfo,
             }
         }
     }
+}
+
+
+/* Consider a database sequence with count kmer hits as the top hit,
+   visiting the sequences in database order. */
+
+static auto sintax_consider(elem_t & best,
+                            unsigned int & tophit_count,
+                            unsigned int const count,
+                            unsigned int const seqno,
+                            unsigned int const length,
+                            SplitMix64 & rng,
+                            struct Parameters const & parameters) -> void
+{
+  if (count > best.count)
+    {
+      best.count = count;
+      best.seqno = seqno;
+      best.length = length;
+      tophit_count = 1;
+    }
+  else if (count == best.count)
+    {
+      if (parameters.opt_sintax_random)
+        {
+          tophit_count++;
+          if (random_bounded(rng, tophit_count) == 0)
+            {
+              best.seqno = seqno;
+              best.length = length;
+            }
+        }
+      else
+        {
+          if (length < best.length)
+            {
+              best.seqno = seqno;
+              best.length = length;
+            }
+          else if (length == best.length)
+            {
+              best.seqno = std::min(seqno, best.seqno);
+            }
+        }
+    }
+}
+
 
+auto sintax_search_topscores(struct searchinfo_s * searchinfo,
+                             SplitMix64 & rng,
+                             struct Parameters const & parameters) -> void
+{
+  /*
+    Count the number of kmer hits in each database sequence and select
+    the database sequence with the highest number of matching kmers.
+    If several sequences have equally many kmer matches, choose one of
+    them according to the following rules: By default, choose the
+    shortest. If two are equally short, choose the one that comes
+    first in the database.  If the sintax_random option is in effect,
+    ties will instead be chosen randomly.
+  */
+
+  sintax_count_kmers(searchinfo);
+
+  unsigned int const indexed_count = searchinfo->dbindex->getcount();
   auto tophit_count = 0U;
 
   elem_t best;
@@ -358,41 +434,238 @@ auto sintax_search_topscores(struct searchinfo_s * searchinfo,
 
   for (auto i = 0U; i < indexed_count; i++)
     {
-      count_t const count = searchinfo->kmers[i];
       auto const seqno = searchinfo->dbindex->getmapping(i);
-      unsigned int const length = static_cast<unsigned int>(searchinfo->db->getsequencelen(seqno));
+      sintax_consider(best, tophit_count, searchinfo->kmers[i], seqno,
+                      static_cast<unsigned int>(searchinfo->db->getsequencelen(seqno)),
+                      rng, parameters);
+    }
 
-      if (count > best.count)
+  minheap_clear(searchinfo->m);
+  if (best.count > 1) {
+    minheap_add(searchinfo->m, &best);
+  }
+}
+
+
+/* 64 bits of a bitset, bit k of byte j as bit 8j + k of the word */
+
+static auto load_bits(unsigned char const * bytes) -> uint64_t
+{
+  auto bits = uint64_t{0};
+  for (auto j = sizeof(uint64_t); j-- > 0; )
+    {
+      bits = (bits << 8U) | bytes[j];
+    }
+  return bits;
+}
+
+
+/* Gather the bitsets of the unique query k-mers in searchinfo->kmersample,
+   and the highest number of them in a sequence of each block. */
+
+static auto sintax_gather_kmer_sets(struct sintax_kmer_sets_s & kmer_sets,
+                                    struct searchinfo_s * searchinfo,
+                                    bool const by_total) -> void
+{
+  auto const & dbindex = *searchinfo->dbindex;
+  unsigned int const indexed_count = dbindex.getcount();
+  unsigned int const sample_count = searchinfo->kmersamplecount;
+  auto const block_count = (indexed_count + block_size - 1) / block_size;
+  auto const row_size = static_cast<std::size_t>(block_count) * sizeof(uint64_t);
+
+  /* count the query k-mers in each sequence */
+  sintax_count_kmers(searchinfo);
+
+  auto rare_count = std::size_t{0};
+  for (auto x = 0U; x < sample_count; x++)
+    {
+      if (dbindex.getbitmap(searchinfo->kmersample[x]) == nullptr)
+        {
+          ++rare_count;
+        }
+    }
+  kmer_sets.rows.assign(rare_count * row_size, 0);
+  kmer_sets.bitsets.resize(sample_count);
+
+  auto * row = kmer_sets.rows.data();
+  for (auto x = 0U; x < sample_count; x++)
+    {
+      unsigned int const kmer = searchinfo->kmersample[x];
+      auto const * bitmap = dbindex.getbitmap(kmer);
+      if (bitmap != nullptr)
         {
-          best.count = count;
-          best.seqno = seqno;
-          best.length = length;
-          tophit_count = 1;
+          kmer_sets.bitsets[x] = bitmap;
+          continue;
         }
-      else if (count == best.count)
+
+      auto const set = [row](unsigned int const indexed) {
+        row[indexed / 8] = static_cast<unsigned char>(row[indexed / 8] | (1U << (indexed % 8)));
+      };
+      auto const count = dbindex.getmatchcount(kmer);
+      if (dbindex.is_packed())
         {
-          if (parameters.opt_sintax_random)
+          auto const * packed = dbindex.getpackedlist(kmer);
+          auto indexed = 0U;
+          for (auto j = 0U; j < count; j++)
             {
-              tophit_count++;
-              if (random_bounded(rng, tophit_count) == 0)
-                {
-                  best.seqno = seqno;
-                  best.length = length;
-                }
+              indexed += unpack_gap(packed);
+              set(indexed);
             }
-          else
+        }
+      else
+        {
+          auto const * list = dbindex.getmatchlist(kmer);
+          for (auto j = 0U; j < count; j++)
             {
-              if (length < best.length)
-                {
-                  best.seqno = seqno;
-                  best.length = length;
-                }
-              else if (length == best.length)
+              set(list[j]);
+            }
+        }
+      kmer_sets.bitsets[x] = row;
+      row += row_size;
+    }
+
+  kmer_sets.block_total.assign(block_count, 0);
+  for (auto i = 0U; i < indexed_count; i++)
+    {
+      auto & total = kmer_sets.block_total[i / block_size];
+      total = std::max<unsigned int>(total, searchinfo->kmers[i]);
+    }
+
+  /* visiting order, by decreasing highest total with a counting sort */
+  kmer_sets.block_order.resize(block_count);
+  if (not by_total)
+    {
+      for (auto b = 0U; b < block_count; b++)
+        {
+          kmer_sets.block_order[b] = b;
+        }
+      return;
+    }
+  std::vector<unsigned int> starts(sample_count + 2, 0);
+  for (auto const total : kmer_sets.block_total)
+    {
+      ++starts[sample_count - total + 1];
+    }
+  for (auto k = 1U; k < starts.size(); k++)
+    {
+      starts[k] += starts[k - 1];
+    }
+  for (auto b = 0U; b < block_count; b++)
+    {
+      kmer_sets.block_order[starts[sample_count - kmer_sets.block_total[b]]++] = b;
+    }
+}
+
+
+constexpr auto plane_count = 6;  /* bits of a count up to subset_size */
+using count_planes = std::array<uint64_t, plane_count>;
+
+
+/* the sequences of a block with a bit-sliced count of at least value */
+
+static auto count_at_least(count_planes const & planes, unsigned int const value) -> uint64_t
+{
+  auto equal = ~uint64_t{0};
+  auto above = uint64_t{0};
+  for (auto k = plane_count; k-- > 0; )
+    {
+      auto const plane = planes[static_cast<std::size_t>(k)];
+      if (((value >> static_cast<unsigned int>(k)) & 1U) != 0U)
+        {
+          equal &= plane;
+        }
+      else
+        {
+          above |= equal & plane;
+          equal &= ~plane;
+        }
+    }
+  return above | equal;
+}
+
+
+/* Select the top hit for a subset of the query k-mers, given by their
+   numbers in the sample, with the same result and random draws as
+   sintax_search_topscores(). The counts of a block of 64 sequences are
+   added up bit-sliced, bit k of the counts in planes[k]. A sequence is
+   only considered if it may reach the best count, as the others leave
+   the top hit and the random draws unchanged, and a block is left as
+   soon as none of its sequences can. */
+
+static auto sintax_sparse_topscores(struct sintax_kmer_sets_s const & kmer_sets,
+                                    unsigned int const * subset,
+                                    unsigned int const subset_count,
+                                    struct searchinfo_s * searchinfo,
+                                    SplitMix64 & rng,
+                                    struct Parameters const & parameters) -> void
+{
+  static constexpr auto group_size = 8U;  /* k-mers added between checks */
+  unsigned int const indexed_count = searchinfo->dbindex->getcount();
+  auto tophit_count = 0U;
+
+  elem_t best;
+  best.count = 0;
+  best.seqno = 0;
+  best.length = 0;
+
+  for (auto const block : kmer_sets.block_order)
+    {
+      if (kmer_sets.block_total[block] < best.count)
+        {
+          /* by decreasing total, no later block can do better */
+          if (not parameters.opt_sintax_random)
+            {
+              break;
+            }
+          continue;
+        }
+
+      auto const first = block * block_size;
+      auto const valid = (indexed_count - first < block_size) ?
+        (uint64_t{1} << (indexed_count - first)) - 1 : ~uint64_t{0};
+      auto const offset = static_cast<std::size_t>(block) * sizeof(uint64_t);
+      count_planes planes {{}};
+      auto reaching = valid;
+
+      for (auto j = 0U; j < subset_count; j++)
+        {
+          auto carry = load_bits(kmer_sets.bitsets[subset[j]] + offset);
+          for (auto & plane : planes)
+            {
+              auto const next = plane & carry;
+              plane ^= carry;
+              carry = next;
+            }
+
+          auto const remaining = subset_count - j - 1;
+          if ((remaining % group_size == 0) && (best.count > remaining))
+            {
+              reaching = valid & count_at_least(planes, best.count - remaining);
+              if (reaching == 0U)
                 {
-                  best.seqno = std::min(seqno, best.seqno);
+                  break;
                 }
             }
         }
+
+      while (reaching != 0U)
+        {
+          auto const bit = static_cast<unsigned int>(__builtin_ctzll(reaching));
+          reaching &= reaching - 1;
+          auto count = 0U;
+          for (auto k = 0U; k < planes.size(); k++)
+            {
+              count |= static_cast<unsigned int>((planes[k] >> bit) & 1U) << k;
+            }
+          if (count < best.count)
+            {
+              continue;
+            }
+          auto const seqno = searchinfo->dbindex->getmapping(first + bit);
+          sintax_consider(best, tophit_count, count, seqno,
+                          static_cast<unsigned int>(searchinfo->db->getsequencelen(seqno)),
+                          rng, parameters);
+        }
     }
 
   minheap_clear(searchinfo->m);
@@ -441,10 +714,22 @@ static auto sintax_query(struct sintax_state_s & state, uint64_t const t) -> voi
 
       if (kmersamplecount >= subset_size)
         {
+          /* gather the bitsets of the query k-mers once, unless the
+             counts of the sequences could overflow */
+          auto & kmer_sets = state.kmer_sets[t];
+          auto const is_sparse = kmersamplecount <= std::numeric_limits<count_t>::max();
+          if (is_sparse)
+            {
+              si->kmersamplecount = kmersamplecount;
+              si->kmersample = kmersample;
+              sintax_gather_kmer_sets(kmer_sets, si, not state.parameters.opt_sintax_random);
+            }
+
           for (auto i = 0; i < bootstrap_count ; i++)
             {
               /* subsample 32 kmers */
               std::array<unsigned int, subset_size> kmersample_subset {{}};
+              std::array<unsigned int, subset_size> subset {{}};
               auto subsamples = 0;
               bitmap_reset_all(b);
               for (auto j = 0; j < subset_size ; j++)
@@ -452,15 +737,24 @@ static auto sintax_query(struct sintax_state_s & state, uint64_t const t) -> voi
                   int64_t const x = static_cast<int64_t>(random_bounded(rng, kmersamplecount));
                   if (bitmap_get(b, static_cast<unsigned int>(x)) == 0U)
                     {
+                      subset[static_cast<std::size_t>(subsamples)] = static_cast<unsigned int>(x);
                       kmersample_subset[static_cast<std::size_t>(subsamples++)] = kmersample[x];
                       bitmap_set(b, static_cast<unsigned int>(x));
                     }
                 }
 
-              si->kmersamplecount = static_cast<unsigned int>(subsamples);
-              si->kmersample = kmersample_subset.data();
-
-              sintax_search_topscores(si, rng, state.parameters);
+              if (is_sparse)
+                {
+                  sintax_sparse_topscores(kmer_sets, subset.data(),
+                                          static_cast<unsigned int>(subsamples),
+                                          si, rng, state.parameters);
+                }
+              else
+                {
+                  si->kmersamplecount = static_cast<unsigned int>(subsamples);
+                  si->kmersample = kmersample_subset.data();
+                  sintax_search_topscores(si, rng, state.parameters);
+                }
 
               if (! minheap_isempty(si->m))
                 {
@@ -647,6 +941,7 @@ static auto sintax_thread_worker_run(struct sintax_state_s & state) -> void
   struct searchinfo_s * const si_minus = state.si_minus;
 
   /* init per-thread search state before the workers start */
+  state.kmer_sets.resize(static_cast<std::size_t>(state.parameters.opt_threads));
   for (auto t = 0; t < state.parameters.opt_threads; t++)
     {
       sintax_thread_init(state, si_plus + t);
@@ -718,6 +1013,10 @@ auto sintax(struct Parameters const & parameters) -> void
     }
 
   seqcount = static_cast<int>(state.db.getsequencecount());
+  if (not udb_read_taxonomy(state.dbindex, state.db, state.taxonomy))
+    {
+      state.taxonomy.parse(state.db);
+    }
 
   if (! is_udb)
     {
@@ -725,6 +1024,11 @@ auto sintax(struct Parameters const & parameters) -> void
       state.dbindex.add_all_sequences(parameters.opt_dbmask, state.db, parameters);
     }
 
+  if (parameters.opt_pack_index)
+    {
+      state.dbindex.pack();
+    }
+
   /* prepare reading of queries */
 
   query_fastx_h = fastx_open(parameters.opt_sintax, parameters);
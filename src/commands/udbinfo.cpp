@@ -60,6 +60,7 @@
 
 #include "vsearch.h"
 #include "commands/udbinfo.hpp"
+#include "core/udb.hpp"
 #include "utils/fatal.hpp"
 #include <array>
 #include <cstdint>  // uint64_t
@@ -105,7 +106,7 @@ auto udbinfo(struct Parameters const & parameters) -> void
       fatal("Unable to read from UDB file or invalid UDB file");
     }
 
-  if ((buffer[0]  != 0x55444246) or
+  if (((buffer[0] != udb_signature) and (buffer[0] != udb2_signature)) or
       (buffer[2] != 32) or
       (buffer[4] < 3) or
       (buffer[4] > 15) or
@@ -196,10 +196,21 @@ auto udbstats(struct Parameters const & parameters) -> void
 
           std::fprintf(parameters.fp_log, " ");
 
+          auto const kmer = freqtable[dbindex.hashsize - 1 - i].kmer;
+          auto const * packed = dbindex.is_packed() ? dbindex.getpackedlist(kmer) : nullptr;
+          auto const * list = dbindex.is_packed() ? nullptr : dbindex.getmatchlist(kmer);
+          auto seqno = 0U;
           for (auto j = 0U; j < freqtable[dbindex.hashsize - 1 - i].count; j++)
             {
-              std::fprintf(parameters.fp_log,
-                      " %u", dbindex.kmerindex[dbindex.kmerhash[freqtable[dbindex.hashsize - 1 - i].kmer] + j]);
+              if (packed != nullptr)
+                {
+                  seqno += unpack_gap(packed);
+                }
+              else
+                {
+                  seqno = list[j];
+                }
+              std::fprintf(parameters.fp_log, " %u", seqno);
 
               if (j == 7)
                 {
@@ -66,31 +66,406 @@
 #include "core/dbindex.hpp"
 #include "core/mask.hpp"
 #include "core/otutable.hpp"
+#include "core/tax.hpp"
 #include "core/udb.hpp"
 #include "utils/fatal.hpp"
 #include "utils/maps.hpp"
 #include "utils/number_of_strands.hpp"
+#include "core/block_compress.hpp"  // compress_output
 #include "utils/open_file.hpp"
+#include "utils/output_buffer.hpp"
 #include "utils/threads.hpp"
-#include "utils/worker_loop.hpp"
 #include <algorithm>  // std::min
+#include <array>
 #include <cinttypes>  // macros PRIu64 and PRId64
+#include <condition_variable>  // std::condition_variable
+#include <cstddef>  // std::size_t
 #include <cstdint>  // uint64_t, int64_t
 #include <cstdio>  // std::FILE, std::fprintf
-#include <cstring>  // std::memset
-#include <mutex>  // std::mutex, std::lock_guard
+#include <cstring>  // std::memset, std::strlen
+#include <functional>  // std::function
+#include <map>
+#include <memory>  // std::unique_ptr
+#include <mutex>  // std::mutex, std::lock_guard, std::unique_lock
+#include <utility>  // std::move
 #include <vector>
 
 
+// anonymous namespace: limit visibility and usage to this translation unit
+namespace {
+
+  /* The queries are parsed ahead of the search threads, by a reader
+     thread, into a small ring of query batches. A search thread claims
+     up to search_queries_per_batch queries at a time from the oldest
+     batch, copies them (populate_si) and releases them; a batch is
+     refilled once all of its queries are released. Decompression and
+     parsing thus stay out of the search threads' critical section, and
+     memory is bounded by the ring. With a single search thread, that
+     thread fills the batches itself when it runs out of queries.
+
+     A parse error ends the input like an end of file; it is reported by
+     the main thread after the search threads are joined (deferred). */
+
+  constexpr auto query_batch_count = std::size_t{4};
+  constexpr auto query_batch_queries = std::size_t{1024};
+  constexpr auto query_batch_bytes = std::size_t{1} << 20U;
+
+  struct query_record
+  {
+    std::size_t header = 0;  // offsets into the batch text
+    std::size_t seq = 0;
+    int headerlen = 0;
+    int seqlen = 0;
+    int seqno = 0;
+    int64_t abundance = 0;
+    uint64_t position = 0;  // in the input file, for the progress bar
+  };
+
+  struct query_batch
+  {
+    std::vector<char> text;
+    std::vector<struct query_record> queries;
+    std::size_t claimed = 0;
+    std::size_t released = 0;
+  };
+
+  struct query_claim
+  {
+    std::size_t slot = 0;
+    std::size_t first = 0;
+    std::size_t count = 0;
+    uint64_t ordinal = 0;  // of the first claimed query in the input
+  };
+
+
+  class Query_reader
+  {
+  public:
+    Query_reader(fastx_handle input_handle, bool const truncate_labels,
+                 bool const own_thread) :
+      input_handle_(input_handle),
+      truncate_labels_(truncate_labels),
+      own_thread_(own_thread) {}
+
+    /* body of the reader thread: fill batches up to the end of the input */
+    auto run() -> void {
+      while (fill_batch()) {}
+    }
+
+    /* claim up to max_count queries; a count of zero at the end */
+    auto claim(std::size_t const max_count) -> struct query_claim {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (true)
+        {
+          if (claiming_ < filled_)
+            {
+              struct query_claim claim;
+              claim.slot = claiming_ % batches_.size();
+              auto & batch = batches_[claim.slot];
+              claim.first = batch.claimed;
+              claim.count = std::min(max_count, batch.queries.size() - batch.claimed);
+              batch.claimed += claim.count;
+              claim.ordinal = claimed_queries_;
+              claimed_queries_ += claim.count;
+              if (batch.claimed == batch.queries.size())
+                {
+                  ++claiming_;
+                }
+              return claim;
+            }
+          if (finished_)
+            {
+              return query_claim{};
+            }
+          if (own_thread_)
+            {
+              cond_.wait(lock);
+            }
+          else
+            {
+              lock.unlock();
+              fill_batch();
+              lock.lock();
+            }
+        }
+    }
+
+    /* the claimed queries, valid until released */
+    auto batch(struct query_claim const & claim) const -> struct query_batch const & {
+      return batches_[claim.slot];
+    }
+
+    auto release(struct query_claim const & claim) -> void {
+      auto emptied = false;
+      {
+        std::lock_guard<std::mutex> const lock(mutex_);
+        batches_[claim.slot].released += claim.count;
+        while (emptied_ < claiming_)
+          {
+            auto & batch = batches_[emptied_ % batches_.size()];
+            if (batch.released != batch.queries.size())
+              {
+                break;
+              }
+            batch.claimed = 0;
+            batch.released = 0;
+            ++emptied_;
+            emptied = true;
+          }
+      }
+      if (emptied)
+        {
+          cond_.notify_all();
+        }
+    }
+
+  private:
+    /* parse the next queries into a free batch; false at the end */
+    auto fill_batch() -> bool {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [this]() -> bool { return filled_ - emptied_ < batches_.size(); });
+      }
+
+      /* the free batch is only accessed by this thread until it is filled */
+      auto & batch = batches_[filled_ % batches_.size()];
+      batch.text.clear();
+      batch.queries.clear();
+      auto more = true;
+      while ((batch.queries.size() < query_batch_queries) and
+             (batch.text.size() < query_batch_bytes))
+        {
+          if (not fastx_next(input_handle_, truncate_labels_, chrmap_no_change()))
+            {
+              more = false;
+              break;
+            }
+          struct query_record query;
+          query.headerlen = static_cast<int>(fastx_get_header_length(input_handle_));
+          query.seqlen = static_cast<int>(fastx_get_sequence_length(input_handle_));
+          query.seqno = static_cast<int>(fastx_get_seqno(input_handle_));
+          query.abundance = fastx_get_abundance(input_handle_);
+          query.position = fastx_get_position(input_handle_);
+          query.header = append(batch.text, fastx_get_header(input_handle_),
+                                static_cast<std::size_t>(query.headerlen));
+          query.seq = append(batch.text, fastx_get_sequence(input_handle_),
+                             static_cast<std::size_t>(query.seqlen));
+          batch.queries.push_back(query);
+        }
+
+      {
+        std::lock_guard<std::mutex> const lock(mutex_);
+        if (not batch.queries.empty())
+          {
+            ++filled_;
+          }
+        finished_ = not more;
+      }
+      cond_.notify_all();
+      return more;
+    }
+
+    static auto append(std::vector<char> & text, char const * chars,
+                       std::size_t const length) -> std::size_t {
+      auto const offset = text.size();
+      text.insert(text.end(), chars, chars + length);
+      text.push_back('\0');
+      return offset;
+    }
+
+    fastx_handle input_handle_;
+    bool truncate_labels_;
+    bool own_thread_;
+    std::array<struct query_batch, query_batch_count> batches_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::size_t filled_ = 0;    // batches filled so far
+    std::size_t claiming_ = 0;  // batches entirely claimed so far
+    std::size_t emptied_ = 0;   // batches entirely released so far
+    uint64_t claimed_queries_ = 0;
+    bool finished_ = false;
+  };
+
+
+  /* The search threads format their results without a lock, into one
+     chunk of text per claim of consecutive queries, and a writer thread
+     writes the chunks in query order. The output is therefore the same
+     whatever the number of threads. A chunk ahead of the next one to be
+     written by more than result_window_queries queries per search thread
+     waits, so that a slow query does not let the pending output grow
+     without bounds. With a single search thread, the chunks are written
+     by that thread.
+
+     Queries written with --matched or --notmatched are numbered in query
+     order (--relabel), so they are stored in the chunk as they are and
+     formatted by the writer. */
+
+  constexpr auto result_window_queries = uint64_t{512};
+
+  struct result_segment
+  {
+    std::FILE * output_handle = nullptr;  // nullptr for a --(not)matched query
+    std::size_t end = 0;  // of the segment in the chunk text
+    /* a --(not)matched query: its header and sequence, each followed
+       by a null character, are the text of the segment */
+    bool matched = false;
+    int header_length = 0;
+    int seqlen = 0;
+    int64_t qsize = 0;
+  };
+
+  struct result_chunk
+  {
+    uint64_t first = 0;  // ordinal of the first query
+    uint64_t count = 0;
+    Output_buffer text;
+    std::vector<struct result_segment> segments;
+
+    /* the text appended since the previous segment goes to output_handle */
+    auto add_segment(std::FILE * output_handle) -> void {
+      auto const begin = segments.empty() ? std::size_t{0} : segments.back().end;
+      if (text.size() == begin)
+        {
+          return;
+        }
+      if ((not segments.empty()) and (segments.back().output_handle == output_handle))
+        {
+          segments.back().end = text.size();
+          return;
+        }
+      struct result_segment segment;
+      segment.output_handle = output_handle;
+      segment.end = text.size();
+      segments.push_back(segment);
+    }
+
+    auto add_query(bool const matched, char const * header, int const header_length,
+                   char const * sequence, int const seqlen, int64_t const qsize) -> void {
+      text.append(header, static_cast<std::size_t>(header_length));
+      text.append('\0');
+      text.append(sequence, static_cast<std::size_t>(seqlen));
+      text.append('\0');
+      struct result_segment segment;
+      segment.end = text.size();
+      segment.matched = matched;
+      segment.header_length = header_length;
+      segment.seqlen = seqlen;
+      segment.qsize = qsize;
+      segments.push_back(segment);
+    }
+
+    auto clear() -> void {
+      text.clear();
+      segments.clear();
+    }
+  };
+
+
+  class Result_writer
+  {
+  public:
+    using Write_function = std::function<void(struct result_chunk const &)>;
+
+    Result_writer(std::size_t const workers, bool const own_thread,
+                  Write_function write_chunk) :
+      write_chunk_(std::move(write_chunk)),
+      window_(result_window_queries * workers),
+      active_(workers),
+      own_thread_(own_thread) {}
+
+    /* an empty chunk, recycled when possible */
+    auto acquire() -> std::unique_ptr<struct result_chunk> {
+      std::lock_guard<std::mutex> const lock(mutex_);
+      if (free_.empty())
+        {
+          return std::unique_ptr<struct result_chunk>(new result_chunk);
+        }
+      auto chunk = std::move(free_.back());
+      free_.pop_back();
+      return chunk;
+    }
+
+    auto submit(std::unique_ptr<struct result_chunk> chunk) -> void {
+      if (not own_thread_)
+        {
+          /* the only search thread: its chunks come in query order */
+          write_chunk_(*chunk);
+          recycle(std::move(chunk));
+          return;
+        }
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto const first = chunk->first;
+        cond_.wait(lock, [this, first]() -> bool { return first < next_ + window_; });
+        pending_[first] = std::move(chunk);
+      }
+      cond_.notify_all();
+    }
+
+    /* called by each search thread once it has submitted its last chunk */
+    auto worker_done() -> void {
+      {
+        std::lock_guard<std::mutex> const lock(mutex_);
+        --active_;
+      }
+      cond_.notify_all();
+    }
+
+    /* body of the writer thread */
+    auto run() -> void {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (true)
+        {
+          cond_.wait(lock, [this]() -> bool {
+            return (pending_.count(next_) != 0) or (active_ == 0);
+          });
+          auto const next = pending_.find(next_);
+          if (next == pending_.end())
+            {
+              return;  // all search threads are done, and all chunks written
+            }
+          auto chunk = std::move(next->second);
+          pending_.erase(next);
+          lock.unlock();
+          write_chunk_(*chunk);
+          lock.lock();
+          next_ += chunk->count;
+          chunk->clear();
+          free_.push_back(std::move(chunk));
+          cond_.notify_all();
+        }
+    }
+
+  private:
+    auto recycle(std::unique_ptr<struct result_chunk> chunk) -> void {
+      chunk->clear();
+      std::lock_guard<std::mutex> const lock(mutex_);
+      free_.push_back(std::move(chunk));
+    }
+
+    Write_function write_chunk_;
+    uint64_t window_;
+    std::size_t active_;  // search threads still running
+    bool own_thread_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::map<uint64_t, std::unique_ptr<struct result_chunk>> pending_;  // by first query
+    std::vector<std::unique_ptr<struct result_chunk>> free_;
+    uint64_t next_ = 0;  // ordinal of the next query to write
+  };
+
+}  // end of anonymous namespace
+
+
 /* Per-invocation state for a usearch_global run — previously the file-static
-   globals below: the per-thread searchinfo arrays, the query file handle, the
-   two mutexes, the match/abundance counters, the per-db-sequence match tally
-   and the sixteen output handles. Folding them into a struct that
+   globals below: the per-thread searchinfo arrays, the query file handle and
+   reader, the output mutex, the match/abundance counters, the per-db-sequence
+   match tally and the sixteen output handles. Folding them into a struct that
    usearch_global() owns and threads through the output helper and the
    streaming worker pool makes the command reentrant and removes the shared
    mutable state (E4). The library session/batch paths own their own searchinfo
    arrays and return results rather than writing files, so they do not use this
-   struct; the shared per-thread sizes (seqcount/tophits) are passed to
+   struct; the shared per-thread size (tophits) is passed to
    search_thread_init as parameters instead. */
 struct search_cli_state_s
 {
@@ -106,20 +481,22 @@ struct search_cli_state_s
   struct Parameters effective_parameters;
   struct Database db;  /* the sequence database this run owns (RAII); si->db points here */
   struct Dbindex dbindex;  /* the k-mer index this run owns (RAII); si->dbindex points here */
+  Taxonomy taxonomy;  /* the parsed tax= annotations of db, for --lcaout */
   int tophits = 0;   /* the maximum number of hits to keep */
   int seqcount = 0;  /* number of database sequences */
   struct searchinfo_s * si_plus = nullptr;
   struct searchinfo_s * si_minus = nullptr;
   fastx_handle query_fastx_h = nullptr;
-  std::mutex mutex_input;   /* serializes query reads */
-  std::mutex mutex_output;  /* serializes output + counter updates */
+  Query_reader * query_reader = nullptr;  /* parses the queries ahead of the workers */
+  Result_writer * result_writer = nullptr;  /* writes the workers' output in query order */
+  std::mutex mutex_output;  /* serializes counter and OTU table updates */
   int qmatches = 0;
   uint64_t qmatches_abundance = 0;
   int queries = 0;
   uint64_t queries_abundance = 0;
   uint64_t * dbmatched = nullptr;
-  /* RAII output handles; the workers read the raw FILE * via .get() under
-     mutex_output. Closed explicitly with reset() in a fixed order (see
+  /* RAII output handles; the workers record the raw FILE * via .get() with
+     their formatted output, and the result writer writes to them. Closed explicitly with reset() in a fixed order (see
      search_done and the OTU/db blocks in usearch_global) so streams sharing
      stdout flush in the legacy order rather than the reverse order a struct
      destructor would use. */
@@ -139,7 +516,7 @@ struct search_cli_state_s
   OutputFileHandle fp_lcaout;
   OutputFileHandle fp_qsegout;
   OutputFileHandle fp_tsegout;
-  int count_matched = 0;
+  int count_matched = 0;  /* numbering of --matched, by the result writer */
   int count_notmatched = 0;
   Progress * progress = nullptr;  /* the owner's progress bar; worker updates it under mutex_output */
 
@@ -148,6 +525,7 @@ struct search_cli_state_s
 
 
 static auto search_output_results(struct search_cli_state_s & state,
+                           struct result_chunk & chunk,
                            std::vector<struct hit> const & hits,
                            char const * query_head,
                            int qseqlen,
@@ -155,14 +533,13 @@ static auto search_output_results(struct search_cli_state_s & state,
                            char const * qsequence_rc,
                            int64_t qsize) -> void
 {
-  std::lock_guard<std::mutex> const lock(state.mutex_output);
-
-  /* show results */
+  /* format the results into the chunk, without a lock */
+  auto & output = chunk.text;
   auto const toreport = std::min(state.parameters.opt_maxhits, static_cast<int64_t>(hits.size()));
 
   if (state.fp_alnout != nullptr)
     {
-      results_show_alnout(state.fp_alnout.get(),
+      results_show_alnout(output,
                           hits.data(),
                           static_cast<int>(toreport),
                           query_head,
@@ -170,21 +547,23 @@ static auto search_output_results(struct search_cli_state_s & state,
                           qseqlen,
                           state.db,
                           state.parameters);
+      chunk.add_segment(state.fp_alnout.get());
     }
 
   if (state.fp_lcaout != nullptr)
     {
-      results_show_lcaout(state.fp_lcaout.get(),
+      results_show_lcaout(output,
                           hits.data(),
                           static_cast<int>(toreport),
                           query_head,
-                          state.db,
+                          state.taxonomy,
                           state.parameters);
+      chunk.add_segment(state.fp_lcaout.get());
     }
 
   if (state.fp_samout != nullptr)
     {
-      results_show_samout(state.fp_samout.get(),
+      results_show_samout(output,
                           hits.data(),
                           static_cast<int>(toreport),
                           query_head,
@@ -192,19 +571,13 @@ static auto search_output_results(struct search_cli_state_s & state,
                           qsequence_rc,
                           state.db,
                           state.parameters);
+      chunk.add_segment(state.fp_samout.get());
     }
 
   if (toreport != 0)  // hits.size() >=1 and <= opt_maxhits
     {
       double const top_hit_id = hits[0].id;
 
-      if ((state.parameters.opt_otutabout != nullptr) || (state.parameters.opt_mothur_shared_out != nullptr) || (state.parameters.opt_biomout != nullptr))
-        {
-          otutable_add(query_head,
-                       state.db.getheader(static_cast<uint64_t>(hits[0].target)),
-                       qsize);
-        }
-
       for (int64_t t = 0; t < toreport; t++)
         {
           auto const * hp = &hits[static_cast<std::size_t>(t)];
@@ -216,51 +589,55 @@ static auto search_output_results(struct search_cli_state_s & state,
 
           if (state.fp_fastapairs != nullptr)
             {
-              results_show_fastapairs_one(state.fp_fastapairs.get(),
+              results_show_fastapairs_one(output,
                                           hp,
                                           query_head,
                                           qsequence,
                                           qsequence_rc,
                                           state.db,
                                           state.parameters);
+              chunk.add_segment(state.fp_fastapairs.get());
             }
 
           if (state.fp_qsegout != nullptr)
             {
-              results_show_qsegout_one(state.fp_qsegout.get(),
+              results_show_qsegout_one(output,
                                        hp,
                                        query_head,
                                        qsequence,
                                        qseqlen,
                                        qsequence_rc,
                                        state.parameters);
+              chunk.add_segment(state.fp_qsegout.get());
             }
 
           if (state.fp_tsegout != nullptr)
             {
-              results_show_tsegout_one(state.fp_tsegout.get(),
+              results_show_tsegout_one(output,
                                        hp,
                                        state.db,
                                        state.parameters);
+              chunk.add_segment(state.fp_tsegout.get());
             }
 
           if (state.fp_uc != nullptr)
             {
               if ((t==0) || (state.parameters.opt_uc_allhits))
                 {
-                  results_show_uc_one(state.fp_uc.get(),
+                  results_show_uc_one(output,
                                       hp,
                                       query_head,
                                       qseqlen,
                                       hp->target,
                                       state.db,
                                       state.parameters);
+                  chunk.add_segment(state.fp_uc.get());
                 }
             }
 
           if (state.fp_userout != nullptr)
             {
-              results_show_userout_one(state.fp_userout.get(),
+              results_show_userout_one(output,
                                        hp,
                                        query_head,
                                        qsequence,
@@ -268,43 +645,39 @@ static auto search_output_results(struct search_cli_state_s & state,
                                        qsequence_rc,
                                        state.db,
                                        state.parameters);
+              chunk.add_segment(state.fp_userout.get());
             }
 
           if (state.fp_blast6out != nullptr)
             {
-              results_show_blast6out_one(state.fp_blast6out.get(),
+              results_show_blast6out_one(output,
                                          hp,
                                          query_head,
                                          qseqlen,
                                          state.db);
+              chunk.add_segment(state.fp_blast6out.get());
             }
         }
     }
   else
     {
-      if ((state.parameters.opt_otutabout != nullptr) || (state.parameters.opt_mothur_shared_out != nullptr) || (state.parameters.opt_biomout != nullptr))
-        {
-          otutable_add(query_head,
-                       nullptr,
-                       qsize);
-        }
-
       if (state.fp_uc != nullptr)
         {
-          results_show_uc_one(state.fp_uc.get(),
+          results_show_uc_one(output,
                               nullptr,
                               query_head,
                               qseqlen,
                               0,
                               state.db,
                               state.parameters);
+          chunk.add_segment(state.fp_uc.get());
         }
 
       if (state.parameters.opt_output_no_hits != 0)
         {
           if (state.fp_userout != nullptr)
             {
-              results_show_userout_one(state.fp_userout.get(),
+              results_show_userout_one(output,
                                        nullptr,
                                        query_head,
                                        qsequence,
@@ -312,56 +685,41 @@ static auto search_output_results(struct search_cli_state_s & state,
                                        qsequence_rc,
                                        state.db,
                                        state.parameters);
+              chunk.add_segment(state.fp_userout.get());
             }
 
           if (state.fp_blast6out != nullptr)
             {
-              results_show_blast6out_one(state.fp_blast6out.get(),
+              results_show_blast6out_one(output,
                                          nullptr,
                                          query_head,
                                          qseqlen,
                                          state.db);
+              chunk.add_segment(state.fp_blast6out.get());
             }
         }
     }
 
-  if (not hits.empty())
+  auto const matched = not hits.empty();
+  if ((matched and (state.fp_matched != nullptr)) or
+      ((not matched) and (state.fp_notmatched != nullptr)))
     {
-      state.count_matched++;
-      if (state.parameters.opt_matched != nullptr)
-        {
-          fasta_print_general(state.fp_matched.get(),
-                              nullptr,
-                              qsequence,
-                              qseqlen,
-                              query_head,
-                              static_cast<int>(std::strlen(query_head)),
-                              static_cast<uint64_t>(qsize),
-                              state.count_matched,
-                              -1.0,
-                              -1, -1, nullptr, 0.0,
-                              0,
-                              state.parameters);
-        }
+      chunk.add_query(matched,
+                      query_head,
+                      static_cast<int>(std::strlen(query_head)),
+                      qsequence,
+                      qseqlen,
+                      qsize);
     }
-  else
+
+  /* lock mutex for update of global data */
+  std::lock_guard<std::mutex> const lock(state.mutex_output);
+
+  if ((state.parameters.opt_otutabout != nullptr) || (state.parameters.opt_mothur_shared_out != nullptr) || (state.parameters.opt_biomout != nullptr))
     {
-      state.count_notmatched++;
-      if (state.parameters.opt_notmatched != nullptr)
-        {
-          fasta_print_general(state.fp_notmatched.get(),
-                              nullptr,
-                              qsequence,
-                              qseqlen,
-                              query_head,
-                              static_cast<int>(std::strlen(query_head)),
-                              static_cast<uint64_t>(qsize),
-                              state.count_notmatched,
-                              -1.0,
-                              -1, -1, nullptr, 0.0,
-                              0,
-                              state.parameters);
-        }
+      otutable_add(query_head,
+                   (toreport != 0) ? state.db.getheader(static_cast<uint64_t>(hits[0].target)) : nullptr,
+                   qsize);
     }
 
   /* update matching db sequences */
@@ -373,42 +731,66 @@ static auto search_output_results(struct search_cli_state_s & state,
 }
 
 
-static auto search_query(struct search_cli_state_s & state, uint64_t t) -> int
+/* write a chunk of results, in the result writer */
+static auto search_write_results(struct search_cli_state_s & state,
+                                 struct result_chunk const & chunk) -> void
 {
-  struct searchinfo_s * const si_plus = state.si_plus;
-  struct searchinfo_s * const si_minus = state.si_minus;
-
-  for (int s = 0; s < number_of_strands(state.parameters.opt_strand); s++)
+  auto begin = std::size_t{0};
+  for (auto const & segment : chunk.segments)
     {
-      struct searchinfo_s * si = (s != 0) ? si_minus + t : si_plus + t;
-
-      /* mask query */
-      if (state.parameters.opt_qmask == Masking::dust)
+      if (segment.output_handle != nullptr)
         {
-          dust(si->qsequence, si->qseqlen, state.parameters);
+          chunk.text.write(segment.output_handle, begin, segment.end);
         }
-      else if ((state.parameters.opt_qmask == Masking::soft) && (state.parameters.opt_hardmask))
+      else
         {
-          hardmask(si->qsequence, si->qseqlen);
+          auto const * query_head = chunk.text.data() + begin;
+          auto const * qsequence = query_head + segment.header_length + 1;
+          auto & count = segment.matched ? state.count_matched : state.count_notmatched;
+          ++count;
+          fasta_print_general(segment.matched ? state.fp_matched.get() : state.fp_notmatched.get(),
+                              nullptr,
+                              qsequence,
+                              segment.seqlen,
+                              query_head,
+                              segment.header_length,
+                              static_cast<uint64_t>(segment.qsize),
+                              count,
+                              -1.0,
+                              -1, -1, nullptr, 0.0,
+                              0,
+                              state.parameters);
         }
+      begin = segment.end;
+    }
+}
+
 
-      /* perform search */
-      search_onequery(si, state.parameters.opt_qmask);
+static auto search_query(struct search_cli_state_s & state,
+                         struct result_chunk & chunk,
+                         struct searchinfo_s * si_plus,
+                         struct searchinfo_s * si_minus) -> int
+{
+  /* the candidates were found by search_find_candidates */
+  for (int s = 0; s < number_of_strands(state.parameters.opt_strand); s++)
+    {
+      search_align_candidates((s != 0) ? si_minus : si_plus);
     }
 
   std::vector<struct hit> hits;
 
-  search_joinhits(si_plus + t,
-                  state.parameters.opt_strand ? si_minus + t : nullptr,
+  search_joinhits(si_plus,
+                  state.parameters.opt_strand ? si_minus : nullptr,
                   hits);
 
   search_output_results(state,
+                        chunk,
                         hits,
-                        si_plus[t].query_head,
-                        si_plus[t].qseqlen,
-                        si_plus[t].qsequence,
-                        state.parameters.opt_strand ? si_minus[t].qsequence : nullptr,
-                        si_plus[t].qsize);
+                        si_plus->query_head,
+                        si_plus->qseqlen,
+                        si_plus->qsequence,
+                        state.parameters.opt_strand ? si_minus->qsequence : nullptr,
+                        si_plus->qsize);
 
   /* free memory for alignment strings */
   for (auto const & hit : hits) {
@@ -423,77 +805,95 @@ static auto search_query(struct search_cli_state_s & state, uint64_t t) -> int
 
 static auto search_thread_run(struct search_cli_state_s & state, uint64_t t) -> void
 {
-  auto const query_fastx_h = state.query_fastx_h;
-  struct searchinfo_s * const si_plus = state.si_plus;
-
-  int query_head_len = 0;
-  int qseqlen = 0;
-  int query_no = 0;
-  int64_t qsize = 0;
-  uint64_t progress = 0;
-
-  auto const has_work_to_claim = [&]() -> bool {
-    if (not fastx_next(query_fastx_h,
-                       (not state.parameters.opt_notrunclabels),
-                       chrmap_no_change()))
+  auto & query_reader = *state.query_reader;
+  auto & result_writer = *state.result_writer;
+
+  /* search_queries_per_batch searchinfo slots per thread and strand */
+  struct searchinfo_s * const si_plus = state.si_plus + (t * search_queries_per_batch);
+  struct searchinfo_s * const si_minus =
+    (state.si_minus != nullptr) ? state.si_minus + (t * search_queries_per_batch) : nullptr;
+
+  int claimed = 0;
+  uint64_t first_claimed = 0;  // ordinal of the first claimed query
+  std::array<uint64_t, search_queries_per_batch> progress {{}};
+
+  auto const claim_queries = [&]() -> bool {
+    auto const claim = query_reader.claim(search_queries_per_batch);
+    first_claimed = claim.ordinal;
+    auto const & batch = query_reader.batch(claim);
+    auto const * text = batch.text.data();
+    for (claimed = 0; claimed < static_cast<int>(claim.count); claimed++)
       {
-        return false;
+        auto const & query = batch.queries[claim.first + static_cast<std::size_t>(claimed)];
+        populate_si(si_plus + claimed,
+                    text + query.header,
+                    query.headerlen,
+                    text + query.seq,
+                    query.seqlen,
+                    query.seqno,
+                    query.abundance,
+                    0);
+
+        /* get progress as amount of input file read */
+        progress[static_cast<std::size_t>(claimed)] = query.position;
       }
-
-    char const * qhead = fastx_get_header(query_fastx_h);
-    query_head_len = static_cast<int>(fastx_get_header_length(query_fastx_h));
-    char const * qseq = fastx_get_sequence(query_fastx_h);
-    qseqlen = static_cast<int>(fastx_get_sequence_length(query_fastx_h));
-    query_no = static_cast<int>(fastx_get_seqno(query_fastx_h));
-    qsize = fastx_get_abundance(query_fastx_h);
-
-    populate_si(si_plus + t,
-                qhead,
-                query_head_len,
-                qseq,
-                qseqlen,
-                query_no,
-                qsize,
-                0);
-
-    /* get progress as amount of input file read */
-    progress = fastx_get_position(query_fastx_h);
-    return true;
+    query_reader.release(claim);
+    return claimed > 0;
   };
 
-  auto const process_query = [&]() {
+  auto const process_queries = [&]() {
     if (state.parameters.opt_strand)
       {
-        populate_si(state.si_minus + t,
-                    si_plus[t].query_head,
-                    query_head_len,
-                    si_plus[t].qsequence,
-                    qseqlen,
-                    query_no,
-                    qsize,
-                    1);
+        for (int j = 0; j < claimed; j++)
+          {
+            populate_si(si_minus + j,
+                        si_plus[j].query_head,
+                        si_plus[j].query_head_len,
+                        si_plus[j].qsequence,
+                        si_plus[j].qseqlen,
+                        si_plus[j].query_no,
+                        si_plus[j].qsize,
+                        1);
+          }
       }
 
-    int const match = search_query(state, t);
-
-    /* lock mutex for update of global data and output */
-    std::lock_guard<std::mutex> const output_lock(state.mutex_output);
+    search_find_candidates(si_plus, si_minus, claimed, state.parameters);
 
-    /* update stats */
-    ++state.queries;
-    state.queries_abundance += static_cast<uint64_t>(qsize);
+    auto chunk = result_writer.acquire();
+    chunk->first = first_claimed;
+    chunk->count = static_cast<uint64_t>(claimed);
 
-    if (match != 0)
+    for (int j = 0; j < claimed; j++)
       {
-        ++state.qmatches;
-        state.qmatches_abundance += static_cast<uint64_t>(qsize);
+        int const match = search_query(state, *chunk, si_plus + j,
+                                       (si_minus != nullptr) ? si_minus + j : nullptr);
+        auto const qsize = si_plus[j].qsize;
+
+        /* lock mutex for update of global data */
+        std::lock_guard<std::mutex> const output_lock(state.mutex_output);
+
+        /* update stats */
+        ++state.queries;
+        state.queries_abundance += static_cast<uint64_t>(qsize);
+
+        if (match != 0)
+          {
+            ++state.qmatches;
+            state.qmatches_abundance += static_cast<uint64_t>(qsize);
+          }
+
+        /* show progress */
+        state.progress->update(progress[static_cast<std::size_t>(j)]);
       }
 
-    /* show progress */
-    state.progress->update(progress);
+    result_writer.submit(std::move(chunk));
   };
 
-  run_worker_loop(state.mutex_input, has_work_to_claim, process_query);
+  while (claim_queries())
+    {
+      process_queries();
+    }
+  result_writer.worker_done();
 }
 
 
@@ -501,29 +901,57 @@ static auto search_thread_worker_run(struct search_cli_state_s & state) -> void
 {
   struct searchinfo_s * const si_plus = state.si_plus;
   struct searchinfo_s * const si_minus = state.si_minus;
-  int const seqcount = state.seqcount;
   int const tophits = state.tophits;
 
+  int const slots = static_cast<int>(state.parameters.opt_threads) * search_queries_per_batch;
+
   /* init per-thread search state before the workers start */
-  for (int t = 0; t < state.parameters.opt_threads; t++)
+  for (int t = 0; t < slots; t++)
     {
-      search_thread_init(si_plus + t, seqcount, tophits, state.effective_parameters, state.dbindex, state.db);
+      search_thread_init(si_plus + t, tophits, state.effective_parameters, state.dbindex, state.db);
       if (si_minus != nullptr)
         {
-          search_thread_init(si_minus + t, seqcount, tophits, state.effective_parameters, state.dbindex, state.db);
+          search_thread_init(si_minus + t, tophits, state.effective_parameters, state.dbindex, state.db);
         }
     }
 
-  /* run the worker pool over the input file */
+  /* run the worker pool over the input file, plus a reader and a
+     writer thread if there are several workers */
   {
-    ThreadRunner threadrunner(static_cast<std::size_t>(state.parameters.opt_threads),
-                              [&state](uint64_t const t)
-                              { search_thread_run(state, t); });
+    auto const workers = static_cast<uint64_t>(state.parameters.opt_threads);
+    auto const own_threads = workers > 1;
+    Query_reader query_reader(state.query_fastx_h,
+                              not state.parameters.opt_notrunclabels,
+                              own_threads);
+    Result_writer result_writer(static_cast<std::size_t>(workers),
+                                own_threads,
+                                [&state](struct result_chunk const & chunk)
+                                { search_write_results(state, chunk); });
+    state.query_reader = &query_reader;
+    state.result_writer = &result_writer;
+    ThreadRunner threadrunner(static_cast<std::size_t>(workers + (own_threads ? 2 : 0)),
+                              [&state, &query_reader, &result_writer, workers](uint64_t const t)
+                              {
+                                if (t == workers)
+                                  {
+                                    query_reader.run();
+                                  }
+                                else if (t == workers + 1)
+                                  {
+                                    result_writer.run();
+                                  }
+                                else
+                                  {
+                                    search_thread_run(state, t);
+                                  }
+                              });
     threadrunner.run();
+    state.query_reader = nullptr;
+    state.result_writer = nullptr;
   }
 
   /* clean up per-thread search state */
-  for (int t = 0; t < state.parameters.opt_threads; t++)
+  for (int t = 0; t < slots; t++)
     {
       search_thread_exit(si_plus + t);
       if (si_minus != nullptr)
@@ -549,12 +977,12 @@ static auto search_prep(struct search_cli_state_s & state) -> void
   state.fp_samout = open_optional_output_file(state.parameters.opt_samout, OutputOption{"--samout"});
   state.fp_userout = open_optional_output_file(state.parameters.opt_userout, OutputOption{"--userout"});
   state.fp_blast6out = open_optional_output_file(state.parameters.opt_blast6out, OutputOption{"--blast6out"});
-  state.fp_uc = open_optional_output_file(state.parameters.opt_uc, OutputOption{"--uc"});
-  state.fp_fastapairs = open_optional_output_file(state.parameters.opt_fastapairs, OutputOption{"--fastapairs"});
-  state.fp_qsegout = open_optional_output_file(state.parameters.opt_qsegout, OutputOption{"--qsegout"});
-  state.fp_tsegout = open_optional_output_file(state.parameters.opt_tsegout, OutputOption{"--tsegout"});
-  state.fp_matched = open_optional_output_file(state.parameters.opt_matched, OutputOption{"--matched"});
-  state.fp_notmatched = open_optional_output_file(state.parameters.opt_notmatched, OutputOption{"--notmatched"});
+  state.fp_uc = compress_output(open_optional_output_file(state.parameters.opt_uc, OutputOption{"--uc"}), state.parameters);
+  state.fp_fastapairs = compress_output(open_optional_output_file(state.parameters.opt_fastapairs, OutputOption{"--fastapairs"}), state.parameters);
+  state.fp_qsegout = compress_output(open_optional_output_file(state.parameters.opt_qsegout, OutputOption{"--qsegout"}), state.parameters);
+  state.fp_tsegout = compress_output(open_optional_output_file(state.parameters.opt_tsegout, OutputOption{"--tsegout"}), state.parameters);
+  state.fp_matched = compress_output(open_optional_output_file(state.parameters.opt_matched, OutputOption{"--matched"}), state.parameters);
+  state.fp_notmatched = compress_output(open_optional_output_file(state.parameters.opt_notmatched, OutputOption{"--notmatched"}), state.parameters);
   state.fp_otutabout = open_optional_output_file(state.parameters.opt_otutabout, OutputOption{"--otutabout"});
   state.fp_mothur_shared_out = open_optional_output_file(state.parameters.opt_mothur_shared_out, OutputOption{"--mothur_shared_out"});
   state.fp_biomout = open_optional_output_file(state.parameters.opt_biomout, OutputOption{"--biomout"});
@@ -588,6 +1016,17 @@ static auto search_prep(struct search_cli_state_s & state) -> void
       state.dbindex.add_all_sequences(state.parameters.opt_dbmask, state.db, state.parameters);
     }
 
+  if (state.parameters.opt_pack_index)
+    {
+      state.dbindex.pack();
+    }
+
+  if ((state.fp_lcaout != nullptr) &&
+      (not udb_read_taxonomy(state.dbindex, state.db, state.taxonomy)))
+    {
+      state.taxonomy.parse(state.db);
+    }
+
   /* tophits = the maximum number of hits we need to store */
 
   /* Clamp maxrejects/maxaccepts to the database size (0 or "> seqcount" means
@@ -659,8 +1098,8 @@ auto usearch_global(struct Parameters const & parameters) -> void
 
   search_prep(state);
 
-  fp_dbmatched = open_optional_output_file(parameters.opt_dbmatched, OutputOption{"--dbmatched"});
-  fp_dbnotmatched = open_optional_output_file(parameters.opt_dbnotmatched, OutputOption{"--dbnotmatched"});
+  fp_dbmatched = compress_output(open_optional_output_file(parameters.opt_dbmatched, OutputOption{"--dbmatched"}), parameters);
+  fp_dbnotmatched = compress_output(open_optional_output_file(parameters.opt_dbnotmatched, OutputOption{"--dbnotmatched"}), parameters);
 
   dbmatched = static_cast<uint64_t *>(xmalloc(static_cast<size_t>(seqcount) * sizeof(uint64_t)));
   std::memset(dbmatched, 0, static_cast<size_t>(seqcount) * sizeof(uint64_t));
@@ -674,17 +1113,17 @@ auto usearch_global(struct Parameters const & parameters) -> void
   queries_abundance = 0;
   query_fastx_h = fastx_open(parameters.opt_usearch_global, parameters);
 
-  /* The query file is parsed inside the worker threads (search_thread_run).
-     Defer parse errors so a malformed query stops the pool cooperatively
-     instead of calling fatal()/std::exit() from a worker while siblings are
-     writing output (CC3); reported below from the main thread after join. */
+  /* The query file is parsed by the reader thread (Query_reader). Defer
+     parse errors so a malformed query stops the pool cooperatively instead
+     of calling fatal()/std::exit() from a worker while siblings are writing
+     output (CC3); reported below from the main thread after join. */
   query_fastx_h->defer_errors = true;
 
-  /* allocate memory for thread info */
-  si_plus = new searchinfo_s[parameters.opt_threads]{};
+  /* allocate memory for thread info, search_queries_per_batch per thread */
+  si_plus = new searchinfo_s[parameters.opt_threads * search_queries_per_batch]{};
   if (parameters.opt_strand)
     {
-      si_minus = new searchinfo_s[parameters.opt_threads]{};
+      si_minus = new searchinfo_s[parameters.opt_threads * search_queries_per_batch]{};
     }
   else
     {
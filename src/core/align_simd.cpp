@@ -60,6 +60,8 @@
 
 #include "vsearch.h"
 #include "core/align_simd.hpp"
+#include "core/align_simd_internal.hpp"
+#include "arch/search16.hpp"
 #include "utils/fatal.hpp"
 #include "utils/maps.hpp"
 #include "utils/string_alloc.hpp"
@@ -82,11 +84,7 @@
   maximize score
 */
 
-constexpr auto matrix_size = 16;
 constexpr auto CHANNELS = 8;
-constexpr auto CDEPTH = 4;
-constexpr auto maxseqlenproduct = 25000000LL;
-constexpr auto maxseqlensum = 65535LL;
 
 
 // anonymous namespace: limit visibility and usage to this translation unit
@@ -97,44 +95,6 @@ namespace {
 }  // end of anonymous namespace
 
 
-/*
-  Due to memory usage, limit the product of the length of the sequences.
-  If the product of the query length and any target sequence length
-  is above the limit, the alignment will not be computed and a score
-  of SHORT_MAX (+32,767) will be returned as the score.
-  If an overflow occurs during alignment computation, a score of
-  SHORT_MAX (+32,767) will also be returned.
-
-  The limit is set to 5 000 * 5 000 = 25 000 000. This will allocate up to
-  200 MB per thread. It will align pairs of sequences less than 5000 nt long
-  using the SIMD implementation, larger alignments will be performed with
-  the linear memory aligner.
-
-  A second limit applies to the SUM of the two lengths. The per-alignment
-  statistics counters in backtrack16 (aligned/matches/mismatches/gaps) are
-  unsigned short, and the alignment path length is at most qlen + dlen, so a
-  sum above 65 535 would wrap those counters. Pairs exceeding the sum limit
-  are therefore also diverted to the linear memory aligner (whose statistics
-  are int64). Both limits are combined in search16_fits().
-*/
-
-
-// anonymous namespace: limit visibility and usage to this translation unit
-namespace {
-
-  /* Whether the SIMD aligner can represent an alignment of a query of length
-     qlen against a target of length dlen, given the product limit (DP work /
-     direction buffer memory) and the sum limit (16-bit statistics counters).
-     The sum is tested first so the product multiplication cannot overflow for
-     an accepted pair. Pairs that do not fit are aligned by linmemalign. */
-  auto search16_fits(uint64_t const qlen, uint64_t const dlen) -> bool
-  {
-    return (static_cast<int64_t>(qlen + dlen) <= maxseqlensum)
-       and (static_cast<int64_t>(qlen) * static_cast<int64_t>(dlen) <= maxseqlenproduct);
-  }
-
-}  // end of anonymous namespace
-
 /*
   The operations below usually operate on 128-bit vectors of 8 signed
   short 16-bit integers. Additions and subtractions should be
@@ -157,12 +117,6 @@ constexpr __vector unsigned char perm_merge_long_high =
   {0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
    0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f};
 
-inline auto v_init(std::array<short, CHANNELS> const & values) -> VECTOR_SHORT {
-  VECTOR_SHORT const result = {values[0], values[1], values[2], values[3],
-                               values[4], values[5], values[6], values[7]};
-  return result;
-}
-
 inline auto v_load(VECTOR_SHORT const * ptr) -> VECTOR_SHORT {
   return vec_ld(0, ptr);
 }
@@ -215,6 +169,27 @@ inline auto v_shift_left(VECTOR_SHORT operand) -> VECTOR_SHORT {
   return vec_sld(operand, v_zero(), 2);
 }
 
+/* The VSX vec_bperm instruction puts the 16 selected bits of the first
+   source into bits 48-63 of the destination. */
+
+constexpr __vector unsigned char perm  = { 120, 112, 104,  96,  88,  80,  72,  64,
+  56,  48,  40,  32,  24,  16,   8,   0 };
+
+inline auto v_mask_gt(VECTOR_SHORT lhs, VECTOR_SHORT rhs) -> unsigned short {
+  /* Build the same per-element greater-than bitmask that x86_64 and aarch64
+     obtain from movemask: compare, then gather one bit per byte with the
+     byte-permute. vec_bperm leaves the 16 gathered bits in lane 4. */
+  static constexpr unsigned int result_lane = 4U;
+  auto const comparison = (__vector unsigned char) vec_cmpgt(lhs, rhs);
+  /* Handle differences between GNU and IBM compilers */
+#ifdef __IBMCPP__
+  auto const bits = (__vector unsigned short) vec_bperm(comparison, perm);
+#else
+  auto const bits = (__vector unsigned short) vec_vbpermq(comparison, perm);
+#endif
+  return bits[result_lane];
+}
+
 #elif defined __aarch64__
 
 using VECTOR_SHORT = int16x8_t;
@@ -222,12 +197,6 @@ using VECTOR_SHORT = int16x8_t;
 constexpr uint16x8_t neon_mask =
   {0x0003, 0x000c, 0x0030, 0x00c0, 0x0300, 0x0c00, 0x3000, 0xc000};
 
-inline auto v_init(std::array<short, CHANNELS> const & values) -> VECTOR_SHORT {
-  VECTOR_SHORT const result = {values[0], values[1], values[2], values[3],
-                               values[4], values[5], values[6], values[7]};
-  return result;
-}
-
 inline auto v_load(VECTOR_SHORT const * ptr) -> VECTOR_SHORT {
   return vld1q_s16(reinterpret_cast<int16_t const *>(ptr));
 }
@@ -312,10 +281,6 @@ inline auto v_mask_gt(VECTOR_SHORT lhs, VECTOR_SHORT rhs) -> uint16_t {
 
 using VECTOR_SHORT = __m128i;
 
-inline auto v_init(std::array<short, CHANNELS> const & values) -> VECTOR_SHORT {
-  return _mm_set_epi16(values[7], values[6], values[5], values[4],
-                       values[3], values[2], values[1], values[0]);
-}
 inline auto v_load(VECTOR_SHORT const * ptr) -> VECTOR_SHORT {
   return _mm_load_si128(ptr);
 }
@@ -408,71 +373,6 @@ inline auto cast_vector16(CELL const * ptr) -> VECTOR_SHORT const * {
   return reinterpret_cast<VECTOR_SHORT const *>(ptr);
 }
 
-struct s16info_s
-{
-  std::array<VECTOR_SHORT, 32> matrix {{}};
-  VECTOR_SHORT * hearray = nullptr;
-  VECTOR_SHORT * dprofile = nullptr;
-  VECTOR_SHORT ** qtable = nullptr;
-  unsigned short * dir = nullptr;
-  char * qseq = nullptr;
-  uint64_t diralloc = 0;
-
-  char * cigar = nullptr;
-  char * cigarend = nullptr;
-  int64_t cigaralloc = 0;
-  int opcount = 0;
-  char op = '\0';
-
-  int qlen = 0;
-  int maxdlen = 0;
-  CELL penalty_gap_open_query_left = 0;
-  CELL penalty_gap_open_target_left = 0;
-  CELL penalty_gap_open_query_interior = 0;
-  CELL penalty_gap_open_target_interior = 0;
-  CELL penalty_gap_open_query_right = 0;
-  CELL penalty_gap_open_target_right = 0;
-  CELL penalty_gap_extension_query_left = 0;
-  CELL penalty_gap_extension_target_left = 0;
-  CELL penalty_gap_extension_query_interior = 0;
-  CELL penalty_gap_extension_target_interior = 0;
-  CELL penalty_gap_extension_query_right = 0;
-  CELL penalty_gap_extension_target_right = 0;
-  bool n_mismatch = false;  // treat alignment against N as a mismatch (opt_n_mismatch)
-  bool force_scalar_fallback = false;  // a score/penalty exceeded the 16-bit cell range: defer every pair to the scalar aligner
-};
-
-
-// anonymous namespace: limit visibility and usage to this translation unit
-namespace {
-
-  /* Read and write a single 16-bit channel (lane) of a SIMD vector.
-
-     The DP vectors hold CHANNELS independent alignments. Accessing a lane
-     through a reinterpreted (CELL *) pointer is a strict-aliasing violation:
-     the vector object has type VECTOR_SHORT, so reading or writing it through
-     an unrelated CELL lvalue is undefined behaviour. With GCC 9 or later at
-     -O3 on x86_64 this miscompiled the per-channel reset of the H and F
-     vectors, producing wrong alignments (see issue #589). std::memcpy accesses
-     the object representation as bytes, which is always well-defined, and the
-     compiler lowers it to a plain vector-lane move. */
-  auto get_channel(VECTOR_SHORT const & vector, int const channel) -> CELL
-  {
-    CELL value = 0;
-    std::memcpy(&value,
-                reinterpret_cast<char const *>(&vector) + (static_cast<size_t>(channel) * sizeof(CELL)),
-                sizeof(CELL));
-    return value;
-  }
-
-  auto set_channel(VECTOR_SHORT & vector, int const channel, CELL const value) -> void
-  {
-    std::memcpy(reinterpret_cast<char *>(&vector) + (static_cast<size_t>(channel) * sizeof(CELL)),
-                &value,
-                sizeof(CELL));
-  }
-
-}  // end of anonymous namespace
 
 
 auto _mm_print(VECTOR_SHORT const x) -> void
@@ -707,542 +607,35 @@ auto dprofile_fill16(CELL * dprofile_word,
 }
 
 
-/*
-  The direction bits are set as follows:
-  in DIR[0..1] if F>H initially (must go up) (4th pri)
-  in DIR[2..3] if E>max(H,F) (must go left) (3rd pri)
-  in DIR[4..5] if new F>H (must extend up) (2nd pri)
-  in DIR[6..7] if new E>H (must extend left) (1st pri)
-  no bits set: go diagonally
-*/
-
-/*
-  onestep() advances one block of DP cells. Its fifth parameter is a pointer
-  into the direction buffer where the four 16-bit direction masks for this
-  block are written, one per v_mask_gt comparison. On PPC v_mask_gt folds in
-  the byte-permute that x86_64/aarch64 obtain directly from movemask, so a
-  single onestep() serves every architecture.
-*/
-
-#ifdef __PPC__
-
-/* The VSX vec_bperm instruction puts the 16 selected bits of the first
-   source into bits 48-63 of the destination. */
-
-constexpr __vector unsigned char perm  = { 120, 112, 104,  96,  88,  80,  72,  64,
-  56,  48,  40,  32,  24,  16,   8,   0 };
-
-inline auto v_mask_gt(VECTOR_SHORT lhs, VECTOR_SHORT rhs) -> unsigned short {
-  /* Build the same per-element greater-than bitmask that x86_64 and aarch64
-     obtain from movemask: compare, then gather one bit per byte with the
-     byte-permute. vec_bperm leaves the 16 gathered bits in lane 4. */
-  static constexpr unsigned int result_lane = 4U;
-  auto const comparison = (__vector unsigned char) vec_cmpgt(lhs, rhs);
-  /* Handle differences between GNU and IBM compilers */
-#ifdef __IBMCPP__
-  auto const bits = (__vector unsigned short) vec_bperm(comparison, perm);
-#else
-  auto const bits = (__vector unsigned short) vec_vbpermq(comparison, perm);
-#endif
-  return bits[result_lane];
-}
-
-#endif
-
-inline auto onestep(VECTOR_SHORT & H,
-                    VECTOR_SHORT & N,
-                    VECTOR_SHORT & F,
-                    VECTOR_SHORT V,
-                    unsigned short * path,
-                    VECTOR_SHORT & E,
-                    VECTOR_SHORT QR_q,
-                    VECTOR_SHORT R_q,
-                    VECTOR_SHORT QR_t,
-                    VECTOR_SHORT R_t,
-                    VECTOR_SHORT & H_min,
-                    VECTOR_SHORT & H_max) -> void
-{
-  H = v_add(H, V);
-  path[0] = v_mask_gt(F, H);
-  H = v_max(H, F);
-  path[1] = v_mask_gt(E, H);
-  H = v_max(H, E);
-  H_min = v_min(H_min, H);
-  H_max = v_max(H_max, H);
-  N = H;
-  VECTOR_SHORT const HF = v_sub(H, QR_t);
-  F = v_sub(F, R_t);
-  path[2] = v_mask_gt(F, HF);
-  F = v_max(F, HF);
-  VECTOR_SHORT const HE = v_sub(H, QR_q);
-  E = v_sub(E, R_q);
-  path[3] = v_mask_gt(E, HE);
-  E = v_max(E, HE);
-}
-
-auto aligncolumns_first(VECTOR_SHORT * Sm,
-                        VECTOR_SHORT * hep,
-                        VECTOR_SHORT ** qp,
-                        VECTOR_SHORT QR_q_i,
-                        VECTOR_SHORT R_q_i,
-                        VECTOR_SHORT QR_q_r,
-                        VECTOR_SHORT R_q_r,
-                        VECTOR_SHORT QR_t_0,
-                        VECTOR_SHORT R_t_0,
-                        VECTOR_SHORT QR_t_1,
-                        VECTOR_SHORT R_t_1,
-                        VECTOR_SHORT QR_t_2,
-                        VECTOR_SHORT R_t_2,
-                        VECTOR_SHORT QR_t_3,
-                        VECTOR_SHORT R_t_3,
-                        VECTOR_SHORT h0,
-                        VECTOR_SHORT h1,
-                        VECTOR_SHORT h2,
-                        VECTOR_SHORT h3,
-                        VECTOR_SHORT f0,
-                        VECTOR_SHORT f1,
-                        VECTOR_SHORT f2,
-                        VECTOR_SHORT f3,
-                        VECTOR_SHORT * _h_min,
-                        VECTOR_SHORT * _h_max,
-                        VECTOR_SHORT Mm,
-                        VECTOR_SHORT M_QR_t_left,
-                        VECTOR_SHORT M_R_t_left,
-                        VECTOR_SHORT M_QR_q_interior,
-                        VECTOR_SHORT M_QR_q_right,
-                        int64_t ql,
-                        unsigned short * dir) -> void
-{
-
-  VECTOR_SHORT h4;
-  VECTOR_SHORT h5;
-  VECTOR_SHORT h6;
-  VECTOR_SHORT h7;
-  VECTOR_SHORT h8;
-  VECTOR_SHORT E;
-  VECTOR_SHORT const * vp = nullptr;
-
-  VECTOR_SHORT h_min = v_zero();
-  VECTOR_SHORT h_max = v_zero();
-
-  int64_t i = 0;
-
-  f0 = v_sub(f0, QR_t_0);
-  f1 = v_sub(f1, QR_t_1);
-  f2 = v_sub(f2, QR_t_2);
-  f3 = v_sub(f3, QR_t_3);
-
-
-  for (i = 0; i < ql - 1; i++)
-    {
-      vp = qp[i + 0];
-
-      h4 = hep[(2 * i) + 0];
-
-      E  = hep[(2 * i) + 1];
-
-      /*
-        Initialize selected h and e values for next/this round.
-        First zero those cells where a new sequence starts
-        by using an unsigned saturated subtraction of a huge value to
-        set it to zero.
-        Then use signed subtraction to obtain the correct value.
-      */
-
-      h4 = v_sub_unsigned(h4, Mm);
-      h4 = v_sub(h4, M_QR_t_left);
-
-      E  = v_sub_unsigned(E, Mm);
-      E  = v_sub(E, M_QR_t_left);
-      E  = v_sub(E, M_QR_q_interior);
-
-      M_QR_t_left = v_add(M_QR_t_left, M_R_t_left);
-
-      onestep(h0, h5, f0, vp[0], dir + (16 * i) + 0, E,
-              QR_q_i, R_q_i, QR_t_0, R_t_0, h_min, h_max);
-      onestep(h1, h6, f1, vp[1], dir + (16 * i) + 4, E,
-              QR_q_i, R_q_i, QR_t_1, R_t_1, h_min, h_max);
-      onestep(h2, h7, f2, vp[2], dir + (16 * i) + 8, E,
-              QR_q_i, R_q_i, QR_t_2, R_t_2, h_min, h_max);
-      onestep(h3, h8, f3, vp[3], dir + (16 * i) + 12, E,
-              QR_q_i, R_q_i, QR_t_3, R_t_3, h_min, h_max);
-
-      hep[(2 * i) + 0] = h8;
-      hep[(2 * i) + 1] = E;
-
-      h0 = h4;
-      h1 = h5;
-      h2 = h6;
-      h3 = h7;
-    }
-
-  /* the final round - using query gap penalties for right end */
-
-  vp = qp[i + 0];
-
-  E  = hep[(2 * i) + 1];
-
-  E  = v_sub_unsigned(E, Mm);
-  E  = v_sub(E, M_QR_t_left);
-  E  = v_sub(E, M_QR_q_right);
-
-
-  onestep(h0, h5, f0, vp[0], dir + (16 * i) + 0, E,
-          QR_q_r, R_q_r, QR_t_0, R_t_0, h_min, h_max);
-  onestep(h1, h6, f1, vp[1], dir + (16 * i) + 4, E,
-          QR_q_r, R_q_r, QR_t_1, R_t_1, h_min, h_max);
-  onestep(h2, h7, f2, vp[2], dir + (16 * i) + 8, E,
-          QR_q_r, R_q_r, QR_t_2, R_t_2, h_min, h_max);
-  onestep(h3, h8, f3, vp[3], dir + (16 * i) + 12, E,
-          QR_q_r, R_q_r, QR_t_3, R_t_3, h_min, h_max);
-
-
-  hep[(2 * i) + 0] = h8;
-  hep[(2 * i) + 1] = E;
-
-  Sm[0] = h5;
-  Sm[1] = h6;
-  Sm[2] = h7;
-  Sm[3] = h8;
-
-  *_h_min = h_min;
-  *_h_max = h_max;
-}
-
-
-auto aligncolumns_rest(VECTOR_SHORT * Sm,
-                       VECTOR_SHORT * hep,
-                       VECTOR_SHORT ** qp,
-                       VECTOR_SHORT QR_q_i,
-                       VECTOR_SHORT R_q_i,
-                       VECTOR_SHORT QR_q_r,
-                       VECTOR_SHORT R_q_r,
-                       VECTOR_SHORT QR_t_0,
-                       VECTOR_SHORT R_t_0,
-                       VECTOR_SHORT QR_t_1,
-                       VECTOR_SHORT R_t_1,
-                       VECTOR_SHORT QR_t_2,
-                       VECTOR_SHORT R_t_2,
-                       VECTOR_SHORT QR_t_3,
-                       VECTOR_SHORT R_t_3,
-                       VECTOR_SHORT h0,
-                       VECTOR_SHORT h1,
-                       VECTOR_SHORT h2,
-                       VECTOR_SHORT h3,
-                       VECTOR_SHORT f0,
-                       VECTOR_SHORT f1,
-                       VECTOR_SHORT f2,
-                       VECTOR_SHORT f3,
-                       VECTOR_SHORT * _h_min,
-                       VECTOR_SHORT * _h_max,
-                       int64_t ql,
-                       unsigned short * dir) -> void
-{
-  VECTOR_SHORT h4;
-  VECTOR_SHORT h5;
-  VECTOR_SHORT h6;
-  VECTOR_SHORT h7;
-  VECTOR_SHORT h8;
-  VECTOR_SHORT E;
-  VECTOR_SHORT const * vp = nullptr;
-
-  VECTOR_SHORT h_min = v_zero();
-  VECTOR_SHORT h_max = v_zero();
-
-  int64_t i = 0;
-
-  f0 = v_sub(f0, QR_t_0);
-  f1 = v_sub(f1, QR_t_1);
-  f2 = v_sub(f2, QR_t_2);
-  f3 = v_sub(f3, QR_t_3);
-
-  for (i = 0; i < ql - 1; i++)
-    {
-      vp = qp[i + 0];
-
-      h4 = hep[(2 * i) + 0];
-
-      E  = hep[(2 * i) + 1];
-
-      onestep(h0, h5, f0, vp[0], dir + (16 * i) + 0, E,
-              QR_q_i, R_q_i, QR_t_0, R_t_0, h_min, h_max);
-      onestep(h1, h6, f1, vp[1], dir + (16 * i) + 4, E,
-              QR_q_i, R_q_i, QR_t_1, R_t_1, h_min, h_max);
-      onestep(h2, h7, f2, vp[2], dir + (16 * i) + 8, E,
-              QR_q_i, R_q_i, QR_t_2, R_t_2, h_min, h_max);
-      onestep(h3, h8, f3, vp[3], dir + (16 * i) + 12, E,
-              QR_q_i, R_q_i, QR_t_3, R_t_3, h_min, h_max);
-
-      hep[(2 * i) + 0] = h8;
-      hep[(2 * i) + 1] = E;
-
-      h0 = h4;
-      h1 = h5;
-      h2 = h6;
-      h3 = h7;
-    }
-
-  /* the final round - using query gap penalties for right end */
-
-  vp = qp[i + 0];
-
-  E  = hep[(2 * i) + 1];
-
-  onestep(h0, h5, f0, vp[0], dir + (16 * i) + 0, E,
-          QR_q_r, R_q_r, QR_t_0, R_t_0, h_min, h_max);
-  onestep(h1, h6, f1, vp[1], dir + (16 * i) + 4, E,
-          QR_q_r, R_q_r, QR_t_1, R_t_1, h_min, h_max);
-  onestep(h2, h7, f2, vp[2], dir + (16 * i) + 8, E,
-          QR_q_r, R_q_r, QR_t_2, R_t_2, h_min, h_max);
-  onestep(h3, h8, f3, vp[3], dir + (16 * i) + 12, E,
-          QR_q_r, R_q_r, QR_t_3, R_t_3, h_min, h_max);
-
-  hep[(2 * i) + 0] = h8;
-  hep[(2 * i) + 1] = E;
-
-  Sm[0] = h5;
-  Sm[1] = h6;
-  Sm[2] = h7;
-  Sm[3] = h8;
-
-  *_h_min = h_min;
-  *_h_max = h_max;
-}
-
-
-inline auto pushop(s16info_s * s, char const newop) -> void
-{
-  if (newop == s->op) {
-    ++s->opcount;
-    return;
-  }
-  *--s->cigarend = s->op;
-  if (s->opcount > 1)
-    {
-      static constexpr auto size = 11;
-      std::array<char, size> buffer {{}};
-      const auto length = std::snprintf(buffer.data(), size, "%d", s->opcount);
-      s->cigarend -= length;
-      std::memcpy(s->cigarend, buffer.data(), static_cast<size_t>(length));
-    }
-  s->op = newop;
-  s->opcount = 1;
-}
-
-
-inline auto finishop(s16info_s * s) -> void
-{
-  if ((s->op != 0) and (s->opcount != 0))
-    {
-      *--s->cigarend = s->op;
-      if (s->opcount > 1)
-        {
-          static constexpr auto size = 11;
-          std::array<char, size> buffer {{}};
-          const auto length = std::snprintf(buffer.data(), size, "%d", s->opcount);
-          s->cigarend -= length;
-          std::memcpy(s->cigarend, buffer.data(), static_cast<size_t>(length));
-        }
-      s->op = 0;
-      s->opcount = 0;
-    }
-}
-
-
-auto backtrack16(s16info_s * s,
-                 char const * dseq,
-                 uint64_t dlen,
-                 uint64_t offset,
-                 uint64_t channel,
-                 unsigned short * paligned,
-                 unsigned short * pmatches,
-                 unsigned short * pmismatches,
-                 unsigned short * pgaps) -> void
-{
-  unsigned short * dirbuffer = s->dir;
-  uint64_t const dirbuffersize = static_cast<uint64_t>(s->qlen) * static_cast<uint64_t>(s->maxdlen) * 4;
-  uint64_t const qlen = static_cast<uint64_t>(s->qlen);
-  char const * qseq = s->qseq;
-
-  uint64_t const maskup      = 3ULL << ((2 * channel) + 0);
-  uint64_t const maskleft    = 3ULL << ((2 * channel) + 16);
-  uint64_t const maskextup   = 3ULL << ((2 * channel) + 32);
-  uint64_t const maskextleft = 3ULL << ((2 * channel) + 48);
-
-#if 0
-
-  std::printf("Dumping backtracking array\n");
-
-  for (uint64_t i = 0; i < qlen; i++)
-    {
-      for (uint64_t j = 0; j < dlen; j++)
-        {
-          uint64_t d = *((uint64_t *) (dirbuffer +
-                                       (offset + matrix_size * qlen * (j / 4) +
-                                        matrix_size * i + 4 * (j & 3)) % dirbuffersize));
-          if (d & maskup)
-            {
-              if (d & maskleft)
-                std::printf("+");
-              else
-                std::printf("^");
-            }
-          else if (d & maskleft)
-            {
-              std::printf("<");
-            }
-          else
-            {
-              std::printf("\\");
-            }
-        }
-      std::printf("\n");
-    }
-
-  std::printf("Dumping gap extension array\n");
-
-  for (uint64_t i = 0; i < qlen; i++)
-    {
-      for (uint64_t j = 0; j < dlen; j++)
-        {
-          uint64_t d = *((uint64_t *) (dirbuffer +
-                                       (offset + matrix_size * qlen * (j / 4) +
-                                        matrix_size * i + 4 * (j & 3)) % dirbuffersize));
-          if (d & maskextup)
-            {
-              if (d & maskextleft)
-                std::printf("+");
-              else
-                std::printf("^");
-            }
-          else if (d & maskextleft)
-            {
-              std::printf("<");
-            }
-          else
-            {
-              std::printf("\\");
-            }
-        }
-      std::printf("\n");
-    }
-
-#endif
-
-  unsigned short aligned = 0;
-  unsigned short matches = 0;
-  unsigned short mismatches = 0;
-  unsigned short gaps = 0;
-
-  int64_t i = static_cast<int64_t>(qlen) - 1;
-  int64_t j = static_cast<int64_t>(dlen) - 1;
-
-  s->cigarend = s->cigar + s->qlen + s->maxdlen + 1;
-  s->op = 0;
-  s->opcount = 1;
-
-  while ((i >= 0) and (j >= 0))
-    {
-      ++aligned;
-
-      // future refactoring:
-      // d = *(block1)
-      // block1 = dirbuffer + (block2 % dirbuffersize);
-      // block2 = (offset + block3 + block4 + block5);
-      // block3 = 16 * qlen * (j / 4);
-      // block4 = 16 * i;
-      // block5 = 4 * (j & 3);
-      unsigned short const * const dir_word = dirbuffer +
-        ((offset + (matrix_size * qlen * static_cast<uint64_t>(j / 4)) +
-          (matrix_size * static_cast<uint64_t>(i)) + (4 * static_cast<uint64_t>(j & 3))) % dirbuffersize);
-      uint64_t d = 0;
-      std::memcpy(&d, dir_word, sizeof(d));
-
-      if ((s->op == 'I') and ((d & maskextleft) != 0U))
-        {
-          --j;
-          pushop(s, 'I');
-        }
-      else if ((s->op == 'D') and ((d & maskextup) != 0U))
-        {
-          --i;
-          pushop(s, 'D');
-        }
-      else if ((d & maskleft) != 0U)
-        {
-          if (s->op != 'I')
-            {
-              ++gaps;
-            }
-          --j;
-          pushop(s, 'I');
-        }
-      else if ((d & maskup) != 0U)
-        {
-          if (s->op != 'D')
-            {
-              ++gaps;
-            }
-          --i;
-          pushop(s, 'D');
-        }
-      else
-        {
-          if (is_equivalent_4bit(qseq[i], dseq[j]))
-            {
-              if (s->n_mismatch and ((map_4bit(qseq[i]) == 15) or
-                                     (map_4bit(dseq[j]) == 15)))
-                {
-                  ++mismatches;
-                }
-              else
-                {
-                  ++matches;
-                }
-            }
-          else
-            {
-              ++mismatches;
-            }
-          --i;
-          --j;
-          pushop(s, 'M');
-        }
-    }
-
-  while (i >= 0)
-    {
-      ++aligned;
-      if (s->op != 'D')
-        {
-          ++gaps;
-        }
-      --i;
-      pushop(s, 'D');
-    }
+// anonymous namespace: limit visibility and usage to this translation unit
+namespace {
 
-  while (j >= 0)
-    {
-      ++aligned;
-      if (s->op != 'I')
-        {
-          ++gaps;
-        }
-      --j;
-      pushop(s, 'I');
+  /* search16 kernel operations on the 128-bit vectors above (8 channels),
+     see core/align_simd_internal.hpp */
+  struct Simd_128 {
+    using cell = CELL;
+    using vector = VECTOR_SHORT;
+    using mask = unsigned short;
+    static constexpr int channels = CHANNELS;
+    static constexpr unsigned int mask_bits = 2;
+
+    static auto v_add(vector lhs, vector rhs) -> vector { return ::v_add(lhs, rhs); }
+    static auto v_sub(vector lhs, vector rhs) -> vector { return ::v_sub(lhs, rhs); }
+    static auto v_sub_unsigned(vector lhs, vector rhs) -> vector { return ::v_sub_unsigned(lhs, rhs); }
+    static auto v_max(vector lhs, vector rhs) -> vector { return ::v_max(lhs, rhs); }
+    static auto v_min(vector lhs, vector rhs) -> vector { return ::v_min(lhs, rhs); }
+    static auto v_and(vector lhs, vector rhs) -> vector { return ::v_and(lhs, rhs); }
+    static auto v_xor(vector lhs, vector rhs) -> vector { return ::v_xor(lhs, rhs); }
+    static auto v_dup(short value) -> vector { return ::v_dup(value); }
+    static auto v_zero() -> vector { return ::v_zero(); }
+    static auto v_shift_left(vector operand) -> vector { return ::v_shift_left(operand); }
+    static auto v_mask_gt(vector lhs, vector rhs) -> mask { return ::v_mask_gt(lhs, rhs); }
+    static auto dprofile_fill(CELL * dprofile, CELL const * matrix, BYTE const * dseq) -> void {
+      dprofile_fill16(dprofile, matrix, dseq);
     }
+  };
 
-  finishop(s);
-
-  /* move cigar to beginning of allocated memory area */
-  int const cigarlen = static_cast<int>(s->cigar + s->qlen + s->maxdlen - s->cigarend);
-  std::memmove(s->cigar, s->cigarend, static_cast<size_t>(cigarlen + 1));
-
-  * paligned = aligned;
-  * pmatches = matches;
-  * pmismatches = mismatches;
-  * pgaps = gaps;
-}
+}  // end of anonymous namespace
 
 
 // anonymous namespace: limit visibility and usage to this translation unit
@@ -1293,14 +686,16 @@ auto search16_init(int64_t score_match,
                    int64_t penalty_gap_extension_target_interior,
                    int64_t penalty_gap_extension_query_right,
                    int64_t penalty_gap_extension_target_right,
-                   bool score_n_mismatch) -> struct s16info_s *
+                   bool score_n_mismatch,
+                   int channels) -> struct s16info_s *
 {
   /* prepare alloc of qtable, dprofile, hearray, dir */
   auto * s = static_cast<struct s16info_s *>(
     xmalloc(sizeof(struct s16info_s)));
 
   s->n_mismatch = score_n_mismatch;
-  s->dprofile = static_cast<VECTOR_SHORT *>(xmalloc(2 * 4 * 8 * 16));
+  s->channels = channels;
+  s->dprofile = static_cast<CELL *>(xmalloc(sizeof(CELL) * matrix_size * CDEPTH * static_cast<size_t>(channels)));
   s->qlen = 0;
   s->qseq = nullptr;
   s->maxdlen = 0;
@@ -1337,7 +732,9 @@ auto search16_init(int64_t score_match,
             {
               value = mismatch;
             }
-          (reinterpret_cast<CELL *>(s->matrix.data()))[(matrix_size * i) + j] = value;
+          s->matrix[(matrix_size * i) + j] = value;
+          /* transposed: a row per query symbol (see dprofile_fill) */
+          s->matrix8[(matrix_size * j) + i] = saturate_cell<signed char>(value);
         }
     }
 
@@ -1372,6 +769,43 @@ auto search16_init(int64_t score_match,
 
   s->force_scalar_fallback = needs_fallback;
 
+  /* The 8-bit score bounds are upper bounds only when saturating the
+     scores and penalties to signed chars can round them in the favourable
+     direction: positive match, match and mismatch at most 127, gap
+     penalties not negative. */
+  auto const penalties = {
+    penalty_gap_open_query_left, penalty_gap_open_target_left,
+    penalty_gap_open_query_interior, penalty_gap_open_target_interior,
+    penalty_gap_open_query_right, penalty_gap_open_target_right,
+    penalty_gap_extension_query_left, penalty_gap_extension_target_left,
+    penalty_gap_extension_query_interior, penalty_gap_extension_target_interior,
+    penalty_gap_extension_query_right, penalty_gap_extension_target_right };
+  auto const byte_max = int64_t{std::numeric_limits<signed char>::max()};
+  bool const bounded = (not needs_fallback)
+    and (score_match > 0) and (score_match <= byte_max) and (score_mismatch <= byte_max)
+    and (std::min(penalties) >= 0);
+
+  s->bounds_channels = 0;
+  s->hearray8 = nullptr;
+  s->dprofile8 = nullptr;
+  s->qtable8 = nullptr;
+#ifdef __x86_64__
+  if (bounded and (channels == avx2_channels))
+    {
+      s->bounds_channels = avx2_bounds_channels;
+    }
+  if (bounded and (channels == avx512_channels))
+    {
+      s->bounds_channels = avx512_bounds_channels;
+    }
+#else
+  static_cast<void>(bounded);
+#endif
+  if (s->bounds_channels != 0)
+    {
+      s->dprofile8 = static_cast<signed char *>(xmalloc(matrix_size * CDEPTH * static_cast<size_t>(s->bounds_channels)));
+    }
+
   return s;
 }
 
@@ -1399,6 +833,18 @@ auto search16_exit(s16info_s * s) -> void
     {
       xfree(s->cigar);
     }
+  if (s->hearray8 != nullptr)
+    {
+      xfree(s->hearray8);
+    }
+  if (s->dprofile8 != nullptr)
+    {
+      xfree(s->dprofile8);
+    }
+  if (s->qtable8 != nullptr)
+    {
+      xfree(s->qtable8);
+    }
   xfree(s);
 }
 
@@ -1412,35 +858,106 @@ auto search16_qprep(s16info_s * s, char * qseq, int qlen) -> void
     {
       xfree(s->hearray);
     }
-  s->hearray = static_cast<VECTOR_SHORT *>(xmalloc(2 * static_cast<uint64_t>(s->qlen) * sizeof(VECTOR_SHORT)));
-  std::memset(s->hearray, 0, 2 * static_cast<uint64_t>(s->qlen) * sizeof(VECTOR_SHORT));
+  /* one H and one E vector of s->channels cells per query position */
+  auto const hearray_size = 2 * static_cast<uint64_t>(s->qlen) * static_cast<uint64_t>(s->channels) * sizeof(CELL);
+  s->hearray = static_cast<CELL *>(xmalloc(hearray_size));
+  std::memset(s->hearray, 0, hearray_size);
 
   if (s->qtable != nullptr)
     {
       xfree(s->qtable);
     }
-  s->qtable = static_cast<VECTOR_SHORT **>(xmalloc(static_cast<uint64_t>(s->qlen) * sizeof(VECTOR_SHORT*)));
+  s->qtable = static_cast<CELL **>(xmalloc(static_cast<uint64_t>(s->qlen) * sizeof(CELL *)));
 
   for (int i = 0; i < qlen; i++)
     {
-      s->qtable[i] = s->dprofile + (4 * map_4bit(qseq[i]));
+      s->qtable[i] = s->dprofile + (CDEPTH * s->channels * map_4bit(qseq[i]));
     }
+
+  if (s->bounds_channels == 0)
+    {
+      return;
+    }
+
+  if (s->hearray8 != nullptr)
+    {
+      xfree(s->hearray8);
+    }
+  auto const hearray8_size = 2 * static_cast<uint64_t>(s->qlen) * static_cast<uint64_t>(s->bounds_channels);
+  s->hearray8 = static_cast<signed char *>(xmalloc(hearray8_size));
+  std::memset(s->hearray8, 0, hearray8_size);
+
+  if (s->qtable8 != nullptr)
+    {
+      xfree(s->qtable8);
+    }
+  s->qtable8 = static_cast<signed char **>(xmalloc(static_cast<uint64_t>(s->qlen) * sizeof(signed char *)));
+
+  for (int i = 0; i < qlen; i++)
+    {
+      s->qtable8[i] = s->dprofile8 + (CDEPTH * s->bounds_channels * map_4bit(qseq[i]));
+    }
+}
+
+
+auto search16_select_channels(struct Parameters const & parameters) -> int
+{
+#ifdef __x86_64__
+  if (parameters.avx512bw_present != 0)
+    {
+      return avx512_channels;
+    }
+  if (parameters.avx2_present != 0)
+    {
+      return avx2_channels;
+    }
+#else
+  static_cast<void>(parameters);
+#endif
+  return CHANNELS;
 }
 
 
+auto search16_channels(s16info_s const * s) -> unsigned int
+{
+  return static_cast<unsigned int>(s->channels);
+}
 
-auto compute_score_min(struct s16info_s const & alignment) -> short {
-  auto const gap_penalty_max = std::max({
-      0,
-      alignment.penalty_gap_open_query_left + alignment.penalty_gap_extension_query_left,
-      alignment.penalty_gap_open_query_interior + alignment.penalty_gap_extension_query_interior,
-      alignment.penalty_gap_open_query_right + alignment.penalty_gap_extension_query_right,
-      alignment.penalty_gap_open_target_left + alignment.penalty_gap_extension_target_left,
-      alignment.penalty_gap_open_target_interior + alignment.penalty_gap_extension_target_interior,
-      alignment.penalty_gap_open_target_right + alignment.penalty_gap_extension_target_right
-    });
 
-  return static_cast<short>(std::numeric_limits<short>::min() + gap_penalty_max);
+auto search16_bounds_channels(s16info_s const * s) -> unsigned int
+{
+  return static_cast<unsigned int>(s->bounds_channels);
+}
+
+
+auto search16_bounds(s16info_s * s,
+                     unsigned int sequences,
+                     unsigned int const * seqnos,
+                     CELL * pbounds,
+                     struct Database const & db) -> void
+{
+#ifdef __x86_64__
+  if (s->qlen > 0)
+    {
+      if (s->bounds_channels == avx512_bounds_channels)
+        {
+          search16_bounds_avx512(s, sequences, seqnos, pbounds, db);
+          return;
+        }
+      if (s->bounds_channels == avx2_bounds_channels)
+        {
+          search16_bounds_avx2(s, sequences, seqnos, pbounds, db);
+          return;
+        }
+    }
+#else
+  static_cast<void>(seqnos);
+  static_cast<void>(db);
+#endif
+  for (auto cand_id = 0U; cand_id < sequences; cand_id++)
+    {
+      pbounds[cand_id] = std::numeric_limits<short>::max();
+    }
 }
 
 
@@ -1455,9 +972,6 @@ auto search16(s16info_s * s,
               char ** pcigar,
               struct Database const & db) -> void
 {
-  CELL ** q_start = reinterpret_cast<CELL **>(s->qtable);
-  CELL * dprofile = reinterpret_cast<CELL *>(s->dprofile);
-  CELL * hearray = reinterpret_cast<CELL *>(s->hearray);
   uint64_t const qlen = static_cast<uint64_t>(s->qlen);
 
   if (s->force_scalar_fallback)
@@ -1468,12 +982,8 @@ auto search16(s16info_s * s,
          (linear-memory) aligner, exactly as the size guard does. */
       for (auto cand_id = 0U; cand_id < sequences; cand_id++)
         {
-          pscores[cand_id] = std::numeric_limits<short>::max();
-          paligned[cand_id] = 0;
-          pmatches[cand_id] = 0;
-          pmismatches[cand_id] = 0;
-          pgaps[cand_id] = 0;
-          pcigar[cand_id] = xstrdup("");
+          search16_defer(cand_id, pscores, paligned, pmatches,
+                         pmismatches, pgaps, pcigar);
         }
       return;
     }
@@ -1492,12 +1002,8 @@ auto search16(s16info_s * s,
              product/sum guard does for non-empty queries. */
           if (not search16_fits(qlen, static_cast<uint64_t>(length)))
             {
-              pscores[cand_id] = std::numeric_limits<short>::max();
-              paligned[cand_id] = 0;
-              pmatches[cand_id] = 0;
-              pmismatches[cand_id] = 0;
-              pgaps[cand_id] = 0;
-              pcigar[cand_id] = xstrdup("");
+              search16_defer(cand_id, pscores, paligned, pmatches,
+                             pmismatches, pgaps, pcigar);
               continue;
             }
 
@@ -1538,523 +1044,20 @@ auto search16(s16info_s * s,
       return;
     }
 
-  /* find longest target sequence and reallocate direction buffer */
-  uint64_t maxdlen = 0;
-  for (int64_t i = 0; i < sequences; i++)
-    {
-      uint64_t const dlen = db.getsequencelen(seqnos[i]);
-      /* skip sequences the SIMD aligner cannot handle (product/sum limits) */
-      if (search16_fits(static_cast<uint64_t>(s->qlen), dlen))
-        {
-          maxdlen = std::max(dlen, maxdlen);
-        }
-    }
-  maxdlen = 4 * ((maxdlen + 3) / 4);
-  s->maxdlen = static_cast<int>(maxdlen);
-  uint64_t const dirbuffersize = static_cast<uint64_t>(s->qlen) * static_cast<uint64_t>(s->maxdlen) * 4;
-
-  if (dirbuffersize > s->diralloc)
+#ifdef __x86_64__
+  if (s->channels == avx512_channels)
     {
-      s->diralloc = dirbuffersize;
-      if (s->dir != nullptr)
-        {
-          xfree(s->dir);
-        }
-      s->dir = static_cast<unsigned short*>(xmalloc(dirbuffersize *
-                                         sizeof(unsigned short)));
+      search16_avx512(s, sequences, seqnos, pscores, paligned, pmatches,
+                      pmismatches, pgaps, pcigar, db);
+      return;
     }
-
-  unsigned short * dirbuffer = s->dir;
-
-  if (s->qlen + s->maxdlen + 1 > s->cigaralloc)
+  if (s->channels == avx2_channels)
     {
-      s->cigaralloc = s->qlen + s->maxdlen + 1;
-      if (s->cigar != nullptr)
-        {
-          xfree(s->cigar);
-        }
-      s->cigar = static_cast<char *>(xmalloc(static_cast<size_t>(s->cigaralloc)));
+      search16_avx2(s, sequences, seqnos, pscores, paligned, pmatches,
+                    pmismatches, pgaps, pcigar, db);
+      return;
     }
-
-  VECTOR_SHORT M;
-  VECTOR_SHORT T0;
-
-  VECTOR_SHORT M_QR_target_left;
-  VECTOR_SHORT M_R_target_left;
-  VECTOR_SHORT M_QR_query_interior;
-  VECTOR_SHORT M_QR_query_right;
-
-  VECTOR_SHORT R_query_left;
-  VECTOR_SHORT QR_query_interior;
-  VECTOR_SHORT R_query_interior;
-  VECTOR_SHORT QR_query_right;
-  VECTOR_SHORT R_query_right;
-  VECTOR_SHORT QR_target_left;
-  VECTOR_SHORT R_target_left;
-  VECTOR_SHORT QR_target_interior;
-  VECTOR_SHORT R_target_interior;
-  VECTOR_SHORT QR_target_right;
-  VECTOR_SHORT R_target_right;
-  std::array<VECTOR_SHORT, 4> QR_target {{}};
-  std::array<VECTOR_SHORT, 4> R_target {{}};
-
-  VECTOR_SHORT * hep = nullptr;
-  VECTOR_SHORT ** qp = nullptr;
-
-  std::array<BYTE const *, CHANNELS> d_begin {{}};
-  std::array<BYTE const *, CHANNELS> d_end {{}};
-  std::array<uint64_t, CHANNELS> d_offset {{}};
-  std::array<BYTE const *, CHANNELS> d_address {{}};
-  std::array<uint64_t, CHANNELS> d_length {{}};
-  std::array<int64_t, CHANNELS> seq_id {{}};
-  std::array<bool, CHANNELS> overflow {{}};
-
-  std::array<VECTOR_SHORT, CDEPTH> dseqalloc {{}};
-  std::array<VECTOR_SHORT, 4> S {{}};
-
-  BYTE * dseq = reinterpret_cast<BYTE *>(dseqalloc.data());
-  BYTE zero = 0;
-
-  uint64_t next_id = 0;
-  uint64_t done = 0;
-
-#pragma GCC diagnostic push
-#ifdef __clang__
-#pragma clang diagnostic ignored "-Wc99-extensions"
-#elif defined(__GNUC__)
-#pragma GCC diagnostic ignored "-Wpedantic"
 #endif
-  T0 = v_init({{-1, 0, 0, 0, 0, 0, 0, 0}});
-
-  R_query_left = v_dup(s->penalty_gap_extension_query_left);
-
-  QR_query_interior = v_dup((s->penalty_gap_open_query_interior +
-                             s->penalty_gap_extension_query_interior));
-  R_query_interior  = v_dup(s->penalty_gap_extension_query_interior);
-
-  QR_query_right  = v_dup((s->penalty_gap_open_query_right +
-                           s->penalty_gap_extension_query_right));
-  R_query_right  = v_dup(s->penalty_gap_extension_query_right);
-
-  QR_target_left  = v_dup((s->penalty_gap_open_target_left +
-                           s->penalty_gap_extension_target_left));
-  R_target_left  = v_dup(s->penalty_gap_extension_target_left);
-
-  QR_target_interior = v_dup((s->penalty_gap_open_target_interior +
-                              s->penalty_gap_extension_target_interior));
-  R_target_interior = v_dup(s->penalty_gap_extension_target_interior);
-
-  QR_target_right  = v_dup((s->penalty_gap_open_target_right +
-                            s->penalty_gap_extension_target_right));
-  R_target_right  = v_dup(s->penalty_gap_extension_target_right);
-#pragma GCC diagnostic pop
-
-  hep = reinterpret_cast<VECTOR_SHORT *>(hearray);
-  qp = reinterpret_cast<VECTOR_SHORT **>(q_start);
-
-  for (size_t c = 0; c < CHANNELS; c++)
-    {
-      d_begin[c] = &zero;
-      d_end[c] = d_begin[c];
-      d_address[c] = nullptr;
-      d_offset[c] = 0;
-      d_length[c] = 0;
-      seq_id[c] = -1;
-      overflow[c] = false;
-    }
-
-  auto const score_min = compute_score_min(*s);
-  auto const score_max = std::numeric_limits<short>::max();
-
-  for (size_t i = 0; i < 4; i++)
-    {
-      S[i] = v_zero();
-      dseqalloc[i] = v_zero();
-    }
-
-  VECTOR_SHORT H0 = v_zero();
-  VECTOR_SHORT H1 = v_zero();
-  VECTOR_SHORT H2 = v_zero();
-  VECTOR_SHORT H3 = v_zero();
-
-  VECTOR_SHORT F0 = v_zero();
-  VECTOR_SHORT F1 = v_zero();
-  VECTOR_SHORT F2 = v_zero();
-  VECTOR_SHORT F3 = v_zero();
-
-  bool easy = false;
-
-  unsigned short * dir = dirbuffer;
-
-  while (true)
-    {
-      if (easy)
-        {
-          /* fill all channels with symbols from the database sequences */
-
-          for (size_t c = 0; c < CHANNELS; c++)
-            {
-              for (size_t j = 0; j < CDEPTH; j++)
-                {
-                  if (d_begin[c] < d_end[c])
-                    {
-                      dseq[(CHANNELS * j) + c] = map_4bit(static_cast<char>(*(d_begin[c]++)));
-                    }
-                  else
-                    {
-                      dseq[(CHANNELS * j) + c] = 0;
-                    }
-                }
-              if (d_begin[c] == d_end[c])
-                {
-                  easy = false;
-                }
-            }
-
-          dprofile_fill16(dprofile, reinterpret_cast<CELL *>(s->matrix.data()), dseq);
-
-          /* create vectors of gap penalties for target depending on whether
-             any of the database sequences ended in these four columns */
-
-          if (easy)
-            {
-              for (unsigned int j = 0; j < CDEPTH; j++)
-                {
-                  QR_target[j] = QR_target_interior;
-                  R_target[j]  = R_target_interior;
-                }
-            }
-          else
-            {
-              /* one or more sequences ended */
-
-              VECTOR_SHORT const QR_diff = v_sub(QR_target_right,
-                                           QR_target_interior);
-              VECTOR_SHORT const R_diff  = v_sub(R_target_right,
-                                           R_target_interior);
-              for (unsigned int j = 0; j < CDEPTH; j++)
-                {
-                  VECTOR_SHORT MM = v_zero();
-                  VECTOR_SHORT TT = T0;
-                  for (size_t c = 0; c < CHANNELS; c++)
-                    {
-                      if ((d_begin[c] == d_end[c]) and
-                          (j >= ((d_length[c] + 3) % 4)))
-                        {
-                          MM = v_xor(MM, TT);
-                        }
-                      TT = v_shift_left(TT);
-                    }
-                  QR_target[j] = v_add(QR_target_interior,
-                                       v_and(QR_diff, MM));
-                  R_target[j]  = v_add(R_target_interior,
-                                       v_and(R_diff, MM));
-                }
-            }
-
-          VECTOR_SHORT h_min;
-          VECTOR_SHORT h_max;
-
-          aligncolumns_rest(S.data(), hep, qp,
-                            QR_query_interior, R_query_interior,
-                            QR_query_right, R_query_right,
-                            QR_target[0], R_target[0],
-                            QR_target[1], R_target[1],
-                            QR_target[2], R_target[2],
-                            QR_target[3], R_target[3],
-                            H0, H1, H2, H3,
-                            F0, F1, F2, F3,
-                            & h_min, & h_max,
-                            static_cast<int64_t>(qlen), dir);
-
-          VECTOR_SHORT h_min_vector;
-          VECTOR_SHORT h_max_vector;
-          v_store(& h_min_vector, h_min);
-          v_store(& h_max_vector, h_max);
-          for (int c = 0; c < CHANNELS; c++)
-            {
-              if (not overflow[static_cast<size_t>(c)])
-                {
-                  signed short const h_min_c = get_channel(h_min_vector, c);
-                  signed short const h_max_c = get_channel(h_max_vector, c);
-                  if ((h_min_c <= score_min) or
-                      (h_max_c >= score_max))
-                    {
-                      overflow[static_cast<size_t>(c)] = true;
-                    }
-                }
-            }
-        }
-      else
-        {
-          /* One or more sequences ended in the previous block.
-             We have to switch over to a new sequence           */
-
-          easy = true;
-
-          M = v_zero();
-
-          VECTOR_SHORT T = T0;
-          for (int c = 0; c < CHANNELS; c++)
-            {
-              size_t const cc = static_cast<size_t>(c);
-              if (d_begin[cc] < d_end[cc])
-                {
-                  /* this channel has more sequence */
-
-                  for (int j = 0; j < CDEPTH; j++)
-                    {
-                      if (d_begin[cc] < d_end[cc])
-                        {
-                          dseq[(CHANNELS * j) + c] = map_4bit(static_cast<char>(*(d_begin[cc]++)));
-                        }
-                      else
-                        {
-                          dseq[(CHANNELS * j) + c] = 0;
-                        }
-                    }
-                  if (d_begin[cc] == d_end[cc])
-                    {
-                      easy = false;
-                    }
-                }
-              else
-                {
-                  /* sequence in channel c ended. change of sequence */
-
-                  M = v_xor(M, T);
-
-                  int64_t cand_id = seq_id[cc];
-
-                  if (cand_id >= 0)
-                    {
-                      /* save score */
-
-                      char const * dbseq = reinterpret_cast<char const *>(d_address[cc]);
-                      int64_t const dbseqlen = static_cast<int64_t>(d_length[cc]);
-                      int64_t const z = (dbseqlen + 3) % 4;
-                      int64_t const score = get_channel(S[static_cast<size_t>(z)], c);
-
-                      if (overflow[cc])
-                        {
-                          pscores[cand_id] = std::numeric_limits<short>::max();
-                          paligned[cand_id] = 0;
-                          pmatches[cand_id] = 0;
-                          pmismatches[cand_id] = 0;
-                          pgaps[cand_id] = 0;
-                          pcigar[cand_id] = xstrdup("");
-                        }
-                      else
-                        {
-                          pscores[cand_id] = static_cast<CELL>(score);
-                          backtrack16(s, dbseq, static_cast<uint64_t>(dbseqlen), d_offset[cc], cc,
-                                      paligned + cand_id,
-                                      pmatches + cand_id,
-                                      pmismatches + cand_id,
-                                      pgaps + cand_id);
-                          pcigar[cand_id] =
-                            static_cast<char *>(xmalloc(std::strlen(s->cigar)+1));
-                          std::strcpy(pcigar[cand_id], s->cigar);
-                        }
-
-                      done++;
-                    }
-
-                  /* get next sequence of reasonable length */
-
-                  int64_t length = 0;
-
-                  while ((length == 0) and (next_id < sequences))
-                    {
-                      cand_id = static_cast<int64_t>(next_id++);
-                      length = static_cast<int64_t>(db.getsequencelen(seqnos[cand_id]));
-                      if ((length == 0) or (not search16_fits(static_cast<uint64_t>(s->qlen), static_cast<uint64_t>(length))))
-                        {
-                          pscores[cand_id] = std::numeric_limits<short>::max();
-                          paligned[cand_id] = 0;
-                          pmatches[cand_id] = 0;
-                          pmismatches[cand_id] = 0;
-                          pgaps[cand_id] = 0;
-                          pcigar[cand_id] = xstrdup("");
-                          length = 0;
-                          done++;
-                        }
-                    }
-
-                  if (length > 0)
-                    {
-                      seq_id[cc] = cand_id;
-                      char const * address = db.getsequence(seqnos[cand_id]);
-                      d_address[cc] = reinterpret_cast<BYTE const *>(address);
-                      d_length[cc] = static_cast<uint64_t>(length);
-                      d_begin[cc] = reinterpret_cast<unsigned char const *>(address);
-                      d_end[cc] = reinterpret_cast<unsigned char const *>(address) + length;
-                      d_offset[cc] = static_cast<uint64_t>(dir - dirbuffer);
-                      overflow[cc] = false;
-
-                      set_channel(H0, c, 0);
-                      set_channel(H1, c, static_cast<CELL>(- s->penalty_gap_open_query_left
-                        - (1 * s->penalty_gap_extension_query_left)));
-                      set_channel(H2, c, static_cast<CELL>(- s->penalty_gap_open_query_left
-                        - (2 * s->penalty_gap_extension_query_left)));
-                      set_channel(H3, c, static_cast<CELL>(- s->penalty_gap_open_query_left
-                        - (3 * s->penalty_gap_extension_query_left)));
-
-                      set_channel(F0, c, static_cast<CELL>(- s->penalty_gap_open_query_left
-                        - (1 * s->penalty_gap_extension_query_left)));
-                      set_channel(F1, c, static_cast<CELL>(- s->penalty_gap_open_query_left
-                        - (2 * s->penalty_gap_extension_query_left)));
-                      set_channel(F2, c, static_cast<CELL>(- s->penalty_gap_open_query_left
-                        - (3 * s->penalty_gap_extension_query_left)));
-                      set_channel(F3, c, static_cast<CELL>(- s->penalty_gap_open_query_left
-                        - (4 * s->penalty_gap_extension_query_left)));
-
-                      /* fill channel */
-
-                      for (int j = 0; j < CDEPTH; j++)
-                        {
-                          if (d_begin[cc] < d_end[cc])
-                            {
-                              dseq[(CHANNELS * j) + c] =
-                                map_4bit(static_cast<char>(*(d_begin[cc]++)));
-                            }
-                          else
-                            {
-                              dseq[(CHANNELS * j) + c] = 0;
-                            }
-                        }
-                      if (d_begin[cc] == d_end[cc])
-                        {
-                          easy = false;
-                        }
-                    }
-                  else
-                    {
-                      /* no more sequences, empty channel */
-
-                      seq_id[cc] = -1;
-                      d_address[cc] = nullptr;
-                      d_begin[cc] = &zero;
-                      d_end[cc] = d_begin[cc];
-                      d_length[cc] = 0;
-                      d_offset[cc] = 0;
-                      for (int j = 0; j < CDEPTH; j++)
-                        {
-                          dseq[(CHANNELS * j) + c] = 0;
-                        }
-                    }
-                }
-              T = v_shift_left(T);
-            }
-
-          if (done == sequences)
-            {
-              break;
-            }
-
-          /* make masked versions of QR and R for gaps in target */
-
-          M_QR_target_left = v_and(M, QR_target_left);
-          M_R_target_left = v_and(M, R_target_left);
-
-          /* make masked versions of QR for gaps in query at target left end */
-
-          M_QR_query_interior = v_and(M, QR_query_interior);
-          M_QR_query_right = v_and(M, QR_query_right);
-
-          dprofile_fill16(dprofile, reinterpret_cast<CELL *>(s->matrix.data()), dseq);
-
-          /* create vectors of gap penalties for target depending on whether
-             any of the database sequences ended in these four columns */
-
-          if (easy)
-            {
-              for (unsigned int j = 0; j < CDEPTH; j++)
-                {
-                  QR_target[j] = QR_target_interior;
-                  R_target[j]  = R_target_interior;
-                }
-            }
-          else
-            {
-              /* one or more sequences ended */
-
-              VECTOR_SHORT const QR_diff = v_sub(QR_target_right,
-                                           QR_target_interior);
-              VECTOR_SHORT const R_diff  = v_sub(R_target_right,
-                                           R_target_interior);
-              for (unsigned int j = 0; j < CDEPTH; j++)
-                {
-                  VECTOR_SHORT MM = v_zero();
-                  VECTOR_SHORT TT = T0;
-                  for (size_t c = 0; c < CHANNELS; c++)
-                    {
-                      if ((d_begin[c] == d_end[c]) and
-                          (j >= ((d_length[c] + 3) % 4)))
-                        {
-                          MM = v_xor(MM, TT);
-                        }
-                      TT = v_shift_left(TT);
-                    }
-                  QR_target[j] = v_add(QR_target_interior,
-                                       v_and(QR_diff, MM));
-                  R_target[j]  = v_add(R_target_interior,
-                                       v_and(R_diff, MM));
-                }
-            }
-
-          VECTOR_SHORT h_min;
-          VECTOR_SHORT h_max;
-
-          aligncolumns_first(S.data(), hep, qp,
-                             QR_query_interior, R_query_interior,
-                             QR_query_right, R_query_right,
-                             QR_target[0], R_target[0],
-                             QR_target[1], R_target[1],
-                             QR_target[2], R_target[2],
-                             QR_target[3], R_target[3],
-                             H0, H1, H2, H3,
-                             F0, F1, F2, F3,
-                             & h_min, & h_max,
-                             M,
-                             M_QR_target_left, M_R_target_left,
-                             M_QR_query_interior,
-                             M_QR_query_right,
-                             static_cast<int64_t>(qlen), dir);
-
-          VECTOR_SHORT h_min_vector;
-          VECTOR_SHORT h_max_vector;
-          v_store(& h_min_vector, h_min);
-          v_store(& h_max_vector, h_max);
-          for (int c = 0; c < CHANNELS; c++)
-            {
-              if (not overflow[static_cast<size_t>(c)])
-                {
-                  signed short const h_min_c = get_channel(h_min_vector, c);
-                  signed short const h_max_c = get_channel(h_max_vector, c);
-                  if ((h_min_c <= score_min) or (h_max_c >= score_max))
-                    {
-                      overflow[static_cast<size_t>(c)] = true;
-                    }
-                }
-            }
-        }
-
-      H0 = v_sub(H3, R_query_left);
-      H1 = v_sub(H0, R_query_left);
-      H2 = v_sub(H1, R_query_left);
-      H3 = v_sub(H2, R_query_left);
-
-      F0 = v_sub(F3, R_query_left);
-      F1 = v_sub(F0, R_query_left);
-      F2 = v_sub(F1, R_query_left);
-      F3 = v_sub(F2, R_query_left);
-
-      dir += 4 * 4 * qlen;
-
-      if (dir >= dirbuffer + dirbuffersize)
-        {
-          dir -= dirbuffersize;
-        }
-    }
+  search16_kernel<Simd_128>(s, sequences, seqnos, pscores, paligned, pmatches,
+                            pmismatches, pgaps, pcigar, db);
 }
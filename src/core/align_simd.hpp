@@ -67,6 +67,7 @@ using WORD = unsigned short;
 using BYTE = unsigned char;
 struct s16info_s;
 struct Database;
+struct Parameters;
 
 
 // The score/penalty parameters are int64_t rather than CELL: search16_init
@@ -87,7 +88,36 @@ auto search16_init(int64_t score_match,
                    int64_t penalty_gap_extension_target_interior,
                    int64_t penalty_gap_extension_query_right,
                    int64_t penalty_gap_extension_target_right,
-                   bool score_n_mismatch) -> struct s16info_s *;
+                   bool score_n_mismatch,
+                   int channels) -> struct s16info_s *;
+
+
+// Number of target sequences aligned side by side (one per 16-bit
+// vector lane): 8 with 128-bit vectors, 16 with AVX2 and 32 with
+// AVX-512BW. The wider variants are x86_64 only and are picked from
+// the features found by cpu_features_detect().
+auto search16_select_channels(struct Parameters const & parameters) -> int;
+
+
+// Lane count of an initialised aligner, i.e. the number of targets a
+// single search16 call processes in parallel.
+auto search16_channels(s16info_s const * searchinfo) -> unsigned int;
+
+
+// Lane count of search16_bounds, or 0 when this CPU or scoring scheme has
+// no 8-bit variant.
+auto search16_bounds_channels(s16info_s const * searchinfo) -> unsigned int;
+
+
+// Upper bounds on the optimal global alignment scores of the query against
+// the targets, computed in saturating 8-bit arithmetic over twice as many
+// lanes as search16. SHRT_MAX means no bound (the scores went out of
+// range, or search16_bounds_channels() is 0).
+auto search16_bounds(s16info_s * searchinfo,
+                     unsigned int sequences,
+                     unsigned int const * seqnos,
+                     CELL * pbounds,
+                     struct Database const & db) -> void;
 
 
 auto search16_exit(s16info_s * searchinfo) -> void;
@@ -0,0 +1,1187 @@
+/*
+
+  VSEARCH: a versatile open source tool for metagenomics
+
+  Copyright (C) 2014-2026, Torbjorn Rognes, Frederic Mahe and Tomas Flouri
+  All rights reserved.
+
+  Contact: Torbjorn Rognes <torognes@ifi.uio.no>,
+  Department of Informatics, University of Oslo,
+  PO Box 1080 Blindern, NO-0316 Oslo, Norway
+
+  This software is dual-licensed and available under a choice
+  of one of two licenses, either under the terms of the GNU
+  General Public License version 3 or the BSD 2-Clause License.
+
+
+  GNU General Public License version 3
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+  The BSD 2-Clause License
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#pragma once
+
+/* The 16-bit global aligner (search16) shared by every SIMD width.
+
+   core/align_simd.cpp implements search16() for the 128-bit vectors of
+   every architecture (8 channels). On x86_64 the same algorithm is also
+   compiled for 256-bit AVX2 vectors (16 channels) and 512-bit AVX-512BW
+   vectors (32 channels) in arch/x86_64/AVX2/ and arch/x86_64/AVX512/,
+   each built with its own -m flag and selected at runtime (see
+   search16_select_channels). This header holds the state they share and
+   the channel-generic kernel, written once as templates over a small
+   "Simd" traits class that each translation unit defines. The AVX2 and
+   AVX-512BW units also instantiate it with 8-bit cells (32 and 64
+   channels) and without traceback, for the score bounds of
+   search16_bounds(). The traits are:
+
+     cell           the signed cell type: CELL, or signed char for the
+                    byte-precision score bounds (search16_bounds)
+     vector         the vector type holding 'channels' cells
+     mask           an unsigned integer wide enough for v_mask_gt()
+     channels       number of cells (alignments) per vector
+     mask_bits      number of bits v_mask_gt() sets per channel
+     v_add, v_sub, v_sub_unsigned, v_max, v_min, v_and, v_xor, v_dup,
+     v_zero, v_shift_left (by one cell, towards higher channels),
+     v_mask_gt, and dprofile_fill (build the target profile of CDEPTH
+     columns for all channels).
+
+   The kernel lives in an anonymous namespace on purpose: the translation
+   units including it are compiled for different instruction sets, and an
+   inline function shared between them could be merged by the linker into
+   a single copy using instructions the host cpu lacks. */
+
+#include "vsearch.h"
+#include "core/db.hpp"
+#include "utils/maps.hpp"
+#include "utils/string_alloc.hpp"
+#include <algorithm>  // std::min, std::max
+#include <array>
+#include <cstdint>  // int64_t, uint64_t
+#include <cstdio>  // std::snprintf
+#include <cstring>  // std::memcpy, std::memmove, std::strcpy, std::strlen
+#include <limits>
+
+
+using CELL = signed short;
+using BYTE = unsigned char;
+
+constexpr auto matrix_size = 16;
+constexpr auto CDEPTH = 4;
+constexpr auto maxseqlenproduct = 25000000LL;
+constexpr auto maxseqlensum = 65535LL;
+
+/* widest vector supported (AVX-512, 64 bytes): buffers are allocated with
+   xmalloc, which aligns to at least that */
+constexpr auto max_channels = 32;
+
+
+/*
+  Due to memory usage, limit the product of the length of the sequences.
+  If the product of the query length and any target sequence length
+  is above the limit, the alignment will not be computed and a score
+  of SHORT_MAX (+32,767) will be returned as the score.
+  If an overflow occurs during alignment computation, a score of
+  SHORT_MAX (+32,767) will also be returned.
+
+  The limit is set to 5 000 * 5 000 = 25 000 000. This will allocate up to
+  200 MB per thread with 8 channels, and 400 MB with the 16 or 32 channels
+  of AVX2 or AVX-512BW (32-bit direction masks). It will align
+  pairs of sequences less than 5000 nt long using the SIMD implementation,
+  larger alignments will be performed with the linear memory aligner.
+
+  A second limit applies to the SUM of the two lengths. The per-alignment
+  statistics counters in backtrack16 (aligned/matches/mismatches/gaps) are
+  unsigned short, and the alignment path length is at most qlen + dlen, so a
+  sum above 65 535 would wrap those counters. Pairs exceeding the sum limit
+  are therefore also diverted to the linear memory aligner (whose statistics
+  are int64). Both limits are combined in search16_fits().
+*/
+
+struct s16info_s
+{
+  /* 16 x 16 score matrix, one row per target symbol */
+  alignas(64) std::array<CELL, matrix_size * matrix_size> matrix {{}};
+  CELL * hearray = nullptr;   // H and E vectors, two per query position
+  CELL * dprofile = nullptr;  // matrix_size x CDEPTH vectors
+  CELL ** qtable = nullptr;   // per query position: its row of dprofile
+  void * dir = nullptr;       // direction masks (Simd::mask elements)
+  char * qseq = nullptr;
+  uint64_t diralloc = 0;      // bytes
+
+  char * cigar = nullptr;
+  char * cigarend = nullptr;
+  int64_t cigaralloc = 0;
+  int opcount = 0;
+  char op = '\0';
+
+  int channels = 0;  // 8, 16 or 32: width of the vectors in use
+  int qlen = 0;
+  int maxdlen = 0;
+  CELL penalty_gap_open_query_left = 0;
+  CELL penalty_gap_open_target_left = 0;
+  CELL penalty_gap_open_query_interior = 0;
+  CELL penalty_gap_open_target_interior = 0;
+  CELL penalty_gap_open_query_right = 0;
+  CELL penalty_gap_open_target_right = 0;
+  CELL penalty_gap_extension_query_left = 0;
+  CELL penalty_gap_extension_target_left = 0;
+  CELL penalty_gap_extension_query_interior = 0;
+  CELL penalty_gap_extension_target_interior = 0;
+  CELL penalty_gap_extension_query_right = 0;
+  CELL penalty_gap_extension_target_right = 0;
+  bool n_mismatch = false;  // treat alignment against N as a mismatch (opt_n_mismatch)
+  bool force_scalar_fallback = false;  // a score/penalty exceeded the 16-bit cell range: defer every pair to the scalar aligner
+
+  /* byte-precision score bounds (search16_bounds), twice the channels */
+  alignas(64) std::array<signed char, matrix_size * matrix_size> matrix8 {{}};
+  signed char * hearray8 = nullptr;
+  signed char * dprofile8 = nullptr;
+  signed char ** qtable8 = nullptr;
+  int bounds_channels = 0;  // 0: no 8-bit variant, or scores it cannot bound
+};
+
+
+// anonymous namespace: one private copy per instruction set (see above)
+namespace {
+
+  /* Whether the SIMD aligner can represent an alignment of a query of length
+     qlen against a target of length dlen, given the product limit (DP work /
+     direction buffer memory) and the sum limit (16-bit statistics counters).
+     The sum is tested first so the product multiplication cannot overflow for
+     an accepted pair. Pairs that do not fit are aligned by linmemalign. */
+  inline auto search16_fits(uint64_t const qlen, uint64_t const dlen) -> bool
+  {
+    return (static_cast<int64_t>(qlen + dlen) <= maxseqlensum)
+       and (static_cast<int64_t>(qlen) * static_cast<int64_t>(dlen) <= maxseqlenproduct);
+  }
+
+
+  /* Report a pair the SIMD aligner does not handle: the SHRT_MAX score
+     sentinel tells the caller to re-align it with the linear memory
+     aligner. */
+  inline auto search16_defer(int64_t const cand_id,
+                             CELL * pscores,
+                             unsigned short * paligned,
+                             unsigned short * pmatches,
+                             unsigned short * pmismatches,
+                             unsigned short * pgaps,
+                             char ** pcigar) -> void
+  {
+    pscores[cand_id] = std::numeric_limits<short>::max();
+    paligned[cand_id] = 0;
+    pmatches[cand_id] = 0;
+    pmismatches[cand_id] = 0;
+    pgaps[cand_id] = 0;
+    pcigar[cand_id] = xstrdup("");
+  }
+
+
+  /* Read and write a single 16-bit channel (lane) of a SIMD vector.
+
+     The DP vectors hold several independent alignments. Accessing a lane
+     through a reinterpreted (CELL *) pointer is a strict-aliasing violation:
+     the vector object has type VECTOR_SHORT, so reading or writing it through
+     an unrelated CELL lvalue is undefined behaviour. With GCC 9 or later at
+     -O3 on x86_64 this miscompiled the per-channel reset of the H and F
+     vectors, producing wrong alignments (see issue #589). std::memcpy accesses
+     the object representation as bytes, which is always well-defined, and the
+     compiler lowers it to a plain vector-lane move. */
+  template <typename Cell, typename Vector>
+  inline auto get_channel(Vector const & vector, int const channel) -> Cell
+  {
+    Cell value = 0;
+    std::memcpy(&value,
+                reinterpret_cast<char const *>(&vector) + (static_cast<size_t>(channel) * sizeof(Cell)),
+                sizeof(Cell));
+    return value;
+  }
+
+  template <typename Cell, typename Vector>
+  inline auto set_channel(Vector & vector, int const channel, Cell const value) -> void
+  {
+    std::memcpy(reinterpret_cast<char *>(&vector) + (static_cast<size_t>(channel) * sizeof(Cell)),
+                &value,
+                sizeof(Cell));
+  }
+
+
+  /* Narrow a score or penalty to the cell type, saturating like the vector
+     arithmetic does. The 16-bit values always fit (search16_init clamps
+     them); the 8-bit bounds pass relies on the saturation. */
+  template <typename Cell>
+  inline auto saturate_cell(int64_t const value) -> Cell
+  {
+    return static_cast<Cell>(std::max(int64_t{std::numeric_limits<Cell>::min()},
+                                      std::min(value, int64_t{std::numeric_limits<Cell>::max()})));
+  }
+
+
+  inline auto compute_score_min(struct s16info_s const & alignment) -> short {
+    auto const gap_penalty_max = std::max({
+        0,
+        alignment.penalty_gap_open_query_left + alignment.penalty_gap_extension_query_left,
+        alignment.penalty_gap_open_query_interior + alignment.penalty_gap_extension_query_interior,
+        alignment.penalty_gap_open_query_right + alignment.penalty_gap_extension_query_right,
+        alignment.penalty_gap_open_target_left + alignment.penalty_gap_extension_target_left,
+        alignment.penalty_gap_open_target_interior + alignment.penalty_gap_extension_target_interior,
+        alignment.penalty_gap_open_target_right + alignment.penalty_gap_extension_target_right
+      });
+
+    return static_cast<short>(std::numeric_limits<short>::min() + gap_penalty_max);
+  }
+
+
+  /*
+    The direction bits are set as follows:
+    in DIR[0..1] if F>H initially (must go up) (4th pri)
+    in DIR[2..3] if E>max(H,F) (must go left) (3rd pri)
+    in DIR[4..5] if new F>H (must extend up) (2nd pri)
+    in DIR[6..7] if new E>H (must extend left) (1st pri)
+    no bits set: go diagonally
+
+    onestep() advances one block of DP cells. Its fifth parameter is a
+    pointer into the direction buffer where the four direction masks for
+    this block are written, one per v_mask_gt comparison, each holding
+    Simd::mask_bits bits per channel. Without traceback (score bounds
+    only) no directions are recorded.
+  */
+
+  template <typename Simd, bool traceback>
+  inline auto onestep(typename Simd::vector & H,
+                      typename Simd::vector & N,
+                      typename Simd::vector & F,
+                      typename Simd::vector const V,
+                      typename Simd::mask * path,
+                      typename Simd::vector & E,
+                      typename Simd::vector const QR_q,
+                      typename Simd::vector const R_q,
+                      typename Simd::vector const QR_t,
+                      typename Simd::vector const R_t,
+                      typename Simd::vector & H_min,
+                      typename Simd::vector & H_max) -> void
+  {
+    H = Simd::v_add(H, V);
+    if (traceback)
+      {
+        path[0] = Simd::v_mask_gt(F, H);
+      }
+    H = Simd::v_max(H, F);
+    if (traceback)
+      {
+        path[1] = Simd::v_mask_gt(E, H);
+      }
+    H = Simd::v_max(H, E);
+    H_min = Simd::v_min(H_min, H);
+    H_max = Simd::v_max(H_max, H);
+    N = H;
+    auto const HF = Simd::v_sub(H, QR_t);
+    F = Simd::v_sub(F, R_t);
+    if (traceback)
+      {
+        path[2] = Simd::v_mask_gt(F, HF);
+      }
+    F = Simd::v_max(F, HF);
+    auto const HE = Simd::v_sub(H, QR_q);
+    E = Simd::v_sub(E, R_q);
+    if (traceback)
+      {
+        path[3] = Simd::v_mask_gt(E, HE);
+      }
+    E = Simd::v_max(E, HE);
+  }
+
+
+  /* The four direction masks of query position i in column k of a block,
+     or none when the alignment is scored without traceback. */
+  template <bool traceback, typename Mask>
+  inline auto path(Mask * dir, int64_t const i, int64_t const k) -> Mask *
+  {
+    return traceback ? dir + (16 * i) + (4 * k) : nullptr;
+  }
+
+
+  /* The gap penalty vectors used by the aligncolumns_* kernels. */
+  template <typename Simd>
+  struct column_penalties {
+    typename Simd::vector QR_q_i;
+    typename Simd::vector R_q_i;
+    typename Simd::vector QR_q_r;
+    typename Simd::vector R_q_r;
+    std::array<typename Simd::vector, CDEPTH> QR_t;
+    std::array<typename Simd::vector, CDEPTH> R_t;
+  };
+
+
+  /* Masks for the channels where a new target sequence starts in this
+     block of columns (aligncolumns_first only). */
+  template <typename Simd>
+  struct channel_restart {
+    typename Simd::vector Mm;
+    typename Simd::vector M_QR_t_left;
+    typename Simd::vector M_R_t_left;
+    typename Simd::vector M_QR_q_interior;
+    typename Simd::vector M_QR_q_right;
+  };
+
+
+  /* Align CDEPTH target columns against the whole query. With restart
+     set, first reset the H and E values of the channels where a new target
+     sequence starts (aligncolumns_first); otherwise all channels continue
+     (aligncolumns_rest). */
+  template <typename Simd, bool restart, bool traceback>
+  auto aligncolumns(typename Simd::vector * Sm,
+                    typename Simd::vector * hep,
+                    typename Simd::cell * const * qp,
+                    column_penalties<Simd> const & p,
+                    std::array<typename Simd::vector, CDEPTH> const & h,
+                    std::array<typename Simd::vector, CDEPTH> f,
+                    typename Simd::vector * _h_min,
+                    typename Simd::vector * _h_max,
+                    channel_restart<Simd> m,
+                    int64_t ql,
+                    typename Simd::mask * dir) -> void
+  {
+    using vector = typename Simd::vector;
+
+    vector h0 = h[0];
+    vector h1 = h[1];
+    vector h2 = h[2];
+    vector h3 = h[3];
+    vector h4;
+    vector h5;
+    vector h6;
+    vector h7;
+    vector h8;
+    vector E;
+    vector const * vp = nullptr;
+
+    vector h_min = Simd::v_zero();
+    vector h_max = Simd::v_zero();
+
+    int64_t i = 0;
+
+    for (auto k = 0U; k < CDEPTH; ++k)
+      {
+        f[k] = Simd::v_sub(f[k], p.QR_t[k]);
+      }
+
+    for (i = 0; i < ql - 1; i++)
+      {
+        vp = reinterpret_cast<vector const *>(qp[i]);
+
+        h4 = hep[(2 * i) + 0];
+
+        E  = hep[(2 * i) + 1];
+
+        if (restart)
+          {
+            /*
+              Initialize selected h and e values for next/this round.
+              First zero those cells where a new sequence starts
+              by using an unsigned saturated subtraction of a huge value to
+              set it to zero.
+              Then use signed subtraction to obtain the correct value.
+            */
+
+            h4 = Simd::v_sub_unsigned(h4, m.Mm);
+            h4 = Simd::v_sub(h4, m.M_QR_t_left);
+
+            E  = Simd::v_sub_unsigned(E, m.Mm);
+            E  = Simd::v_sub(E, m.M_QR_t_left);
+            E  = Simd::v_sub(E, m.M_QR_q_interior);
+
+            m.M_QR_t_left = Simd::v_add(m.M_QR_t_left, m.M_R_t_left);
+          }
+
+        onestep<Simd, traceback>(h0, h5, f[0], vp[0], path<traceback>(dir, i, 0), E,
+                      p.QR_q_i, p.R_q_i, p.QR_t[0], p.R_t[0], h_min, h_max);
+        onestep<Simd, traceback>(h1, h6, f[1], vp[1], path<traceback>(dir, i, 1), E,
+                      p.QR_q_i, p.R_q_i, p.QR_t[1], p.R_t[1], h_min, h_max);
+        onestep<Simd, traceback>(h2, h7, f[2], vp[2], path<traceback>(dir, i, 2), E,
+                      p.QR_q_i, p.R_q_i, p.QR_t[2], p.R_t[2], h_min, h_max);
+        onestep<Simd, traceback>(h3, h8, f[3], vp[3], path<traceback>(dir, i, 3), E,
+                      p.QR_q_i, p.R_q_i, p.QR_t[3], p.R_t[3], h_min, h_max);
+
+        hep[(2 * i) + 0] = h8;
+        hep[(2 * i) + 1] = E;
+
+        h0 = h4;
+        h1 = h5;
+        h2 = h6;
+        h3 = h7;
+      }
+
+    /* the final round - using query gap penalties for right end */
+
+    vp = reinterpret_cast<vector const *>(qp[i]);
+
+    E  = hep[(2 * i) + 1];
+
+    if (restart)
+      {
+        E  = Simd::v_sub_unsigned(E, m.Mm);
+        E  = Simd::v_sub(E, m.M_QR_t_left);
+        E  = Simd::v_sub(E, m.M_QR_q_right);
+      }
+
+    onestep<Simd, traceback>(h0, h5, f[0], vp[0], path<traceback>(dir, i, 0), E,
+                  p.QR_q_r, p.R_q_r, p.QR_t[0], p.R_t[0], h_min, h_max);
+    onestep<Simd, traceback>(h1, h6, f[1], vp[1], path<traceback>(dir, i, 1), E,
+                  p.QR_q_r, p.R_q_r, p.QR_t[1], p.R_t[1], h_min, h_max);
+    onestep<Simd, traceback>(h2, h7, f[2], vp[2], path<traceback>(dir, i, 2), E,
+                  p.QR_q_r, p.R_q_r, p.QR_t[2], p.R_t[2], h_min, h_max);
+    onestep<Simd, traceback>(h3, h8, f[3], vp[3], path<traceback>(dir, i, 3), E,
+                  p.QR_q_r, p.R_q_r, p.QR_t[3], p.R_t[3], h_min, h_max);
+
+    hep[(2 * i) + 0] = h8;
+    hep[(2 * i) + 1] = E;
+
+    Sm[0] = h5;
+    Sm[1] = h6;
+    Sm[2] = h7;
+    Sm[3] = h8;
+
+    *_h_min = h_min;
+    *_h_max = h_max;
+  }
+
+
+  inline auto pushop(s16info_s * s, char const newop) -> void
+  {
+    if (newop == s->op) {
+      ++s->opcount;
+      return;
+    }
+    *--s->cigarend = s->op;
+    if (s->opcount > 1)
+      {
+        static constexpr auto size = 11;
+        std::array<char, size> buffer {{}};
+        const auto length = std::snprintf(buffer.data(), size, "%d", s->opcount);
+        s->cigarend -= length;
+        std::memcpy(s->cigarend, buffer.data(), static_cast<size_t>(length));
+      }
+    s->op = newop;
+    s->opcount = 1;
+  }
+
+
+  inline auto finishop(s16info_s * s) -> void
+  {
+    if ((s->op != 0) and (s->opcount != 0))
+      {
+        *--s->cigarend = s->op;
+        if (s->opcount > 1)
+          {
+            static constexpr auto size = 11;
+            std::array<char, size> buffer {{}};
+            const auto length = std::snprintf(buffer.data(), size, "%d", s->opcount);
+            s->cigarend -= length;
+            std::memcpy(s->cigarend, buffer.data(), static_cast<size_t>(length));
+          }
+        s->op = 0;
+        s->opcount = 0;
+      }
+  }
+
+
+  template <typename Simd>
+  auto backtrack16(s16info_s * s,
+                   char const * dseq,
+                   uint64_t dlen,
+                   uint64_t offset,
+                   uint64_t channel,
+                   unsigned short * paligned,
+                   unsigned short * pmatches,
+                   unsigned short * pmismatches,
+                   unsigned short * pgaps) -> void
+  {
+    using mask = typename Simd::mask;
+
+    auto const * dirbuffer = static_cast<mask const *>(s->dir);
+    uint64_t const dirbuffersize = static_cast<uint64_t>(s->qlen) * static_cast<uint64_t>(s->maxdlen) * 4;
+    uint64_t const qlen = static_cast<uint64_t>(s->qlen);
+    char const * qseq = s->qseq;
+
+    /* the bits of this channel in each of the four direction masks */
+    auto const channel_bits =
+      static_cast<mask>(((1ULL << Simd::mask_bits) - 1) << (Simd::mask_bits * channel));
+
+    unsigned short aligned = 0;
+    unsigned short matches = 0;
+    unsigned short mismatches = 0;
+    unsigned short gaps = 0;
+
+    int64_t i = static_cast<int64_t>(qlen) - 1;
+    int64_t j = static_cast<int64_t>(dlen) - 1;
+
+    s->cigarend = s->cigar + s->qlen + s->maxdlen + 1;
+    s->op = 0;
+    s->opcount = 1;
+
+    while ((i >= 0) and (j >= 0))
+      {
+        ++aligned;
+
+        mask const * const d = dirbuffer +
+          ((offset + (matrix_size * qlen * static_cast<uint64_t>(j / 4)) +
+            (matrix_size * static_cast<uint64_t>(i)) + (4 * static_cast<uint64_t>(j & 3))) % dirbuffersize);
+        bool const up = (d[0] & channel_bits) != 0U;
+        bool const left = (d[1] & channel_bits) != 0U;
+        bool const extup = (d[2] & channel_bits) != 0U;
+        bool const extleft = (d[3] & channel_bits) != 0U;
+
+        if ((s->op == 'I') and extleft)
+          {
+            --j;
+            pushop(s, 'I');
+          }
+        else if ((s->op == 'D') and extup)
+          {
+            --i;
+            pushop(s, 'D');
+          }
+        else if (left)
+          {
+            if (s->op != 'I')
+              {
+                ++gaps;
+              }
+            --j;
+            pushop(s, 'I');
+          }
+        else if (up)
+          {
+            if (s->op != 'D')
+              {
+                ++gaps;
+              }
+            --i;
+            pushop(s, 'D');
+          }
+        else
+          {
+            if (is_equivalent_4bit(qseq[i], dseq[j]))
+              {
+                if (s->n_mismatch and ((map_4bit(qseq[i]) == 15) or
+                                       (map_4bit(dseq[j]) == 15)))
+                  {
+                    ++mismatches;
+                  }
+                else
+                  {
+                    ++matches;
+                  }
+              }
+            else
+              {
+                ++mismatches;
+              }
+            --i;
+            --j;
+            pushop(s, 'M');
+          }
+      }
+
+    while (i >= 0)
+      {
+        ++aligned;
+        if (s->op != 'D')
+          {
+            ++gaps;
+          }
+        --i;
+        pushop(s, 'D');
+      }
+
+    while (j >= 0)
+      {
+        ++aligned;
+        if (s->op != 'I')
+          {
+            ++gaps;
+          }
+        --j;
+        pushop(s, 'I');
+      }
+
+    finishop(s);
+
+    /* move cigar to beginning of allocated memory area */
+    int const cigarlen = static_cast<int>(s->cigar + s->qlen + s->maxdlen - s->cigarend);
+    std::memmove(s->cigar, s->cigarend, static_cast<size_t>(cigarlen + 1));
+
+    * paligned = aligned;
+    * pmatches = matches;
+    * pmismatches = mismatches;
+    * pgaps = gaps;
+  }
+
+
+  /* create vectors of gap penalties for target depending on whether
+     any of the database sequences ended in these four columns */
+  template <typename Simd>
+  auto target_penalties(column_penalties<Simd> & p,
+                        bool const easy,
+                        typename Simd::vector const QR_target_interior,
+                        typename Simd::vector const R_target_interior,
+                        typename Simd::vector const QR_target_right,
+                        typename Simd::vector const R_target_right,
+                        typename Simd::vector const T0,
+                        BYTE const * const * d_begin,
+                        BYTE const * const * d_end,
+                        uint64_t const * d_length) -> void
+  {
+    if (easy)
+      {
+        for (unsigned int j = 0; j < CDEPTH; j++)
+          {
+            p.QR_t[j] = QR_target_interior;
+            p.R_t[j]  = R_target_interior;
+          }
+        return;
+      }
+
+    /* one or more sequences ended */
+
+    auto const QR_diff = Simd::v_sub(QR_target_right, QR_target_interior);
+    auto const R_diff  = Simd::v_sub(R_target_right, R_target_interior);
+    for (unsigned int j = 0; j < CDEPTH; j++)
+      {
+        auto MM = Simd::v_zero();
+        auto TT = T0;
+        for (size_t c = 0; c < Simd::channels; c++)
+          {
+            if ((d_begin[c] == d_end[c]) and
+                (j >= ((d_length[c] + 3) % 4)))
+              {
+                MM = Simd::v_xor(MM, TT);
+              }
+            TT = Simd::v_shift_left(TT);
+          }
+        p.QR_t[j] = Simd::v_add(QR_target_interior, Simd::v_and(QR_diff, MM));
+        p.R_t[j]  = Simd::v_add(R_target_interior, Simd::v_and(R_diff, MM));
+      }
+  }
+
+
+  /* flag the channels whose scores came too close to the cell limits */
+  template <typename Simd>
+  auto check_overflow(typename Simd::vector const h_min,
+                      typename Simd::vector const h_max,
+                      int const score_min,
+                      int const score_max,
+                      bool * overflow) -> void
+  {
+    using cell = typename Simd::cell;
+
+    for (int c = 0; c < Simd::channels; c++)
+      {
+        if (not overflow[c])
+          {
+            int const h_min_c = get_channel<cell>(h_min, c);
+            int const h_max_c = get_channel<cell>(h_max, c);
+            if ((h_min_c <= score_min) or (h_max_c >= score_max))
+              {
+                overflow[c] = true;
+              }
+          }
+      }
+  }
+
+
+  /* The query profile and DP state of one cell width: the 16-bit ones
+     of search16, or the 8-bit ones of search16_bounds. */
+  template <typename Simd>
+  struct kernel_buffers {
+    typename Simd::cell * dprofile;
+    typename Simd::cell const * matrix;
+    typename Simd::cell * const * qtable;
+    void * hearray;
+  };
+
+
+  /* Align a non-empty query against the targets, Simd::channels at a time.
+     With traceback, compute exact scores and alignments (search16). Without,
+     only store the score of each target in pscores, or SHRT_MAX when its
+     cells reached the top of the cell range (search16_bounds): since the
+     saturating arithmetic can only round the low values up, the score is
+     then an upper bound on the optimal score. */
+  template <typename Simd, bool traceback>
+  auto align_targets(s16info_s * s,
+                     kernel_buffers<Simd> const & buffers,
+                     unsigned int sequences,
+                     unsigned int const * seqnos,
+                     CELL * pscores,
+                     unsigned short * paligned,
+                     unsigned short * pmatches,
+                     unsigned short * pmismatches,
+                     unsigned short * pgaps,
+                     char ** pcigar,
+                     struct Database const & db) -> void
+  {
+    using vector = typename Simd::vector;
+    using mask = typename Simd::mask;
+    using cell = typename Simd::cell;
+    constexpr auto channels = static_cast<size_t>(Simd::channels);
+
+    auto * dprofile = buffers.dprofile;
+    uint64_t const qlen = static_cast<uint64_t>(s->qlen);
+    mask * dirbuffer = nullptr;
+    uint64_t dirbuffersize = 0;
+
+    if (traceback)
+      {
+        /* find longest target sequence and reallocate direction buffer */
+        uint64_t maxdlen = 0;
+        for (int64_t i = 0; i < sequences; i++)
+          {
+            uint64_t const dlen = db.getsequencelen(seqnos[i]);
+            /* skip sequences the SIMD aligner cannot handle (product/sum limits) */
+            if (search16_fits(static_cast<uint64_t>(s->qlen), dlen))
+              {
+                maxdlen = std::max(dlen, maxdlen);
+              }
+          }
+        maxdlen = 4 * ((maxdlen + 3) / 4);
+        s->maxdlen = static_cast<int>(maxdlen);
+        dirbuffersize = static_cast<uint64_t>(s->qlen) * static_cast<uint64_t>(s->maxdlen) * 4;
+
+        if (dirbuffersize * sizeof(mask) > s->diralloc)
+          {
+            s->diralloc = dirbuffersize * sizeof(mask);
+            if (s->dir != nullptr)
+              {
+                xfree(s->dir);
+              }
+            s->dir = xmalloc(s->diralloc);
+          }
+
+        dirbuffer = static_cast<mask *>(s->dir);
+
+        if (s->qlen + s->maxdlen + 1 > s->cigaralloc)
+          {
+            s->cigaralloc = s->qlen + s->maxdlen + 1;
+            if (s->cigar != nullptr)
+              {
+                xfree(s->cigar);
+              }
+            s->cigar = static_cast<char *>(xmalloc(static_cast<size_t>(s->cigaralloc)));
+          }
+      }
+
+    channel_restart<Simd> restart {};
+    column_penalties<Simd> penalties {};
+
+    std::array<BYTE const *, channels> d_begin {{}};
+    std::array<BYTE const *, channels> d_end {{}};
+    std::array<uint64_t, channels> d_offset {{}};
+    std::array<BYTE const *, channels> d_address {{}};
+    std::array<uint64_t, channels> d_length {{}};
+    std::array<int64_t, channels> seq_id {{}};
+    std::array<bool, channels> overflow {{}};
+
+    std::array<BYTE, CDEPTH * channels> dseq {{}};
+    std::array<vector, CDEPTH> S {{}};
+    std::array<vector, CDEPTH> H {{}};
+    std::array<vector, CDEPTH> F {{}};
+
+    BYTE const zero = 0;
+
+    uint64_t next_id = 0;
+    uint64_t done = 0;
+
+    auto T0 = Simd::v_zero();
+    set_channel<cell>(T0, 0, -1);
+
+    /* the penalty (or sum of penalties) v broadcast to every channel */
+    auto const dup = [](int64_t const v) -> vector { return Simd::v_dup(saturate_cell<cell>(v)); };
+
+    auto const R_query_left = dup(s->penalty_gap_extension_query_left);
+
+    penalties.QR_q_i = dup(s->penalty_gap_open_query_interior +
+                           s->penalty_gap_extension_query_interior);
+    penalties.R_q_i  = dup(s->penalty_gap_extension_query_interior);
+
+    penalties.QR_q_r = dup(s->penalty_gap_open_query_right +
+                           s->penalty_gap_extension_query_right);
+    penalties.R_q_r  = dup(s->penalty_gap_extension_query_right);
+
+    auto const QR_target_left = dup(s->penalty_gap_open_target_left +
+                                    s->penalty_gap_extension_target_left);
+    auto const R_target_left = dup(s->penalty_gap_extension_target_left);
+
+    auto const QR_target_interior = dup(s->penalty_gap_open_target_interior +
+                                        s->penalty_gap_extension_target_interior);
+    auto const R_target_interior = dup(s->penalty_gap_extension_target_interior);
+
+    auto const QR_target_right = dup(s->penalty_gap_open_target_right +
+                                     s->penalty_gap_extension_target_right);
+    auto const R_target_right = dup(s->penalty_gap_extension_target_right);
+
+    auto * hep = static_cast<vector *>(buffers.hearray);
+    auto * const * qp = buffers.qtable;
+
+    for (size_t c = 0; c < channels; c++)
+      {
+        d_begin[c] = &zero;
+        d_end[c] = d_begin[c];
+        d_address[c] = nullptr;
+        d_offset[c] = 0;
+        d_length[c] = 0;
+        seq_id[c] = -1;
+        overflow[c] = false;
+      }
+
+    /* Exact scores must stay clear of both cell limits. A bound only must
+       not reach the top: there saturation would round the scores down. */
+    int const score_min = traceback ? compute_score_min(*s) : std::numeric_limits<int>::min();
+    int const score_max = std::numeric_limits<cell>::max();
+
+    for (size_t i = 0; i < CDEPTH; i++)
+      {
+        S[i] = Simd::v_zero();
+        H[i] = Simd::v_zero();
+        F[i] = Simd::v_zero();
+      }
+
+    bool easy = false;
+
+    mask * dir = dirbuffer;
+
+    while (true)
+      {
+        vector h_min;
+        vector h_max;
+
+        if (easy)
+          {
+            /* fill all channels with symbols from the database sequences */
+
+            for (size_t c = 0; c < channels; c++)
+              {
+                for (size_t j = 0; j < CDEPTH; j++)
+                  {
+                    if (d_begin[c] < d_end[c])
+                      {
+                        dseq[(channels * j) + c] = map_4bit(static_cast<char>(*(d_begin[c]++)));
+                      }
+                    else
+                      {
+                        dseq[(channels * j) + c] = 0;
+                      }
+                  }
+                if (d_begin[c] == d_end[c])
+                  {
+                    easy = false;
+                  }
+              }
+
+            Simd::dprofile_fill(dprofile, buffers.matrix, dseq.data());
+
+            target_penalties<Simd>(penalties, easy,
+                                   QR_target_interior, R_target_interior,
+                                   QR_target_right, R_target_right, T0,
+                                   d_begin.data(), d_end.data(), d_length.data());
+
+            aligncolumns<Simd, false, traceback>(S.data(), hep, qp, penalties, H, F,
+                                      & h_min, & h_max, restart,
+                                      static_cast<int64_t>(qlen), dir);
+          }
+        else
+          {
+            /* One or more sequences ended in the previous block.
+               We have to switch over to a new sequence           */
+
+            easy = true;
+
+            auto M = Simd::v_zero();
+
+            auto T = T0;
+            for (int c = 0; c < Simd::channels; c++)
+              {
+                size_t const cc = static_cast<size_t>(c);
+                if (d_begin[cc] < d_end[cc])
+                  {
+                    /* this channel has more sequence */
+
+                    for (size_t j = 0; j < CDEPTH; j++)
+                      {
+                        if (d_begin[cc] < d_end[cc])
+                          {
+                            dseq[(channels * j) + cc] = map_4bit(static_cast<char>(*(d_begin[cc]++)));
+                          }
+                        else
+                          {
+                            dseq[(channels * j) + cc] = 0;
+                          }
+                      }
+                    if (d_begin[cc] == d_end[cc])
+                      {
+                        easy = false;
+                      }
+                  }
+                else
+                  {
+                    /* sequence in channel c ended. change of sequence */
+
+                    M = Simd::v_xor(M, T);
+
+                    int64_t cand_id = seq_id[cc];
+
+                    if (cand_id >= 0)
+                      {
+                        /* save score */
+
+                        char const * dbseq = reinterpret_cast<char const *>(d_address[cc]);
+                        int64_t const dbseqlen = static_cast<int64_t>(d_length[cc]);
+                        int64_t const z = (dbseqlen + 3) % 4;
+                        int64_t const score = get_channel<cell>(S[static_cast<size_t>(z)], c);
+
+                        if (not traceback)
+                          {
+                            pscores[cand_id] = overflow[cc] ? std::numeric_limits<short>::max() : static_cast<CELL>(score);
+                          }
+                        else if (overflow[cc])
+                          {
+                            search16_defer(cand_id, pscores, paligned, pmatches,
+                                           pmismatches, pgaps, pcigar);
+                          }
+                        else
+                          {
+                            pscores[cand_id] = static_cast<CELL>(score);
+                            backtrack16<Simd>(s, dbseq, static_cast<uint64_t>(dbseqlen), d_offset[cc], cc,
+                                              paligned + cand_id,
+                                              pmatches + cand_id,
+                                              pmismatches + cand_id,
+                                              pgaps + cand_id);
+                            pcigar[cand_id] =
+                              static_cast<char *>(xmalloc(std::strlen(s->cigar)+1));
+                            std::strcpy(pcigar[cand_id], s->cigar);
+                          }
+
+                        done++;
+                      }
+
+                    /* get next sequence of reasonable length */
+
+                    int64_t length = 0;
+
+                    while ((length == 0) and (next_id < sequences))
+                      {
+                        cand_id = static_cast<int64_t>(next_id++);
+                        length = static_cast<int64_t>(db.getsequencelen(seqnos[cand_id]));
+                        if (length == 0)
+                          {
+                            if (traceback)
+                              {
+                                search16_defer(cand_id, pscores, paligned, pmatches,
+                                               pmismatches, pgaps, pcigar);
+                              }
+                            else
+                              {
+                                pscores[cand_id] = std::numeric_limits<short>::max();
+                              }
+                            done++;
+                          }
+                        else if (traceback and (not search16_fits(static_cast<uint64_t>(s->qlen), static_cast<uint64_t>(length))))
+                          {
+                            search16_defer(cand_id, pscores, paligned, pmatches,
+                                           pmismatches, pgaps, pcigar);
+                            length = 0;
+                            done++;
+                          }
+                      }
+
+                    if (length > 0)
+                      {
+                        seq_id[cc] = cand_id;
+                        char const * address = db.getsequence(seqnos[cand_id]);
+                        d_address[cc] = reinterpret_cast<BYTE const *>(address);
+                        d_length[cc] = static_cast<uint64_t>(length);
+                        d_begin[cc] = reinterpret_cast<unsigned char const *>(address);
+                        d_end[cc] = reinterpret_cast<unsigned char const *>(address) + length;
+                        d_offset[cc] = traceback ? static_cast<uint64_t>(dir - dirbuffer) : 0;
+                        overflow[cc] = false;
+
+                        set_channel<cell>(H[0], c, 0);
+                        set_channel<cell>(H[1], c, saturate_cell<cell>(- s->penalty_gap_open_query_left
+                          - (1 * s->penalty_gap_extension_query_left)));
+                        set_channel<cell>(H[2], c, saturate_cell<cell>(- s->penalty_gap_open_query_left
+                          - (2 * s->penalty_gap_extension_query_left)));
+                        set_channel<cell>(H[3], c, saturate_cell<cell>(- s->penalty_gap_open_query_left
+                          - (3 * s->penalty_gap_extension_query_left)));
+
+                        set_channel<cell>(F[0], c, saturate_cell<cell>(- s->penalty_gap_open_query_left
+                          - (1 * s->penalty_gap_extension_query_left)));
+                        set_channel<cell>(F[1], c, saturate_cell<cell>(- s->penalty_gap_open_query_left
+                          - (2 * s->penalty_gap_extension_query_left)));
+                        set_channel<cell>(F[2], c, saturate_cell<cell>(- s->penalty_gap_open_query_left
+                          - (3 * s->penalty_gap_extension_query_left)));
+                        set_channel<cell>(F[3], c, saturate_cell<cell>(- s->penalty_gap_open_query_left
+                          - (4 * s->penalty_gap_extension_query_left)));
+
+                        /* fill channel */
+
+                        for (size_t j = 0; j < CDEPTH; j++)
+                          {
+                            if (d_begin[cc] < d_end[cc])
+                              {
+                                dseq[(channels * j) + cc] =
+                                  map_4bit(static_cast<char>(*(d_begin[cc]++)));
+                              }
+                            else
+                              {
+                                dseq[(channels * j) + cc] = 0;
+                              }
+                          }
+                        if (d_begin[cc] == d_end[cc])
+                          {
+                            easy = false;
+                          }
+                      }
+                    else
+                      {
+                        /* no more sequences, empty channel */
+
+                        seq_id[cc] = -1;
+                        d_address[cc] = nullptr;
+                        d_begin[cc] = &zero;
+                        d_end[cc] = d_begin[cc];
+                        d_length[cc] = 0;
+                        d_offset[cc] = 0;
+                        for (size_t j = 0; j < CDEPTH; j++)
+                          {
+                            dseq[(channels * j) + cc] = 0;
+                          }
+                      }
+                  }
+                T = Simd::v_shift_left(T);
+              }
+
+            if (done == sequences)
+              {
+                break;
+              }
+
+            /* make masked versions of QR and R for gaps in target */
+
+            restart.Mm = M;
+            restart.M_QR_t_left = Simd::v_and(M, QR_target_left);
+            restart.M_R_t_left = Simd::v_and(M, R_target_left);
+
+            /* make masked versions of QR for gaps in query at target left end */
+
+            restart.M_QR_q_interior = Simd::v_and(M, penalties.QR_q_i);
+            restart.M_QR_q_right = Simd::v_and(M, penalties.QR_q_r);
+
+            Simd::dprofile_fill(dprofile, buffers.matrix, dseq.data());
+
+            target_penalties<Simd>(penalties, easy,
+                                   QR_target_interior, R_target_interior,
+                                   QR_target_right, R_target_right, T0,
+                                   d_begin.data(), d_end.data(), d_length.data());
+
+            aligncolumns<Simd, true, traceback>(S.data(), hep, qp, penalties, H, F,
+                                     & h_min, & h_max, restart,
+                                     static_cast<int64_t>(qlen), dir);
+          }
+
+        check_overflow<Simd>(h_min, h_max, score_min, score_max, overflow.data());
+
+        H[0] = Simd::v_sub(H[3], R_query_left);
+        H[1] = Simd::v_sub(H[0], R_query_left);
+        H[2] = Simd::v_sub(H[1], R_query_left);
+        H[3] = Simd::v_sub(H[2], R_query_left);
+
+        F[0] = Simd::v_sub(F[3], R_query_left);
+        F[1] = Simd::v_sub(F[0], R_query_left);
+        F[2] = Simd::v_sub(F[1], R_query_left);
+        F[3] = Simd::v_sub(F[2], R_query_left);
+
+        if (traceback)
+          {
+            dir += 4 * 4 * qlen;
+
+            if (dir >= dirbuffer + dirbuffersize)
+              {
+                dir -= dirbuffersize;
+              }
+          }
+      }
+  }
+
+
+  /* search16 for a non-empty query, Simd::channels targets at a time */
+  template <typename Simd>
+  auto search16_kernel(s16info_s * s,
+                       unsigned int sequences,
+                       unsigned int const * seqnos,
+                       CELL * pscores,
+                       unsigned short * paligned,
+                       unsigned short * pmatches,
+                       unsigned short * pmismatches,
+                       unsigned short * pgaps,
+                       char ** pcigar,
+                       struct Database const & db) -> void
+  {
+    kernel_buffers<Simd> const buffers {s->dprofile, s->matrix.data(), s->qtable, s->hearray};
+    align_targets<Simd, true>(s, buffers, sequences, seqnos, pscores, paligned,
+                              pmatches, pmismatches, pgaps, pcigar, db);
+  }
+
+
+  /* search16_bounds for a non-empty query, with 8-bit cells */
+  template <typename Simd>
+  auto search16_bounds_kernel(s16info_s * s,
+                              unsigned int sequences,
+                              unsigned int const * seqnos,
+                              CELL * pbounds,
+                              struct Database const & db) -> void
+  {
+    kernel_buffers<Simd> const buffers {s->dprofile8, s->matrix8.data(), s->qtable8, s->hearray8};
+    align_targets<Simd, false>(s, buffers, sequences, seqnos, pbounds, nullptr,
+                               nullptr, nullptr, nullptr, nullptr, db);
+  }
+
+}  // end of anonymous namespace
@@ -64,7 +64,7 @@
 #include <array>
 #include <cerrno>  // errno
 #include <cstdint>  // int64_t
-#include <cstdio>  // std::FILE, std::fprintf
+#include <cstdio>  // std::FILE
 #include <cstdlib>  // std::strtoll
 #include <cstring>  // std::strstr, std::strspn
 
@@ -230,7 +230,7 @@ auto annotation_separator(bool & trailing_separator) -> char const * {
 }
 
 
-auto header_fprint_strip(std::FILE * output_handle,
+auto header_fprint_strip(Output_buffer & output,
                          char const * header,
                          int const header_length,
                          bool const strip_size,
@@ -289,7 +289,7 @@ auto header_fprint_strip(std::FILE * output_handle,
 
   if (nth_attribute == 0)
     {
-      std::fprintf(output_handle, "%.*s", header_length, header);
+      output.append(header, static_cast<std::size_t>(header_length));
       if (header_length > 0) { last_index = header_length - 1; }
     }
   else
@@ -300,9 +300,8 @@ auto header_fprint_strip(std::FILE * output_handle,
           /* print part of header in front of this attribute */
           if (attribute_start[static_cast<std::size_t>(i)] > prev_end + 1)
             {
-              std::fprintf(output_handle, "%.*s",
-                      attribute_start[static_cast<std::size_t>(i)] - prev_end - 1,
-                      header + prev_end);
+              output.append(header + prev_end,
+                            static_cast<std::size_t>(attribute_start[static_cast<std::size_t>(i)] - prev_end - 1));
               last_index = attribute_start[static_cast<std::size_t>(i)] - 2;
             }
           prev_end = attribute_end[static_cast<std::size_t>(i)];
@@ -311,9 +310,8 @@ auto header_fprint_strip(std::FILE * output_handle,
       /* print the rest, if any */
       if (header_length > prev_end + 1)
         {
-          std::fprintf(output_handle, "%.*s",
-                  header_length - prev_end,
-                  header + prev_end);
+          output.append(header + prev_end,
+                        static_cast<std::size_t>(header_length - prev_end));
           last_index = header_length - 1;
         }
     }
@@ -321,3 +319,18 @@ auto header_fprint_strip(std::FILE * output_handle,
   /* report whether the last emitted character is the annotation separator */
   return (last_index >= 0) and (header[last_index] == ';');
 }
+
+
+auto header_fprint_strip(std::FILE * output_handle,
+                         char const * header,
+                         int const header_length,
+                         bool const strip_size,
+                         bool const strip_ee,
+                         bool const strip_length) -> bool
+{
+  Output_buffer output;
+  auto const trailing_separator = header_fprint_strip(output, header, header_length,
+                                                      strip_size, strip_ee, strip_length);
+  output.write(output_handle);
+  return trailing_separator;
+}
@@ -61,6 +61,7 @@
 #pragma once
 
 #include <cstdint>  // int64_t
+#include "utils/output_buffer.hpp"
 #include <cstdio>  // std::FILE
 
 
@@ -74,3 +75,10 @@ auto header_fprint_strip(std::FILE * output_handle,
                          bool strip_size,
                          bool strip_ee,
                          bool strip_length) -> bool;
+
+auto header_fprint_strip(Output_buffer & output,
+                         char const * header,
+                         int header_length,
+                         bool strip_size,
+                         bool strip_ee,
+                         bool strip_length) -> bool;
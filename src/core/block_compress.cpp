@@ -0,0 +1,366 @@
+/*
+
+  VSEARCH: a versatile open source tool for metagenomics
+
+  Copyright (C) 2014-2026, Torbjorn Rognes, Frederic Mahe and Tomas Flouri
+  All rights reserved.
+
+  Contact: Torbjorn Rognes <torognes@ifi.uio.no>,
+  Department of Informatics, University of Oslo,
+  PO Box 1080 Blindern, NO-0316 Oslo, Norway
+
+  This software is dual-licensed and available under a choice
+  of one of two licenses, either under the terms of the GNU
+  General Public License version 3 or the BSD 2-Clause License.
+
+
+  GNU General Public License version 3
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+  The BSD 2-Clause License
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "vsearch.h"
+#include "core/block_compress.hpp"
+#include "os/dynlibs.hpp"
+#include "utils/fatal.hpp"
+#include "utils/open_file.hpp"  // OutputFileHandle
+#include <algorithm>  // std::min, std::max
+#include <array>
+#include <condition_variable>
+#include <cstddef>  // std::size_t
+#include <cstdint>  // uint64_t
+#include <cstdio>  // std::FILE, std::fwrite, std::fflush, std::ferror, std::fclose
+#include <cstring>  // std::memcpy
+#include <deque>
+#include <iterator>  // std::next
+#include <memory>  // std::unique_ptr
+#include <mutex>
+#include <thread>
+#include <utility>  // std::move
+#include <vector>
+
+
+#ifdef HAVE_ZLIB_H
+
+namespace {
+
+  constexpr std::size_t block_text_size = 0xff00;  // input per member, as bgzip
+  constexpr std::size_t block_member_size = 1U << 16U;  // BSIZE is 16 bits
+  constexpr std::size_t member_header_size = 18;
+  constexpr std::size_t member_trailer_size = 8;  // CRC32, ISIZE
+  constexpr int raw_deflate_window_bits = -15;  // no zlib wrapper
+  constexpr std::size_t max_blocks_per_thread = 4;
+
+  /* header of a gzip member with a 'BC' extra field holding BSIZE - 1 */
+  constexpr std::array<unsigned char, member_header_size> member_header
+    {{0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0, 0, 0}};
+
+  /* empty member that marks the end of a BGZF file */
+  constexpr std::array<unsigned char, 28> end_of_file_marker
+    {{0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0, 0x1b, 0,
+      3, 0, 0, 0, 0, 0, 0, 0, 0, 0}};
+
+  enum struct Block_state : unsigned char { queued, compressing, done, failed };
+
+
+  auto write_le16(unsigned char * bytes, std::size_t value) -> void {
+    bytes[0] = static_cast<unsigned char>(value & 0xffU);
+    bytes[1] = static_cast<unsigned char>((value >> 8U) & 0xffU);
+  }
+
+
+  auto write_le32(unsigned char * bytes, std::size_t value) -> void {
+    write_le16(bytes, value & 0xffffU);
+    write_le16(std::next(bytes, 2), (value >> 16U) & 0xffffU);
+  }
+
+
+  class Block_compressor
+  {
+  public:
+    Block_compressor(std::FILE * target,
+                     DynamicLibraries const & libraries,
+                     unsigned int thread_count) :
+      target_(target), libraries_(libraries),
+      max_blocks_(max_blocks_per_thread * std::size_t{thread_count}) {
+      for (auto i = 0U; i < thread_count; ++i) {
+        threads_.emplace_back(&Block_compressor::compress_blocks, this);
+      }
+    }
+
+    ~Block_compressor() {
+      {
+        std::lock_guard<std::mutex> const lock(mutex_);
+        stopping_ = true;
+      }
+      changed_.notify_all();
+      for (auto & thread : threads_) {
+        thread.join();
+      }
+      if (target_ != nullptr) {
+        static_cast<void>(std::fclose(target_));
+      }
+    }
+
+    Block_compressor(Block_compressor const &) = delete;
+    Block_compressor(Block_compressor &&) = delete;
+    auto operator=(Block_compressor const &) -> Block_compressor & = delete;
+    auto operator=(Block_compressor &&) -> Block_compressor & = delete;
+
+    // stream callbacks (see xfopen_writer)
+    static auto write_text(void * cookie, char const * buffer, std::size_t size) -> bool {
+      return static_cast<Block_compressor *>(cookie)->write(buffer, size);
+    }
+
+    static auto close_stream(void * cookie) -> bool {
+      auto * const compressor = static_cast<Block_compressor *>(cookie);
+      auto const success = compressor->finish();
+      delete compressor;
+      return success;
+    }
+
+  private:
+    struct block_s {
+      std::vector<char> text;
+      std::vector<unsigned char> member;
+      std::size_t text_size = 0;
+      std::size_t member_size = 0;
+      Block_state state = Block_state::queued;
+    };
+
+    // append text, queueing each block as it fills up
+    auto write(char const * buffer, std::size_t size) -> bool {
+      while (size > 0) {
+        if (current_ == nullptr) {
+          current_ = take_block();
+        }
+        auto const length = std::min(size, block_text_size - current_->text_size);
+        std::memcpy(std::next(current_->text.data(), static_cast<std::ptrdiff_t>(current_->text_size)),
+                    buffer, length);
+        current_->text_size += length;
+        buffer = std::next(buffer, static_cast<std::ptrdiff_t>(length));
+        size -= length;
+        if ((current_->text_size == block_text_size) and not queue_current()) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    // queue the last block, write everything, end the file and close it
+    auto finish() -> bool {
+      auto success = ((current_ == nullptr) or (current_->text_size == 0) or queue_current())
+        and write_blocks(0);
+      success = success
+        and (std::fwrite(end_of_file_marker.data(), 1, end_of_file_marker.size(), target_)
+             == end_of_file_marker.size());
+      success = (std::fflush(target_) == 0) and (std::ferror(target_) == 0) and success;
+      success = (std::fclose(target_) == 0) and success;
+      target_ = nullptr;
+      return success;
+    }
+
+    auto take_block() -> std::unique_ptr<block_s> {
+      std::unique_ptr<block_s> block;
+      {
+        std::lock_guard<std::mutex> const lock(mutex_);
+        if (not free_blocks_.empty()) {
+          block = std::move(free_blocks_.back());
+          free_blocks_.pop_back();
+        }
+      }
+      if (block == nullptr) {
+        block.reset(new block_s);
+        block->text.resize(block_text_size);
+        block->member.resize(block_member_size);
+      }
+      block->text_size = 0;
+      block->member_size = 0;
+      block->state = Block_state::queued;
+      return block;
+    }
+
+    auto queue_current() -> bool {
+      {
+        std::lock_guard<std::mutex> const lock(mutex_);
+        blocks_.push_back(std::move(current_));
+      }
+      changed_.notify_all();
+      /* write what is ready; wait for the oldest block when too many are pending */
+      return write_blocks(max_blocks_);
+    }
+
+    // Write the finished blocks at the front, in order, until at most
+    // `pending` blocks remain
+    auto write_blocks(std::size_t pending) -> bool {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (not blocks_.empty()) {
+        auto const state = blocks_.front()->state;
+        if ((state == Block_state::queued) or (state == Block_state::compressing)) {
+          if (blocks_.size() <= pending) {
+            break;
+          }
+          changed_.wait(lock);
+          continue;
+        }
+        auto block = std::move(blocks_.front());
+        blocks_.pop_front();
+        lock.unlock();
+        auto const success = (state == Block_state::done)
+          and (std::fwrite(block->member.data(), 1, block->member_size, target_) == block->member_size);
+        lock.lock();
+        free_blocks_.push_back(std::move(block));
+        if (not success) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    auto compress(z_stream & stream, block_s & block) const -> bool {
+      stream.next_in = reinterpret_cast<Bytef *>(block.text.data());
+      stream.avail_in = static_cast<uInt>(block.text_size);
+      stream.next_out = std::next(block.member.data(), member_header_size);
+      stream.avail_out = static_cast<uInt>(block_member_size - member_header_size - member_trailer_size);
+      if ((libraries_.deflate(&stream, Z_FINISH) != Z_STREAM_END)
+          or (libraries_.deflate_reset(&stream) != Z_OK)) {
+        return false;
+      }
+      auto const compressed_size = block_member_size - member_header_size
+        - member_trailer_size - stream.avail_out;
+      block.member_size = member_header_size + compressed_size + member_trailer_size;
+      std::copy(member_header.begin(), member_header.end(), block.member.begin());
+      write_le16(std::next(block.member.data(), 16), block.member_size - 1);
+      auto * const trailer = std::next(block.member.data(),
+                                       static_cast<std::ptrdiff_t>(member_header_size + compressed_size));
+      auto const crc = libraries_.crc32(0, reinterpret_cast<Bytef const *>(block.text.data()),
+                                        static_cast<uInt>(block.text_size));
+      write_le32(trailer, crc);
+      write_le32(std::next(trailer, 4), block.text_size);
+      return true;
+    }
+
+    auto compress_blocks() -> void {
+      z_stream stream {};
+      auto const ready = (libraries_.deflate_init2(&stream, Z_DEFAULT_COMPRESSION,
+                                                   raw_deflate_window_bits) == Z_OK);
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (true) {
+        block_s * block = nullptr;
+        changed_.wait(lock, [this, &block]() -> bool {
+          if (stopping_) {
+            return true;
+          }
+          for (auto const & queued : blocks_) {
+            if (queued->state == Block_state::queued) {
+              block = queued.get();
+              return true;
+            }
+          }
+          return false;
+        });
+        if (block == nullptr) {
+          break;
+        }
+        block->state = Block_state::compressing;
+        lock.unlock();
+        auto const success = ready and compress(stream, *block);
+        lock.lock();
+        block->state = success ? Block_state::done : Block_state::failed;
+        changed_.notify_all();
+      }
+      lock.unlock();
+      if (ready) {
+        libraries_.deflate_end(&stream);
+      }
+    }
+
+    std::FILE * target_;
+    DynamicLibraries const & libraries_;
+    std::size_t max_blocks_;
+    std::unique_ptr<block_s> current_;  // filled by the writing thread
+
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::deque<std::unique_ptr<block_s>> blocks_;  // in output order
+    std::vector<std::unique_ptr<block_s>> free_blocks_;
+    bool stopping_ = false;
+    std::vector<std::thread> threads_;
+  };
+
+}  // end of anonymous namespace
+
+#endif
+
+
+auto compress_output(OutputFileHandle output_handle,
+                     struct Parameters const & parameters) -> OutputFileHandle
+{
+  if ((not parameters.opt_gzip_compress) or (output_handle == nullptr))
+    {
+      return output_handle;
+    }
+
+#ifdef HAVE_ZLIB_H
+  if ((parameters.dyn_libs == nullptr) or not parameters.dyn_libs->gzip_available())
+    {
+      fatal("Compressed output (--gzip_compress) requires the zlib library");
+    }
+
+  auto const thread_count = static_cast<unsigned int>(std::max(parameters.opt_threads, int64_t{1}));
+  auto * const compressor = new Block_compressor(output_handle.release(),
+                                                 *parameters.dyn_libs,
+                                                 thread_count);
+  auto * const stream = xfopen_writer(compressor,
+                                      Block_compressor::write_text,
+                                      Block_compressor::close_stream);
+  if (stream == nullptr)
+    {
+      delete compressor;
+      fatal("Compressed output (--gzip_compress) is not supported on this system");
+    }
+  return OutputFileHandle{stream};
+#else
+  fatal("Compressed output (--gzip_compress) requires the zlib library");
+  return output_handle;
+#endif
+}
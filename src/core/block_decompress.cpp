@@ -0,0 +1,784 @@
+/*
+
+  VSEARCH: a versatile open source tool for metagenomics
+
+  Copyright (C) 2014-2026, Torbjorn Rognes, Frederic Mahe and Tomas Flouri
+  All rights reserved.
+
+  Contact: Torbjorn Rognes <torognes@ifi.uio.no>,
+  Department of Informatics, University of Oslo,
+  PO Box 1080 Blindern, NO-0316 Oslo, Norway
+
+  This software is dual-licensed and available under a choice
+  of one of two licenses, either under the terms of the GNU
+  General Public License version 3 or the BSD 2-Clause License.
+
+
+  GNU General Public License version 3
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+  The BSD 2-Clause License
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "vsearch.h"
+#include "core/block_decompress.hpp"
+#include "core/fastx.hpp"  // Format
+#include "os/dynlibs.hpp"
+#include <algorithm>  // std::min, std::max
+#include <array>
+#include <cstring>  // std::memchr, std::memcmp, std::memcpy
+#include <iterator>  // std::next, std::distance
+#include <limits>  // std::numeric_limits
+#include <utility>  // std::move
+
+
+namespace {
+
+  constexpr std::size_t read_chunk_size = 1U << 20U;  // compressed bytes per fread()
+  constexpr std::size_t job_output_size = 4U << 20U;  // decoded bytes per job (initial)
+  constexpr std::size_t bzip2_job_input = 1U << 20U;  // compressed bytes per bzip2 job
+  constexpr std::size_t bzip2_probe_size = 4U << 20U;
+  constexpr std::size_t bzip2_search_window = 16U << 20U;
+  constexpr std::size_t bgzf_max_block = 1U << 16U;
+  constexpr std::size_t gzip_header_size = 12;  // fixed part, up to XLEN
+  constexpr std::size_t gzip_trailer_size = 8;  // CRC32, ISIZE
+  constexpr std::size_t bzip2_signature_size = 10;  // "BZh" level, block magic
+  constexpr unsigned char gzip_flag_extra = 4;
+  constexpr int gzip_window_bits = 15 + 16;  // zlib: expect a gzip wrapper
+  constexpr std::array<unsigned char, 6> bzip2_block_magic {{0x31, 0x41, 0x59, 0x26, 0x53, 0x59}};
+
+  enum struct Job_state : unsigned char { queued, decoding, done, failed };
+  enum struct Decode_status : unsigned char { more, stream_end, error };
+
+
+  auto read_le16(unsigned char const * bytes) -> std::size_t {
+    return static_cast<std::size_t>(bytes[0])
+      | (static_cast<std::size_t>(bytes[1]) << 8U);
+  }
+
+
+  auto read_le32(unsigned char const * bytes) -> std::size_t {
+    return read_le16(bytes) | (read_le16(std::next(bytes, 2)) << 16U);
+  }
+
+
+  auto is_gzip_member(unsigned char const * bytes, std::size_t length) -> bool {
+    return (length >= gzip_header_size) and (bytes[0] == 0x1f)
+      and (bytes[1] == 0x8b) and (bytes[2] == 8);  // deflate
+  }
+
+
+  auto gzip_extra_length(unsigned char const * bytes) -> std::size_t {
+    return ((bytes[3] & gzip_flag_extra) != 0) ? read_le16(std::next(bytes, 10)) : 0;
+  }
+
+
+  // Total size of a BGZF block, read from the 'BC' subfield of the gzip
+  // extra field; 0 for a plain gzip member. The header and its extra
+  // field must be available.
+  auto bgzf_block_size(unsigned char const * bytes, std::size_t length) -> std::size_t {
+    if (not is_gzip_member(bytes, length)) {
+      return 0;
+    }
+    auto const extra_length = gzip_extra_length(bytes);
+    if ((extra_length == 0) or (length < gzip_header_size + extra_length)) {
+      return 0;
+    }
+    auto const * subfield = std::next(bytes, gzip_header_size);
+    auto rest = extra_length;
+    while (rest >= 4) {
+      auto const subfield_length = read_le16(std::next(subfield, 2));
+      if (subfield_length + 4 > rest) {
+        break;
+      }
+      if ((subfield[0] == 'B') and (subfield[1] == 'C') and (subfield_length == 2)) {
+        auto const block_size = read_le16(std::next(subfield, 4)) + 1;
+        auto const minimum = gzip_header_size + extra_length + gzip_trailer_size;
+        return (block_size >= minimum) ? block_size : 0;
+      }
+      subfield = std::next(subfield, static_cast<std::ptrdiff_t>(subfield_length + 4));
+      rest -= subfield_length + 4;
+    }
+    return 0;
+  }
+
+
+  auto is_bzip2_stream(unsigned char const * bytes, std::size_t length) -> bool {
+    return (length >= 4) and (bytes[0] == 'B') and (bytes[1] == 'Z')
+      and (bytes[2] == 'h') and (bytes[3] >= '1') and (bytes[3] <= '9');
+  }
+
+
+  // Offset of the first bzip2 stream header followed by a block magic,
+  // searching from `from`; `length` when there is none. bzip2 blocks are
+  // not byte-aligned, so a stream header is the only safe cut point.
+  auto find_bzip2_stream(unsigned char const * bytes,
+                         std::size_t from,
+                         std::size_t length) -> std::size_t {
+    auto position = from;
+    while (position + bzip2_signature_size <= length) {
+      auto const * found = static_cast<unsigned char const *>(
+        std::memchr(std::next(bytes, static_cast<std::ptrdiff_t>(position)), 'B',
+                    length - bzip2_signature_size + 1 - position));
+      if (found == nullptr) {
+        break;
+      }
+      position = static_cast<std::size_t>(std::distance(bytes, found));
+      if (is_bzip2_stream(found, 4)
+          and (std::memcmp(std::next(found, 4), bzip2_block_magic.data(), bzip2_block_magic.size()) == 0)) {
+        return position;
+      }
+      ++position;
+    }
+    return length;
+  }
+
+}  // end of anonymous namespace
+
+
+/* Decoder for one gzip member or bzip2 stream at a time; each thread owns one */
+
+class Block_decompressor::Stream_decoder
+{
+public:
+  Stream_decoder(Format format, DynamicLibraries const & libraries) :
+    format_(format), libraries_(libraries) {}
+
+  ~Stream_decoder() { finish(); }
+
+  Stream_decoder(Stream_decoder const &) = delete;
+  Stream_decoder(Stream_decoder &&) = delete;
+  auto operator=(Stream_decoder const &) -> Stream_decoder & = delete;
+  auto operator=(Stream_decoder &&) -> Stream_decoder & = delete;
+
+  auto is_start(unsigned char const * bytes, std::size_t length) const -> bool {
+    return (format_ == Format::gzip) ? is_gzip_member(bytes, length)
+      : is_bzip2_stream(bytes, length);
+  }
+
+  // prepare for a new member or stream
+  auto start() -> bool {
+    switch (format_) {
+    case Format::gzip:
+#ifdef HAVE_ZLIB_H
+      if (active_) {
+        return libraries_.inflate_reset(&zstream_) == Z_OK;
+      }
+      zstream_ = z_stream{};
+      active_ = (libraries_.inflate_init2(&zstream_, gzip_window_bits) == Z_OK);
+      return active_;
+#endif
+    case Format::bzip:
+#ifdef HAVE_BZLIB_H
+      finish();
+      bzstream_ = bz_stream{};
+      active_ = (libraries_.bz_decompress_init(&bzstream_, 0, 0) == BZ_OK);
+      return active_;
+#endif
+    default:
+      return false;
+    }
+  }
+
+  // Decode from input to output, advancing both
+  auto run(unsigned char const * & input, std::size_t & input_length,
+           char * & output, std::size_t & output_length) -> Decode_status {
+    constexpr auto max_chunk = std::size_t{std::numeric_limits<unsigned int>::max()};
+    auto const input_chunk = static_cast<unsigned int>(std::min(input_length, max_chunk));
+    auto const output_chunk = static_cast<unsigned int>(std::min(output_length, max_chunk));
+    auto status = Decode_status::error;
+    auto input_left = 0U;
+    auto output_left = 0U;
+
+    switch (format_) {
+    case Format::gzip:
+#ifdef HAVE_ZLIB_H
+      {
+        zstream_.next_in = const_cast<Bytef *>(input);
+        zstream_.avail_in = input_chunk;
+        zstream_.next_out = reinterpret_cast<Bytef *>(output);
+        zstream_.avail_out = output_chunk;
+        auto const result = libraries_.inflate(&zstream_, Z_NO_FLUSH);
+        input_left = zstream_.avail_in;
+        output_left = zstream_.avail_out;
+        if (result == Z_STREAM_END) {
+          status = Decode_status::stream_end;
+        }
+        else if ((result == Z_OK) or (result == Z_BUF_ERROR)) {
+          status = Decode_status::more;
+        }
+        break;
+      }
+#endif
+    case Format::bzip:
+#ifdef HAVE_BZLIB_H
+      {
+        bzstream_.next_in = const_cast<char *>(reinterpret_cast<char const *>(input));
+        bzstream_.avail_in = input_chunk;
+        bzstream_.next_out = output;
+        bzstream_.avail_out = output_chunk;
+        auto const result = libraries_.bz_decompress(&bzstream_);
+        input_left = bzstream_.avail_in;
+        output_left = bzstream_.avail_out;
+        if (result == BZ_STREAM_END) {
+          status = Decode_status::stream_end;
+        }
+        else if (result == BZ_OK) {
+          status = Decode_status::more;
+        }
+        break;
+      }
+#endif
+    default:
+      return Decode_status::error;
+    }
+
+    auto const used = std::size_t{input_chunk - input_left};
+    auto const produced = std::size_t{output_chunk - output_left};
+    input = std::next(input, static_cast<std::ptrdiff_t>(used));
+    input_length -= used;
+    output = std::next(output, static_cast<std::ptrdiff_t>(produced));
+    output_length -= produced;
+    return status;
+  }
+
+private:
+  auto finish() -> void {
+    if (not active_) {
+      return;
+    }
+    active_ = false;
+#ifdef HAVE_ZLIB_H
+    if (format_ == Format::gzip) {
+      libraries_.inflate_end(&zstream_);
+    }
+#endif
+#ifdef HAVE_BZLIB_H
+    if (format_ == Format::bzip) {
+      libraries_.bz_decompress_end(&bzstream_);
+    }
+#endif
+  }
+
+  Format format_;
+  DynamicLibraries const & libraries_;
+  bool active_ = false;
+#ifdef HAVE_ZLIB_H
+  z_stream zstream_ {};
+#endif
+#ifdef HAVE_BZLIB_H
+  bz_stream bzstream_ {};
+#endif
+};
+
+
+struct Block_decompressor::job_s
+{
+  std::vector<unsigned char> input;  // whole members or streams
+  std::vector<char> output;
+  std::size_t output_size = 0;
+  std::size_t expected_size = 0;  // decoded size, when known in advance
+  uint64_t end_offset = 0;  // file offset just past the job's input
+  Job_state state = Job_state::queued;
+};
+
+
+enum struct Block_decompressor::Cut : unsigned char { job, stream, end };
+
+
+Block_decompressor::Block_decompressor(std::FILE * input_file,
+                                       Format format,
+                                       DynamicLibraries const & libraries) :
+  input_file_(input_file), format_(format), libraries_(libraries) {}
+
+
+Block_decompressor::~Block_decompressor()
+{
+  {
+    std::lock_guard<std::mutex> const lock(mutex_);
+    stopping_ = true;
+  }
+  changed_.notify_all();
+  for (auto & thread : threads_)
+    {
+      thread.join();
+    }
+}
+
+
+auto Block_decompressor::open(std::FILE * input_file,
+                              Format format,
+                              DynamicLibraries const * libraries,
+                              unsigned int thread_count) -> std::unique_ptr<Block_decompressor>
+{
+  if ((libraries == nullptr) or (thread_count == 0))
+    {
+      return nullptr;
+    }
+
+  switch (format)
+    {
+    case Format::gzip:
+#ifdef HAVE_ZLIB_H
+      if (not libraries->gzip_available())
+        {
+          return nullptr;
+        }
+      break;
+#else
+      return nullptr;
+#endif
+
+    case Format::bzip:
+#ifdef HAVE_BZLIB_H
+      if (not libraries->bzip2_available())
+        {
+          return nullptr;
+        }
+      break;
+#else
+      return nullptr;
+#endif
+
+    default:
+      return nullptr;
+    }
+
+  std::unique_ptr<Block_decompressor> decompressor(
+    new Block_decompressor(input_file, format, *libraries));
+  if (not decompressor->probe())
+    {
+      return nullptr;
+    }
+
+  /* the reader, then the workers */
+  decompressor->max_jobs_ = (2 * std::size_t{thread_count}) + 2;
+  decompressor->threads_.emplace_back(&Block_decompressor::read_input, decompressor.get());
+  for (auto i = 0U; i < thread_count; ++i)
+    {
+      decompressor->threads_.emplace_back(&Block_decompressor::decode_jobs, decompressor.get());
+    }
+  return decompressor;
+}
+
+
+auto Block_decompressor::read(char * destination, std::size_t space) -> std::size_t
+{
+  while ((current_ == nullptr) or (current_position_ == current_->output_size))
+    {
+      if (failed_)
+        {
+          return 0;
+        }
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (current_ != nullptr)
+        {
+          free_jobs_.push_back(std::move(current_));
+        }
+      changed_.wait(lock, [this]() -> bool {
+        if (jobs_.empty())
+          {
+            return reader_done_;
+          }
+        auto const state = jobs_.front()->state;
+        return (state == Job_state::done) or (state == Job_state::failed);
+      });
+      if (jobs_.empty())
+        {
+          return 0;
+        }
+      current_ = std::move(jobs_.front());
+      jobs_.pop_front();
+      changed_.notify_all();  // room for the reader
+      current_position_ = 0;
+      position_ = current_->end_offset;
+      if (current_->state == Job_state::failed)
+        {
+          failed_ = true;
+          current_->output_size = 0;
+        }
+    }
+
+  auto const length = std::min(space, current_->output_size - current_position_);
+  std::memcpy(destination,
+              std::next(current_->output.data(), static_cast<std::ptrdiff_t>(current_position_)),
+              length);
+  current_position_ += length;
+  return length;
+}
+
+
+auto Block_decompressor::failed() const -> bool
+{
+  return failed_;
+}
+
+
+auto Block_decompressor::position() const -> uint64_t
+{
+  return position_;
+}
+
+
+/* compressed input (reader thread) */
+
+// Make at least `wanted` unconsumed bytes available, unless the input
+// ends first; returns the number available.
+auto Block_decompressor::fill(std::size_t wanted) -> std::size_t
+{
+  auto available = pending_.size() - pending_start_;
+  if ((available >= wanted) or input_end_)
+    {
+      return available;
+    }
+
+  pending_.erase(pending_.begin(),
+                 std::next(pending_.begin(), static_cast<std::ptrdiff_t>(pending_start_)));
+  pending_start_ = 0;
+  while ((available < wanted) and not input_end_)
+    {
+      auto const chunk = std::max(wanted - available, read_chunk_size);
+      pending_.resize(available + chunk);
+      auto const bytes_read = std::fread(std::next(pending_.data(), static_cast<std::ptrdiff_t>(available)),
+                                         1, chunk, input_file_);
+      available += bytes_read;
+      /* end of file or read error: a truncated member fails to decode */
+      input_end_ = (bytes_read < chunk);
+    }
+  pending_.resize(available);
+  return available;
+}
+
+
+auto Block_decompressor::consume(std::size_t length) -> void
+{
+  pending_start_ += length;
+  pending_offset_ += length;
+}
+
+
+// Check that the file starts with a BGZF block, or that a second bzip2
+// stream follows closely; otherwise decoding it as a single stream is
+// just as fast.
+auto Block_decompressor::probe() -> bool
+{
+  if (format_ == Format::gzip)
+    {
+      auto available = fill(gzip_header_size);
+      if (not is_gzip_member(pending_.data(), available))
+        {
+          return false;
+        }
+      available = fill(gzip_header_size + gzip_extra_length(pending_.data()));
+      return bgzf_block_size(pending_.data(), available) != 0;
+    }
+
+  auto const available = fill(bzip2_probe_size);
+  return is_bzip2_stream(pending_.data(), available)
+    and (find_bzip2_stream(pending_.data(), 4, available) < available);
+}
+
+
+// Gather whole BGZF blocks into a job, up to job_output_size decoded bytes
+auto Block_decompressor::cut_gzip_job(job_s & job) -> Cut
+{
+  job.input.clear();
+  job.expected_size = 0;
+
+  while (job.expected_size < job_output_size)
+    {
+      auto available = fill(gzip_header_size);
+      auto const * member = std::next(pending_.data(), static_cast<std::ptrdiff_t>(pending_start_));
+      if (not is_gzip_member(member, available))
+        {
+          break;  // end of input; trailing bytes are ignored, as by gzip
+        }
+
+      available = fill(gzip_header_size + gzip_extra_length(member));
+      member = std::next(pending_.data(), static_cast<std::ptrdiff_t>(pending_start_));
+      auto const block_size = bgzf_block_size(member, available);
+      if (block_size == 0)
+        {
+          if (job.input.empty())
+            {
+              return Cut::stream;
+            }
+          break;
+        }
+
+      available = fill(block_size);
+      member = std::next(pending_.data(), static_cast<std::ptrdiff_t>(pending_start_));
+      auto const length = std::min(block_size, available);
+      job.input.insert(job.input.end(), member, std::next(member, static_cast<std::ptrdiff_t>(length)));
+      consume(length);
+      if (length < block_size)
+        {
+          break;  // truncated block, reported by the worker
+        }
+      job.expected_size += std::min(read_le32(std::next(member, static_cast<std::ptrdiff_t>(block_size - 4))),
+                                    bgzf_max_block);
+    }
+
+  return job.input.empty() ? Cut::end : Cut::job;
+}
+
+
+// Gather whole bzip2 streams into a job of about bzip2_job_input bytes
+auto Block_decompressor::cut_bzip2_job(job_s & job) -> Cut
+{
+  auto available = fill(bzip2_signature_size);
+  if (not is_bzip2_stream(std::next(pending_.data(), static_cast<std::ptrdiff_t>(pending_start_)), available))
+    {
+      return Cut::end;  // trailing bytes are ignored, as by bzip2
+    }
+
+  auto search_from = bzip2_job_input;
+  auto wanted = bzip2_job_input + read_chunk_size;
+  auto end = std::size_t{0};
+  while (true)
+    {
+      available = fill(wanted);
+      auto const * streams = std::next(pending_.data(), static_cast<std::ptrdiff_t>(pending_start_));
+      end = find_bzip2_stream(streams, search_from, available);
+      if ((end < available) or input_end_)
+        {
+          break;
+        }
+      if (available >= bzip2_search_window)
+        {
+          return Cut::stream;
+        }
+      search_from = std::max(search_from, available + 1 - bzip2_signature_size);
+      wanted = available + read_chunk_size;
+    }
+
+  auto const * streams = std::next(pending_.data(), static_cast<std::ptrdiff_t>(pending_start_));
+  job.input.assign(streams, std::next(streams, static_cast<std::ptrdiff_t>(end)));
+  job.expected_size = 0;
+  consume(end);
+  return Cut::job;
+}
+
+
+// Decode the member or stream at the read position on the reader thread,
+// publishing the text in chunks; `job` is the first chunk
+auto Block_decompressor::decode_in_reader(Stream_decoder & decoder,
+                                          std::unique_ptr<job_s> job) -> bool
+{
+  auto status = decoder.start() ? Decode_status::more : Decode_status::error;
+  while (job != nullptr)
+    {
+      job->output.resize(std::max(job->output.size(), job_output_size));
+      job->output_size = 0;
+      while ((status == Decode_status::more) and (job->output_size < job->output.size()))
+        {
+          auto const available = fill(1);
+          if (available == 0)
+            {
+              status = Decode_status::error;  // truncated
+              break;
+            }
+          auto const * input = std::next(pending_.data(), static_cast<std::ptrdiff_t>(pending_start_));
+          auto input_length = available;
+          auto * output = std::next(job->output.data(), static_cast<std::ptrdiff_t>(job->output_size));
+          auto output_length = job->output.size() - job->output_size;
+          status = decoder.run(input, input_length, output, output_length);
+          consume(available - input_length);
+          job->output_size = job->output.size() - output_length;
+        }
+      job->state = (status == Decode_status::error) ? Job_state::failed : Job_state::done;
+      job->end_offset = pending_offset_;
+      publish(std::move(job));
+      if (status != Decode_status::more)
+        {
+          break;
+        }
+      job = take_free_job();
+    }
+  return status == Decode_status::stream_end;
+}
+
+
+// Decode a job's members or streams; false on corrupt or truncated data
+auto Block_decompressor::decode_job(Stream_decoder & decoder, job_s & job) -> bool
+{
+  auto const * input = job.input.data();
+  auto input_length = job.input.size();
+  job.output_size = 0;
+  if (job.output.size() < job.expected_size)
+    {
+      job.output.resize(job.expected_size);
+    }
+
+  while ((input_length > 0) and decoder.is_start(input, input_length))
+    {
+      if (not decoder.start())
+        {
+          return false;
+        }
+      auto status = Decode_status::more;
+      while (status == Decode_status::more)
+        {
+          if (job.output_size == job.output.size())
+            {
+              job.output.resize(std::max(2 * job.output.size(), job_output_size));
+            }
+          auto * output = std::next(job.output.data(), static_cast<std::ptrdiff_t>(job.output_size));
+          auto const space = job.output.size() - job.output_size;
+          auto output_length = space;
+          status = decoder.run(input, input_length, output, output_length);
+          job.output_size += space - output_length;
+          if ((status == Decode_status::more) and (input_length == 0) and (output_length != 0))
+            {
+              return false;  // truncated
+            }
+        }
+      if (status == Decode_status::error)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+
+/* threads */
+
+auto Block_decompressor::take_free_job() -> std::unique_ptr<job_s>
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  changed_.wait(lock, [this]() -> bool { return stopping_ or (jobs_.size() < max_jobs_); });
+  if (stopping_)
+    {
+      return nullptr;
+    }
+  if (free_jobs_.empty())
+    {
+      return std::unique_ptr<job_s>(new job_s);
+    }
+  auto job = std::move(free_jobs_.back());
+  free_jobs_.pop_back();
+  return job;
+}
+
+
+auto Block_decompressor::publish(std::unique_ptr<job_s> job) -> void
+{
+  {
+    std::lock_guard<std::mutex> const lock(mutex_);
+    jobs_.push_back(std::move(job));
+  }
+  changed_.notify_all();
+}
+
+
+auto Block_decompressor::read_input() -> void
+{
+  Stream_decoder decoder(format_, libraries_);
+  auto more = true;
+  while (more)
+    {
+      auto job = take_free_job();
+      if (job == nullptr)
+        {
+          break;
+        }
+      auto const cut = (format_ == Format::gzip) ? cut_gzip_job(*job) : cut_bzip2_job(*job);
+      switch (cut)
+        {
+        case Cut::job:
+          job->state = Job_state::queued;
+          job->end_offset = pending_offset_;
+          publish(std::move(job));
+          break;
+
+        case Cut::stream:
+          more = decode_in_reader(decoder, std::move(job));
+          break;
+
+        case Cut::end:
+          more = false;
+          break;
+        }
+    }
+
+  {
+    std::lock_guard<std::mutex> const lock(mutex_);
+    reader_done_ = true;
+  }
+  changed_.notify_all();
+}
+
+
+auto Block_decompressor::decode_jobs() -> void
+{
+  Stream_decoder decoder(format_, libraries_);
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true)
+    {
+      job_s * job = nullptr;
+      changed_.wait(lock, [this, &job]() -> bool {
+        if (stopping_)
+          {
+            return true;
+          }
+        for (auto const & queued : jobs_)
+          {
+            if (queued->state == Job_state::queued)
+              {
+                job = queued.get();
+                return true;
+              }
+          }
+        return reader_done_;
+      });
+      if (job == nullptr)
+        {
+          return;
+        }
+      job->state = Job_state::decoding;
+      lock.unlock();
+      auto const success = decode_job(decoder, *job);
+      lock.lock();
+      job->state = success ? Job_state::done : Job_state::failed;
+      changed_.notify_all();
+    }
+}
@@ -0,0 +1,169 @@
+/*
+
+  VSEARCH: a versatile open source tool for metagenomics
+
+  Copyright (C) 2014-2026, Torbjorn Rognes, Frederic Mahe and Tomas Flouri
+  All rights reserved.
+
+  Contact: Torbjorn Rognes <torognes@ifi.uio.no>,
+  Department of Informatics, University of Oslo,
+  PO Box 1080 Blindern, NO-0316 Oslo, Norway
+
+  This software is dual-licensed and available under a choice
+  of one of two licenses, either under the terms of the GNU
+  General Public License version 3 or the BSD 2-Clause License.
+
+
+  GNU General Public License version 3
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+  The BSD 2-Clause License
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>  // std::size_t
+#include <cstdint>  // uint64_t
+#include <cstdio>  // std::FILE
+#include <deque>
+#include <memory>  // std::unique_ptr
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+enum struct Format : unsigned char;  // defined in fastx.hpp
+class DynamicLibraries;
+
+
+/*
+  Block_decompressor decodes a compressed FASTA or FASTQ file with a
+  small pool of threads. It applies to files made of pieces that can be
+  decoded independently:
+
+    - BGZF files (bgzip, htslib): a series of gzip members, each
+      recording its own compressed size in a 'BC' extra field,
+    - multi-stream bzip2 files (pbzip2, concatenated files): each stream
+      starts with a byte-aligned "BZh" header followed by a block magic.
+
+  A reader thread cuts the compressed input into jobs of whole members
+  or streams, the workers decode the jobs in any order, and read() hands
+  the decoded text out in file order. A piece whose end cannot be found
+  without decoding it (a plain gzip member, or a bzip2 stream longer
+  than the search window) is decoded by the reader thread itself, in
+  chunks, so memory use stays bounded. Decoding errors are recorded and
+  reported by the caller of read(), never from a worker thread.
+*/
+
+class Block_decompressor
+{
+public:
+  // Returns nullptr when the file does not start with independent
+  // pieces, or when the compression library is missing; the caller then
+  // decodes the file as a single stream and must rewind it first.
+  static auto open(std::FILE * input_file,
+                   Format format,
+                   DynamicLibraries const * libraries,
+                   unsigned int thread_count) -> std::unique_ptr<Block_decompressor>;
+
+  ~Block_decompressor();
+
+  Block_decompressor(Block_decompressor const &) = delete;
+  Block_decompressor(Block_decompressor &&) = delete;
+  auto operator=(Block_decompressor const &) -> Block_decompressor & = delete;
+  auto operator=(Block_decompressor &&) -> Block_decompressor & = delete;
+
+  // Copy up to `space` decoded bytes to `destination`. Returns 0 at the
+  // end of the input, or after an error (see failed()).
+  auto read(char * destination, std::size_t space) -> std::size_t;
+  auto failed() const -> bool;
+  // compressed bytes consumed so far, for progress reporting
+  auto position() const -> uint64_t;
+
+private:
+  class Stream_decoder;
+  struct job_s;
+  enum struct Cut : unsigned char;
+
+  Block_decompressor(std::FILE * input_file,
+                     Format format,
+                     DynamicLibraries const & libraries);
+
+  auto fill(std::size_t wanted) -> std::size_t;
+  auto consume(std::size_t length) -> void;
+  auto probe() -> bool;
+  auto cut_gzip_job(job_s & job) -> Cut;
+  auto cut_bzip2_job(job_s & job) -> Cut;
+  auto decode_in_reader(Stream_decoder & decoder, std::unique_ptr<job_s> job) -> bool;
+  static auto decode_job(Stream_decoder & decoder, job_s & job) -> bool;
+  auto take_free_job() -> std::unique_ptr<job_s>;
+  auto publish(std::unique_ptr<job_s> job) -> void;
+  auto read_input() -> void;
+  auto decode_jobs() -> void;
+
+  std::FILE * input_file_;
+  Format format_;
+  DynamicLibraries const & libraries_;
+
+  /* compressed input not yet cut into jobs (reader thread only) */
+  std::vector<unsigned char> pending_;
+  std::size_t pending_start_ = 0;
+  uint64_t pending_offset_ = 0;
+  bool input_end_ = false;
+
+  /* shared state, guarded by mutex_ */
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  std::deque<std::unique_ptr<job_s>> jobs_;  // in file order
+  std::vector<std::unique_ptr<job_s>> free_jobs_;
+  std::size_t max_jobs_ = 0;
+  bool reader_done_ = false;
+  bool stopping_ = false;
+
+  /* job being handed out by read() (caller thread only) */
+  std::unique_ptr<job_s> current_;
+  std::size_t current_position_ = 0;
+  uint64_t position_ = 0;
+  bool failed_ = false;
+
+  std::vector<std::thread> threads_;
+};
@@ -72,6 +72,7 @@
 #include "core/unique.hpp"
 #include "utils/cigar.hpp"
 #include "utils/fatal.hpp"
+#include "utils/make_unique.hpp"
 #include "utils/maps.hpp"
 #include "utils/open_file.hpp"
 #include "utils/span.hpp"
@@ -80,6 +81,7 @@
 #include "utils/string_alloc.hpp"
 #include <algorithm>  // std::copy, std::fill, std::fill_n, std::max, std::max_element, std::min, std::transform
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <cctype>  // std::tolower
 #include <cinttypes>  // macros PRIu64 and PRId64
@@ -1880,6 +1882,27 @@ auto eval_parents(struct chimera_info_s * ci, struct chimera_cli_state_s * cli,
 }
 
 
+static auto chimera_search16_init(struct Parameters const & parameters) -> struct s16info_s *
+{
+  return search16_init(parameters.opt_match,
+                       parameters.opt_mismatch,
+                       parameters.opt_gap_open_query_left,
+                       parameters.opt_gap_open_target_left,
+                       parameters.opt_gap_open_query_interior,
+                       parameters.opt_gap_open_target_interior,
+                       parameters.opt_gap_open_query_right,
+                       parameters.opt_gap_open_target_right,
+                       parameters.opt_gap_extension_query_left,
+                       parameters.opt_gap_extension_target_left,
+                       parameters.opt_gap_extension_query_interior,
+                       parameters.opt_gap_extension_target_interior,
+                       parameters.opt_gap_extension_query_right,
+                       parameters.opt_gap_extension_target_right,
+                       parameters.opt_n_mismatch,
+                       search16_select_channels(parameters));
+}
+
+
 static auto query_init(struct searchinfo_s * search_info, int const tophits,
                        struct Database const & db,
                        struct Parameters const & parameters,
@@ -1896,21 +1919,7 @@ static auto query_init(struct searchinfo_s * search_info, int const tophits,
   search_info->kmers = search_info->kmers_v.data();
   search_info->hit_count = 0;
   search_info->uh = unique_init();
-  search_info->s = search16_init(parameters.opt_match,
-                                 parameters.opt_mismatch,
-                                 parameters.opt_gap_open_query_left,
-                                 parameters.opt_gap_open_target_left,
-                                 parameters.opt_gap_open_query_interior,
-                                 parameters.opt_gap_open_target_interior,
-                                 parameters.opt_gap_open_query_right,
-                                 parameters.opt_gap_open_target_right,
-                                 parameters.opt_gap_extension_query_left,
-                                 parameters.opt_gap_extension_target_left,
-                                 parameters.opt_gap_extension_query_interior,
-                                 parameters.opt_gap_extension_target_interior,
-                                 parameters.opt_gap_extension_query_right,
-                                 parameters.opt_gap_extension_target_right,
-                                 parameters.opt_n_mismatch);
+  search_info->s = chimera_search16_init(parameters);
   search_info->m = minheap_init(tophits);
 }
 
@@ -1967,21 +1976,7 @@ auto chimera_thread_init(struct chimera_info_s * ci, int const tophits,
       query_init(&ci->si[static_cast<size_t>(i)], tophits, db, parameters, dbindex);
     }
 
-  ci->s = search16_init(parameters.opt_match,
-                        parameters.opt_mismatch,
-                        parameters.opt_gap_open_query_left,
-                        parameters.opt_gap_open_target_left,
-                        parameters.opt_gap_open_query_interior,
-                        parameters.opt_gap_open_target_interior,
-                        parameters.opt_gap_open_query_right,
-                        parameters.opt_gap_open_target_right,
-                        parameters.opt_gap_extension_query_left,
-                        parameters.opt_gap_extension_target_left,
-                        parameters.opt_gap_extension_query_interior,
-                        parameters.opt_gap_extension_target_interior,
-                        parameters.opt_gap_extension_query_right,
-                        parameters.opt_gap_extension_target_right,
-                        parameters.opt_n_mismatch);
+  ci->s = chimera_search16_init(parameters);
 }
 
 
@@ -1995,16 +1990,207 @@ auto chimera_thread_exit(struct chimera_info_s * ci) -> void
 }
 
 
-/* Process a single query that has already been loaded into ci.
-   Shared by chimera_thread_core (CLI) and chimera_detect_single (API).
-   ci->query_seq, query_head, query_len, query_head_len, query_size must
-   be populated. allhits_list must be pre-allocated to maxcandidates.
-   lma is the per-thread linear memory aligner (fallback for SIMD overflow). */
-static auto chimera_process_query(struct chimera_info_s * ci,
-                                  std::vector<struct hit> & allhits_list,
-                                  LinearMemoryAligner & lma,
-                                  struct chimera_cli_state_s * cli,
-                                  struct Database const & db) -> Status
+/* Align the full query to the candidates first to last - 1 with the
+   aligner s, or with lma where s cannot align. The results of each
+   candidate do not depend on the others, so that disjoint ranges can be
+   aligned concurrently with different aligners. */
+static auto align_candidates(struct chimera_info_s * ci,
+                             int const first,
+                             int const last,
+                             struct s16info_s * s,
+                             LinearMemoryAligner & lma,
+                             struct Database const & db) -> void
+{
+  auto const offset = static_cast<size_t>(first);
+
+  search16_qprep(s, ci->query_seq.data(), ci->query_len);
+
+  search16(s,
+           static_cast<unsigned int>(last - first),
+           ci->cand_list.data() + offset,
+           ci->snwscore.data() + offset,
+           ci->snwalignmentlength.data() + offset,
+           ci->snwmatches.data() + offset,
+           ci->snwmismatches.data() + offset,
+           ci->snwgaps.data() + offset,
+           ci->nwcigar.data() + offset,
+           db);
+
+  for (auto i = first; i < last; ++i)
+    {
+      int64_t const target = ci->cand_list[static_cast<size_t>(i)];
+      int64_t nwscore = ci->snwscore[static_cast<size_t>(i)];
+      char * nwcigar = nullptr;
+      int64_t nwalignmentlength = 0;
+      int64_t nwmatches = 0;
+      int64_t nwmismatches = 0;
+      int64_t nwgaps = 0;
+
+      if (nwscore == std::numeric_limits<short>::max())
+        {
+          /* In case the SIMD aligner cannot align,
+             perform a new alignment with the
+             linear memory aligner */
+
+          auto const * tseq = db.getsequence(static_cast<uint64_t>(target));
+          int64_t const tseqlen = static_cast<int64_t>(db.getsequencelen(static_cast<uint64_t>(target)));
+
+          if (ci->nwcigar[static_cast<size_t>(i)] != nullptr)
+            {
+              xfree(ci->nwcigar[static_cast<size_t>(i)]);
+            }
+
+          nwcigar = xstrdup(lma.align(ci->query_seq.data(),
+                                      tseq,
+                                      ci->query_len,
+                                      tseqlen));
+          lma.alignstats(nwcigar,
+                         ci->query_seq.data(),
+                         tseq,
+                         & nwscore,
+                         & nwalignmentlength,
+                         & nwmatches,
+                         & nwmismatches,
+                         & nwgaps);
+
+          ci->nwcigar[static_cast<size_t>(i)] = nwcigar;
+          ci->nwscore[static_cast<size_t>(i)] = nwscore;
+          ci->nwalignmentlength[static_cast<size_t>(i)] = nwalignmentlength;
+          ci->nwmatches[static_cast<size_t>(i)] = nwmatches;
+          ci->nwmismatches[static_cast<size_t>(i)] = nwmismatches;
+          ci->nwgaps[static_cast<size_t>(i)] = nwgaps;
+        }
+      else
+        {
+          ci->nwscore[static_cast<size_t>(i)] = ci->snwscore[static_cast<size_t>(i)];
+          ci->nwalignmentlength[static_cast<size_t>(i)] = ci->snwalignmentlength[static_cast<size_t>(i)];
+          ci->nwmatches[static_cast<size_t>(i)] = ci->snwmatches[static_cast<size_t>(i)];
+          ci->nwmismatches[static_cast<size_t>(i)] = ci->snwmismatches[static_cast<size_t>(i)];
+          ci->nwgaps[static_cast<size_t>(i)] = ci->snwgaps[static_cast<size_t>(i)];
+        }
+    }
+}
+
+
+/* Threads working on a single query (--threads_per_query): first the
+   searches of the query parts, one task per part, then the alignments
+   of the query to the candidates, one task per range of candidates.
+   Each thread has its own aligners, each task writes its own entries of
+   ci, and the results are combined in part and candidate order, so they
+   are the same as with a single thread. As in cluster_work_pool_s, the
+   ThreadRunner is created last and its lambda captures this. */
+struct chimera_query_pool_s
+{
+  enum class phase_t { search, align };
+
+  struct chimera_info_s * ci;
+  struct Database const & db;
+  Masking const qmask;
+  int const channels;  // candidates aligned together by search16
+  std::vector<struct s16info_s *> s16;  // one per thread
+  std::vector<std::unique_ptr<LinearMemoryAligner>> lma;  // one per thread
+  phase_t phase = phase_t::search;
+  int tasks = 0;
+  int candidates_per_task = 0;
+  std::atomic<int> next_task {0};
+  std::unique_ptr<ThreadRunner> runner;  // constructed last; lambda captures this
+
+  chimera_query_pool_s(int const nthreads,
+                       struct chimera_info_s * info,
+                       struct Parameters const & parameters,
+                       struct Database const & database)
+    : ci(info),
+      db(database),
+      qmask(parameters.opt_qmask),
+      channels(search16_select_channels(parameters)),
+      s16(static_cast<std::size_t>(nthreads))
+  {
+    struct Scoring const scoring = scoring_from_options(parameters);
+    for (auto & s : s16)
+      {
+        s = chimera_search16_init(parameters);
+        lma.emplace_back(make_unique<LinearMemoryAligner>(scoring));
+      }
+    runner = make_unique<ThreadRunner>(static_cast<std::size_t>(nthreads),
+                                       [this](uint64_t const t) { worker(t); });
+  }
+
+  ~chimera_query_pool_s()
+  {
+    runner.reset();  // join the workers before freeing their aligners
+    for (auto * s : s16)
+      {
+        search16_exit(s);
+      }
+  }
+
+  chimera_query_pool_s(chimera_query_pool_s const &) = delete;
+  chimera_query_pool_s(chimera_query_pool_s &&) = delete;
+  auto operator=(chimera_query_pool_s const &) -> chimera_query_pool_s & = delete;
+  auto operator=(chimera_query_pool_s &&) -> chimera_query_pool_s & = delete;
+
+  auto search_parts() -> void
+  {
+    run(phase_t::search, ci->parts);
+  }
+
+  auto align_candidates_all() -> void
+  {
+    /* whole groups of channels, as search16 aligns that many
+       candidates at a time: a smaller range would leave channels idle */
+    auto const nthreads = static_cast<int>(s16.size());
+    auto const groups = (ci->cand_count + channels - 1) / channels;
+    candidates_per_task = channels * ((groups + nthreads - 1) / nthreads);
+    if (candidates_per_task > 0)
+      {
+        run(phase_t::align, (ci->cand_count + candidates_per_task - 1) / candidates_per_task);
+      }
+  }
+
+private:
+
+  auto run(phase_t const next_phase, int const task_count) -> void
+  {
+    phase = next_phase;
+    tasks = task_count;
+    next_task = 0;
+    runner->run();
+  }
+
+  auto worker(uint64_t const t) -> void
+  {
+    auto task = next_task++;
+    while (task < tasks)
+      {
+        if (phase == phase_t::search)
+          {
+            search_onequery(&ci->si[static_cast<size_t>(task)], qmask);
+          }
+        else
+          {
+            auto const first = task * candidates_per_task;
+            auto const last = std::min(first + candidates_per_task, ci->cand_count);
+            align_candidates(ci, first, last, s16[t], *lma[t], db);
+          }
+        task = next_task++;
+      }
+  }
+};
+
+
+/* Search the database for the candidate parents of a query that has
+   already been loaded into ci, align the query to them and choose the
+   best parents; return whether parents were found. ci->query_seq,
+   query_head, query_len, query_head_len, query_size must be populated.
+   allhits_list must be pre-allocated to maxcandidates. lma is the
+   per-thread linear memory aligner (fallback for SIMD overflow). pool,
+   if not null, spreads the part searches and the alignments over its
+   threads. */
+static auto chimera_find_parents(struct chimera_info_s * ci,
+                                 std::vector<struct hit> & allhits_list,
+                                 LinearMemoryAligner & lma,
+                                 struct chimera_query_pool_s * pool,
+                                 struct Database const & db) -> bool
 {
   struct Parameters const & parameters = *ci->parameters;
   /* partition query */
@@ -2017,10 +2203,17 @@ static auto chimera_process_query(struct chimera_info_s * ci,
 
   if (ci->query_len >= ci->parts)
     {
+      if (pool != nullptr)
+        {
+          pool->search_parts();
+        }
       std::vector<struct hit> hits;
       for (auto i = 0; i < ci->parts; ++i)
         {
-          search_onequery(&ci->si[static_cast<size_t>(i)], parameters.opt_qmask);
+          if (pool == nullptr)
+            {
+              search_onequery(&ci->si[static_cast<size_t>(i)], parameters.opt_qmask);
+            }
           search_joinhits(&ci->si[static_cast<size_t>(i)], nullptr, hits);
           for (auto & hit : hits) {
             if (hit.accepted and allhits_count < maxcandidates)
@@ -2073,99 +2266,207 @@ static auto chimera_process_query(struct chimera_info_s * ci,
 
   /* align full query to each candidate */
 
-  search16_qprep(ci->s, ci->query_seq.data(), ci->query_len);
-
-  search16(ci->s,
-           static_cast<unsigned int>(ci->cand_count),
-           ci->cand_list.data(),
-           ci->snwscore.data(),
-           ci->snwalignmentlength.data(),
-           ci->snwmatches.data(),
-           ci->snwmismatches.data(),
-           ci->snwgaps.data(),
-           ci->nwcigar.data(),
-           db);
+  if (pool != nullptr)
+    {
+      pool->align_candidates_all();
+    }
+  else
+    {
+      align_candidates(ci, 0, ci->cand_count, ci->s, lma, db);
+    }
 
-  for (auto i = 0; i < ci->cand_count; ++i)
+
+  /* find the best pair of parents */
+
+  if (parameters.opt_chimeras_denovo != nullptr)
     {
-      int64_t const target = ci->cand_list[static_cast<size_t>(i)];
-      int64_t nwscore = ci->snwscore[static_cast<size_t>(i)];
-      char * nwcigar = nullptr;
-      int64_t nwalignmentlength = 0;
-      int64_t nwmatches = 0;
-      int64_t nwmismatches = 0;
-      int64_t nwgaps = 0;
+      /* long high-quality reads */
+      return find_best_parents_long(ci) != 0;
+    }
+  return find_best_parents(ci) != 0;
+}
 
-      if (nwscore == std::numeric_limits<short>::max())
-        {
-          /* In case the SIMD aligner cannot align,
-             perform a new alignment with the
-             linear memory aligner */
 
-          auto const * tseq = db.getsequence(static_cast<uint64_t>(target));
-          int64_t const tseqlen = static_cast<int64_t>(db.getsequencelen(static_cast<uint64_t>(target)));
+/* Score the query in ci for the parents found by chimera_find_parents */
+static auto chimera_evaluate(struct chimera_info_s * ci,
+                             bool const parents_found,
+                             struct chimera_cli_state_s * cli,
+                             struct Database const & db) -> Status
+{
+  if (not parents_found)
+    {
+      return Status::no_parents;
+    }
+  if (ci->parameters->opt_chimeras_denovo != nullptr)
+    {
+      return eval_parents_long(ci, cli, db);
+    }
+  return eval_parents(ci, cli, db);
+}
 
-          if (ci->nwcigar[static_cast<size_t>(i)] != nullptr)
-            {
-              xfree(ci->nwcigar[static_cast<size_t>(i)]);
-            }
 
-          nwcigar = xstrdup(lma.align(ci->query_seq.data(),
-                                      tseq,
-                                      ci->query_len,
-                                      tseqlen));
-          lma.alignstats(nwcigar,
-                         ci->query_seq.data(),
-                         tseq,
-                         & nwscore,
-                         & nwalignmentlength,
-                         & nwmatches,
-                         & nwmismatches,
-                         & nwgaps);
+/* Process a single query that has already been loaded into ci.
+   Shared by chimera_thread_core (CLI) and chimera_detect_single (API). */
+static auto chimera_process_query(struct chimera_info_s * ci,
+                                  std::vector<struct hit> & allhits_list,
+                                  LinearMemoryAligner & lma,
+                                  struct chimera_query_pool_s * pool,
+                                  struct chimera_cli_state_s * cli,
+                                  struct Database const & db) -> Status
+{
+  auto const parents_found = chimera_find_parents(ci, allhits_list, lma, pool, db);
+  return chimera_evaluate(ci, parents_found, cli, db);
+}
 
-          ci->nwcigar[static_cast<size_t>(i)] = nwcigar;
-          ci->nwscore[static_cast<size_t>(i)] = nwscore;
-          ci->nwalignmentlength[static_cast<size_t>(i)] = nwalignmentlength;
-          ci->nwmatches[static_cast<size_t>(i)] = nwmatches;
-          ci->nwmismatches[static_cast<size_t>(i)] = nwmismatches;
-          ci->nwgaps[static_cast<size_t>(i)] = nwgaps;
-        }
-      else
+
+/* Count and write out the query in ci with its status, and add it to the
+   database index of a de novo search if it is not chimeric. The caller
+   holds state.mutex_output. */
+static auto chimera_output_query(struct chimera_cli_state_s & state,
+                                 struct chimera_info_s * ci,
+                                 Status const status,
+                                 uint64_t const query_position,
+                                 struct Database const & db) -> void
+{
+  ++state.total_count;
+  state.total_abundance += ci->query_size;
+
+  if (status == Status::chimeric)
+    {
+      ++state.chimera_count;
+      state.chimera_abundance += ci->query_size;
+
+      if (state.parameters.opt_chimeras != nullptr)
         {
-          ci->nwscore[static_cast<size_t>(i)] = ci->snwscore[static_cast<size_t>(i)];
-          ci->nwalignmentlength[static_cast<size_t>(i)] = ci->snwalignmentlength[static_cast<size_t>(i)];
-          ci->nwmatches[static_cast<size_t>(i)] = ci->snwmatches[static_cast<size_t>(i)];
-          ci->nwmismatches[static_cast<size_t>(i)] = ci->snwmismatches[static_cast<size_t>(i)];
-          ci->nwgaps[static_cast<size_t>(i)] = ci->snwgaps[static_cast<size_t>(i)];
+          fasta_print_general(state.fp_chimeras,
+                              nullptr,
+                              ci->query_seq.data(),
+                              ci->query_len,
+                              ci->query_head.data(),
+                              ci->query_head_len,
+                              static_cast<uint64_t>(ci->query_size),
+                              state.chimera_count,
+                              -1.0,
+                              -1,
+                              -1,
+                              state.parameters.opt_fasta_score ?
+                              ( (state.parameters.opt_uchime_ref != nullptr) ?
+                                "uchime_ref" : "uchime_denovo" ) : nullptr,
+                              ci->best_h,
+                              0,
+                              state.parameters);
+
         }
     }
 
+  if (status == Status::suspicious)
+    {
+      ++state.borderline_count;
+      state.borderline_abundance += ci->query_size;
+
+      if (state.parameters.opt_borderline != nullptr)
+        {
+          fasta_print_general(state.fp_borderline,
+                              nullptr,
+                              ci->query_seq.data(),
+                              ci->query_len,
+                              ci->query_head.data(),
+                              ci->query_head_len,
+                              static_cast<uint64_t>(ci->query_size),
+                              state.borderline_count,
+                              -1.0,
+                              -1,
+                              -1,
+                              state.parameters.opt_fasta_score ?
+                              ( (state.parameters.opt_uchime_ref != nullptr) ?
+                                "uchime_ref" : "uchime_denovo" ) : nullptr,
+                              ci->best_h,
+                              0,
+                              state.parameters);
 
-  /* find the best pair of parents, then compute score for them */
+        }
+    }
 
-  if (parameters.opt_chimeras_denovo != nullptr)
+  if (status < Status::suspicious)
     {
-      /* long high-quality reads */
-      if (find_best_parents_long(ci) != 0)
+      ++state.nonchimera_count;
+      state.nonchimera_abundance += ci->query_size;
+
+      /* output no parents, no chimeras */
+      if ((status < Status::low_score) and (state.parameters.opt_uchimeout != nullptr))
         {
-          return eval_parents_long(ci, cli, db);
+          std::fprintf(state.fp_uchimeout, "%.4f\t", ci->best_h);
+
+          header_fprint_strip(state.fp_uchimeout,
+                              ci->query_head.data(),
+                              ci->query_head_len,
+                              state.parameters.opt_xsize,
+                              state.parameters.opt_xee,
+                              state.parameters.opt_xlength);
+
+          if (state.parameters.opt_uchimeout5 != 0)
+            {
+              std::fprintf(state.fp_uchimeout,
+                      "\t*\t*\t*\t*\t*\t*\t*\t0\t0\t0\t0\t0\t0\t*\tN\n");
+            }
+          else
+            {
+              std::fprintf(state.fp_uchimeout,
+                      "\t*\t*\t*\t*\t*\t*\t*\t*\t0\t0\t0\t0\t0\t0\t*\tN\n");
+            }
         }
-      else
+
+      if (state.parameters.opt_nonchimeras != nullptr)
         {
-          return Status::no_parents;
+          fasta_print_general(state.fp_nonchimeras,
+                              nullptr,
+                              ci->query_seq.data(),
+                              ci->query_len,
+                              ci->query_head.data(),
+                              ci->query_head_len,
+                              static_cast<uint64_t>(ci->query_size),
+                              state.nonchimera_count,
+                              -1.0,
+                              -1,
+                              -1,
+                              state.parameters.opt_fasta_score ?
+                              ( (state.parameters.opt_uchime_ref != nullptr) ?
+                                "uchime_ref" : "uchime_denovo" ) : nullptr,
+                              ci->best_h,
+                              0,
+                              state.parameters);
         }
     }
-  else
+
+  if (status < Status::suspicious)
     {
-      if (find_best_parents(ci) != 0)
+      /* uchime_denovo: add non-chimeras to db */
+      if ((state.parameters.opt_uchime_denovo != nullptr) or (state.parameters.opt_uchime2_denovo != nullptr) or (state.parameters.opt_uchime3_denovo != nullptr) or (state.parameters.opt_chimeras_denovo != nullptr))
         {
-          return eval_parents(ci, cli, db);
+          state.dbindex.add_sequence(state.seqno, state.parameters.opt_qmask, db);
         }
-      else
+    }
+
+  for (auto i = 0; i < ci->cand_count; ++i)
+    {
+      if (ci->nwcigar[static_cast<size_t>(i)] != nullptr)
         {
-          return Status::no_parents;
+          xfree(ci->nwcigar[static_cast<size_t>(i)]);
         }
     }
+
+  if (state.parameters.opt_uchime_ref != nullptr)
+    {
+      state.progress = query_position;
+    }
+  else
+    {
+      state.progress += db.getsequencelen(state.seqno);
+    }
+
+  state.progress_bar->update(state.progress);
+
+  ++state.seqno;
 }
 
 
@@ -2187,6 +2488,14 @@ static auto chimera_thread_core(struct chimera_cli_state_s & state,
 
   LinearMemoryAligner lma(scoring);
 
+  /* threads working on each query of this thread (--threads_per_query) */
+  std::unique_ptr<struct chimera_query_pool_s> pool;
+  if (state.detection_parameters.opt_threads_per_query > 1)
+    {
+      pool = make_unique<struct chimera_query_pool_s>(static_cast<int>(state.detection_parameters.opt_threads_per_query),
+                                                      ci, state.detection_parameters, db);
+    }
+
   uint64_t query_position = 0;
 
   auto const has_work_to_claim = [&]() -> bool {
@@ -2246,155 +2555,17 @@ static auto chimera_thread_core(struct chimera_cli_state_s & state,
   };
 
   auto const process_query = [&]() {
-    auto const status = chimera_process_query(ci, allhits_list, lma, &state, db);
+    auto const status = chimera_process_query(ci, allhits_list, lma, pool.get(), &state, db);
 
     /* output results */
 
     std::lock_guard<std::mutex> const output_lock(state.mutex_output);
-
-    ++state.total_count;
-    state.total_abundance += ci->query_size;
-
-    if (status == Status::chimeric)
-      {
-        ++state.chimera_count;
-        state.chimera_abundance += ci->query_size;
-
-        if (state.parameters.opt_chimeras != nullptr)
-          {
-            fasta_print_general(state.fp_chimeras,
-                                nullptr,
-                                ci->query_seq.data(),
-                                ci->query_len,
-                                ci->query_head.data(),
-                                ci->query_head_len,
-                                static_cast<uint64_t>(ci->query_size),
-                                state.chimera_count,
-                                -1.0,
-                                -1,
-                                -1,
-                                state.parameters.opt_fasta_score ?
-                                ( (state.parameters.opt_uchime_ref != nullptr) ?
-                                  "uchime_ref" : "uchime_denovo" ) : nullptr,
-                                ci->best_h,
-                                0,
-                                state.parameters);
-
-          }
-      }
-
-    if (status == Status::suspicious)
-      {
-        ++state.borderline_count;
-        state.borderline_abundance += ci->query_size;
-
-        if (state.parameters.opt_borderline != nullptr)
-          {
-            fasta_print_general(state.fp_borderline,
-                                nullptr,
-                                ci->query_seq.data(),
-                                ci->query_len,
-                                ci->query_head.data(),
-                                ci->query_head_len,
-                                static_cast<uint64_t>(ci->query_size),
-                                state.borderline_count,
-                                -1.0,
-                                -1,
-                                -1,
-                                state.parameters.opt_fasta_score ?
-                                ( (state.parameters.opt_uchime_ref != nullptr) ?
-                                  "uchime_ref" : "uchime_denovo" ) : nullptr,
-                                ci->best_h,
-                                0,
-                                state.parameters);
-
-          }
-      }
-
-    if (status < Status::suspicious)
-      {
-        ++state.nonchimera_count;
-        state.nonchimera_abundance += ci->query_size;
-
-        /* output no parents, no chimeras */
-        if ((status < Status::low_score) and (state.parameters.opt_uchimeout != nullptr))
-          {
-            std::fprintf(state.fp_uchimeout, "%.4f\t", ci->best_h);
-
-            header_fprint_strip(state.fp_uchimeout,
-                                ci->query_head.data(),
-                                ci->query_head_len,
-                                state.parameters.opt_xsize,
-                                state.parameters.opt_xee,
-                                state.parameters.opt_xlength);
-
-            if (state.parameters.opt_uchimeout5 != 0)
-              {
-                std::fprintf(state.fp_uchimeout,
-                        "\t*\t*\t*\t*\t*\t*\t*\t0\t0\t0\t0\t0\t0\t*\tN\n");
-              }
-            else
-              {
-                std::fprintf(state.fp_uchimeout,
-                        "\t*\t*\t*\t*\t*\t*\t*\t*\t0\t0\t0\t0\t0\t0\t*\tN\n");
-              }
-          }
-
-        if (state.parameters.opt_nonchimeras != nullptr)
-          {
-            fasta_print_general(state.fp_nonchimeras,
-                                nullptr,
-                                ci->query_seq.data(),
-                                ci->query_len,
-                                ci->query_head.data(),
-                                ci->query_head_len,
-                                static_cast<uint64_t>(ci->query_size),
-                                state.nonchimera_count,
-                                -1.0,
-                                -1,
-                                -1,
-                                state.parameters.opt_fasta_score ?
-                                ( (state.parameters.opt_uchime_ref != nullptr) ?
-                                  "uchime_ref" : "uchime_denovo" ) : nullptr,
-                                ci->best_h,
-                                0,
-                                state.parameters);
-          }
-      }
-
-    if (status < Status::suspicious)
-      {
-        /* uchime_denovo: add non-chimeras to db */
-        if ((state.parameters.opt_uchime_denovo != nullptr) or (state.parameters.opt_uchime2_denovo != nullptr) or (state.parameters.opt_uchime3_denovo != nullptr) or (state.parameters.opt_chimeras_denovo != nullptr))
-          {
-            state.dbindex.add_sequence(state.seqno, state.parameters.opt_qmask, db);
-          }
-      }
-
-    for (auto i = 0; i < ci->cand_count; ++i)
-      {
-        if (ci->nwcigar[static_cast<size_t>(i)] != nullptr)
-          {
-            xfree(ci->nwcigar[static_cast<size_t>(i)]);
-          }
-      }
-
-    if (state.parameters.opt_uchime_ref != nullptr)
-      {
-        state.progress = query_position;
-      }
-    else
-      {
-        state.progress += db.getsequencelen(state.seqno);
-      }
-
-    state.progress_bar->update(state.progress);
-
-    ++state.seqno;
+    chimera_output_query(state, ci, status, query_position, db);
   };
 
   run_worker_loop(mutex_input, has_work_to_claim, process_query);
 
+  pool.reset();
   chimera_thread_exit(ci);
 
 
@@ -2419,6 +2590,187 @@ static auto chimera_threads_run(struct chimera_cli_state_s & state) -> void
 }
 
 
+/* Could one of the sequences published, sorted by seqno with their
+   unique k-mers, have changed the part searches of the query in ci, had
+   they been in the index? A part search examines its candidates from
+   the best down, in the order of elem_smaller: more shared k-mers,
+   then shorter, then lower seqno. A published sequence has a higher
+   seqno than all sequences searched, so it would not have been examined
+   if it sorts after the last candidate examined, or if it shares too
+   few k-mers to be a candidate. Examining candidates stops early unless
+   they run out, in which case any candidate would have been examined. */
+static auto chimera_published_may_change(struct chimera_info_s const * ci,
+                                         std::vector<unsigned int> const & published,
+                                         std::vector<std::vector<unsigned int>> const & published_kmers,
+                                         struct Dbindex const & dbindex,
+                                         struct Database const & db) -> bool
+{
+  if (ci->query_len < ci->parts)
+    {
+      return false;  // not searched
+    }
+
+  auto const & parameters = *ci->parameters;
+  for (auto p = 0; p < ci->parts; ++p)
+    {
+      auto const & si = ci->si[static_cast<size_t>(p)];
+      auto const minmatches = std::min(static_cast<unsigned int>(parameters.opt_minwordmatches),
+                                       si.kmersamplecount);
+      auto const examined_all = (si.hit_count == 0) or minheap_isempty(si.m);
+      elem_t last {};
+      if (not examined_all)
+        {
+          auto const & hit = si.hits[si.hit_count - 1];
+          last.count = hit.count;
+          last.seqno = static_cast<unsigned int>(hit.target);
+          last.length = static_cast<unsigned int>(db.getsequencelen(last.seqno));
+        }
+
+      for (auto k = 0U; k < published.size(); ++k)
+        {
+          auto const & kmers = published_kmers[k];
+          elem_t candidate {};
+          /* the k-mer counters of search_topscores saturate at INT16_MAX */
+          candidate.count = std::min(unique_count_shared(*si.uh, static_cast<int>(dbindex.wordlength),
+                                                         static_cast<int>(kmers.size()), kmers.data()),
+                                     static_cast<unsigned int>(INT16_MAX));
+          if (candidate.count < minmatches)
+            {
+              continue;
+            }
+          if (examined_all)
+            {
+              return true;
+            }
+          candidate.seqno = published[k];
+          candidate.length = static_cast<unsigned int>(db.getsequencelen(candidate.seqno));
+          if (elem_smaller(&candidate, &last) == 0)
+            {
+              return true;
+            }
+        }
+    }
+  return false;
+}
+
+
+/* De novo detection with several threads. Each query is searched among
+   the non-chimeric sequences of higher abundance, so that its verdict
+   depends on those of all the queries before it. The queries are taken
+   in rounds of one query per thread. The threads search the queries of
+   a round at the same time, in an index holding the non-chimeras of the
+   previous rounds; the index is only extended between the searches, so
+   that each round sees a fixed index (an epoch). The queries are then
+   evaluated, written and, if not chimeric, added to the index in order,
+   by this thread. A query whose search could have found a non-chimera
+   of its own round is searched again in the index holding it, so that
+   the results are those of a single thread. */
+static auto chimera_denovo_threads_run(struct chimera_cli_state_s & state) -> void
+{
+  auto const & parameters = state.detection_parameters;
+  auto const nthreads = static_cast<unsigned int>(parameters.opt_threads);
+  auto const seqcount = static_cast<unsigned int>(state.db.getsequencecount());
+  int const tophits = static_cast<int>(parameters.opt_maxaccepts + parameters.opt_maxrejects);
+  struct Scoring const scoring = scoring_from_options(state.parameters);
+
+  std::vector<std::vector<struct hit>> allhits_lists(nthreads, std::vector<struct hit>(maxcandidates));
+  std::vector<std::unique_ptr<LinearMemoryAligner>> lmas;
+  std::vector<std::unique_ptr<struct chimera_query_pool_s>> pools(nthreads);
+  for (auto t = 0U; t < nthreads; ++t)
+    {
+      auto * ci = state.cia + t;
+      chimera_thread_init(ci, tophits, parameters, state.dbindex, state.db);
+      lmas.emplace_back(make_unique<LinearMemoryAligner>(scoring));
+      if (parameters.opt_threads_per_query > 1)
+        {
+          pools[t] = make_unique<struct chimera_query_pool_s>(static_cast<int>(parameters.opt_threads_per_query),
+                                                              ci, parameters, state.db);
+        }
+    }
+
+  std::vector<char> parents_found(nthreads, 0);
+  auto round_start = 0U;
+  auto round_size = 0U;
+
+  auto const find_parents = [&](unsigned int const t) -> void {
+    parents_found[t] = chimera_find_parents(state.cia + t, allhits_lists[t], *lmas[t],
+                                            pools[t].get(), state.db) ? 1 : 0;
+  };
+
+  ThreadRunner threadrunner(nthreads,
+                            [&](uint64_t const nth_thread) {
+                              auto const t = static_cast<unsigned int>(nth_thread);
+                              if (t >= round_size)
+                                {
+                                  return;
+                                }
+                              auto * ci = state.cia + t;
+                              auto const seqno = round_start + t;
+                              ci->query_no = static_cast<int>(seqno);
+                              ci->query_head_len = static_cast<int>(state.db.getheaderlen(seqno));
+                              ci->query_len = static_cast<int>(state.db.getsequencelen(seqno));
+                              ci->query_size = static_cast<int64_t>(state.db.getabundance(seqno));
+                              realloc_arrays(ci, state.db);
+                              std::strcpy(ci->query_head.data(), state.db.getheader(seqno));
+                              std::strcpy(ci->query_seq.data(), state.db.getsequence(seqno));
+                              find_parents(t);
+                            });
+
+  /* the non-chimeras of the current round, with their unique k-mers */
+  struct uhandle_s * uhandle = unique_init();
+  std::vector<unsigned int> published;
+  std::vector<std::vector<unsigned int>> published_kmers;
+
+  while (round_start < seqcount)
+    {
+      round_size = std::min(nthreads, seqcount - round_start);
+      threadrunner.run();
+
+      published.clear();
+      published_kmers.clear();
+      for (auto t = 0U; t < round_size; ++t)
+        {
+          auto * ci = state.cia + t;
+          if ((not published.empty()) and
+              chimera_published_may_change(ci, published, published_kmers, state.dbindex, state.db))
+            {
+              for (auto i = 0; i < ci->cand_count; ++i)
+                {
+                  if (ci->nwcigar[static_cast<size_t>(i)] != nullptr)
+                    {
+                      xfree(ci->nwcigar[static_cast<size_t>(i)]);
+                    }
+                }
+              find_parents(t);
+            }
+
+          auto const status = chimera_evaluate(ci, parents_found[t] != 0, &state, state.db);
+          if ((status < Status::suspicious) and (t + 1 < round_size))
+            {
+              auto const seqno = state.seqno;
+              auto kmer_count = 0U;
+              unsigned int const * kmers = nullptr;
+              unique_count(uhandle, static_cast<int>(state.dbindex.wordlength),
+                           static_cast<int>(state.db.getsequencelen(seqno)), state.db.getsequence(seqno),
+                           &kmer_count, &kmers, state.parameters.opt_qmask);
+              published.push_back(seqno);
+              published_kmers.emplace_back(kmers, kmers + kmer_count);
+            }
+          std::lock_guard<std::mutex> const output_lock(state.mutex_output);
+          chimera_output_query(state, ci, status, 0, state.db);
+        }
+      round_start += round_size;
+    }
+
+  unique_exit(uhandle);
+  pools.clear();
+  for (auto t = 0U; t < nthreads; ++t)
+    {
+      chimera_thread_exit(state.cia + t);
+    }
+}
+
+
 /* Defined below (next to the library detection entry that also uses it). */
 static auto chimera_detection_parameters(struct Parameters const & parameters) -> struct Parameters;
 
@@ -2466,11 +2818,8 @@ auto chimera(struct Parameters const & parameters) -> void
     }
 
   /* CLI-only: denovo detection is order-dependent (each query is compared
-     against previously processed sequences), so run its pool single-threaded. */
-  if (parameters.opt_uchime_ref == nullptr)
-    {
-      state.detection_parameters.opt_threads = 1;
-    }
+     against previously processed sequences), so with several threads it
+     runs in rounds (chimera_denovo_threads_run) instead of as a pool. */
 
   uint64_t progress_total = 0;
   state.chimera_count = 0;
@@ -2595,7 +2944,14 @@ auto chimera(struct Parameters const & parameters) -> void
   {
     Progress progress_bar("Detecting chimeras", progress_total, parameters);
     state.progress_bar = &progress_bar;
-    chimera_threads_run(state);
+    if ((parameters.opt_uchime_ref == nullptr) and (state.detection_parameters.opt_threads > 1))
+      {
+        chimera_denovo_threads_run(state);
+      }
+    else
+      {
+        chimera_threads_run(state);
+      }
   }
 
   /* all workers joined; report a deferred query parse error (CC3, uchime_ref
@@ -2931,7 +3287,7 @@ auto chimera_detect_single(struct chimera_info_s * ci,
      (cli == nullptr): the detection core populates ci->result_out instead of
      writing files, and takes no output lock. */
   auto const status = chimera_process_query(ci, ci->api_allhits_list,
-                                            *ci->api_lma_ptr, nullptr, *ci->db);
+                                            *ci->api_lma_ptr, nullptr, nullptr, *ci->db);
 
   if (status == Status::no_parents)
     {
@@ -74,6 +74,7 @@
 #include "core/unique.hpp"
 #include "utils/fatal.hpp"
 #include "utils/make_unique.hpp"
+#include "core/block_compress.hpp"  // compress_output
 #include "utils/open_file.hpp"
 #include "utils/number_of_strands.hpp"
 #include "utils/threads.hpp"
@@ -82,10 +83,11 @@
 #include "utils/string_alloc.hpp"
 #include <algorithm>  // std::count, std::minmax_element, std::max_element, std::min
 #include <array>
+#include <atomic>
 #include <cinttypes>  // macros PRIu64 and PRId64
 #include <cstdint>  // int64_t, uint64_t
 #include <cstdio>  // std::FILE, std::fprintf, std::fclose
-#include <cstring>  // std::strcpy, std::strlen
+#include <cstring>  // std::memset, std::strcpy, std::strlen
 #include <limits>
 #include <map>
 #include <memory>  // std::unique_ptr
@@ -150,14 +152,30 @@ struct cluster_cli_state_s
   explicit cluster_cli_state_s(struct Parameters const & params) : parameters(params) {}
 };
 
-/* per-thread slice of queries assigned for the current round; owned by
-   cluster_work_pool_s (the threading primitives live inside its ThreadRunner) */
-struct thread_work_s
+/* per-thread search scratch owned by cluster_work_pool_s: the k-mer
+   counters (one per database sequence) and touched flags are only needed
+   while a query is searched, so a thread lends them to each query it
+   takes instead of every query slot of a round owning its own */
+struct cluster_scratch_s
 {
-  int query_first;
-  int query_count;
+  count_t * kmers = nullptr;
+  std::vector<unsigned char> touched;
+  std::unique_ptr<LinearMemoryAligner> lma;
 };
 
+/* what the speculative phase of a round found for one query strand
+   against the search misses earlier in the round, the likely new
+   centroids: the number of shared k-mers per earlier query slot
+   (extra_not_counted if not a miss), and the alignments of the best
+   candidates, done ahead (nwalignment owned until taken) */
+struct cluster_extra_cache_s
+{
+  std::vector<unsigned int> shared;
+  std::vector<struct hit> aligned;
+};
+
+constexpr auto extra_not_counted = std::numeric_limits<unsigned int>::max();
+
 
 inline auto cluster_query_core(struct searchinfo_s * si, struct Database const & db, struct Parameters const & parameters) -> void
 {
@@ -192,7 +210,8 @@ inline auto cluster_query_core(struct searchinfo_s * si, struct Database const &
 auto cluster_query_init(struct searchinfo_s * si, int const seqcount, int const tophits,
                         struct Database const & db,
                         struct Parameters const & parameters,
-                        struct Dbindex const & dbindex) -> void
+                        struct Dbindex const & dbindex,
+                        bool const with_kmers) -> void
 {
   /* initialisation of data for one thread; run once for each thread */
   /* thread specific initialiation */
@@ -209,7 +228,12 @@ auto cluster_query_init(struct searchinfo_s * si, int const seqcount, int const
   si->seq_alloc = static_cast<int>(db.getlongestsequence() + 1);
   si->qsequence = static_cast<char *>(xmalloc(static_cast<std::size_t>(si->seq_alloc)));
 
-  si->kmers = static_cast<count_t *>(xmalloc((static_cast<std::size_t>(seqcount) * sizeof(count_t)) + 32));
+  /* without, the caller lends the counters for each search */
+  if (with_kmers)
+    {
+      si->kmers = static_cast<count_t *>(xmalloc((static_cast<std::size_t>(seqcount) * sizeof(count_t)) + 32));
+      std::memset(si->kmers, 0, static_cast<std::size_t>(seqcount) * sizeof(count_t));
+    }
   si->hits = static_cast<struct hit *>(xmalloc(sizeof(struct hit) * static_cast<std::size_t>(tophits)));
 
   si->uh = unique_init();
@@ -228,7 +252,8 @@ auto cluster_query_init(struct searchinfo_s * si, int const seqcount, int const
                         parameters.opt_gap_extension_target_interior,
                         parameters.opt_gap_extension_query_right,
                         parameters.opt_gap_extension_target_right,
-                        parameters.opt_n_mismatch);
+                        parameters.opt_n_mismatch,
+                        search16_select_channels(parameters));
 }
 
 
@@ -255,29 +280,147 @@ auto cluster_query_exit(struct searchinfo_s * si) -> void
 }
 
 
+static auto align_extra_hit(struct searchinfo_s * si,
+                            struct hit * hit,
+                            LinearMemoryAligner & lma,
+                            struct Database const & db) -> void
+{
+  /* perform vectorized alignment */
+  /* but only using 1 sequence ! */
+
+  unsigned int const target = static_cast<unsigned int>(hit->target);
+  unsigned int nwtarget = target;
+
+  int64_t nwscore = 0;
+  int64_t nwalignmentlength = 0;
+  int64_t nwmatches = 0;
+  int64_t nwmismatches = 0;
+  int64_t nwgaps = 0;
+  char * nwcigar = nullptr;
+
+  /* short variants for simd aligner */
+  CELL snwscore = 0;
+  unsigned short snwalignmentlength = 0;
+  unsigned short snwmatches = 0;
+  unsigned short snwmismatches = 0;
+  unsigned short snwgaps = 0;
+
+  search16(si->s,
+           1,
+           & nwtarget,
+           & snwscore,
+           & snwalignmentlength,
+           & snwmatches,
+           & snwmismatches,
+           & snwgaps,
+           & nwcigar,
+           db);
+
+  int64_t const tseqlen = static_cast<int64_t>(db.getsequencelen(target));
+
+  if (snwscore == std::numeric_limits<short>::max())
+    {
+      /* In case the SIMD aligner cannot align,
+         perform a new alignment with the
+         linear memory aligner */
+
+      char const * tseq = db.getsequence(target);
+
+      if (nwcigar != nullptr)
+        {
+          xfree(nwcigar);
+        }
+
+      nwcigar = xstrdup(lma.align(si->qsequence,
+                                  tseq,
+                                  si->qseqlen,
+                                  tseqlen));
+
+      lma.alignstats(nwcigar,
+                     si->qsequence,
+                     tseq,
+                     & nwscore,
+                     & nwalignmentlength,
+                     & nwmatches,
+                     & nwmismatches,
+                     & nwgaps);
+    }
+  else
+    {
+      nwscore = snwscore;
+      nwalignmentlength = snwalignmentlength;
+      nwmatches = snwmatches;
+      nwmismatches = snwmismatches;
+      nwgaps = snwgaps;
+    }
+
+
+  int64_t const nwdiff = nwalignmentlength - nwmatches;
+  int64_t const nwindels = nwdiff - nwmismatches;
+
+  hit->aligned = true;
+  hit->nwalignment = nwcigar;
+  hit->nwscore = static_cast<int>(nwscore);
+  hit->nwdiff = static_cast<int>(nwdiff);
+  hit->nwgaps = static_cast<int>(nwgaps);
+  hit->nwindels = static_cast<int>(nwindels);
+  hit->nwalignmentlength = static_cast<int>(nwalignmentlength);
+  hit->matches = static_cast<int>(nwmatches);
+  hit->mismatches = static_cast<int>(nwmismatches);
+
+  hit->nwid = 100.0 *
+    static_cast<double>(nwalignmentlength - hit->nwdiff) /
+    static_cast<double>(nwalignmentlength);
+
+  hit->shortest = std::min(si->qseqlen, static_cast<int>(tseqlen));
+  hit->longest = std::max(si->qseqlen, static_cast<int>(tseqlen));
+
+  /* trim alignment and compute numbers
+     excluding terminal gaps */
+  align_trim(hit, *si->parameters);
+}
+
+
 /* Self-contained per-invocation worker pool for the clustering search phase.
-   It owns the per-thread searchinfo_s arrays, the per-round query slices, and
-   its own ThreadRunner, so a caller drives its own pool with no shared
+   It owns the per-slot searchinfo_s arrays, the per-thread search scratch,
+   and its own ThreadRunner, so a caller drives its own pool with no shared
    file-static state (E4) — this is what lets cluster_assign_batch() stop
    borrowing the CLI path's si_plus/si_minus/thread_work/cluster_threadrunner
    via a save/restore hack.
 
+   A round holds up to one query per slot; the threads take the queries of
+   a round in turn from a shared counter, so that rounds of many queries per
+   thread stay balanced. Besides the search, a round may run a speculative
+   phase (speculate()) that counts and aligns each query against the search
+   misses earlier in the round, which are likely to become new centroids.
+   The serial evaluation of the round then finds that work done in
+   extra_cache(), and still decides exactly as without it.
+
    Similar to the Scanner class in swarm (src/utils/scanner.{h,cc}), the sister
-   project's equivalent abstraction: the per-thread search state is a member
-   vector, the worker reads its own slice, and the ThreadRunner is held as the
-   last-created member whose lambda captures `this` — so the object must keep a
+   project's equivalent abstraction: the search state is held in member
+   vectors, the workers take their queries from them, and the ThreadRunner is
+   held as the last-created member whose lambda captures `this` — so the object must keep a
    stable address and is non-copyable/non-movable. */
 struct cluster_work_pool_s
 {
+  enum class phase_t { search, speculate };
+
   struct Parameters const & parameters;  // run config, read by the workers (E1)
   struct Dbindex const & dbindex;       // k-mer index the workers search
   struct Database const & db;           // sequence database the workers query
-  std::vector<searchinfo_s> si_plus;    // one entry per thread
+  int const seqcount;
+  std::vector<searchinfo_s> si_plus;    // one entry per query slot
   std::vector<searchinfo_s> si_minus;   // empty unless searching both strands
-  std::vector<thread_work_s> thread_work;
+  std::vector<cluster_extra_cache_s> cache_plus;  // one entry per query slot
+  std::vector<cluster_extra_cache_s> cache_minus;
+  std::vector<cluster_scratch_s> scratch;  // one entry per thread
+  std::vector<int> const * misses = nullptr;  // slots searched without a hit
+  phase_t phase = phase_t::search;
+  int queries = 0;
+  std::atomic<int> next_query {0};
   std::unique_ptr<ThreadRunner> runner;  // constructed last; lambda captures this
 
-  cluster_work_pool_s(int const nthreads, int const seqcount,
+  cluster_work_pool_s(int const nthreads, int const slots, int const seqcount_,
                       int const tophits, bool const need_minus,
                       struct Parameters const & params,
                       struct Dbindex const & index,
@@ -285,20 +428,30 @@ struct cluster_work_pool_s
     : parameters(params),
       dbindex(index),
       db(database),
-      si_plus(static_cast<std::size_t>(nthreads)),
-      si_minus(need_minus ? static_cast<std::size_t>(nthreads) : std::size_t{0}),
-      thread_work(static_cast<std::size_t>(nthreads))
+      seqcount(seqcount_),
+      si_plus(static_cast<std::size_t>(slots)),
+      si_minus(need_minus ? static_cast<std::size_t>(slots) : std::size_t{0}),
+      cache_plus(static_cast<std::size_t>(slots)),
+      cache_minus(need_minus ? static_cast<std::size_t>(slots) : std::size_t{0}),
+      scratch(static_cast<std::size_t>(nthreads))
   {
     for (auto & si : si_plus)
       {
-        cluster_query_init(&si, seqcount, tophits, db, parameters, dbindex);
+        cluster_query_init(&si, seqcount, tophits, db, parameters, dbindex, false);
         si.strand = 0;
       }
     for (auto & si : si_minus)
       {
-        cluster_query_init(&si, seqcount, tophits, db, parameters, dbindex);
+        cluster_query_init(&si, seqcount, tophits, db, parameters, dbindex, false);
         si.strand = 1;
       }
+    struct Scoring const scoring = scoring_from_options(parameters);
+    for (auto & thread : scratch)
+      {
+        thread.kmers = static_cast<count_t *>(xmalloc((static_cast<std::size_t>(seqcount) * sizeof(count_t)) + 32));
+        std::memset(thread.kmers, 0, static_cast<std::size_t>(seqcount) * sizeof(count_t));
+        thread.lma = make_unique<LinearMemoryAligner>(scoring);
+      }
     runner = make_unique<ThreadRunner>(static_cast<std::size_t>(nthreads),
                                        [this](uint64_t const t) { worker(t); });
   }
@@ -306,8 +459,10 @@ struct cluster_work_pool_s
   ~cluster_work_pool_s()
   {
     runner.reset();  // join the workers before freeing the buffers they read
+    release_extra_cache(static_cast<int>(si_plus.size()));
     for (auto & si : si_plus) { cluster_query_exit(&si); }
     for (auto & si : si_minus) { cluster_query_exit(&si); }
+    for (auto & thread : scratch) { xfree(thread.kmers); }
   }
 
   cluster_work_pool_s(cluster_work_pool_s const &) = delete;
@@ -315,47 +470,145 @@ struct cluster_work_pool_s
   auto operator=(cluster_work_pool_s const &) -> cluster_work_pool_s & = delete;
   auto operator=(cluster_work_pool_s &&) -> cluster_work_pool_s & = delete;
 
-  /* worker body: process this thread's assigned slice of the current round */
+  /* worker body: take the queries of the current round in turn */
   auto worker(uint64_t const t) -> void
   {
-    auto const & work = thread_work[t];
-    for (int q = 0; q < work.query_count; q++)
+    auto & thread = scratch[t];
+    auto query = next_query.fetch_add(1);
+    while (query < queries)
       {
-        cluster_query_core(si_plus.data() + work.query_first + q, db, parameters);
-        if (not si_minus.empty())
+        auto const qdx = static_cast<std::size_t>(query);
+        if (phase == phase_t::search)
           {
-            cluster_query_core(si_minus.data() + work.query_first + q, db, parameters);
+            search_slot(si_plus[qdx], thread);
+            if (not si_minus.empty())
+              {
+                search_slot(si_minus[qdx], thread);
+              }
+          }
+        else
+          {
+            speculate_slot(si_plus[qdx], cache_plus[qdx], query, *thread.lma);
+            if (not si_minus.empty())
+              {
+                speculate_slot(si_minus[qdx], cache_minus[qdx], query, *thread.lma);
+              }
           }
+        query = next_query.fetch_add(1);
       }
   }
 
-  /* distribute `queries` across the threads and run one round */
-  auto wakeup(int const queries) -> void
+  auto search_slot(struct searchinfo_s & si, cluster_scratch_s & thread) -> void
+  {
+    /* the counters are zero again after each search */
+    si.kmers = thread.kmers;
+    si.touched.swap(thread.touched);
+    cluster_query_core(&si, db, parameters);
+    si.touched.swap(thread.touched);
+    si.kmers = nullptr;
+  }
+
+  auto speculate_slot(struct searchinfo_s & si, cluster_extra_cache_s & cache,
+                      int const query, LinearMemoryAligner & lma) -> void
   {
-    int const nthreads = static_cast<int>(thread_work.size());
-    int const active = queries > nthreads ? nthreads : queries;
-    int queries_rest = queries;
-    int threads_rest = active;
-    int query_next = 0;
-    for (int t = 0; t < nthreads; t++)
+    /* count the k-mers shared with each earlier miss, as
+       evaluate_extra_hits() would */
+    if (misses->empty() or (misses->front() >= query))
       {
-        auto const tdx = static_cast<std::size_t>(t);
-        if (t < active)
+        return;
+      }
+    std::vector<int> candidates;
+    cache.shared.assign(static_cast<std::size_t>(query), extra_not_counted);
+    for (auto const miss : *misses)
+      {
+        if (miss >= query)
           {
-            thread_work[tdx].query_first = query_next;
-            thread_work[tdx].query_count = (queries_rest + threads_rest - 1) / threads_rest;
-            queries_rest -= thread_work[tdx].query_count;
-            query_next += thread_work[tdx].query_count;
-            --threads_rest;
+            break;
           }
-        else
+        auto const & sic = si_plus[static_cast<std::size_t>(miss)];
+        auto const shared = unique_count_shared(*si.uh,
+                                                static_cast<int>(dbindex.wordlength),
+                                                static_cast<int>(sic.kmersamplecount),
+                                                sic.kmersample);
+        cache.shared[static_cast<std::size_t>(miss)] = shared;
+        if (search_enough_kmers(si, shared) and search_acceptable_unaligned(si, sic.query_no))
           {
-            thread_work[tdx].query_first = query_next;
-            thread_work[tdx].query_count = 0;
+            candidates.push_back(miss);
           }
       }
+
+    /* align the candidates that would be tried first: those sharing
+       the most k-mers, then the shortest ones */
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [this, &cache](int const lhs, int const rhs) -> bool {
+                       auto const lhs_shared = cache.shared[static_cast<std::size_t>(lhs)];
+                       auto const rhs_shared = cache.shared[static_cast<std::size_t>(rhs)];
+                       if (lhs_shared != rhs_shared)
+                         {
+                           return lhs_shared > rhs_shared;
+                         }
+                       return si_plus[static_cast<std::size_t>(lhs)].qseqlen < si_plus[static_cast<std::size_t>(rhs)].qseqlen;
+                     });
+    auto const tries = static_cast<std::size_t>(si.parameters->opt_maxaccepts + si.parameters->opt_maxrejects);
+    candidates.resize(std::min(candidates.size(), tries));
+    for (auto const candidate : candidates)
+      {
+        struct hit hit {};
+        hit.target = si_plus[static_cast<std::size_t>(candidate)].query_no;
+        hit.strand = si.strand;
+        hit.count = cache.shared[static_cast<std::size_t>(candidate)];
+        align_extra_hit(&si, &hit, lma, db);
+        cache.aligned.push_back(hit);
+      }
+  }
+
+  auto run_phase(phase_t const next_phase, int const round_queries) -> void
+  {
+    phase = next_phase;
+    queries = round_queries;
+    next_query = 0;
     runner->run();
   }
+
+  /* search the queries in the first `queries` slots */
+  auto wakeup(int const round_queries) -> void
+  {
+    run_phase(phase_t::search, round_queries);
+  }
+
+  /* speculate on the slots after the first of the misses (ascending) */
+  auto speculate(int const round_queries, std::vector<int> const & round_misses) -> void
+  {
+    misses = &round_misses;
+    run_phase(phase_t::speculate, round_queries);
+  }
+
+  auto extra_cache(int const query, int const strand) -> cluster_extra_cache_s *
+  {
+    auto & caches = (strand != 0) ? cache_minus : cache_plus;
+    return &caches[static_cast<std::size_t>(query)];
+  }
+
+  /* free the alignments done ahead but not taken */
+  auto release_extra_cache(int const round_queries) -> void
+  {
+    for (auto * caches : {&cache_plus, &cache_minus})
+      {
+        for (auto i = 0; i < std::min(round_queries, static_cast<int>(caches->size())); i++)
+          {
+            auto & cache = (*caches)[static_cast<std::size_t>(i)];
+            for (auto & hit : cache.aligned)
+              {
+                if (hit.nwalignment != nullptr)
+                  {
+                    xfree(hit.nwalignment);
+                  }
+              }
+            cache.aligned.clear();
+            cache.shared.clear();
+          }
+      }
+  }
 };
 
 
@@ -598,13 +851,37 @@ auto compare_kmersample(const void * a, const void * b) -> int
   return 0;
 }
 
+static auto take_extra_alignment(struct cluster_extra_cache_s * cache,
+                                 struct hit * hit) -> bool
+{
+  /* an alignment done ahead by the speculative phase, identical
+     to the one align_extra_hit() would do now */
+
+  if (cache == nullptr)
+    {
+      return false;
+    }
+  for (auto & ahead : cache->aligned)
+    {
+      if ((ahead.target == hit->target) and (ahead.nwalignment != nullptr))
+        {
+          *hit = ahead;
+          ahead.nwalignment = nullptr;
+          return true;
+        }
+    }
+  return false;
+}
+
+
 static auto evaluate_extra_hits(struct searchinfo_s * si,
                                 struct searchinfo_s const * si_plus,
                                 const int * extra_list,
                                 int extra_count,
                                 LinearMemoryAligner & lma,
                                 int const tophits,
-                                struct Database const & db) -> void
+                                struct Database const & db,
+                                struct cluster_extra_cache_s * cache) -> void
 {
   int added = 0;
 
@@ -627,11 +904,18 @@ static auto evaluate_extra_hits(struct searchinfo_s * si,
           struct searchinfo_s const * sic = si_plus + extra_list[j];
 
           /* find the number of shared unique kmers */
-          auto const shared
-            = unique_count_shared(*si->uh,
-                                  static_cast<int>(si->dbindex->wordlength),
-                                  static_cast<int>(sic->kmersamplecount),
-                                  sic->kmersample);
+          auto shared = extra_not_counted;
+          if ((cache != nullptr) and (static_cast<std::size_t>(extra_list[j]) < cache->shared.size()))
+            {
+              shared = cache->shared[static_cast<std::size_t>(extra_list[j])];
+            }
+          if (shared == extra_not_counted)
+            {
+              shared = unique_count_shared(*si->uh,
+                                           static_cast<int>(si->dbindex->wordlength),
+                                           static_cast<int>(sic->kmersamplecount),
+                                           sic->kmersample);
+            }
 
           /* check if min number of shared kmers is satisfied */
           if (search_enough_kmers(*si, shared))
@@ -718,101 +1002,12 @@ static auto evaluate_extra_hits(struct searchinfo_s * si,
           if (not hit->aligned)
             {
               /* Test accept/reject criteria before alignment */
-              unsigned int const target = static_cast<unsigned int>(hit->target);
-              if (search_acceptable_unaligned(*si, static_cast<int>(target)))
+              if (search_acceptable_unaligned(*si, hit->target))
                 {
-                  /* perform vectorized alignment */
-                  /* but only using 1 sequence ! */
-
-                  unsigned int nwtarget = target;
-
-                  int64_t nwscore = 0;
-                  int64_t nwalignmentlength = 0;
-                  int64_t nwmatches = 0;
-                  int64_t nwmismatches = 0;
-                  int64_t nwgaps = 0;
-                  char * nwcigar = nullptr;
-
-                  /* short variants for simd aligner */
-                  CELL snwscore = 0;
-                  unsigned short snwalignmentlength = 0;
-                  unsigned short snwmatches = 0;
-                  unsigned short snwmismatches = 0;
-                  unsigned short snwgaps = 0;
-
-                  search16(si->s,
-                           1,
-                           & nwtarget,
-                           & snwscore,
-                           & snwalignmentlength,
-                           & snwmatches,
-                           & snwmismatches,
-                           & snwgaps,
-                           & nwcigar,
-                           db);
-
-                  int64_t const tseqlen = static_cast<int64_t>(db.getsequencelen(target));
-
-                  if (snwscore == std::numeric_limits<short>::max())
-                    {
-                      /* In case the SIMD aligner cannot align,
-                         perform a new alignment with the
-                         linear memory aligner */
-
-                      char const * tseq = db.getsequence(target);
-
-                      if (nwcigar != nullptr)
-                        {
-                          xfree(nwcigar);
-                        }
-
-                      nwcigar = xstrdup(lma.align(si->qsequence,
-                                                  tseq,
-                                                  si->qseqlen,
-                                                  tseqlen));
-
-                      lma.alignstats(nwcigar,
-                                     si->qsequence,
-                                     tseq,
-                                     & nwscore,
-                                     & nwalignmentlength,
-                                     & nwmatches,
-                                     & nwmismatches,
-                                     & nwgaps);
-                    }
-                  else
+                  if (not take_extra_alignment(cache, hit))
                     {
-                      nwscore = snwscore;
-                      nwalignmentlength = snwalignmentlength;
-                      nwmatches = snwmatches;
-                      nwmismatches = snwmismatches;
-                      nwgaps = snwgaps;
+                      align_extra_hit(si, hit, lma, db);
                     }
-
-
-                  int64_t const nwdiff = nwalignmentlength - nwmatches;
-                  int64_t const nwindels = nwdiff - nwmismatches;
-
-                  hit->aligned = true;
-                  hit->nwalignment = nwcigar;
-                  hit->nwscore = static_cast<int>(nwscore);
-                  hit->nwdiff = static_cast<int>(nwdiff);
-                  hit->nwgaps = static_cast<int>(nwgaps);
-                  hit->nwindels = static_cast<int>(nwindels);
-                  hit->nwalignmentlength = static_cast<int>(nwalignmentlength);
-                  hit->matches = static_cast<int>(nwmatches);
-                  hit->mismatches = static_cast<int>(nwmismatches);
-
-                  hit->nwid = 100.0 *
-                    static_cast<double>(nwalignmentlength - hit->nwdiff) /
-                    static_cast<double>(nwalignmentlength);
-
-                  hit->shortest = std::min(si->qseqlen, static_cast<int>(tseqlen));
-                  hit->longest = std::max(si->qseqlen, static_cast<int>(tseqlen));
-
-                  /* trim alignment and compute numbers
-                     excluding terminal gaps */
-                  align_trim(hit, *si->parameters);
                 }
               else
                 {
@@ -878,17 +1073,27 @@ auto cluster_core_parallel(struct cluster_cli_state_s & state,
                            int const seqcount, int const tophits,
                            struct Database const & db) -> void
 {
-  constexpr static int queries_per_thread = 1;
-  const int max_queries = queries_per_thread * static_cast<int>(state.parameters.opt_threads);
-
-  /* Own worker pool + per-thread search state (E4); see cluster_work_pool_s.
+  /* Rounds of queries are searched in parallel against the centroids
+     found before the round, then evaluated in order against the new
+     centroids of the round, as a serial run would see them. Rounds grow
+     up to max_queries_per_thread queries per thread while few of their
+     queries become centroids, and shrink again when many do, as each
+     query is then evaluated against all earlier new centroids. */
+  constexpr static int max_queries_per_thread = 16;
+  int const threads = static_cast<int>(state.parameters.opt_threads);
+  int const max_queries = max_queries_per_thread * threads;
+  int round_queries = threads;
+
+  /* Own worker pool + per-slot search state (E4); see cluster_work_pool_s.
      The local si_plus/si_minus aliases let the loops below read unchanged. */
-  cluster_work_pool_s pool(static_cast<int>(state.parameters.opt_threads), seqcount, tophits,
+  cluster_work_pool_s pool(threads, max_queries, seqcount, tophits,
                            state.parameters.opt_strand, state.effective_parameters, state.dbindex, db);
   searchinfo_s * const si_plus = pool.si_plus.data();
   searchinfo_s * const si_minus = pool.si_minus.empty() ? nullptr : pool.si_minus.data();
 
   std::vector<int> extra_list(static_cast<std::size_t>(max_queries));
+  std::vector<int> misses;
+  misses.reserve(static_cast<std::size_t>(max_queries));
 
   struct Scoring scoring = scoring_from_options(state.parameters);
 
@@ -911,7 +1116,7 @@ auto cluster_core_parallel(struct cluster_cli_state_s & state,
 
       int queries = 0;
 
-      for (int i = 0; i < max_queries; i++)
+      for (int i = 0; i < round_queries; i++)
         {
           if (seqno < seqcount)
             {
@@ -941,6 +1146,22 @@ auto cluster_core_parallel(struct cluster_cli_state_s & state,
       /* perform work in threads */
       pool.wakeup(queries);
 
+      /* queries without a hit so far will likely be new centroids:
+         count and align the later queries against them in parallel */
+      misses.clear();
+      for (int i = 0; i < queries; i++)
+        {
+          struct searchinfo_s const * si_m = state.parameters.opt_strand ? si_minus + i : nullptr;
+          if (search_findbest2_byid(si_plus + i, si_m) == nullptr)
+            {
+              misses.push_back(i);
+            }
+        }
+      if (not misses.empty() and (misses.front() < queries - 1))
+        {
+          pool.speculate(queries, misses);
+        }
+
       /* analyse results */
       int extra_count = 0;
 
@@ -953,7 +1174,8 @@ auto cluster_core_parallel(struct cluster_cli_state_s & state,
             {
               struct searchinfo_s * si = (s != 0) ? si_m : si_p;
 
-              evaluate_extra_hits(si, si_plus, extra_list.data(), extra_count, lma, tophits, db);
+              evaluate_extra_hits(si, si_plus, extra_list.data(), extra_count, lma, tophits, db,
+                                  pool.extra_cache(i, s));
             }
 
           /* find best hit */
@@ -1023,6 +1245,17 @@ auto cluster_core_parallel(struct cluster_cli_state_s & state,
           sum_nucleotides += si_p->qseqlen;
         }
 
+      pool.release_extra_cache(queries);
+
+      if (extra_count * 4 > queries)
+        {
+          round_queries = std::max(threads, round_queries / 2);
+        }
+      else if (extra_count * 16 < queries)
+        {
+          round_queries = std::min(max_queries, round_queries * 2);
+        }
+
       progress.update(static_cast<uint64_t>(sum_nucleotides));
     }
 
@@ -1037,10 +1270,10 @@ auto cluster_core_serial(struct cluster_cli_state_s & state,
   std::array<struct searchinfo_s, 1> si_p {{}};  // refactoring: direct initialization?
   std::array<struct searchinfo_s, 1> si_m {{}};
 
-  cluster_query_init(si_p.data(), seqcount, tophits, db, state.effective_parameters, state.dbindex);
+  cluster_query_init(si_p.data(), seqcount, tophits, db, state.effective_parameters, state.dbindex, true);
   if (state.parameters.opt_strand)
     {
-      cluster_query_init(si_m.data(), seqcount, tophits, db, state.effective_parameters, state.dbindex);
+      cluster_query_init(si_m.data(), seqcount, tophits, db, state.effective_parameters, state.dbindex, true);
     }
 
   auto lastlength = std::numeric_limits<int>::max();
@@ -1145,9 +1378,9 @@ auto cluster(char const * dbname,
   auto & fp_qsegout = state.fp_qsegout;
   auto & fp_tsegout = state.fp_tsegout;
 
-  OutputFileHandle centroids_handle = open_optional_output_file(parameters.opt_centroids, OutputOption{"--centroids"});
+  OutputFileHandle centroids_handle = compress_output(open_optional_output_file(parameters.opt_centroids, OutputOption{"--centroids"}), parameters);
   fp_centroids = centroids_handle.get();
-  OutputFileHandle uc_handle = open_optional_output_file(parameters.opt_uc, OutputOption{"--uc"});
+  OutputFileHandle uc_handle = compress_output(open_optional_output_file(parameters.opt_uc, OutputOption{"--uc"}), parameters);
   fp_uc = uc_handle.get();
 
   OutputFileHandle alnout_handle = open_optional_output_file(parameters.opt_alnout, OutputOption{"--alnout"});
@@ -1164,15 +1397,15 @@ auto cluster(char const * dbname,
   fp_userout = userout_handle.get();
   OutputFileHandle blast6out_handle = open_optional_output_file(parameters.opt_blast6out, OutputOption{"--blast6out"});
   fp_blast6out = blast6out_handle.get();
-  OutputFileHandle fastapairs_handle = open_optional_output_file(parameters.opt_fastapairs, OutputOption{"--fastapairs"});
+  OutputFileHandle fastapairs_handle = compress_output(open_optional_output_file(parameters.opt_fastapairs, OutputOption{"--fastapairs"}), parameters);
   fp_fastapairs = fastapairs_handle.get();
-  OutputFileHandle qsegout_handle = open_optional_output_file(parameters.opt_qsegout, OutputOption{"--qsegout"});
+  OutputFileHandle qsegout_handle = compress_output(open_optional_output_file(parameters.opt_qsegout, OutputOption{"--qsegout"}), parameters);
   fp_qsegout = qsegout_handle.get();
-  OutputFileHandle tsegout_handle = open_optional_output_file(parameters.opt_tsegout, OutputOption{"--tsegout"});
+  OutputFileHandle tsegout_handle = compress_output(open_optional_output_file(parameters.opt_tsegout, OutputOption{"--tsegout"}), parameters);
   fp_tsegout = tsegout_handle.get();
-  OutputFileHandle matched_handle = open_optional_output_file(parameters.opt_matched, OutputOption{"--matched"});
+  OutputFileHandle matched_handle = compress_output(open_optional_output_file(parameters.opt_matched, OutputOption{"--matched"}), parameters);
   fp_matched = matched_handle.get();
-  OutputFileHandle notmatched_handle = open_optional_output_file(parameters.opt_notmatched, OutputOption{"--notmatched"});
+  OutputFileHandle notmatched_handle = compress_output(open_optional_output_file(parameters.opt_notmatched, OutputOption{"--notmatched"}), parameters);
   fp_notmatched = notmatched_handle.get();
   OutputFileHandle otutabout_handle = open_optional_output_file(parameters.opt_otutabout, OutputOption{"--otutabout"});
   fp_otutabout = otutabout_handle.get();
@@ -1391,7 +1624,7 @@ auto cluster(char const * dbname,
                          "%s%d",
                          parameters.opt_clusters,
                          clusterno);
-                fp_clusters = open_output_file(fn_clusters.data());
+                fp_clusters = compress_output(open_output_file(fn_clusters.data()), parameters);
                 if (not fp_clusters)
                   {
                     fatal("Unable to open clusters file for writing (%s)", fn_clusters.data());
@@ -1475,8 +1708,8 @@ auto cluster(char const * dbname,
       int msa_target_count = 0;
       std::vector<struct msa_target_s> msa_target_list_v(static_cast<std::size_t>(size_max));
 
-      auto msaout_handle = open_optional_output_file(parameters.opt_msaout, OutputOption{"--msaout"});
-      auto consout_handle = open_optional_output_file(parameters.opt_consout, OutputOption{"--consout"});
+      auto msaout_handle = compress_output(open_optional_output_file(parameters.opt_msaout, OutputOption{"--msaout"}), parameters);
+      auto consout_handle = compress_output(open_optional_output_file(parameters.opt_consout, OutputOption{"--consout"}), parameters);
       auto profile_handle = open_optional_output_file(parameters.opt_profile, OutputOption{"--profile"});
       std::FILE * const fp_msaout = msaout_handle.get();
       std::FILE * const fp_consout = consout_handle.get();
@@ -1652,7 +1885,7 @@ auto cluster_session_init(struct cluster_session_s * cs, struct Parameters const
 
   /* Set search parameters matching the CLI cluster path.
      seqcount must be set BEFORE cluster_query_init (it sizes the kmers buffer).
-     MAXDELAYED (8) is needed as safety buffer for align_delayed().
+     MAXDELAYED (64) is needed as safety buffer for align_delayed().
      Clamp tophits to seqcount to avoid oversized allocations.
      The library path does not clamp to the database size (only the CLI
      cluster() does), so the sizing uses the configured values from parameters;
@@ -1665,13 +1898,13 @@ auto cluster_session_init(struct cluster_session_s * cs, struct Parameters const
     }
 
   cs->si = make_unique<searchinfo_s>();
-  cluster_query_init(cs->si.get(), cs->seqcount, cs->tophits, db, parameters, *cs->dbindex);
+  cluster_query_init(cs->si.get(), cs->seqcount, cs->tophits, db, parameters, *cs->dbindex, true);
   cs->si->strand = 0;
 
   if (parameters.opt_strand)
     {
       cs->si_minus = make_unique<searchinfo_s>();
-      cluster_query_init(cs->si_minus.get(), cs->seqcount, cs->tophits, db, parameters, *cs->dbindex);
+      cluster_query_init(cs->si_minus.get(), cs->seqcount, cs->tophits, db, parameters, *cs->dbindex, true);
       cs->si_minus->strand = 1;
     }
 
@@ -1794,7 +2027,7 @@ auto cluster_assign_batch(struct cluster_session_s * cs,
      per-thread searchinfo arrays and creates the ThreadRunner; the destructor
      joins the workers and cluster_query_exit()s them. The local si_plus/
      si_minus aliases let the loop below read unchanged. */
-  cluster_work_pool_s pool(static_cast<int>(parameters.opt_threads), cs->seqcount,
+  cluster_work_pool_s pool(static_cast<int>(parameters.opt_threads), max_queries, cs->seqcount,
                            cs->tophits, parameters.opt_strand, parameters, *cs->dbindex, *cs->db);
   searchinfo_s * const si_plus = pool.si_plus.data();
   searchinfo_s * const si_minus = pool.si_minus.empty() ? nullptr : pool.si_minus.data();
@@ -1848,7 +2081,7 @@ auto cluster_assign_batch(struct cluster_session_s * cs,
             {
               struct searchinfo_s * si = (s != 0) ? si_m : si_p;
 
-              evaluate_extra_hits(si, si_plus, extra_list.data(), extra_count, lma, cs->tophits, *cs->db);
+              evaluate_extra_hits(si, si_plus, extra_list.data(), extra_count, lma, cs->tophits, *cs->db, nullptr);
             }
 
           /* Find best hit across strands */
@@ -63,12 +63,15 @@
 #include "utils/maps.hpp"
 #include "utils/progress.hpp"
 #include "utils/string_alloc.hpp"
+#include "utils/threads.hpp"
 #include <algorithm>  // std::min, std::max, std::sort
 #include <cinttypes>  // macros PRIu64 and PRId64
 #include <cstdint>  // int64_t, uint64_t
 #include <cstdio>  // std::fprintf, std::size_t
-#include <cstring>  // std::memcpy, std::strcmp
+#include <cstring>  // std::memcpy, std::memmove, std::strcmp
 #include <limits>
+#include <utility>  // std::move
+#include <vector>
 
 
 constexpr uint64_t memchunk = 16777216;  // 2^24
@@ -91,6 +94,238 @@ namespace {
     vec.reserve(chunked_bytes / item_size);
   }
 
+
+  /* a FASTA file is read on several threads when each gets at least
+     this many bytes */
+  constexpr uint64_t min_shard_size = memchunk;
+
+
+  enum struct Record_fate : unsigned char { keep, too_short, too_long, too_rare };
+
+
+  auto classify_record(std::size_t const sequencelength,
+                       int64_t const abundance,
+                       struct Parameters const & parameters) -> Record_fate
+  {
+    /* opt_minseqlength defaults to the -1 "unset" sentinel, which the CLI
+       resolves to a command-specific value (1 or 32) before read() runs.
+       A library caller may leave it unset, so guard the cast: a non-positive
+       minimum means "no lower bound". Without this, static_cast<size_t>(-1)
+       is SIZE_MAX and every sequence is discarded as too short. */
+    if ((parameters.opt_minseqlength > 0) and
+        (sequencelength < static_cast<size_t>(parameters.opt_minseqlength)))
+      {
+        return Record_fate::too_short;
+      }
+    if (sequencelength > static_cast<size_t>(parameters.opt_maxseqlength))
+      {
+        return Record_fate::too_long;
+      }
+    if ((parameters.opt_cluster_unoise != nullptr) && (abundance < parameters.opt_minsize))
+      {
+        return Record_fate::too_rare;
+      }
+    return Record_fate::keep;
+  }
+
+
+  struct Read_summary
+  {
+    int64_t discarded_short = 0;
+    int64_t discarded_long = 0;
+    int64_t discarded_unoise = 0;
+    uint64_t sequences = 0;
+    uint64_t nucleotides = 0;
+    uint64_t longest = 0;
+    uint64_t shortest = std::numeric_limits<uint64_t>::max();
+    uint64_t longestheader = 0;
+
+    auto count_discarded(Record_fate const fate) -> void {
+      switch (fate)
+        {
+        case Record_fate::too_short:
+          ++discarded_short;
+          break;
+        case Record_fate::too_long:
+          ++discarded_long;
+          break;
+        case Record_fate::too_rare:
+          ++discarded_unoise;
+          break;
+        case Record_fate::keep:
+          break;
+        }
+    }
+
+    auto add(Read_summary const & other) -> void {
+      discarded_short += other.discarded_short;
+      discarded_long += other.discarded_long;
+      discarded_unoise += other.discarded_unoise;
+      sequences += other.sequences;
+      nucleotides += other.nucleotides;
+      longest = std::max(longest, other.longest);
+      shortest = std::min(shortest, other.shortest);
+      longestheader = std::max(longestheader, other.longestheader);
+    }
+  };
+
+
+  using Data_buffer = std::vector<char, FatalAllocator<char>>;
+  using Index_buffer = std::vector<seqinfo_t, FatalAllocator<seqinfo_t>>;
+
+
+  struct Shard
+  {
+    uint64_t begin = 0;  // range of the file, and of the data buffer
+    uint64_t end = 0;
+    uint64_t first_line = 1;
+    uint64_t data_end = 0;  // the records are stored in data[begin, data_end)
+    Index_buffer index;
+    Read_summary summary;
+    fastx_handle handle = nullptr;
+  };
+
+
+  auto read_shard(Shard & shard,
+                  fastx_handle input_handle,
+                  char * data,
+                  unsigned char const * char_mapping,
+                  Progress * progress,
+                  uint64_t const shard_count,
+                  struct Parameters const & parameters) -> void
+  {
+    shard.handle = fastx_open_shard(input_handle, shard.begin, shard.end, shard.first_line);
+    auto position = shard.begin;
+    while (fastx_next(shard.handle, not parameters.opt_notrunclabels, char_mapping))
+      {
+        auto const headerlength = fastx_get_header_length(shard.handle);
+        auto const sequencelength = fastx_get_sequence_length(shard.handle);
+        auto const abundance = fastx_get_abundance(shard.handle);
+        auto const fate = classify_record(sequencelength, abundance, parameters);
+        if (fate != Record_fate::keep)
+          {
+            shard.summary.count_discarded(fate);
+          }
+        else
+          {
+            /* stored as by Database::add() */
+            seqinfo_t record;
+            record.headerlen = static_cast<unsigned int>(headerlength);
+            record.seqlen = static_cast<unsigned int>(sequencelength);
+            record.header_p = position;
+            std::memcpy(data + position, fastx_get_header(shard.handle), headerlength + 1);
+            position += headerlength + 1;
+            record.seq_p = position;
+            std::memcpy(data + position, fastx_get_sequence(shard.handle), sequencelength + 1);
+            position += sequencelength + 1;
+            record.qual_p = position;
+            record.size = static_cast<uint64_t>(abundance);
+            shard.index.push_back(record);
+
+            ++shard.summary.sequences;
+            shard.summary.nucleotides += sequencelength;
+            shard.summary.longest = std::max(static_cast<uint64_t>(sequencelength), shard.summary.longest);
+            shard.summary.shortest = std::min(static_cast<uint64_t>(sequencelength), shard.summary.shortest);
+            shard.summary.longestheader = std::max(static_cast<uint64_t>(headerlength), shard.summary.longestheader);
+          }
+        if (progress != nullptr)
+          {
+            /* shards have about the same size: the first one stands for all */
+            progress->update(fastx_get_position(shard.handle) * shard_count);
+          }
+      }
+    shard.data_end = position;
+  }
+
+
+  /* Parse the ranges of a mapped FASTA file on one thread each. A record
+     never takes more room in memory (header and sequence, each followed
+     by a NUL) than in the file ('>', header, line end, sequence lines),
+     so each shard stores its records in the part of the data buffer
+     that matches its part of the file. The shards are then moved down
+     to close the gaps, in file order: the result is the same as
+     appending the records one by one with Database::add(). */
+  auto read_shards(fastx_handle input_handle,
+                   std::vector<uint64_t> const & offsets,
+                   unsigned char const * char_mapping,
+                   Data_buffer & data,
+                   Index_buffer & seqindex,
+                   Progress & progress,
+                   struct Parameters const & parameters) -> Read_summary
+  {
+    auto const shard_count = offsets.size() - 1;
+    std::vector<Shard> shards(shard_count);
+    for (auto i = std::size_t{0}; i < shard_count; ++i)
+      {
+        shards[i].begin = offsets[i];
+        shards[i].end = offsets[i + 1];
+      }
+    data.resize(static_cast<std::size_t>(offsets.back()));
+    auto * const buffer = data.data();
+
+    /* first count the lines of each shard, for the line numbers of
+       warnings and errors, then parse */
+    auto counting_lines = true;
+    ThreadRunner thread_runner(shard_count, [&](uint64_t const nth_thread) -> void {
+      auto & shard = shards[nth_thread];
+      if (counting_lines)
+        {
+          shard.first_line = fastx_count_lines(input_handle, shard.begin, shard.end);
+          return;
+        }
+      read_shard(shard, input_handle, buffer, char_mapping,
+                 (nth_thread == 0) ? &progress : nullptr, shard_count, parameters);
+    });
+    thread_runner.run();
+    uint64_t line_number = 1;
+    for (auto & shard : shards)
+      {
+        auto const line_count = shard.first_line;
+        shard.first_line = line_number;
+        line_number += line_count;
+      }
+    counting_lines = false;
+    thread_runner.run();
+
+    /* report the first error in file order, as a sequential read would */
+    for (auto const & shard : shards)
+      {
+        if (fastx_get_error(shard.handle))
+          {
+            fatal("%s", fastx_get_errmsg(shard.handle));
+          }
+      }
+
+    Read_summary summary;
+    auto record_count = std::size_t{0};
+    for (auto const & shard : shards)
+      {
+        record_count += shard.index.size();
+      }
+    seqindex.reserve(record_count);
+    auto stored = uint64_t{0};
+    for (auto & shard : shards)
+      {
+        auto const length = shard.data_end - shard.begin;
+        std::memmove(buffer + stored, buffer + shard.begin, length);
+        auto const shift = shard.begin - stored;
+        for (auto record : shard.index)
+          {
+            record.header_p -= shift;
+            record.seq_p -= shift;
+            record.qual_p -= shift;
+            seqindex.push_back(record);
+          }
+        stored += length;
+        summary.add(shard.summary);
+        fastx_close_shard(shard.handle, input_handle);
+        shard.index = Index_buffer{};
+      }
+    data.resize(stored);
+    progress.update(offsets.back());
+    return summary;
+  }
+
 }  // end of anonymous namespace
 
 
@@ -110,6 +345,14 @@ auto Database::init() -> void
 }
 
 
+auto Database::bind_views() -> void
+{
+  /* called after every change that may move the vectors' storage */
+  data_view_ = data_.data();
+  seqindex_view_ = seqindex_.data();
+}
+
+
 auto Database::udb_reserve(uint64_t const count, uint64_t const datap_bytes) -> void
 {
   /* udb_read fills these buffers in place (it bypasses add()); size them up
@@ -118,6 +361,7 @@ auto Database::udb_reserve(uint64_t const count, uint64_t const datap_bytes) ->
      the value-initialised bytes are overwritten by the loader. */
   seqindex_.resize(static_cast<std::size_t>(count));
   data_.resize(static_cast<std::size_t>(datap_bytes));
+  bind_views();
 }
 
 
@@ -157,11 +401,35 @@ auto Database::udb_finalize(uint64_t const count,
 }
 
 
+auto Database::udb_map(std::shared_ptr<void> mapping,
+                       char * data,
+                       seqinfo_t * index,
+                       uint64_t const count,
+                       uint64_t const nucleotide_count,
+                       uint64_t const longest_sequence,
+                       uint64_t const shortest_sequence,
+                       uint64_t const longest_header,
+                       bool const unit_abundances) -> void
+{
+  clear();
+  udb_mapping_ = std::move(mapping);
+  unit_abundances_ = unit_abundances;
+  data_view_ = data;
+  seqindex_view_ = index;
+  fastq_format = false;
+  sequences = count;
+  nucleotides = nucleotide_count;
+  longest = longest_sequence;
+  shortest = shortest_sequence;
+  longestheader = longest_header;
+}
+
+
 auto Database::getquality(uint64_t seqno) const -> char const *
 {
   if (fastq_format)
     {
-      return data_.data() + seqindex_[seqno].qual_p;
+      return data_view_ + seqindex_view_[seqno].qual_p;
     }
   return nullptr;
 }
@@ -216,6 +484,7 @@ auto Database::add(bool const is_fastq_record,
   record.qual_p = quality_p;
   record.size = static_cast<uint64_t>(abundance);
   seqindex_.push_back(record);
+  bind_views();
 
   /* update statistics */
   ++sequences;
@@ -246,52 +515,61 @@ auto Database::read(const char * filename, int upcase, struct Parameters const &
   sequences = 0;
   nucleotides = 0;
 
-  int64_t discarded_short = 0;
-  int64_t discarded_long = 0;
-  int64_t discarded_unoise = 0;
+  Read_summary summary;
 
-  /* start from empty buffers; the records are appended by add() below */
+  /* start from empty buffers; the records are appended by add() below,
+     or stored by read_shards() */
   data_.clear();
   seqindex_.clear();
+  bind_views();
+
+  auto const * const char_mapping = (upcase != 0) ? chrmap_upcase() : chrmap_no_change();
+
+  /* large uncompressed FASTA files are cut into shards parsed on
+     several threads */
+  std::vector<uint64_t> shard_offsets;
+  if (parameters.opt_threads > 1)
+    {
+      auto const shard_count = std::min(static_cast<uint64_t>(parameters.opt_threads),
+                                        static_cast<uint64_t>(filesize) / min_shard_size);
+      shard_offsets = fastx_split(h, static_cast<unsigned int>(shard_count));
+    }
 
   {
     Progress progress(prompt, static_cast<uint64_t>(filesize), parameters);
-    while (fastx_next(h,
-                     not parameters.opt_notrunclabels,
-                      (upcase != 0) ? chrmap_upcase() : chrmap_no_change()))
+    if (shard_offsets.size() > 2)
       {
-        size_t const sequencelength = fastx_get_sequence_length(h);
-        int64_t const abundance = fastx_get_abundance(h);
-
-        /* opt_minseqlength defaults to the -1 "unset" sentinel, which the CLI
-           resolves to a command-specific value (1 or 32) before read() runs.
-           A library caller may leave it unset, so guard the cast: a non-positive
-           minimum means "no lower bound". Without this, static_cast<size_t>(-1)
-           is SIZE_MAX and every sequence is discarded as too short. */
-        if ((parameters.opt_minseqlength > 0) and
-            (sequencelength < static_cast<size_t>(parameters.opt_minseqlength)))
-          {
-            ++discarded_short;
-          }
-        else if (sequencelength > static_cast<size_t>(parameters.opt_maxseqlength))
-          {
-            ++discarded_long;
-          }
-        else if ((parameters.opt_cluster_unoise != nullptr) && (abundance < parameters.opt_minsize))
-          {
-            ++discarded_unoise;
-          }
-        else
+        summary = read_shards(h, shard_offsets, char_mapping, data_, seqindex_, progress, parameters);
+        bind_views();
+        sequences = summary.sequences;
+        nucleotides = summary.nucleotides;
+        longest = summary.longest;
+        shortest = summary.shortest;
+        longestheader = summary.longestheader;
+      }
+    else
+      {
+        while (fastx_next(h, not parameters.opt_notrunclabels, char_mapping))
           {
-            add(fastq_format,
-                fastx_get_header(h),
-                fastx_get_sequence(h),
-                fastq_format ? fastx_get_quality(h) : nullptr,
-                fastx_get_header_length(h),
-                sequencelength,
-                abundance);
+            size_t const sequencelength = fastx_get_sequence_length(h);
+            int64_t const abundance = fastx_get_abundance(h);
+            auto const fate = classify_record(sequencelength, abundance, parameters);
+            if (fate != Record_fate::keep)
+              {
+                summary.count_discarded(fate);
+              }
+            else
+              {
+                add(fastq_format,
+                    fastx_get_header(h),
+                    fastx_get_sequence(h),
+                    fastq_format ? fastx_get_quality(h) : nullptr,
+                    fastx_get_header_length(h),
+                    sequencelength,
+                    abundance);
+              }
+            progress.update(fastx_get_position(h));
           }
-        progress.update(fastx_get_position(h));
       }
   }
   xfree(prompt);
@@ -343,57 +621,57 @@ auto Database::read(const char * filename, int upcase, struct Parameters const &
 
   /* Warn about discarded sequences */
 
-  if (discarded_short != 0)
+  if (summary.discarded_short != 0)
     {
       std::fprintf(stderr,
               "minseqlength %" PRId64 ": %" PRId64 " %s discarded.\n",
               parameters.opt_minseqlength,
-              discarded_short,
-              (discarded_short == 1 ? "sequence" : "sequences"));
+              summary.discarded_short,
+              (summary.discarded_short == 1 ? "sequence" : "sequences"));
 
       if (parameters.opt_log != nullptr)
         {
           std::fprintf(parameters.fp_log,
                   "minseqlength %" PRId64 ": %" PRId64 " %s discarded.\n\n",
                   parameters.opt_minseqlength,
-                  discarded_short,
-                  (discarded_short == 1 ? "sequence" : "sequences"));
+                  summary.discarded_short,
+                  (summary.discarded_short == 1 ? "sequence" : "sequences"));
         }
     }
 
-  if (discarded_long != 0)
+  if (summary.discarded_long != 0)
     {
       std::fprintf(stderr,
               "maxseqlength %" PRId64 ": %" PRId64 " %s discarded.\n",
               parameters.opt_maxseqlength,
-              discarded_long,
-              (discarded_long == 1 ? "sequence" : "sequences"));
+              summary.discarded_long,
+              (summary.discarded_long == 1 ? "sequence" : "sequences"));
 
       if (parameters.opt_log != nullptr)
         {
           std::fprintf(parameters.fp_log,
                   "maxseqlength %" PRId64 ": %" PRId64 " %s discarded.\n\n",
                   parameters.opt_maxseqlength,
-                  discarded_long,
-                  (discarded_long == 1 ? "sequence" : "sequences"));
+                  summary.discarded_long,
+                  (summary.discarded_long == 1 ? "sequence" : "sequences"));
         }
     }
 
-    if (discarded_unoise != 0)
+    if (summary.discarded_unoise != 0)
     {
       std::fprintf(stderr,
               "minsize %" PRId64 ": %" PRId64 " %s discarded.\n",
               parameters.opt_minsize,
-              discarded_unoise,
-              (discarded_unoise == 1 ? "sequence" : "sequences"));
+              summary.discarded_unoise,
+              (summary.discarded_unoise == 1 ? "sequence" : "sequences"));
 
       if (parameters.opt_log != nullptr)
         {
           std::fprintf(parameters.fp_log,
                   "minsize %" PRId64 ": %" PRId64 " %s discarded.\n",
                   parameters.opt_minsize,
-                  discarded_unoise,
-                  (discarded_unoise == 1 ? "sequence" : "sequences"));
+                  summary.discarded_unoise,
+                  (summary.discarded_unoise == 1 ? "sequence" : "sequences"));
         }
     }
 }
@@ -408,6 +686,9 @@ auto Database::clear() -> void
   data_.shrink_to_fit();
   seqindex_.clear();
   seqindex_.shrink_to_fit();
+  bind_views();
+  udb_mapping_.reset();
+  unit_abundances_ = false;
   sequences = 0;
   nucleotides = 0;
   longest = 0;
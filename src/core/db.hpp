@@ -63,6 +63,7 @@
 #include "utils/fatal_allocator.hpp"  // FatalAllocator
 #include <cstdint>  // uint64_t
 #include <cstdio>  // std::size_t
+#include <memory>  // std::shared_ptr
 #include <vector>
 
 
@@ -94,7 +95,8 @@ using seqinfo_t = struct seqinfo_s;
    getX members) is const so search worker threads can query one shared database
    concurrently. It is populated in one of three ways: init() + add() when a
    library caller assembles a database programmatically, read() from a
-   FASTA/FASTQ file, or udb_read() straight from a UDB file. Each command (and
+   FASTA/FASTQ file, or udb_read() straight from a UDB file (a UDB v2 file
+   is mapped, not copied, see udb_map()). Each command (and
    each library caller) owns its own instance and threads a reference through
    the code. Remaining polish is tracked in TBD_20260713_Database_polish.md. */
 struct Database
@@ -106,6 +108,13 @@ private:
   std::vector<char, FatalAllocator<char>>           data_;
   std::vector<seqinfo_t, FatalAllocator<seqinfo_t>> seqindex_;
 
+  // what the accessors read: the two vectors above, or the sections of a
+  // UDB v2 file mapped by udb_map(), kept alive by udb_mapping_
+  char * data_view_ = nullptr;
+  seqinfo_t * seqindex_view_ = nullptr;
+  std::shared_ptr<void> udb_mapping_;
+  bool unit_abundances_ = false;  // read the mapped abundances as 1
+
   bool     fastq_format = false;  // read through the is_fastq() accessor
   uint64_t sequences = 0;
   uint64_t nucleotides = 0;
@@ -115,6 +124,8 @@ private:
 
   /* udb_read is a second database loader that fills data_/seqindex_ in place
      (it bypasses add()); grant it access to the otherwise-private buffers. */
+  auto bind_views() -> void;
+
   friend auto udb_read(const char * filename,
                        bool create_bitmaps,
                        bool parse_abundances,
@@ -147,7 +158,8 @@ public:
      bypasses add() and fills the reserved buffers in place, mirroring how it
      fills Dbindex's buffers). udb_reserve allocates the two buffers up front;
      udb_finalize runs the terminator-insertion memmove pass and records the
-     summary statistics. */
+     summary statistics. udb_map instead points the database at the sections
+     of a mapped UDB v2 file, which already hold terminated sequences. */
   auto udb_reserve(uint64_t count, uint64_t datap_bytes) -> void;
   auto udb_finalize(uint64_t count,
                     uint64_t nucleotide_count,
@@ -155,6 +167,15 @@ public:
                     uint64_t shortest_sequence,
                     uint64_t longest_header,
                     struct Parameters const & parameters) -> void;
+  auto udb_map(std::shared_ptr<void> mapping,
+               char * data,
+               seqinfo_t * index,
+               uint64_t count,
+               uint64_t nucleotide_count,
+               uint64_t longest_sequence,
+               uint64_t shortest_sequence,
+               uint64_t longest_header,
+               bool unit_abundances) -> void;
 
   auto getquality(uint64_t seqno) const -> char const *;
 
@@ -166,12 +187,12 @@ public:
 
   auto getheader(uint64_t seqno) const -> char const *
   {
-    return data_.data() + seqindex_[seqno].header_p;
+    return data_view_ + seqindex_view_[seqno].header_p;
   }
 
   auto getsequence(uint64_t seqno) const -> char const *
   {
-    return data_.data() + seqindex_[seqno].seq_p;
+    return data_view_ + seqindex_view_[seqno].seq_p;
   }
 
   /* Non-const companions to getsequence()/getheader(): hand out writable
@@ -182,27 +203,27 @@ public:
      mutate the database. */
   auto mutatesequence(uint64_t seqno) -> char *
   {
-    return data_.data() + seqindex_[seqno].seq_p;
+    return data_view_ + seqindex_view_[seqno].seq_p;
   }
 
   auto mutateheader(uint64_t seqno) -> char *
   {
-    return data_.data() + seqindex_[seqno].header_p;
+    return data_view_ + seqindex_view_[seqno].header_p;
   }
 
   auto getabundance(uint64_t seqno) const -> uint64_t
   {
-    return seqindex_[seqno].size;
+    return unit_abundances_ ? 1 : seqindex_view_[seqno].size;
   }
 
   auto getsequencelen(uint64_t seqno) const -> uint64_t
   {
-    return seqindex_[seqno].seqlen;
+    return seqindex_view_[seqno].seqlen;
   }
 
   auto getheaderlen(uint64_t seqno) const -> uint64_t
   {
-    return seqindex_[seqno].headerlen;
+    return seqindex_view_[seqno].headerlen;
   }
 
   auto getsequencecount() const -> uint64_t { return sequences; }
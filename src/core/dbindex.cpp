@@ -62,9 +62,13 @@
 #include "core/bitmap.hpp"
 #include "core/dbindex.hpp"
 #include "core/unique.hpp"
+#include "utils/fatal.hpp"
 #include "utils/open_file.hpp"
 #include "utils/progress.hpp"
+#include "utils/threads.hpp"
+#include <algorithm>  // std::copy, std::max, std::min
 #include <array>
+#include <atomic>
 #include <cstdint>  // uint64_t
 #include <cstdio>  // std::FILE, std::fprintf
 #include <cstring>  // std::memset
@@ -74,6 +78,37 @@
 constexpr unsigned int bitmap_threshold = 8;
 
 
+// anonymous namespace: limit visibility and usage to this translation unit
+namespace {
+
+  /* upper limit on the per-thread k-mer counts (entries over all threads):
+     long words index serially rather than allocate a huge row per thread */
+  constexpr auto chunk_kmercount_max = uint64_t{1} << 28U;
+
+
+  auto index_threads(struct Parameters const & parameters,
+                     unsigned int const hashsize,
+                     unsigned int const seqcount) -> unsigned int
+  {
+    auto const wanted = static_cast<uint64_t>(std::max(int64_t{1}, parameters.opt_threads));
+    auto const fitting = std::max(uint64_t{1}, chunk_kmercount_max / hashsize);
+    auto const useful = std::max(uint64_t{1}, (static_cast<uint64_t>(seqcount) + 7) / 8);
+    return static_cast<unsigned int>(std::min({wanted, fitting, useful}));
+  }
+
+
+  /* first sequence of a range; the ranges are multiples of 8 sequences
+     so that the threads set bits in distinct bytes of the bitmaps */
+  auto chunk_first(unsigned int const seqcount, unsigned int const chunks,
+                   unsigned int const chunk) -> unsigned int
+  {
+    auto const step = ((((static_cast<uint64_t>(seqcount) + chunks - 1) / chunks) + 7) / 8) * 8;
+    return static_cast<unsigned int>(std::min(step * chunk, static_cast<uint64_t>(seqcount)));
+  }
+
+}  // end of anonymous namespace
+
+
 auto Dbindex::getbitmap(unsigned int const kmer) const -> unsigned char *
 {
   auto * a_bitmap_s = *std::next(kmerbitmap, kmer);
@@ -93,10 +128,101 @@ auto Dbindex::getmatchcount(unsigned int const kmer) const -> unsigned int
 
 auto Dbindex::getmatchlist(unsigned int const kmer) const -> unsigned int *
 {
+  if (not udb_checked.empty())
+    {
+      check_list(kmer);
+    }
   return std::next(kmerindex, static_cast<std::iterator_traits<unsigned int *>::difference_type>(*std::next(kmerhash, kmer)));
 }
 
 
+auto Dbindex::getpackedlist(unsigned int const kmer) const -> unsigned char const *
+{
+  /* kmer == hashsize gives the end of the last list */
+  if ((not udb_checked.empty()) and (kmer < hashsize))
+    {
+      check_list(kmer);
+    }
+  return std::next(kmerpacked, static_cast<std::iterator_traits<unsigned char *>::difference_type>(*std::next(kmerhash, kmer)));
+}
+
+
+auto Dbindex::check_list(unsigned int const kmer) const -> void
+{
+  /* The list of a k-mer in a mapped UDB v2 file must lie within the
+     k-mer lists (whose bounds udb_read() has checked) and hold strictly
+     increasing sequence numbers below count, as the batched search
+     relies on; a packed list must decode to exactly kmercount of them
+     within its own bytes. Several threads
+     may check the same list at once, which is harmless. */
+
+  auto & checked = udb_checked[kmer / 64];
+  auto const bit = uint64_t{1} << (kmer % 64);
+  if ((checked.load(std::memory_order_acquire) & bit) != 0)
+    {
+      return;
+    }
+
+  auto const start = kmerhash[kmer];
+  auto const entries = kmercount[kmer];
+  if (is_packed())
+    {
+      auto const end = kmerhash[kmer + 1];
+      if ((start > end) or (end > kmerhash[hashsize]))
+        {
+          fatal("Invalid UDB file");
+        }
+      auto const * input = kmerpacked + start;
+      auto const * const list_end = kmerpacked + end;
+      uint64_t seqno = 0;
+      for (auto j = 0U; j < entries; j++)
+        {
+          /* at most packed_gap_max_bytes bytes, all within the list */
+          uint64_t gap = 0;
+          auto shift = 0U;
+          auto more = true;
+          while (more)
+            {
+              if ((input == list_end) or (shift > 7 * (packed_gap_max_bytes - 1)))
+                {
+                  fatal("Invalid UDB file");
+                }
+              gap |= static_cast<uint64_t>(*input & 0x7FU) << shift;
+              more = ((*input & 0x80U) != 0);
+              ++input;
+              shift += 7;
+            }
+          if (((j != 0) and (gap == 0)) or (seqno + gap >= count))
+            {
+              fatal("Invalid UDB file");
+            }
+          seqno += gap;
+        }
+      if (input != list_end)
+        {
+          fatal("Invalid UDB file");
+        }
+    }
+  else
+    {
+      if ((start > indexsize) or (entries > indexsize - start))
+        {
+          fatal("Invalid UDB file");
+        }
+      auto const * const list = kmerindex + start;
+      for (auto j = 0U; j < entries; j++)
+        {
+          if ((list[j] >= count) or ((j != 0) and (list[j] <= list[j - 1])))
+            {
+              fatal("Invalid UDB file");
+            }
+        }
+    }
+
+  checked.fetch_or(bit, std::memory_order_release);
+}
+
+
 auto Dbindex::getmapping(unsigned int const index) const -> unsigned int
 {
   return *std::next(map, index);
@@ -150,13 +276,75 @@ auto Dbindex::add_sequence(unsigned int seqno, Masking seqmask, struct Database
 
 auto Dbindex::add_all_sequences(Masking seqmask, struct Database const & db, struct Parameters const & parameters) -> void
 {
+  /*
+    Each thread fills the k-mer lists with the sequences of the range it
+    counted in prepare(). Its entries in the list of a k-mer start after
+    those of the preceding ranges, so the lists are in sequence order and
+    the index is the same as one built serially with add_sequence().
+  */
+
   unsigned int const seqcount = static_cast<unsigned int>(db.getsequencecount());
-  Progress progress("Creating k-mer index", seqcount, parameters);
-  for (auto seqno = 0U; seqno < seqcount ; seqno++)
+  auto const threads = chunk_threads;
+
+  /* turn the counts of each range into its offsets in the lists */
+  for (auto kmer = 0U; kmer < hashsize; kmer++)
     {
-      add_sequence(seqno, seqmask, db);
-      progress.update(seqno);
+      auto sum = 0U;
+      for (auto t = 0U; t < threads; t++)
+        {
+          auto & cell = chunk_kmercount[(static_cast<std::size_t>(t) * hashsize) + kmer];
+          auto const range_count = cell;
+          cell = sum;
+          sum += range_count;
+        }
     }
+
+  {
+    Progress progress("Creating k-mer index", seqcount, parameters);
+    ThreadRunner threadrunner(threads, [&](uint64_t const nth_thread) {
+      auto const chunk = static_cast<unsigned int>(nth_thread);
+      auto * const cursor = chunk_kmercount.data() + (static_cast<std::size_t>(chunk) * hashsize);
+      auto * const thread_uhandle = unique_init();
+      auto const first = chunk_first(seqcount, threads, chunk);
+      auto const last = chunk_first(seqcount, threads, chunk + 1);
+      for (auto seqno = first; seqno < last; seqno++)
+        {
+          unsigned int uniquecount = 0;
+          unsigned int const * uniquelist = nullptr;
+          unique_count(thread_uhandle, static_cast<int>(wordlength),
+                       static_cast<int>(db.getsequencelen(seqno)), db.getsequence(seqno),
+                       &uniquecount, &uniquelist, seqmask);
+          map[seqno] = seqno;
+          for (auto i = 0U; i < uniquecount; i++)
+            {
+              auto const kmer = uniquelist[i];
+              if (kmerbitmap[kmer] != nullptr)
+                {
+                  bitmap_set(kmerbitmap[kmer], seqno);
+                }
+              else
+                {
+                  kmerindex[kmerhash[kmer] + cursor[kmer]] = seqno;
+                }
+              ++cursor[kmer];
+            }
+          if (chunk == 0)
+            {
+              progress.update(std::min((seqno + 1 - first) * threads, seqcount));
+            }
+        }
+      unique_exit(thread_uhandle);
+    });
+    threadrunner.run();
+  }
+
+  /* the cursors of the last range end at the k-mer counts */
+  auto const * const totals = chunk_kmercount.data() + (static_cast<std::size_t>(threads - 1) * hashsize);
+  std::copy(totals, totals + hashsize, kmercount);
+  count = seqcount;
+
+  chunk_kmercount.clear();
+  chunk_kmercount.shrink_to_fit();
 }
 
 
@@ -180,24 +368,48 @@ auto Dbindex::prepare(int use_bitmap, Masking seqmask, struct Database const & d
   kmercount = static_cast<unsigned int *>(xmalloc(hashsize * sizeof(unsigned int)));
   std::memset(kmercount, 0, hashsize * sizeof(unsigned int));
 
-  /* first scan, just count occurences */
+  /* first scan, just count occurences, in parallel over ranges of
+     sequences with a row of counts per range */
+  chunk_threads = index_threads(parameters, hashsize, seqcount);
+  chunk_kmercount.assign(static_cast<std::size_t>(chunk_threads) * hashsize, 0);
   {
     Progress progress("Counting k-mers", seqcount, parameters);
-    for (auto seqno = 0U; seqno < seqcount ; seqno++)
-      {
-        unsigned int uniquecount = 0;
-        unsigned int const * uniquelist = nullptr;
-        unique_count(uhandle, static_cast<int>(wordlength),
-                     static_cast<int>(db.getsequencelen(seqno)), db.getsequence(seqno),
-                     &uniquecount, &uniquelist, seqmask);
-        for (auto i = 0U; i < uniquecount; i++)
-          {
-            ++kmercount[uniquelist[i]];
-          }
-        progress.update(seqno);
-      }
+    ThreadRunner threadrunner(chunk_threads, [&](uint64_t const nth_thread) {
+      auto const chunk = static_cast<unsigned int>(nth_thread);
+      auto * const row = chunk_kmercount.data() + (static_cast<std::size_t>(chunk) * hashsize);
+      auto * const thread_uhandle = unique_init();
+      auto const first = chunk_first(seqcount, chunk_threads, chunk);
+      auto const last = chunk_first(seqcount, chunk_threads, chunk + 1);
+      for (auto seqno = first; seqno < last; seqno++)
+        {
+          unsigned int uniquecount = 0;
+          unsigned int const * uniquelist = nullptr;
+          unique_count(thread_uhandle, static_cast<int>(wordlength),
+                       static_cast<int>(db.getsequencelen(seqno)), db.getsequence(seqno),
+                       &uniquecount, &uniquelist, seqmask);
+          for (auto i = 0U; i < uniquecount; i++)
+            {
+              ++row[uniquelist[i]];
+            }
+          if (chunk == 0)
+            {
+              progress.update(std::min((seqno + 1 - first) * chunk_threads, seqcount));
+            }
+        }
+      unique_exit(thread_uhandle);
+    });
+    threadrunner.run();
   }
 
+  for (auto t = 0U; t < chunk_threads; t++)
+    {
+      auto const * const row = chunk_kmercount.data() + (static_cast<std::size_t>(t) * hashsize);
+      for (auto kmer = 0U; kmer < hashsize; kmer++)
+        {
+          kmercount[kmer] += row[kmer];
+        }
+    }
+
 #if 0
   /* dump kmer counts */
   auto const kmercounts_handle = open_output_file("kmercounts.txt");
@@ -255,6 +467,72 @@ auto Dbindex::prepare(int use_bitmap, Masking seqmask, struct Database const & d
 }
 
 
+auto Dbindex::pack() -> void
+{
+  /*
+    Replace kmerindex with the packed lists. The gaps between the sorted
+    seqnos of a list are mostly small, so most take one or two bytes
+    instead of four. The lists of k-mers with a bitmap are not read by
+    the search and are dropped. A mapped UDB v2 index is used as stored:
+    its pages are shared and not held by this process alone. The gaps
+    are unsigned, so a list that is not strictly increasing (which
+    udb_read() already rejects) is refused here rather than encoded
+    as a huge gap.
+  */
+
+  if (udb_mapping or is_packed() or (kmerindex == nullptr))
+    {
+      return;
+    }
+
+  uint64_t packedsize = 0;
+  for (auto kmer = 0U; kmer < hashsize; kmer++)
+    {
+      if (kmerbitmap[kmer] != nullptr)
+        {
+          continue;
+        }
+      auto previous = 0U;
+      auto const * list = kmerindex + kmerhash[kmer];
+      for (auto j = 0U; j < kmercount[kmer]; j++)
+        {
+          if ((j != 0) and (list[j] <= previous))
+            {
+              fatal("Invalid UDB file");
+            }
+          std::array<unsigned char, packed_gap_max_bytes> code {{}};
+          packedsize += static_cast<uint64_t>(pack_gap(code.data(), list[j] - previous) - code.data());
+          previous = list[j];
+        }
+    }
+
+  auto * const offsets = static_cast<uint64_t *>(xmalloc((hashsize + 1ULL) * sizeof(uint64_t)));
+  kmerpacked = static_cast<unsigned char *>(xmalloc(packedsize));
+  auto * output = kmerpacked;
+  for (auto kmer = 0U; kmer < hashsize; kmer++)
+    {
+      offsets[kmer] = static_cast<uint64_t>(output - kmerpacked);
+      if (kmerbitmap[kmer] != nullptr)
+        {
+          continue;
+        }
+      auto previous = 0U;
+      auto const * list = kmerindex + kmerhash[kmer];
+      for (auto j = 0U; j < kmercount[kmer]; j++)
+        {
+          output = pack_gap(output, list[j] - previous);
+          previous = list[j];
+        }
+    }
+  offsets[hashsize] = packedsize;
+
+  xfree(kmerindex);
+  kmerindex = nullptr;
+  xfree(kmerhash);
+  kmerhash = offsets;
+}
+
+
 auto Dbindex::clear() -> void
 {
   /* Free and null every owned buffer so the routine is idempotent (a second
@@ -262,9 +540,19 @@ auto Dbindex::clear() -> void
      subsequent prepare() starts from a clean slate. xfree() fatals on
      a null pointer, so each free is guarded; the bitmap loop and unique handle
      are likewise guarded because they may not have been allocated yet (L2a). */
+  if (udb_mapping)
+    {
+      kmerhash = nullptr;
+      kmerindex = nullptr;
+      kmercount = nullptr;
+      kmerpacked = nullptr;
+      udb_mapping.reset();
+      udb_checked.clear();
+    }
   if (kmerhash != nullptr) { xfree(kmerhash); kmerhash = nullptr; }
   if (kmerindex != nullptr) { xfree(kmerindex); kmerindex = nullptr; }
   if (kmercount != nullptr) { xfree(kmercount); kmercount = nullptr; }
+  if (kmerpacked != nullptr) { xfree(kmerpacked); kmerpacked = nullptr; }
   if (map != nullptr) { xfree(map); map = nullptr; }
 
   if (kmerbitmap != nullptr)
@@ -286,6 +574,9 @@ auto Dbindex::clear() -> void
       uhandle = nullptr;
     }
 
+  chunk_kmercount.clear();
+  chunk_kmercount.shrink_to_fit();
+  chunk_threads = 0;
   hashsize = 0;
   indexsize = 0;
 }
@@ -62,8 +62,11 @@
 
 #include "core/bitmap.hpp"
 #include "core/mask.hpp"  // Masking
+#include <atomic>
 #include <cstdio>  // std::FILE
 #include <cstdint>  // uint64_t
+#include <memory>  // std::shared_ptr
+#include <vector>
 
 
 struct uhandle_s;
@@ -88,6 +91,26 @@ struct Dbindex
   unsigned int hashsize = 0;  /* number of kmer slots, i.e. 4^wordlength */
   uint64_t indexsize = 0;  /* total number of entries in kmerindex */
 
+  /* the k-mer lists after pack(), replacing kmerindex: each list holds the
+     gaps between its seqnos (the first from zero) in a variable-byte code,
+     and kmerhash holds the offset in bytes of each list (hashsize + 1) */
+  unsigned char * kmerpacked = nullptr;
+
+  /* set by udb_read for a UDB v2 file, whose kmercount, kmerhash and
+     kmerindex point into this mapping instead of owned buffers */
+  std::shared_ptr<void> udb_mapping {};
+
+  /* the k-mer lists of a UDB v2 file are checked when first read
+     (check_list), not when the file is mapped; a bit per k-mer marks
+     the lists found valid. Empty for other indexes. */
+  mutable std::vector<std::atomic<uint64_t>> udb_checked {};
+
+  /* k-mer counts of each of the chunk_threads ranges of sequences that
+     prepare() counted in parallel, one row of hashsize per range; turned
+     into the start of each range in the k-mer lists by add_all_sequences() */
+  std::vector<unsigned int> chunk_kmercount {};
+  unsigned int chunk_threads = 0;
+
   /* effective word length of the built k-mer index (derived index state, not
      config): set by prepare (from parameters.opt_wordlength) for a FASTA
      database, or by udb_read for a UDB database whose stored word length differs.
@@ -110,14 +133,49 @@ struct Dbindex
   auto prepare(int use_bitmap, Masking seqmask, struct Database const & db, struct Parameters const & parameters) -> void;
   auto add_sequence(unsigned int seqno, Masking seqmask, struct Database const & db) -> void;
   auto add_all_sequences(Masking seqmask, struct Database const & db, struct Parameters const & parameters) -> void;
+  auto pack() -> void;
   auto clear() -> void;
 
   auto getbitmap(unsigned int kmer) const -> unsigned char *;
   auto getmatchcount(unsigned int kmer) const -> unsigned int;
   auto getmatchlist(unsigned int kmer) const -> unsigned int *;
+  auto getpackedlist(unsigned int kmer) const -> unsigned char const *;
+  auto is_packed() const -> bool { return kmerpacked != nullptr; }
   auto getmapping(unsigned int index) const -> unsigned int;
   auto getcount() const -> unsigned int;
+
+private:
+  auto check_list(unsigned int kmer) const -> void;
 };
 
 
+/* variable-byte code of the packed k-mer lists: 7 bits per byte, least
+   significant first, the high bit set on all bytes but the last */
+constexpr auto packed_gap_max_bytes = 5U;
+
+inline auto pack_gap(unsigned char * output, unsigned int gap) -> unsigned char *
+{
+  while (gap >= 0x80U)
+    {
+      *output++ = static_cast<unsigned char>(gap | 0x80U);
+      gap >>= 7U;
+    }
+  *output++ = static_cast<unsigned char>(gap);
+  return output;
+}
+
+
+inline auto unpack_gap(unsigned char const * & input) -> unsigned int
+{
+  unsigned int gap = *input & 0x7FU;
+  auto shift = 7U;
+  while ((*input++ & 0x80U) != 0)
+    {
+      gap |= static_cast<unsigned int>(*input & 0x7FU) << shift;
+      shift += 7U;
+    }
+  return gap;
+}
+
+
 auto fprint_kmer(std::FILE * output_handle, unsigned int kmer_length, uint64_t kmer) -> void;
@@ -64,13 +64,16 @@
 #include "core/derep_internal.hpp"
 #include "utils/fatal.hpp"
 #include "utils/maps.hpp"
+#include "core/block_compress.hpp"  // compress_output
 #include "utils/open_file.hpp"
 #include "utils/seqcmp.hpp"
 #include "utils/cityhash.hpp"
 #include "utils/reverse_complement.hpp"
 #include "utils/string_alloc.hpp"
 #include "utils/string_normalize.hpp"
+#include "utils/threads.hpp"
 #include <algorithm>  // std::count_if, std::min
+#include <array>
 #include <cinttypes>  // macros PRIu64 and PRId64
 #include <cmath>  // std::log10, std::pow
 #include <cstdint> // int64_t, uint64_t
@@ -198,6 +201,478 @@ namespace {
     return static_cast<int>(quality_value + parameters.opt_fastq_asciiout);
   }
 
+
+  constexpr auto terminal = std::numeric_limits<unsigned int>::max();
+
+
+  /* the clusters found so far: an open-addressing hash table,
+     doubled whenever it would become more than half full */
+  struct derep_table
+  {
+    uint64_t alloc_clusters = 1024;
+    uint64_t hash_mask = (2 * alloc_clusters) - 1;
+    uint64_t clusters = 0;
+    std::vector<struct bucket> hashtable = std::vector<struct bucket>(2 * alloc_clusters);
+  };
+
+
+  /* with --uc or --tabbedout: the next sequence of the same cluster,
+     the header and the matching strand of each input sequence */
+  struct derep_links
+  {
+    std::vector<unsigned int> nextseqtab;
+    std::vector<std::string> headertab;
+    std::vector<char> match_strand;
+
+    auto reserve(uint64_t const sequences) -> void {
+      if (sequences <= nextseqtab.size()) {
+        return;
+      }
+      auto const new_alloc_seqs = std::max<uint64_t>(sequences, 2 * nextseqtab.size());
+      nextseqtab.resize(new_alloc_seqs, terminal);
+      headertab.resize(new_alloc_seqs);
+      match_strand.resize(new_alloc_seqs);
+      // memory-intensive: per-sequence buffers have been grown
+    }
+  };
+
+
+  /* an input sequence, normalized (and reverse complemented) and hashed */
+  struct derep_entry
+  {
+    char const * header = nullptr;
+    std::size_t headerlen = 0;
+    char const * seq = nullptr;
+    char const * qual = nullptr;  // nullptr if FASTA
+    char const * seq_up = nullptr;
+    char const * rc_seq_up = nullptr;
+    int64_t seqlen = 0;
+    int64_t abundance = 1;
+    uint64_t seqno = 0;
+    uint64_t hash = 0;
+    uint64_t rc_hash = 0;
+  };
+
+
+  /* lengths and counts of the input sequences */
+  struct derep_input_stats
+  {
+    uint64_t sequencecount = 0;
+    uint64_t nucleotidecount = 0;
+    int64_t shortest = std::numeric_limits<int64_t>::max();
+    int64_t longest = 0;
+    uint64_t discarded_short = 0;
+    uint64_t discarded_long = 0;
+    int64_t sumsize = 0;
+
+    /* count a sequence, or its discarding */
+    auto accept(int64_t const seqlen, struct Parameters const & parameters) -> bool {
+      if (seqlen < parameters.opt_minseqlength) {
+        ++discarded_short;
+        return false;
+      }
+      if (seqlen > parameters.opt_maxseqlength) {
+        ++discarded_long;
+        return false;
+      }
+      nucleotidecount += static_cast<uint64_t>(seqlen);
+      longest = std::max(seqlen, longest);
+      shortest = std::min(seqlen, shortest);
+      return true;
+    }
+  };
+
+
+  auto hash_entry(struct derep_entry & entry, bool const use_header,
+                  struct Parameters const & parameters) -> void {
+    auto const hash_header = use_header ? hash_function(entry.header, entry.headerlen) : uint64_t{0};
+    entry.hash = hash_function(entry.seq_up, static_cast<uint64_t>(entry.seqlen)) ^ hash_header;
+    if (parameters.opt_strand) {
+      entry.rc_hash = hash_function(entry.rc_seq_up, static_cast<uint64_t>(entry.seqlen)) ^ hash_header;
+    }
+  }
+
+
+  auto find_bucket(struct derep_table & table, uint64_t const hash,
+                   char const * seq_up, int64_t const seqlen,
+                   char const * header, bool const use_header) -> struct bucket * {
+    /*
+      Find free bucket or bucket for identical sequence.
+      Make sure sequences are exactly identical
+      in case of any hash collision.
+      With 64-bit hashes, there is about 50% chance of a
+      collision when the number of sequences is about 5e9.
+    */
+    auto j = hash & table.hash_mask;
+    auto * bp = &table.hashtable[j];  // refactoring: rename to "cluster"
+
+    while ((bp->size != 0U) and
+           ((hash != bp->hash) or
+            (seqcmp(seq_up, bp->seq, seqlen) != 0) or
+            (use_header and (std::strcmp(header, bp->header) != 0))))
+      {
+        j = (j + 1) & table.hash_mask;
+        bp = &table.hashtable[j];
+      }
+    return bp;
+  }
+
+
+  /* add a sequence to its cluster, or start a new cluster; links is
+     nullptr unless --uc or --tabbedout are in effect */
+  auto derep_insert(struct derep_table & table, struct derep_entry const & entry,
+                    struct derep_links * links, bool const use_header,
+                    struct Parameters const & parameters) -> void {
+    if (table.clusters + 1 > table.alloc_clusters)
+      {
+        rehash(table.hashtable);
+
+        table.alloc_clusters *= 2;
+        table.hash_mask = (2 * table.alloc_clusters) - 1;
+
+        // memory-intensive: the hash table has been resized (rehash)
+      }
+
+    auto const seqlen = entry.seqlen;
+    auto * bp = find_bucket(table, entry.hash, entry.seq_up, seqlen, entry.header, use_header);
+
+    if (parameters.opt_strand and (bp->size == 0U))
+      {
+        /* no match on plus strand */
+        /* check minus strand as well */
+
+        auto * rc_bp = find_bucket(table, entry.rc_hash, entry.rc_seq_up, seqlen, entry.header, use_header);
+
+        if (rc_bp->size != 0U)
+          {
+            bp = rc_bp;
+            if (links != nullptr)
+              {
+                links->match_strand[entry.seqno] = 1;
+              }
+          }
+      }
+
+    if (bp->size != 0U)
+      {
+        /* at least one identical sequence already */
+        if (links != nullptr)
+          {
+            unsigned int const last = bp->seqno_last;
+            links->nextseqtab[last] = static_cast<unsigned int>(entry.seqno);
+            bp->seqno_last = static_cast<unsigned int>(entry.seqno);
+            links->headertab[entry.seqno] = entry.header;
+          }
+
+        int64_t const s1 = bp->size;
+        int64_t const s2 = entry.abundance;
+        int64_t const s3 = s1 + s2;
+
+        if (parameters.opt_fastqout != nullptr)
+          {
+            /* update quality scores */
+            for (int i = 0; i < seqlen; i++)
+              {
+                int const q1 = bp->qual[i];
+                int const q2 = entry.qual[i];
+                auto const p1 = convert_quality_symbol_to_probability(q1, parameters);
+                auto const p2 = convert_quality_symbol_to_probability(q2, parameters);
+                auto p3 = 0.0;
+
+                /* how to compute the new quality score? */
+
+                if (parameters.opt_fastq_qout_max)
+                  {
+                    // fastq_qout_max
+                    /* min error prob, highest quality */
+                    p3 = std::min(p1, p2);
+                  }
+                else
+                  {
+                    // fastq_qout_avg
+                    /* average, as in USEARCH */
+                    p3 = ((p1 * static_cast<double>(s1)) + (p2 * static_cast<double>(s2))) / static_cast<double>(s3);
+                  }
+
+                // fastq_qout_min
+                /* max error prob, lowest quality */
+                // p3 = std::max(p1, p2);
+
+                // fastq_qout_first
+                /* keep first */
+                // p3 = p1;
+
+                // fastq_qout_last
+                /* keep last */
+                // p3 = p2;
+
+                // fastq_qout_ef
+                /* Compute as multiple independent observations
+                   Edgar & Flyvbjerg (2015)
+                   But what about s1 and s2? */
+                // p3 = p1 * p2 / 3.0 / (1.0 - p1 - p2 + (4.0 * p1 * p2 / 3.0));
+
+                /* always worst quality possible, certain error */
+                // p3 = 1.0;
+
+                // always best quality possible, perfect, no errors */
+                // p3 = 0.0;
+
+                int const q3 = convert_probability_to_quality_symbol(p3, parameters);
+                bp->qual[i] = static_cast<char>(q3);
+              }
+          }
+
+        bp->size = static_cast<unsigned int>(s3);
+        ++bp->count;
+      }
+    else
+      {
+        /* no identical sequences yet */
+        bp->size = static_cast<unsigned int>(entry.abundance);
+        bp->hash = entry.hash;
+        bp->seqno_first = static_cast<unsigned int>(entry.seqno);
+        bp->seqno_last = static_cast<unsigned int>(entry.seqno);
+        bp->seq = xstrdup(entry.seq);
+        bp->header = xstrdup(entry.header);
+        bp->count = 1;
+        if (entry.qual != nullptr) {
+          bp->qual = xstrdup(entry.qual);
+        } else {
+          bp->qual = nullptr;
+        }
+        ++table.clusters;
+      }
+  }
+
+
+  /* Threaded dereplication. The input is read in batches of records,
+     copied with room for their normalized forms. The threads normalize
+     and hash the records of a batch, then each thread adds the records
+     of its shard of the hash values to its own table, in input order.
+     Shards are chosen by the smaller of the plus and minus strand
+     hashes, so that a sequence and its reverse complement meet in the
+     same table. As no cluster spans two tables, each table holds
+     exactly the clusters, sizes, qualities and links a serial run would
+     build, and the tables are simply concatenated at the end.
+
+     A batch goes through three steps, overlapped with the next two
+     batches: one thread reads batch k + 1 while the others hash batch k
+     and insert batch k - 1. */
+
+  constexpr auto derep_batch_records = std::size_t{16384};
+  constexpr auto derep_batch_bytes = std::size_t{16} << 20U;
+  constexpr auto no_quality = std::numeric_limits<std::size_t>::max();
+
+  struct derep_record
+  {
+    std::size_t header = 0;  // offsets into the batch text
+    std::size_t headerlen = 0;
+    std::size_t seq = 0;
+    std::size_t qual = no_quality;
+    std::size_t seq_up = 0;  // followed by rc_seq_up
+    int64_t seqlen = 0;
+    int64_t abundance = 1;
+    uint64_t seqno = 0;
+    uint64_t hash = 0;
+    uint64_t rc_hash = 0;
+    unsigned int shard = 0;
+  };
+
+  struct derep_batch
+  {
+    std::vector<char> text;
+    std::vector<struct derep_record> records;
+
+    auto entry(struct derep_record const & record) const -> struct derep_entry {
+      struct derep_entry entry;
+      auto const * base = text.data();
+      entry.header = base + record.header;
+      entry.headerlen = record.headerlen;
+      entry.seq = base + record.seq;
+      entry.qual = (record.qual == no_quality) ? nullptr : base + record.qual;
+      entry.seq_up = base + record.seq_up;
+      entry.rc_seq_up = base + record.seq_up + record.seqlen + 1;
+      entry.seqlen = record.seqlen;
+      entry.abundance = record.abundance;
+      entry.seqno = record.seqno;
+      entry.hash = record.hash;
+      entry.rc_hash = record.rc_hash;
+      return entry;
+    }
+  };
+
+
+  class Derep_pipeline
+  {
+  public:
+    Derep_pipeline(fastx_handle input_handle, std::size_t const threads,
+                   bool const use_header, bool const extra_info,
+                   struct Parameters const & parameters) :
+      input_handle_(input_handle),
+      threads_(threads),
+      use_header_(use_header),
+      extra_info_(extra_info),
+      parameters_(parameters),
+      tables_(threads) {}
+
+    /* read, hash and insert all input; stats and links are updated */
+    auto run(Progress & progress, struct derep_input_stats & stats,
+             struct derep_links & links) -> void {
+      progress_ = &progress;
+      stats_ = &stats;
+      links_ = extra_info_ ? &links : nullptr;
+      ThreadRunner runner(threads_ + 1, [this](uint64_t const t) { step(t); });
+
+      auto next = std::size_t{0};
+      auto more = read_batch(batches_[next]);
+      hashing_ = more ? &batches_[next] : nullptr;
+      inserting_ = nullptr;
+      while ((hashing_ != nullptr) or (inserting_ != nullptr))
+        {
+          /* the links of all sequences read so far */
+          if (links_ != nullptr)
+            {
+              links_->reserve(stats_->sequencecount);
+            }
+          next = (next + 1) % batches_.size();
+          reading_ = more ? &batches_[next] : nullptr;
+          runner.run();
+          more = more and not reading_->records.empty();
+          inserting_ = hashing_;
+          hashing_ = more ? reading_ : nullptr;
+        }
+    }
+
+    /* the tables concatenated, as a single (unordered) table */
+    auto merge() -> struct derep_table {
+      struct derep_table merged;
+      merged.hashtable.clear();
+      for (auto & table : tables_) {
+        merged.clusters += table.clusters;
+        merged.hashtable.insert(merged.hashtable.end(),
+                                table.hashtable.begin(), table.hashtable.end());
+        table.hashtable = std::vector<struct bucket>();
+      }
+      return merged;
+    }
+
+  private:
+    auto step(uint64_t const t) -> void {
+      if (t == threads_)
+        {
+          if (reading_ != nullptr)
+            {
+              read_batch(*reading_);
+            }
+          return;
+        }
+      if (hashing_ != nullptr)
+        {
+          hash_records(*hashing_, t);
+        }
+      if (inserting_ != nullptr)
+        {
+          insert_records(*inserting_, t);
+        }
+    }
+
+    /* copy the next records, stopping at a full batch; false at the end */
+    auto read_batch(struct derep_batch & batch) -> bool {
+      batch.text.clear();
+      batch.records.clear();
+      while ((batch.records.size() < derep_batch_records) and
+             (batch.text.size() < derep_batch_bytes) and
+             fastx_next(input_handle_, not parameters_.opt_notrunclabels, chrmap_no_change()))
+        {
+          auto const seqlen = static_cast<int64_t>(fastx_get_sequence_length(input_handle_));
+          if (not stats_->accept(seqlen, parameters_))
+            {
+              continue;
+            }
+          struct derep_record record;
+          record.seqlen = seqlen;
+          record.abundance = parameters_.opt_sizein ? fastx_get_abundance(input_handle_) : int64_t{1};
+          record.seqno = stats_->sequencecount;
+          stats_->sumsize += record.abundance;
+          ++stats_->sequencecount;
+
+          auto const length = static_cast<std::size_t>(seqlen);
+          record.headerlen = fastx_get_header_length(input_handle_);
+          record.header = append(batch.text, fastx_get_header(input_handle_), record.headerlen);
+          record.seq = append(batch.text, fastx_get_sequence(input_handle_), length);
+          auto const * qual = fastx_get_quality(input_handle_);
+          if (qual != nullptr)
+            {
+              record.qual = append(batch.text, qual, length);
+            }
+          /* room for the normalized sequence and its reverse complement */
+          record.seq_up = batch.text.size();
+          batch.text.resize(batch.text.size() + (2 * (length + 1)));
+          batch.records.push_back(record);
+
+          progress_->update(fastx_get_position(input_handle_));
+        }
+      return not batch.records.empty();
+    }
+
+    static auto append(std::vector<char> & text, char const * chars,
+                       std::size_t const length) -> std::size_t {
+      auto const offset = text.size();
+      text.insert(text.end(), chars, chars + length);
+      text.push_back('\0');
+      return offset;
+    }
+
+    auto hash_records(struct derep_batch & batch, uint64_t const t) const -> void {
+      auto const count = batch.records.size();
+      auto const first = count * t / threads_;
+      auto const last = count * (t + 1) / threads_;
+      for (auto i = first; i < last; ++i)
+        {
+          auto & record = batch.records[i];
+          auto * seq_up = batch.text.data() + record.seq_up;
+          auto * rc_seq_up = seq_up + record.seqlen + 1;
+          string_normalize(seq_up, batch.text.data() + record.seq,
+                           static_cast<unsigned int>(record.seqlen));
+          if (parameters_.opt_strand)
+            {
+              reverse_complement(rc_seq_up, seq_up, record.seqlen);
+            }
+          auto entry = batch.entry(record);
+          hash_entry(entry, use_header_, parameters_);
+          record.hash = entry.hash;
+          record.rc_hash = entry.rc_hash;
+          auto const key = parameters_.opt_strand ? std::min(entry.hash, entry.rc_hash) : entry.hash;
+          record.shard = static_cast<unsigned int>(((key >> 32U) * threads_) >> 32U);
+        }
+    }
+
+    auto insert_records(struct derep_batch const & batch, uint64_t const t) -> void {
+      for (auto const & record : batch.records)
+        {
+          if (record.shard == t)
+            {
+              derep_insert(tables_[t], batch.entry(record), links_, use_header_, parameters_);
+            }
+        }
+    }
+
+    fastx_handle input_handle_;
+    std::size_t threads_;
+    bool use_header_;
+    bool extra_info_;
+    struct Parameters const & parameters_;
+    std::vector<struct derep_table> tables_;
+    std::array<struct derep_batch, 3> batches_;
+    struct derep_batch * reading_ = nullptr;
+    struct derep_batch * hashing_ = nullptr;
+    struct derep_batch * inserting_ = nullptr;
+    Progress * progress_ = nullptr;
+    struct derep_input_stats * stats_ = nullptr;
+    struct derep_links * links_ = nullptr;
+  };
+
 }  // end of anonymous namespace
 
 
@@ -310,20 +785,20 @@ auto derep(struct Parameters const & parameters, char * input_filename, Derep_mo
 
   if (mode == Derep_mode::uniques)
     {
-      fastaout_handle = open_optional_output_file(parameters.opt_fastaout, OutputOption{"--fastaout"});
+      fastaout_handle = compress_output(open_optional_output_file(parameters.opt_fastaout, OutputOption{"--fastaout"}), parameters);
       fp_fastaout = fastaout_handle.get();
-      fastqout_handle = open_optional_output_file(parameters.opt_fastqout, OutputOption{"--fastqout"});
+      fastqout_handle = compress_output(open_optional_output_file(parameters.opt_fastqout, OutputOption{"--fastqout"}), parameters);
       fp_fastqout = fastqout_handle.get();
       tabbedout_handle = open_optional_output_file(parameters.opt_tabbedout, OutputOption{"--tabbedout"});
       fp_tabbedout = tabbedout_handle.get();
     }
   else
     {
-      fastaout_handle = open_optional_output_file(parameters.opt_output, OutputOption{"--output"});
+      fastaout_handle = compress_output(open_optional_output_file(parameters.opt_output, OutputOption{"--output"}), parameters);
       fp_fastaout = fastaout_handle.get();
     }
 
-  uc_handle = open_optional_output_file(parameters.opt_uc, OutputOption{"--uc"});
+  uc_handle = compress_output(open_optional_output_file(parameters.opt_uc, OutputOption{"--uc"}), parameters);
   fp_uc = uc_handle.get();
 
   auto const filesize = fastx_get_size(input_handle);
@@ -332,20 +807,11 @@ auto derep(struct Parameters const & parameters, char * input_filename, Derep_mo
   /* allocate initial memory for 1024 clusters
      with sequences of length 1023 */
 
-  uint64_t alloc_clusters = 1024;
-  uint64_t alloc_seqs = 1024;
-  int64_t alloc_seqlen = 1023;
-
-  uint64_t hashtablesize = 2 * alloc_clusters;
-  uint64_t hash_mask = hashtablesize - 1;
-  std::vector<struct bucket> hashtable(hashtablesize);
+  struct derep_table table;
 
   // memory-intensive: the hash table has been allocated
 
-  constexpr auto terminal = std::numeric_limits<unsigned int>::max();
-  std::vector<unsigned int> nextseqtab;
-  std::vector<std::string> headertab;
-  std::vector<char> match_strand;
+  struct derep_links links;
 
   auto const extra_info = (parameters.opt_uc != nullptr) or (parameters.opt_tabbedout != nullptr);
 
@@ -353,266 +819,109 @@ auto derep(struct Parameters const & parameters, char * input_filename, Derep_mo
     {
       /* If the uc or tabbedout option is in effect,
          we need to keep some extra info.
-         Allocate and init memory for this. */
-
-      /* Links to other sequences in cluster */
-      nextseqtab.resize(alloc_seqs, terminal);
-
-      /* Pointers to the header strings */
-      headertab.resize(alloc_seqs);
-
-      /* Matching strand */
-      match_strand.resize(alloc_seqs);
+         Allocate and init memory for this:
+         links to other sequences in cluster,
+         the header strings and the matching strand. */
+      links.reserve(1024);
     }
 
-  // memory-intensive: per-sequence buffers have been allocated
-
-  std::vector<char> seq_up(static_cast<std::size_t>(alloc_seqlen) + 1);
-  std::vector<char> rc_seq_up(static_cast<std::size_t>(alloc_seqlen) + 1);
   std::string const prompt = std::string("Dereplicating file ") + input_filename;
 
-
-  uint64_t sequencecount = 0;
-  uint64_t nucleotidecount = 0;
-  auto shortest = std::numeric_limits<int64_t>::max();
-  int64_t longest = 0;
-  uint64_t discarded_short = 0;
-  uint64_t discarded_long = 0;
-  uint64_t clusters = 0;
-  int64_t sumsize = 0;
+  struct derep_input_stats stats;
   uint64_t maxsize = 0;
   auto average = 0.0;
 
-  {
-    Progress progress(prompt.c_str(), filesize, parameters);
-    while (fastx_next(input_handle, not parameters.opt_notrunclabels, chrmap_no_change()))
-      {
-        int64_t const seqlen = static_cast<int64_t>(fastx_get_sequence_length(input_handle));
-
-        if (seqlen < parameters.opt_minseqlength)
-          {
-            ++discarded_short;
-            continue;
-          }
-
-        if (seqlen > parameters.opt_maxseqlength)
-          {
-            ++discarded_long;
-            continue;
-          }
-
-        nucleotidecount += static_cast<uint64_t>(seqlen);
-        longest = std::max(seqlen, longest);
-        shortest = std::min(seqlen, shortest);
-
-        /* check allocations */
-
-        if (seqlen > alloc_seqlen)
-          {
-            alloc_seqlen = seqlen;
-            seq_up.resize(static_cast<std::size_t>(alloc_seqlen) + 1);
-            rc_seq_up.resize(static_cast<std::size_t>(alloc_seqlen) + 1);
-
-            // memory-intensive: sequence buffers grown to fit the longest sequence
-          }
-
-        if (extra_info and (sequencecount + 1 > alloc_seqs))
-          {
-            uint64_t const new_alloc_seqs = 2 * alloc_seqs;
-
-            nextseqtab.resize(new_alloc_seqs, terminal);
-
-            headertab.resize(new_alloc_seqs);
-
-            match_strand.resize(new_alloc_seqs);
-
-            alloc_seqs = new_alloc_seqs;
-
-            // memory-intensive: per-sequence buffers have been grown
-          }
-
-        if (clusters + 1 > alloc_clusters)
-          {
-            uint64_t const new_alloc_clusters = 2 * alloc_clusters;
-
-            rehash(hashtable);
-
-            alloc_clusters = new_alloc_clusters;
-            hashtablesize = 2 * alloc_clusters;
-            hash_mask = hashtablesize - 1;
-
-            // memory-intensive: the hash table has been resized (rehash)
-          }
-
-        auto const * seq = fastx_get_sequence(input_handle);
-        auto const * header = fastx_get_header(input_handle);
-        auto const headerlen = fastx_get_header_length(input_handle);
-        auto const * qual = fastx_get_quality(input_handle); // nullptr if FASTA
-
-        /* normalize sequence: uppercase and replace U by T  */
-        string_normalize(seq_up.data(), seq, static_cast<unsigned int>(seqlen));
+  if (parameters.opt_threads > 1)
+    {
+      Progress progress(prompt.c_str(), filesize, parameters);
+      Derep_pipeline pipeline(input_handle, static_cast<std::size_t>(parameters.opt_threads),
+                              use_header, extra_info, parameters);
+      pipeline.run(progress, stats, links);
+      table = pipeline.merge();
+    }
+  else
+    {
+      int64_t alloc_seqlen = 1023;
+      std::vector<char> seq_up(static_cast<std::size_t>(alloc_seqlen) + 1);
+      std::vector<char> rc_seq_up(static_cast<std::size_t>(alloc_seqlen) + 1);
 
-        /* reverse complement if necessary */
-        if (parameters.opt_strand)
-          {
-            reverse_complement(rc_seq_up.data(), seq_up.data(), seqlen);
-          }
+      // memory-intensive: per-sequence buffers have been allocated
 
-        /*
-          Find free bucket or bucket for identical sequence.
-          Make sure sequences are exactly identical
-          in case of any hash collision.
-          With 64-bit hashes, there is about 50% chance of a
-          collision when the number of sequences is about 5e9.
-        */
+      Progress progress(prompt.c_str(), filesize, parameters);
+      while (fastx_next(input_handle, not parameters.opt_notrunclabels, chrmap_no_change()))
+        {
+          int64_t const seqlen = static_cast<int64_t>(fastx_get_sequence_length(input_handle));
 
-        auto const hash_header = use_header ? hash_function(header, headerlen) : uint64_t{0};
+          if (not stats.accept(seqlen, parameters))
+            {
+              continue;
+            }
 
-        auto const hash = hash_function(seq_up.data(), static_cast<uint64_t>(seqlen)) ^ hash_header;
-        auto j = hash & hash_mask;
-        auto * bp = &hashtable[j];  // refactoring: rename to "cluster"
+          /* check allocations */
 
-        while ((bp->size != 0U) and
-               ((hash != bp->hash) or
-                (seqcmp(seq_up.data(), bp->seq, seqlen) != 0) or
-                (use_header and (std::strcmp(header, bp->header) != 0))))
-          {
-            j = (j + 1) & hash_mask;
-            bp = &hashtable[j];
-          }
+          if (seqlen > alloc_seqlen)
+            {
+              alloc_seqlen = seqlen;
+              seq_up.resize(static_cast<std::size_t>(alloc_seqlen) + 1);
+              rc_seq_up.resize(static_cast<std::size_t>(alloc_seqlen) + 1);
 
-        if (parameters.opt_strand and (bp->size == 0U))
-          {
-            /* no match on plus strand */
-            /* check minus strand as well */
-
-            auto const rc_hash = hash_function(rc_seq_up.data(), static_cast<uint64_t>(seqlen)) ^ hash_header;
-            auto k = rc_hash & hash_mask;
-            auto * rc_bp = &hashtable[k];
-
-            while ((rc_bp->size != 0U)
-                   and
-                   ((rc_hash != rc_bp->hash) or
-                    (seqcmp(rc_seq_up.data(), rc_bp->seq, seqlen) != 0U) or
-                    (use_header and (std::strcmp(header, rc_bp->header) != 0))))
-              {
-                k = (k + 1) & hash_mask;
-                rc_bp = &hashtable[k];
-              }
+              // memory-intensive: sequence buffers grown to fit the longest sequence
+            }
 
-            if (rc_bp->size != 0U)
-              {
-                bp = rc_bp;
-                j = k;
-                if (extra_info)
-                  {
-                    match_strand[sequencecount] = 1;
-                  }
-              }
-          }
+          if (extra_info)
+            {
+              links.reserve(stats.sequencecount + 1);
+            }
 
-        auto const abundance = parameters.opt_sizein ? fastx_get_abundance(input_handle) : int64_t{1};
-        sumsize += abundance;
+          struct derep_entry entry;
+          entry.seq = fastx_get_sequence(input_handle);
+          entry.header = fastx_get_header(input_handle);
+          entry.headerlen = fastx_get_header_length(input_handle);
+          entry.qual = fastx_get_quality(input_handle); // nullptr if FASTA
+          entry.seqlen = seqlen;
+          entry.seqno = stats.sequencecount;
+
+          /* normalize sequence: uppercase and replace U by T  */
+          string_normalize(seq_up.data(), entry.seq, static_cast<unsigned int>(seqlen));
+          entry.seq_up = seq_up.data();
+
+          /* reverse complement if necessary */
+          if (parameters.opt_strand)
+            {
+              reverse_complement(rc_seq_up.data(), seq_up.data(), seqlen);
+              entry.rc_seq_up = rc_seq_up.data();
+            }
 
-        if (bp->size != 0U)
-          {
-            /* at least one identical sequence already */
-            if (extra_info)
-              {
-                unsigned int const last = bp->seqno_last;
-                nextseqtab[last] = static_cast<unsigned int>(sequencecount);
-                bp->seqno_last = static_cast<unsigned int>(sequencecount);
-                headertab[sequencecount] = header;
-              }
+          hash_entry(entry, use_header, parameters);
 
-            int64_t const s1 = bp->size;
-            int64_t const s2 = abundance;
-            int64_t const s3 = s1 + s2;
+          entry.abundance = parameters.opt_sizein ? fastx_get_abundance(input_handle) : int64_t{1};
+          stats.sumsize += entry.abundance;
 
-            if (parameters.opt_fastqout != nullptr)
-              {
-                /* update quality scores */
-                for (int i = 0; i < seqlen; i++)
-                  {
-                    int const q1 = bp->qual[i];
-                    int const q2 = qual[i];
-                    auto const p1 = convert_quality_symbol_to_probability(q1, parameters);
-                    auto const p2 = convert_quality_symbol_to_probability(q2, parameters);
-                    auto p3 = 0.0;
-
-                    /* how to compute the new quality score? */
-
-                    if (parameters.opt_fastq_qout_max)
-                      {
-                        // fastq_qout_max
-                        /* min error prob, highest quality */
-                        p3 = std::min(p1, p2);
-                      }
-                    else
-                      {
-                        // fastq_qout_avg
-                        /* average, as in USEARCH */
-                        p3 = ((p1 * static_cast<double>(s1)) + (p2 * static_cast<double>(s2))) / static_cast<double>(s3);
-                      }
-
-                    // fastq_qout_min
-                    /* max error prob, lowest quality */
-                    // p3 = std::max(p1, p2);
-
-                    // fastq_qout_first
-                    /* keep first */
-                    // p3 = p1;
-
-                    // fastq_qout_last
-                    /* keep last */
-                    // p3 = p2;
-
-                    // fastq_qout_ef
-                    /* Compute as multiple independent observations
-                       Edgar & Flyvbjerg (2015)
-                       But what about s1 and s2? */
-                    // p3 = p1 * p2 / 3.0 / (1.0 - p1 - p2 + (4.0 * p1 * p2 / 3.0));
-
-                    /* always worst quality possible, certain error */
-                    // p3 = 1.0;
-
-                    // always best quality possible, perfect, no errors */
-                    // p3 = 0.0;
-
-                    int const q3 = convert_probability_to_quality_symbol(p3, parameters);
-                    bp->qual[i] = static_cast<char>(q3);
-                  }
-              }
+          derep_insert(table, entry, extra_info ? &links : nullptr, use_header, parameters);
 
-            bp->size = static_cast<unsigned int>(s3);
-            ++bp->count;
-          }
-        else
-          {
-            /* no identical sequences yet */
-            bp->size = static_cast<unsigned int>(abundance);
-            bp->hash = hash;
-            bp->seqno_first = static_cast<unsigned int>(sequencecount);
-            bp->seqno_last = static_cast<unsigned int>(sequencecount);
-            bp->seq = xstrdup(seq);
-            bp->header = xstrdup(header);
-            bp->count = 1;
-            if (qual != nullptr) {
-              bp->qual = xstrdup(qual);
-            } else {
-              bp->qual = nullptr;
-            }
-            ++clusters;
-          }
+          ++stats.sequencecount;
 
-        maxsize = std::max<uint64_t>(bp->size, maxsize);
+          progress.update(fastx_get_position(input_handle));
+        }
+    }
+  fastx_close(input_handle, parameters);
 
-        ++sequencecount;
+  auto const sequencecount = stats.sequencecount;
+  auto const nucleotidecount = stats.nucleotidecount;
+  auto const shortest = stats.shortest;
+  auto const longest = stats.longest;
+  auto const discarded_short = stats.discarded_short;
+  auto const discarded_long = stats.discarded_long;
+  auto const sumsize = stats.sumsize;
+  auto const clusters = table.clusters;
+  auto & hashtable = table.hashtable;
+  auto const & nextseqtab = links.nextseqtab;
+  auto const & headertab = links.headertab;
+  auto const & match_strand = links.match_strand;
 
-        progress.update(fastx_get_position(input_handle));
-      }
+  for (auto const & bucket : hashtable) {
+    maxsize = std::max<uint64_t>(bucket.size, maxsize);
   }
-  fastx_close(input_handle, parameters);
 
   if (not parameters.opt_quiet)
     {
@@ -696,7 +1005,7 @@ auto derep(struct Parameters const & parameters, char * input_filename, Derep_mo
 
   {
     Progress const progress("Sorting", 1, parameters);
-    std::qsort(hashtable.data(), hashtablesize, sizeof(struct bucket), derep_compare_full);
+    std::qsort(hashtable.data(), hashtable.size(), sizeof(struct bucket), derep_compare_full);
   }
 
   auto const median = find_median_size(hashtable, clusters);
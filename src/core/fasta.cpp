@@ -59,13 +59,16 @@
 */
 
 #include "vsearch.h"
+#include "arch/scan_symbols.hpp"
 #include "core/attributes.hpp"
 #include "utils/fatal.hpp"
+#include "utils/output_buffer.hpp"
 #include "utils/sequence_digest.hpp"
 #include <algorithm>  // std::min
 #include <array>
 #include <cassert>  // assert
 #include <cinttypes>  // macros PRIu64 and PRId64
+#include <cstddef>  // std::ptrdiff_t
 #include <cstdint> // int64_t, uint64_t
 #include <cstdio> // std::FILE, std::fprintf, std::size_t, std::snprintf
 #include <cstring>  // std::memchr, std::strlen
@@ -199,10 +202,22 @@ auto fasta_filter_sequence(fastx_handle input_handle,
      errors on certain characters. */
 
   auto * source = input_handle->sequence_buffer.data;
+  auto * const end = std::next(source, static_cast<std::ptrdiff_t>(input_handle->sequence_buffer.length));
   auto * dest = source;
 
   while (*source != '\0')
     {
+      /* copy the run of nucleotide symbols up to the next character
+         that needs the rules below (usually the end of the line) */
+      auto const run_length = count_nucleotide_symbols(source, static_cast<std::size_t>(end - source));
+      copy_nucleotide_run(dest, source, run_length, char_mapping);
+      source = std::next(source, static_cast<std::ptrdiff_t>(run_length));
+      dest = std::next(dest, static_cast<std::ptrdiff_t>(run_length));
+      if (*source == '\0')
+        {
+          break;
+        }
+
       auto const current_char = static_cast<unsigned char>(*source);
 
       switch (map_action(*source))
@@ -372,6 +387,10 @@ auto fasta_get_abundance_and_presence(struct fastx_s const * input_handle) -> in
 
 auto fasta_get_position(struct fastx_s const * input_handle) -> uint64_t
 {
+  if (input_handle->is_mapped)
+    {
+      return input_handle->file_buffer.position;
+    }
   return input_handle->file_position;
 }
 
@@ -450,6 +469,27 @@ auto fasta_print_sequence(std::FILE * output_handle, char const * seq, uint64_t
 }
 
 
+auto fasta_print_sequence(Output_buffer & output, char const * seq, uint64_t const len, int const width) -> void
+{
+  /* as above */
+
+  if (width < 1)  // no sequence folding
+    {
+      output.append(seq, len);
+      output.append('\n');
+    }
+  else  // sequence folding every 'width'
+    {
+      auto const width_u = static_cast<uint64_t>(width);
+      for (uint64_t i = 0; i < len; i += width_u)
+        {
+          output.append(seq + i, std::min(len - i, width_u));
+          output.append('\n');
+        }
+    }
+}
+
+
 auto fasta_print(std::FILE * output_handle, char const * header,
                  char const * seq, uint64_t const len,
                  struct Parameters const & parameters) -> void
@@ -459,14 +499,14 @@ auto fasta_print(std::FILE * output_handle, char const * header,
 }
 
 
-inline auto fprint_seq_label(std::FILE * output_handle, char const * seq, int const len) -> void
+inline auto fprint_seq_label(Output_buffer & output, char const * seq, int const len) -> void
 {
   /* profile/consensus output (see msa.cc) has no centroid sequence and
      passes seq == nullptr; passing a null pointer to "%s" is undefined
      behaviour even when len is zero, so emit an empty label instead. */
   if (seq == nullptr) { return; }
   /* normalize first? */
-  std::fprintf(output_handle, "%.*s", len, seq);
+  output.append(seq, static_cast<std::size_t>(len));
 }
 
 
@@ -479,27 +519,27 @@ inline auto fprint_seq_label(std::FILE * output_handle, char const * seq, int co
 // fastq equivalent) is the deferred S5 Tier-2 sweep; see CODE_REVIEW.md.
 // Reachable only with a >2 GB single sequence and --maxseqlength raised, and
 // read-only (wrong output, no corruption).
-auto fasta_print_general(std::FILE * output_handle,
-                         char const * prefix,
-                         char const * seq,
-                         int const len,
-                         char const * header,
-                         int const header_length,
-                         uint64_t const abundance,
-                         int64_t const ordinal,
-                         double const expected_error,
-                         int64_t const clustersize,
-                         int const clusterid,
-                         char const * score_name,
-                         double const score,
-                         uint64_t const centroid_size,
-                         struct Parameters const & parameters) -> void
+static auto fasta_print_label(Output_buffer & output,
+                              char const * prefix,
+                              char const * seq,
+                              int const len,
+                              char const * header,
+                              int const header_length,
+                              uint64_t const abundance,
+                              int64_t const ordinal,
+                              double const expected_error,
+                              int64_t const clustersize,
+                              int const clusterid,
+                              char const * score_name,
+                              double const score,
+                              uint64_t const centroid_size,
+                              struct Parameters const & parameters) -> void
 {
-  std::fprintf(output_handle, ">");
+  output.append('>');
 
   if (prefix != nullptr)
     {
-      std::fprintf(output_handle, "%s", prefix);
+      output.append(prefix);
     }
 
   // track whether the text printed so far ends with the annotation
@@ -509,26 +549,27 @@ auto fasta_print_general(std::FILE * output_handle,
 
   if (parameters.opt_relabel_self)
     {
-      fprint_seq_label(output_handle, seq, len);
+      fprint_seq_label(output, seq, len);
     }
   else if (parameters.opt_relabel_sha1)
     {
-      fprint_seq_digest_sha1(output_handle, seq, len);
+      fprint_seq_digest_sha1(output, seq, len);
     }
   else if (parameters.opt_relabel_md5)
     {
-      fprint_seq_digest_md5(output_handle, seq, len);
+      fprint_seq_digest_md5(output, seq, len);
     }
   else if ((parameters.opt_relabel != nullptr) and (ordinal > 0))
     {
-      std::fprintf(output_handle, "%s%" PRId64, parameters.opt_relabel, ordinal);
+      output.append(parameters.opt_relabel);
+      output.append_integer(ordinal);
     }
   else
     {
       bool const strip_size = parameters.opt_xsize or (parameters.opt_sizeout and (abundance > 0));
       bool const strip_ee = parameters.opt_xee or ((parameters.opt_eeout or parameters.opt_fastq_eeout) and (expected_error >= 0.0));
       bool const strip_length = parameters.opt_xlength or parameters.opt_lengthout;
-      trailing_separator = header_fprint_strip(output_handle,
+      trailing_separator = header_fprint_strip(output,
                                                header,
                                                header_length,
                                                strip_size,
@@ -538,7 +579,7 @@ auto fasta_print_general(std::FILE * output_handle,
 
   if (parameters.opt_label_suffix != nullptr)
     {
-      std::fprintf(output_handle, "%s", parameters.opt_label_suffix);
+      output.append(parameters.opt_label_suffix);
       if (*parameters.opt_label_suffix != '\0')
         {
           trailing_separator = (parameters.opt_label_suffix[std::strlen(parameters.opt_label_suffix) - 1] == ';');
@@ -547,73 +588,125 @@ auto fasta_print_general(std::FILE * output_handle,
 
   if (parameters.opt_sample != nullptr)
     {
-      std::fprintf(output_handle, "%ssample=%s", annotation_separator(trailing_separator), parameters.opt_sample);
+      output.appendf("%ssample=%s", annotation_separator(trailing_separator), parameters.opt_sample);
     }
 
   if (clustersize > 0)
     {
-      std::fprintf(output_handle, "%sseqs=%" PRId64, annotation_separator(trailing_separator), clustersize);
+      output.appendf("%sseqs=%" PRId64, annotation_separator(trailing_separator), clustersize);
     }
 
   if (clusterid >= 0)
     {
-      std::fprintf(output_handle, "%sclusterid=%d", annotation_separator(trailing_separator), clusterid);
+      output.appendf("%sclusterid=%d", annotation_separator(trailing_separator), clusterid);
     }
 
   if (parameters.opt_sizeout and (abundance > 0))
     {
-      std::fprintf(output_handle, "%ssize=%" PRIu64, annotation_separator(trailing_separator), abundance);
+      output.append(annotation_separator(trailing_separator));
+      output.append("size=");
+      output.append_unsigned(abundance);
     }
 
   if (parameters.opt_centroid_sizeout and (centroid_size > 0))
     {
-      std::fprintf(output_handle, "%scentroid_size=%" PRIu64, annotation_separator(trailing_separator), centroid_size);
+      output.appendf("%scentroid_size=%" PRIu64, annotation_separator(trailing_separator), centroid_size);
     }
 
   if ((parameters.opt_eeout or parameters.opt_fastq_eeout) and (expected_error >= 0.0))
     {
       auto const * separator = annotation_separator(trailing_separator);
       if (expected_error < 0.000000001) {
-        std::fprintf(output_handle, "%see=%.13lf", separator, expected_error);
+        output.appendf("%see=%.13lf", separator, expected_error);
       } else if (expected_error < 0.00000001) {
-        std::fprintf(output_handle, "%see=%.12lf", separator, expected_error);
+        output.appendf("%see=%.12lf", separator, expected_error);
       } else if (expected_error < 0.0000001) {
-        std::fprintf(output_handle, "%see=%.11lf", separator, expected_error);
+        output.appendf("%see=%.11lf", separator, expected_error);
       } else if (expected_error < 0.000001) {
-        std::fprintf(output_handle, "%see=%.10lf", separator, expected_error);
+        output.appendf("%see=%.10lf", separator, expected_error);
       } else if (expected_error < 0.00001) {
-        std::fprintf(output_handle, "%see=%.9lf", separator, expected_error);
+        output.appendf("%see=%.9lf", separator, expected_error);
       } else if (expected_error < 0.0001) {
-        std::fprintf(output_handle, "%see=%.8lf", separator, expected_error);
+        output.appendf("%see=%.8lf", separator, expected_error);
       } else if (expected_error < 0.001) {
-        std::fprintf(output_handle, "%see=%.7lf", separator, expected_error);
+        output.appendf("%see=%.7lf", separator, expected_error);
       } else if (expected_error < 0.01) {
-        std::fprintf(output_handle, "%see=%.6lf", separator, expected_error);
+        output.appendf("%see=%.6lf", separator, expected_error);
       } else if (expected_error < 0.1) {
-        std::fprintf(output_handle, "%see=%.5lf", separator, expected_error);
+        output.appendf("%see=%.5lf", separator, expected_error);
       } else {
-        std::fprintf(output_handle, "%see=%.4lf", separator, expected_error);
+        output.appendf("%see=%.4lf", separator, expected_error);
       }
     }
 
   if (parameters.opt_lengthout)
     {
-      std::fprintf(output_handle, "%slength=%d", annotation_separator(trailing_separator), len);
+      output.appendf("%slength=%d", annotation_separator(trailing_separator), len);
     }
 
   if (score_name != nullptr)
     {
-      std::fprintf(output_handle, "%s%s=%.4lf", annotation_separator(trailing_separator), score_name, score);
+      output.appendf("%s%s=%.4lf", annotation_separator(trailing_separator), score_name, score);
     }
 
   if (parameters.opt_relabel_keep and
       (((parameters.opt_relabel != nullptr) and (ordinal > 0)) or parameters.opt_relabel_sha1 or parameters.opt_relabel_md5 or parameters.opt_relabel_self))
     {
-      std::fprintf(output_handle, " %s", header);
+      output.appendf(" %s", header);
     }
 
-  std::fprintf(output_handle, "\n");
+  output.append('\n');
+}
+
 
+auto fasta_print_general(Output_buffer & output,
+                         char const * prefix,
+                         char const * seq,
+                         int const len,
+                         char const * header,
+                         int const header_length,
+                         uint64_t const abundance,
+                         int64_t const ordinal,
+                         double const expected_error,
+                         int64_t const clustersize,
+                         int const clusterid,
+                         char const * score_name,
+                         double const score,
+                         uint64_t const centroid_size,
+                         struct Parameters const & parameters) -> void
+{
+  fasta_print_label(output, prefix, seq, len, header, header_length,
+                    abundance, ordinal, expected_error, clustersize,
+                    clusterid, score_name, score, centroid_size, parameters);
+  if (seq != nullptr)
+    {
+      fasta_print_sequence(output, seq, static_cast<uint64_t>(len), static_cast<int>(parameters.opt_fasta_width));
+    }
+}
+
+
+auto fasta_print_general(std::FILE * output_handle,
+                         char const * prefix,
+                         char const * seq,
+                         int const len,
+                         char const * header,
+                         int const header_length,
+                         uint64_t const abundance,
+                         int64_t const ordinal,
+                         double const expected_error,
+                         int64_t const clustersize,
+                         int const clusterid,
+                         char const * score_name,
+                         double const score,
+                         uint64_t const centroid_size,
+                         struct Parameters const & parameters) -> void
+{
+  /* the sequence, possibly very long, is written without a copy */
+  Output_buffer output;
+  fasta_print_label(output, prefix, seq, len, header, header_length,
+                    abundance, ordinal, expected_error, clustersize,
+                    clusterid, score_name, score, centroid_size, parameters);
+  output.write(output_handle);
   if (seq != nullptr)
     {
       fasta_print_sequence(output_handle, seq, static_cast<uint64_t>(len), static_cast<int>(parameters.opt_fasta_width));
@@ -60,6 +60,7 @@
 
 #pragma once
 
+#include "utils/output_buffer.hpp"
 #include <cstdio>  // std::FILE
 #include <cstdint>  // uint64_t
 
@@ -110,6 +111,22 @@ auto fasta_print_general(std::FILE * output_handle,
                          uint64_t centroid_size,
                          struct Parameters const & parameters) -> void;
 
+auto fasta_print_general(Output_buffer & output,
+                         char const * prefix,
+                         char const * seq,
+                         int len,
+                         char const * header,
+                         int header_length,
+                         uint64_t abundance,
+                         int64_t ordinal,
+                         double expected_error,
+                         int64_t clustersize,
+                         int clusterid,
+                         char const * score_name,
+                         double score,
+                         uint64_t centroid_size,
+                         struct Parameters const & parameters) -> void;
+
 auto fasta_print_db(std::FILE * output_handle,
                     uint64_t seqno,
                     struct Database const & db,
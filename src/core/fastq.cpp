@@ -59,6 +59,7 @@
 */
 
 #include "vsearch.h"
+#include "arch/scan_symbols.hpp"
 #include "core/attributes.hpp"
 #include "utils/fatal.hpp"
 #include "utils/sequence_digest.hpp"
@@ -68,13 +69,16 @@
 #include <cinttypes>  // macros PRIu64 and PRId64
 #include <cstdint> // int64_t, uint64_t
 #include <cstdio>  // std::FILE, std::fprintf, std::snprintf, std::size_t
-#include <cstring>  // std::memcmp, std::memchr, std::strlen
+#include <cstring>  // std::memcmp, std::memchr, std::memcpy, std::strlen
 #include <vector>
 
 
 // anonymous namespace: limit visibility and usage to this translation unit
 namespace {
 
+  // count_nucleotide_symbols or count_quality_symbols (arch/scan_symbols.hpp)
+  using Symbol_scanner = auto (*)(char const * symbols, std::size_t length) -> std::size_t;
+
   // refactoring: eliminate and replace with an overload of buffer_filter_extend()?
   const std::vector<unsigned char> chrmap_identity = {
     /* identity map: does nothing */
@@ -244,6 +248,7 @@ auto buffer_filter_extend(fastx_handle input_handle,
                           char const * source_buf,
                           uint64_t const len,
                           unsigned int const * char_action,
+                          Symbol_scanner const count_legal_symbols,
                           unsigned char const * char_mapping,
                           bool * ok,
                           char * illegal_char) -> void
@@ -254,12 +259,31 @@ auto buffer_filter_extend(fastx_handle input_handle,
      errors on certain characters. */
 
   auto const * p = source_buf;
+  auto const * const end = source_buf + len;
   auto * d = dest_buffer->data + dest_buffer->length;
   auto * q = d;
   *ok = true;
 
-  for (auto i = 0ULL; i < len; i++)
+  while (p != end)
     {
+      /* copy the run of legal characters up to the next character that
+         needs the rules below (usually the end of the line) */
+      auto const run_length = count_legal_symbols(p, static_cast<std::size_t>(end - p));
+      if (char_mapping == chrmap_identity.data())
+        {
+          std::memcpy(q, p, run_length);
+        }
+      else
+        {
+          copy_nucleotide_run(q, p, run_length, char_mapping);
+        }
+      p += run_length;
+      q += run_length;
+      if (p == end)
+        {
+          break;
+        }
+
       auto const c = *p++;
       char const m = static_cast<char>(char_action[static_cast<unsigned char>(c)]);
 
@@ -411,7 +435,8 @@ auto fastq_next(fastx_handle input_handle,
                            &input_handle->sequence_buffer,
                            fragment.view.data(),
                            fragment.view.size(),
-                           char_fq_action_seq.data(), char_mapping,
+                           char_fq_action_seq.data(), count_nucleotide_symbols,
+                           char_mapping,
                            &ok, &illegal_char);
       consume_fragment(input_handle, fragment);
       if (fragment.has_newline)
@@ -529,7 +554,8 @@ auto fastq_next(fastx_handle input_handle,
                            &input_handle->quality_buffer,
                            fragment.view.data(),
                            fragment.view.size(),
-                           char_fq_action_qual.data(), chrmap_identity.data(),
+                           char_fq_action_qual.data(), count_quality_symbols,
+                           chrmap_identity.data(),
                            &ok, &illegal_char);
       consume_fragment(input_handle, fragment);
       if (fragment.has_newline)
@@ -595,6 +621,10 @@ auto fastq_get_quality_length(fastx_handle input_handle) -> uint64_t
 
 auto fastq_get_position(struct fastx_s const * input_handle) -> uint64_t
 {
+  if (input_handle->is_mapped)
+    {
+      return input_handle->file_buffer.position;
+    }
   return input_handle->file_position;
 }
 
@@ -59,22 +59,26 @@
 */
 
 #include "vsearch.h"
+#include "core/block_decompress.hpp"
 #include "os/dynlibs.hpp"
 #include "utils/fatal.hpp"
 #include "utils/logfile.hpp"  // log_file::handle
+#include "utils/maps.hpp"  // chrmap_no_change, chrmap_upcase
 #include "utils/open_file.hpp"  // open_input_file
 #include "utils/span.hpp"
 #include <unistd.h>  // dup, STDOUT_FILENO
-#include <algorithm>  // std::find_first_of
+#include <algorithm>  // std::count, std::find_first_of, std::max
 #include <array>
 #include <cassert>  // assert
 #include <cinttypes>  // macros PRIu64 and PRId64
+#include <cstddef>  // std::ptrdiff_t
 #include <cstdint>  // int64_t, uint64_t
 #include <cstdio>  // std::FILE, std::fprintf, std::fclose, std::size_t, std::fread, std::fileno
 #include <cstdlib>  // std::exit, EXIT_FAILURE
-#include <cstring>  // std::memcpy, std::memcmp, std::strcmp
-#include <iterator> // std::distance
+#include <cstring>  // std::memchr, std::memcpy, std::memcmp, std::memmove, std::strcmp
+#include <iterator> // std::distance, std::next
 #include <limits>  // std::numeric_limits
+#include <memory>  // std::unique_ptr
 #include <vector>
 
 
@@ -82,6 +86,7 @@
 /* basic file buffering function for fastq and fastx parsers */
 
 constexpr uint64_t fastx_buffer_alloc = 8192;
+constexpr int64_t max_decompress_threads = 4;
 
 #ifdef HAVE_BZLIB_H
 constexpr auto BZ_VERBOSE_0 = 0;
@@ -149,6 +154,36 @@ auto buffer_extend(struct fastx_buffer_s * dest_buffer,
 }
 
 
+auto copy_nucleotide_run(char * dest,
+                         char const * source,
+                         std::size_t const length,
+                         unsigned char const * char_mapping) -> void
+{
+  /* the two maps used by most commands need no table lookup: nucleotide
+     symbols are letters, left as they are or upcased by clearing the
+     lowercase bit (a loop the compiler vectorizes) */
+  static constexpr auto lowercase_bit = 0x20U;
+  if (char_mapping == chrmap_no_change())
+    {
+      std::memmove(dest, source, length);
+    }
+  else if (char_mapping == chrmap_upcase())
+    {
+      for (auto i = std::size_t{0}; i < length; ++i)
+        {
+          dest[i] = static_cast<char>(static_cast<unsigned char>(source[i]) & ~lowercase_bit);
+        }
+    }
+  else
+    {
+      for (auto i = std::size_t{0}; i < length; ++i)
+        {
+          dest[i] = static_cast<char>(char_mapping[static_cast<unsigned char>(source[i])]);
+        }
+    }
+}
+
+
 auto find_header_end_first_blank(Span<char> raw_header) -> std::size_t {
   static const std::vector<char> blanks {' ', '\t', '\0', '\r', '\n'};
   auto * result = std::find_first_of(raw_header.begin(), raw_header.end(),
@@ -371,7 +406,31 @@ auto fastx_open(char const * filename, struct Parameters const & parameters) ->
         }
     }
 
-  if (input_handle->format == Format::gzip)
+  /* multithreaded commands decode block-compressed files (bgzip,
+     pbzip2) on a few extra threads */
+
+  if (((input_handle->format == Format::gzip) or (input_handle->format == Format::bzip))
+      and not input_handle->is_pipe and (parameters.opt_threads > 1))
+    {
+      auto const thread_count = static_cast<unsigned int>(std::min(parameters.opt_threads,
+                                                                   max_decompress_threads));
+      input_handle->decompressor = Block_decompressor::open(input_handle->fp,
+                                                            input_handle->format,
+                                                            input_handle->libraries,
+                                                            thread_count).release();
+      if (input_handle->decompressor == nullptr)
+        {
+          /* reopen to rewind, as above */
+          std::fclose(input_handle->fp);
+          input_handle->fp = open_input_file(filename).release();
+          if (input_handle->fp == nullptr)
+            {
+              fatal("Unable to open file for reading (%s)", filename);
+            }
+        }
+    }
+
+  if ((input_handle->format == Format::gzip) and (input_handle->decompressor == nullptr))
     {
       /* GZIP: Keep original file open, then open as gzipped file as well */
 #ifdef HAVE_ZLIB_H
@@ -389,7 +448,7 @@ auto fastx_open(char const * filename, struct Parameters const & parameters) ->
 #endif
     }
 
-  if (input_handle->format == Format::bzip)
+  if ((input_handle->format == Format::bzip) and (input_handle->decompressor == nullptr))
     {
       /* BZIP2: Keep original file open, then open as bzipped file as well */
 #ifdef HAVE_BZLIB_H
@@ -413,7 +472,25 @@ auto fastx_open(char const * filename, struct Parameters const & parameters) ->
 
   input_handle->file_position = 0;
 
-  buffer_init(& input_handle->file_buffer);
+  void * mapping = nullptr;
+  if ((input_handle->format == Format::plain) and not input_handle->is_pipe
+      and not is_stdin and (input_handle->file_size > 0))
+    {
+      mapping = xmmap_sequential(fileno(input_handle->fp), input_handle->file_size);
+    }
+
+  if (mapping != nullptr)
+    {
+      input_handle->is_mapped = true;
+      input_handle->file_buffer.data = static_cast<char *>(mapping);
+      input_handle->file_buffer.alloc = input_handle->file_size;
+      input_handle->file_buffer.length = input_handle->file_size;
+      input_handle->file_buffer.position = 0;
+    }
+  else
+    {
+      buffer_init(& input_handle->file_buffer);
+    }
 
   /* start filling up file buffer */
 
@@ -445,6 +522,9 @@ auto fastx_open(char const * filename, struct Parameters const & parameters) ->
         {
           /* close files if unrecognized file type */
 
+          delete input_handle->decompressor;
+          input_handle->decompressor = nullptr;
+
           switch (input_handle->format)
             {
             case Format::plain:
@@ -452,7 +532,10 @@ auto fastx_open(char const * filename, struct Parameters const & parameters) ->
 
             case Format::gzip:
 #ifdef HAVE_ZLIB_H
-              input_handle->libraries->gzclose(input_handle->fp_gz);
+              if (input_handle->fp_gz != nullptr)
+                {
+                  input_handle->libraries->gzclose(input_handle->fp_gz);
+                }
               input_handle->fp_gz = nullptr;
               break;
 #endif
@@ -518,6 +601,110 @@ auto fastx_is_empty(struct fastx_s const * input_handle) -> bool
 }
 
 
+auto fastx_split(struct fastx_s const * input_handle, unsigned int const count) -> std::vector<uint64_t>
+{
+  std::vector<uint64_t> offsets;
+  if ((not input_handle->is_mapped) or input_handle->is_fastq or (count < 2))
+    {
+      return offsets;
+    }
+
+  auto const * const data = input_handle->file_buffer.data;
+  auto const begin = input_handle->file_buffer.position;
+  auto const end = input_handle->file_buffer.length;
+  auto const step = (end - begin) / count;
+
+  offsets.push_back(begin);
+  for (auto i = 1U; i < count; ++i)
+    {
+      /* the first line starting with '>' after the even cut point */
+      auto position = std::max(begin + (i * step), offsets.back() + 1) - 1;
+      auto found = false;
+      while (not found)
+        {
+          auto const * const line_end = static_cast<char const *>(
+            std::memchr(std::next(data, static_cast<std::ptrdiff_t>(position)), '\n', end - position));
+          if (line_end == nullptr)
+            {
+              break;
+            }
+          position = static_cast<uint64_t>(std::distance(data, line_end)) + 1;
+          found = (position < end) and (data[position] == '>');
+        }
+      if (not found)
+        {
+          break;
+        }
+      offsets.push_back(position);
+    }
+  offsets.push_back(end);
+  return offsets;
+}
+
+
+auto fastx_count_lines(struct fastx_s const * input_handle,
+                       uint64_t const begin,
+                       uint64_t const end) -> uint64_t
+{
+  auto const * const data = input_handle->file_buffer.data;
+  return static_cast<uint64_t>(std::count(std::next(data, static_cast<std::ptrdiff_t>(begin)),
+                                          std::next(data, static_cast<std::ptrdiff_t>(end)),
+                                          '\n'));
+}
+
+
+auto fastx_open_shard(struct fastx_s const * input_handle,
+                      uint64_t const begin,
+                      uint64_t const end,
+                      uint64_t const first_line) -> fastx_handle
+{
+  assert(input_handle->is_mapped);
+  auto * shard = new fastx_s;
+  shard->libraries = input_handle->libraries;
+  shard->format = Format::plain;
+  shard->is_fastq = input_handle->is_fastq;
+  shard->is_empty = (begin == end);
+
+  /* a view on part of the input mapping, not unmapped by this handle */
+  shard->is_mapped = true;
+  shard->file_buffer.data = std::next(input_handle->file_buffer.data,
+                                      static_cast<std::ptrdiff_t>(begin));
+  shard->file_buffer.alloc = end - begin;
+  shard->file_buffer.length = end - begin;
+  shard->file_buffer.position = 0;
+  shard->file_size = end - begin;
+
+  buffer_init(& shard->header_buffer);
+  buffer_init(& shard->sequence_buffer);
+  buffer_init(& shard->plusline_buffer);
+  buffer_init(& shard->quality_buffer);
+
+  shard->lineno = first_line;
+  shard->lineno_start = first_line;
+  shard->seqno = -1;
+
+  /* shards are read on worker threads */
+  shard->defer_errors = true;
+  return shard;
+}
+
+
+auto fastx_close_shard(fastx_handle shard, fastx_handle input_handle) -> void
+{
+  input_handle->stripped_all += shard->stripped_all;
+  for (auto i = 0U; i < byte_range; ++i)
+    {
+      input_handle->stripped[i] += shard->stripped[i];
+    }
+
+  buffer_free(& shard->header_buffer);
+  buffer_free(& shard->sequence_buffer);
+  buffer_free(& shard->plusline_buffer);
+  buffer_free(& shard->quality_buffer);
+  delete shard;
+}
+
+
 auto fastx_is_pipe(struct fastx_s const * input_handle) -> bool
 {
   return input_handle->is_pipe;
@@ -560,6 +747,9 @@ auto fastx_close(fastx_handle input_handle, struct Parameters const & parameters
   int bz_error = 0;
 #endif
 
+  delete input_handle->decompressor;
+  input_handle->decompressor = nullptr;
+
   switch (input_handle->format)
     {
     case Format::plain:
@@ -567,7 +757,10 @@ auto fastx_close(fastx_handle input_handle, struct Parameters const & parameters
 
     case Format::gzip:
 #ifdef HAVE_ZLIB_H
-      input_handle->libraries->gzclose(input_handle->fp_gz);
+      if (input_handle->fp_gz != nullptr)
+        {
+          input_handle->libraries->gzclose(input_handle->fp_gz);
+        }
       input_handle->fp_gz = nullptr;
       break;
 #endif
@@ -586,6 +779,12 @@ auto fastx_close(fastx_handle input_handle, struct Parameters const & parameters
   std::fclose(input_handle->fp);
   input_handle->fp = nullptr;
 
+  if (input_handle->is_mapped)
+    {
+      xmunmap(input_handle->file_buffer.data, input_handle->file_buffer.alloc);
+      input_handle->file_buffer.data = nullptr;
+      input_handle->is_mapped = false;
+    }
   buffer_free(& input_handle->file_buffer);
   buffer_free(& input_handle->header_buffer);
   buffer_free(& input_handle->sequence_buffer);
@@ -602,6 +801,81 @@ auto fastx_close(fastx_handle input_handle, struct Parameters const & parameters
 }
 
 
+#ifdef HAVE_BZLIB_H
+// Move on to the next bzip2 stream of a file made of several (pbzip2,
+// concatenated files); false at the end of the input. Trailing bytes that
+// do not start a stream are ignored, as by bzip2.
+auto bzip2_next_stream(fastx_handle input_handle) -> bool
+{
+  int bz_error = 0;
+  void * unused = nullptr;
+  int unused_length = 0;
+  input_handle->libraries->bz_read_get_unused(& bz_error, input_handle->fp_bz,
+                                              & unused, & unused_length);
+  auto * const unused_bytes = static_cast<char *>(unused);
+  std::vector<char> leftover(unused_bytes, std::next(unused_bytes, unused_length));
+  input_handle->libraries->bz_read_close(& bz_error, input_handle->fp_bz);
+  input_handle->fp_bz = nullptr;
+
+  while (leftover.size() < magic_bzip.size())
+    {
+      auto const next_byte = std::getc(input_handle->fp);
+      if (next_byte == EOF)
+        {
+          break;
+        }
+      leftover.push_back(static_cast<char>(next_byte));
+    }
+  if ((leftover.size() < magic_bzip.size())
+      or (std::memcmp(leftover.data(), magic_bzip.data(), magic_bzip.size()) != 0))
+    {
+      return false;
+    }
+
+  input_handle->fp_bz = input_handle->libraries->bz_read_open(& bz_error, input_handle->fp,
+                                                              BZ_VERBOSE_0, BZ_MORE_MEM,
+                                                              leftover.data(),
+                                                              static_cast<int>(leftover.size()));
+  if (input_handle->fp_bz == nullptr)
+    {
+      fatal("Unable to read from bzip2 compressed file");
+    }
+  input_handle->bz_stream_end = false;
+  return true;
+}
+
+
+auto bzip2_read(fastx_handle input_handle, char * destination, uint64_t space) -> int
+{
+  while (true)
+    {
+      if (input_handle->bz_stream_end and not bzip2_next_stream(input_handle))
+        {
+          return 0;
+        }
+
+      int bzError = 0;
+      auto const bytes_read = input_handle->libraries->bz_read(& bzError,
+                                                               input_handle->fp_bz,
+                                                               destination,
+                                                               static_cast<int>(space));
+      if ((bytes_read < 0) or
+          not ((bzError == BZ_OK) or
+               (bzError == BZ_STREAM_END) or
+               (bzError == BZ_SEQUENCE_ERROR)))
+        {
+          fatal("Unable to read from bzip2 compressed file");
+        }
+      input_handle->bz_stream_end = (bzError == BZ_STREAM_END);
+      if ((bytes_read > 0) or not input_handle->bz_stream_end)
+        {
+          return bytes_read;
+        }
+    }
+}
+#endif
+
+
 auto fastx_file_fill_buffer(fastx_handle input_handle) -> uint64_t
 {
   /* read more data if necessary */
@@ -612,6 +886,12 @@ auto fastx_file_fill_buffer(fastx_handle input_handle) -> uint64_t
       return rest;
     }
 
+  if (input_handle->is_mapped)
+    {
+      /* the whole file is in the buffer */
+      return 0;
+    }
+
   uint64_t space = input_handle->file_buffer.alloc - input_handle->file_buffer.length;
 
   if (space == 0)
@@ -622,11 +902,23 @@ auto fastx_file_fill_buffer(fastx_handle input_handle) -> uint64_t
       space = input_handle->file_buffer.alloc;
     }
 
-  int bytes_read = 0;
+  if (input_handle->decompressor != nullptr)
+    {
+      auto const decoded = input_handle->decompressor->read(input_handle->file_buffer.data
+                                                            + input_handle->file_buffer.position,
+                                                            space);
+      if (input_handle->decompressor->failed())
+        {
+          fatal((input_handle->format == Format::gzip)
+                ? "Unable to read gzip compressed file"
+                : "Unable to read from bzip2 compressed file");
+        }
+      input_handle->file_position = input_handle->decompressor->position();
+      input_handle->file_buffer.length += decoded;
+      return decoded;
+    }
 
-#ifdef HAVE_BZLIB_H
-  int bzError = 0;
-#endif
+  int bytes_read = 0;
 
   switch (input_handle->format)
     {
@@ -653,18 +945,10 @@ auto fastx_file_fill_buffer(fastx_handle input_handle) -> uint64_t
 
     case Format::bzip:
 #ifdef HAVE_BZLIB_H
-      bytes_read = input_handle->libraries->bz_read(& bzError,
-                                   input_handle->fp_bz,
-                                   input_handle->file_buffer.data
-                                   + input_handle->file_buffer.position,
-                                   static_cast<int>(space));
-      if ((bytes_read < 0) or
-          not ((bzError == BZ_OK) or
-             (bzError == BZ_STREAM_END) or
-             (bzError == BZ_SEQUENCE_ERROR)))
-        {
-          fatal("Unable to read from bzip2 compressed file");
-        }
+      bytes_read = bzip2_read(input_handle,
+                              input_handle->file_buffer.data
+                              + input_handle->file_buffer.position,
+                              space);
       break;
 #endif
 
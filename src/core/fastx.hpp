@@ -67,6 +67,7 @@
 #include <cstdint>  // uint64_t
 #include <cstring>  // std::memchr
 #include <iterator>  // std::next, std::distance
+#include <vector>
 
 
 constexpr auto byte_range = 256U;
@@ -86,9 +87,18 @@ auto buffer_extend(struct fastx_buffer_s * dest_buffer,
                    uint64_t len) -> void;
 auto buffer_makespace(struct fastx_buffer_s * buffer, uint64_t size) -> void;
 
+// Copy a run of symbols accepted by count_nucleotide_symbols() (see
+// arch/scan_symbols.hpp), applying char_mapping. dest may equal or
+// precede source (in-place filtering).
+auto copy_nucleotide_run(char * dest,
+                         char const * source,
+                         std::size_t length,
+                         unsigned char const * char_mapping) -> void;
+
 enum struct Format : unsigned char { undefined, plain, bzip, gzip };
 
 class DynamicLibraries;  // set from parameters.dyn_libs in fastx_open()
+class Block_decompressor;
 
 struct fastx_s
 {
@@ -108,8 +118,17 @@ struct fastx_s
 
 #ifdef HAVE_BZLIB_H
   BZFILE * fp_bz = nullptr;
+  bool bz_stream_end = false;
 #endif
 
+  /* owned; set instead of fp_gz/fp_bz when the compressed file is made of
+     independent blocks decoded by several threads */
+  Block_decompressor * decompressor = nullptr;
+
+  /* uncompressed regular files are mapped into memory: file_buffer then
+     views the whole mapped file, and no bytes are copied into it (the
+     handles of fastx_open_shard() view part of that mapping) */
+  bool is_mapped = false;
   struct fastx_buffer_s file_buffer;
 
   struct fastx_buffer_s header_buffer;
@@ -159,6 +178,24 @@ auto fastx_close(fastx_handle input_handle, struct Parameters const & parameters
 auto fastx_next(fastx_handle input_handle,
                 bool truncateatspace,
                 const unsigned char * char_mapping) -> bool;
+
+/* Sharded parsing of a mapped FASTA file (see Database::read):
+   fastx_split() cuts the unread part of the file into at most count
+   ranges, each starting at a record ('>' at the start of a line), and
+   returns their boundaries (count + 1 offsets, fewer when records are
+   long; empty when the input is not a mapped FASTA file).
+   fastx_count_lines() counts the line ends in a range. fastx_open_shard()
+   returns a handle reading one range, with deferred errors and line
+   numbers starting at first_line. fastx_close_shard() adds the stripped
+   characters of the shard to the input handle, which reports them when
+   it is closed. */
+auto fastx_split(struct fastx_s const * input_handle, unsigned int count) -> std::vector<uint64_t>;
+auto fastx_count_lines(struct fastx_s const * input_handle, uint64_t begin, uint64_t end) -> uint64_t;
+auto fastx_open_shard(struct fastx_s const * input_handle,
+                      uint64_t begin,
+                      uint64_t end,
+                      uint64_t first_line) -> fastx_handle;
+auto fastx_close_shard(fastx_handle shard, fastx_handle input_handle) -> void;
 auto fastx_get_position(struct fastx_s const * input_handle) -> uint64_t;
 auto fastx_get_size(struct fastx_s const * input_handle) -> uint64_t;
 auto fastx_get_lineno(struct fastx_s const * input_handle) -> uint64_t;
@@ -57,26 +57,36 @@
   POSSIBILITY OF SUCH DAMAGE.
 
 */
-
 #include "core/filter.hpp"
 #include "vsearch.h"
 #include "utils/progress.hpp"
 #include "utils/fatal.hpp"
 #include "utils/maps.hpp"
+#include "core/block_compress.hpp"  // compress_output
 #include "utils/open_file.hpp"
+#include "utils/threads.hpp"
 #include <algorithm>  // std::min, std::max
+#include <array>
 #include <cinttypes>  // macros PRIu64 and PRId64
 #include <cmath>  // std::pow, std::signbit
+#include <cstddef>  // std::size_t
 #include <cstdint>  // int64_t, uint64_t
 #include <cstdio>  // std::FILE, std::fprintf, std::fclose
 #include <cstdlib>  // std::exit, EXIT_FAILURE
 #include <limits>
+#include <vector>
 
 
 inline auto fastq_get_qual(char const quality_symbol, struct Parameters const & parameters) -> int
 {
-  int const quality_score = quality_symbol - static_cast<int>(parameters.opt_fastq_ascii);
+  return quality_symbol - static_cast<int>(parameters.opt_fastq_ascii);
+}
+
 
+/* Report a quality value outside of the qmin..qmax range and exit.
+   Called from the main thread only, once the worker threads are idle. */
+auto report_quality_error(int const quality_score, struct Parameters const & parameters) -> void
+{
   if (quality_score < parameters.opt_fastq_qmin)
     {
       std::fprintf(stderr,
@@ -90,9 +100,8 @@ inline auto fastq_get_qual(char const quality_symbol, struct Parameters const &
                   PRId64 ")\n",
                   quality_score, parameters.opt_fastq_qmin);
         }
-      std::exit(EXIT_FAILURE);
     }
-  else if (quality_score > parameters.opt_fastq_qmax)
+  else
     {
       std::fprintf(stderr,
               "\n\nFatal error: FASTQ quality value (%d) above qmax (%"
@@ -113,9 +122,8 @@ inline auto fastq_get_qual(char const quality_symbol, struct Parameters const &
                   "To allow higher quality values, "
                   "please use the option --fastq_qmax %d\n", quality_score);
         }
-      std::exit(EXIT_FAILURE);
     }
-  return quality_score;
+  std::exit(EXIT_FAILURE);
 }
 
 
@@ -123,18 +131,22 @@ struct analysis_res
 {
   bool discarded = false;
   bool truncated = false;
+  bool bad_quality = false;  // quality_score is out of range
+  int quality_score = 0;
   int start = 0;
   int length = 0;
   double ee = -1.0;
 };
 
 
-auto analyse(fastx_handle input_handle, struct Parameters const & parameters) -> struct analysis_res
+/* quality is nullptr for fasta input */
+auto analyse(char const * sequence, char const * quality, int const sequence_length,
+             int64_t const abundance, struct Parameters const & parameters) -> struct analysis_res
 {
   auto const fastq_trunclen = static_cast<int>(parameters.opt_fastq_trunclen);
   auto const fastq_trunclen_keep = static_cast<int>(parameters.opt_fastq_trunclen_keep);
   struct analysis_res res;
-  res.length = static_cast<int>(fastx_get_sequence_length(input_handle));
+  res.length = sequence_length;
   auto const old_length = res.length;
 
   /* strip left (5') end */
@@ -171,15 +183,22 @@ auto analyse(fastx_handle input_handle, struct Parameters const & parameters) ->
       res.length = std::min(res.length, fastq_trunclen_keep);
     }
 
-  if (input_handle->is_fastq)
+  if (quality != nullptr)
     {
       /* truncate by quality and expected errors (ee) */
       res.ee = 0.0;
       static constexpr auto base = 10.0;
-      auto const * quality_symbols = fastx_get_quality(input_handle) + res.start;
+      auto const * quality_symbols = quality + res.start;
       for (auto i = 0; i < res.length; ++i)
         {
           auto const quality_score = fastq_get_qual(quality_symbols[i], parameters);
+          if ((quality_score < parameters.opt_fastq_qmin) or
+              (quality_score > parameters.opt_fastq_qmax))
+            {
+              res.bad_quality = true;
+              res.quality_score = quality_score;
+              return res;
+            }
           auto const expected_error = std::pow(base, -quality_score / base);
           res.ee += expected_error;
 
@@ -225,7 +244,7 @@ auto analyse(fastx_handle input_handle, struct Parameters const & parameters) ->
 
   /* filter by n's */  // refactoring: std::count_if();
   int64_t ncount = 0;
-  auto const * nucleotides = fastx_get_sequence(input_handle) + res.start;
+  auto const * nucleotides = sequence + res.start;
   for (auto i = 0; i < res.length; ++i)
     {
       auto const nucleotide = nucleotides[i];
@@ -240,7 +259,6 @@ auto analyse(fastx_handle input_handle, struct Parameters const & parameters) ->
     }
 
   /* filter by abundance */
-  auto const abundance = fastx_get_abundance(input_handle);
   if (abundance < parameters.opt_minsize)
     {
       res.discarded = true;
@@ -262,6 +280,319 @@ namespace {
   // defined further below, in the anonymous namespace
   auto check_parameters(struct Parameters const & parameters) -> void;
 
+
+  /* Reads are filtered in batches, in three steps overlapped with the
+     neighbouring batches: one thread reads batch k + 1, the worker
+     threads trim and filter the reads of batch k, and one thread writes
+     batch k - 1. Kept and discarded reads are numbered (--relabel) by
+     the writer, so the output is the same as with a single thread.
+
+     Only the main thread may exit (see mergepairs.cpp): an out-of-range
+     quality value is recorded in the analysis of its read, and the
+     writer stops there, after writing the reads before it. */
+
+  constexpr auto filter_batch_reads = std::size_t{16384};
+  constexpr auto filter_batch_bytes = std::size_t{16} << 20U;
+  constexpr auto no_quality = std::numeric_limits<std::size_t>::max();
+
+  struct filter_read
+  {
+    std::size_t header = 0;  // offsets into the batch text
+    std::size_t headerlen = 0;
+    std::size_t seq = 0;
+    std::size_t qual = no_quality;
+    int length = 0;
+    int64_t abundance = 1;
+    struct analysis_res res;
+  };
+
+  struct filter_batch
+  {
+    std::vector<char> text;
+    std::vector<struct filter_read> forward;
+    std::vector<struct filter_read> reverse;  // empty without --reverse
+  };
+
+  struct filter_outputs
+  {
+    std::FILE * fastaout = nullptr;
+    std::FILE * fastqout = nullptr;
+    std::FILE * fastaout_discarded = nullptr;
+    std::FILE * fastqout_discarded = nullptr;
+    std::FILE * fastaout_rev = nullptr;
+    std::FILE * fastqout_rev = nullptr;
+    std::FILE * fastaout_discarded_rev = nullptr;
+    std::FILE * fastqout_discarded_rev = nullptr;
+  };
+
+
+  class Filter_pipeline
+  {
+  public:
+    Filter_pipeline(fastx_handle forward_handle, fastx_handle reverse_handle,
+                    std::size_t const threads, struct filter_outputs const & outputs,
+                    struct Parameters const & parameters) :
+      forward_handle_(forward_handle),
+      reverse_handle_(reverse_handle),
+      threads_(threads),
+      outputs_(outputs),
+      parameters_(parameters) {}
+
+    /* read, filter and write all reads, or up to a bad quality value */
+    auto run(Progress & progress) -> void {
+      progress_ = &progress;
+
+      if (threads_ == 1)
+        {
+          auto & batch = batches_.front();
+          while (read_batch(batch))
+            {
+              analyse_reads(batch, 0);
+              if (not write_batch(batch))
+                {
+                  return;
+                }
+            }
+          return;
+        }
+
+      ThreadRunner runner(threads_ + 2, [this](uint64_t const t) { step(t); });
+
+      auto next = std::size_t{0};
+      analysing_ = read_batch(batches_[next]) ? &batches_[next] : nullptr;
+      writing_ = nullptr;
+      while ((analysing_ != nullptr) or (writing_ != nullptr))
+        {
+          next = (next + 1) % batches_.size();
+          reading_ = (analysing_ != nullptr) ? &batches_[next] : nullptr;
+          runner.run();
+          if (bad_quality_)
+            {
+              return;
+            }
+          writing_ = analysing_;
+          analysing_ = ((reading_ != nullptr) and not reading_->forward.empty()) ? reading_ : nullptr;
+        }
+    }
+
+    int64_t kept = 0;
+    int64_t discarded = 0;
+    int64_t truncated = 0;
+
+    /* valid after run() */
+    auto bad_quality() const -> bool { return bad_quality_; }
+    auto quality_score() const -> int { return quality_score_; }
+    auto reverse_missing() const -> bool { return reverse_missing_; }
+
+  private:
+    auto step(uint64_t const t) -> void {
+      if (t == threads_)
+        {
+          if (reading_ != nullptr)
+            {
+              read_batch(*reading_);
+            }
+          return;
+        }
+      if (t == threads_ + 1)
+        {
+          if (writing_ != nullptr)
+            {
+              write_batch(*writing_);
+            }
+          return;
+        }
+      if (analysing_ != nullptr)
+        {
+          analyse_reads(*analysing_, t);
+        }
+    }
+
+    /* copy the next reads, stopping at a full batch; false at the end */
+    auto read_batch(struct filter_batch & batch) -> bool {
+      batch.text.clear();
+      batch.forward.clear();
+      batch.reverse.clear();
+      while ((not finished_reading_) and
+             (batch.forward.size() < filter_batch_reads) and
+             (batch.text.size() < filter_batch_bytes))
+        {
+          if (not fastx_next(forward_handle_, false, chrmap_no_change()))
+            {
+              finished_reading_ = true;
+              break;
+            }
+          if (reverse_handle_ != nullptr)
+            {
+              if (not fastx_next(reverse_handle_, false, chrmap_no_change()))
+                {
+                  /* reported by filter() once the reads before are written */
+                  reverse_missing_ = true;
+                  finished_reading_ = true;
+                  break;
+                }
+              batch.reverse.push_back(copy_read(batch, reverse_handle_));
+            }
+          batch.forward.push_back(copy_read(batch, forward_handle_));
+
+          progress_->update(fastx_get_position(forward_handle_));
+        }
+      return not batch.forward.empty();
+    }
+
+    static auto copy_read(struct filter_batch & batch, fastx_handle input_handle) -> struct filter_read {
+      struct filter_read read;
+      read.length = static_cast<int>(fastx_get_sequence_length(input_handle));
+      read.abundance = fastx_get_abundance(input_handle);
+      auto const length = static_cast<std::size_t>(read.length);
+      read.headerlen = fastx_get_header_length(input_handle);
+      read.header = append(batch.text, fastx_get_header(input_handle), read.headerlen);
+      read.seq = append(batch.text, fastx_get_sequence(input_handle), length);
+      auto const * qual = fastx_get_quality(input_handle);
+      if (qual != nullptr)
+        {
+          read.qual = append(batch.text, qual, length);
+        }
+      return read;
+    }
+
+    static auto append(std::vector<char> & text, char const * chars,
+                       std::size_t const length) -> std::size_t {
+      auto const offset = text.size();
+      text.insert(text.end(), chars, chars + length);
+      text.push_back('\0');
+      return offset;
+    }
+
+    auto analyse_read(struct filter_batch const & batch, struct filter_read & read) const -> void {
+      auto const * base = batch.text.data();
+      read.res = analyse(base + read.seq,
+                         (read.qual == no_quality) ? nullptr : base + read.qual,
+                         read.length,
+                         read.abundance,
+                         parameters_);
+    }
+
+    auto analyse_reads(struct filter_batch & batch, uint64_t const t) const -> void {
+      auto const count = batch.forward.size();
+      auto const first = count * t / threads_;
+      auto const last = count * (t + 1) / threads_;
+      for (auto i = first; i < last; ++i)
+        {
+          analyse_read(batch, batch.forward[i]);
+          if (not batch.reverse.empty())
+            {
+              analyse_read(batch, batch.reverse[i]);
+            }
+        }
+    }
+
+    /* write the reads in input order; false at a bad quality value */
+    auto write_batch(struct filter_batch const & batch) -> bool {
+      static const struct analysis_res no_reverse;
+      for (auto i = std::size_t{0}; i < batch.forward.size(); ++i)
+        {
+          auto const & read1 = batch.forward[i];
+          auto const * read2 = batch.reverse.empty() ? nullptr : &batch.reverse[i];
+          auto const & res1 = read1.res;
+          auto const & res2 = (read2 != nullptr) ? read2->res : no_reverse;
+
+          if (res1.bad_quality or res2.bad_quality)
+            {
+              quality_score_ = res1.bad_quality ? res1.quality_score : res2.quality_score;
+              bad_quality_ = true;
+              return false;
+            }
+
+          if (res1.discarded or res2.discarded)
+            {
+              /* discard the sequence(s) */
+
+              ++discarded;
+
+              print_read(batch, read1, outputs_.fastaout_discarded,
+                         outputs_.fastqout_discarded, discarded);
+              if (read2 != nullptr)
+                {
+                  print_read(batch, *read2, outputs_.fastaout_discarded_rev,
+                             outputs_.fastqout_discarded_rev, discarded);
+                }
+            }
+          else
+            {
+              /* keep the sequence(s) */
+
+              ++kept;
+
+              if (res1.truncated or res2.truncated)
+                {
+                  ++truncated;
+                }
+
+              print_read(batch, read1, outputs_.fastaout, outputs_.fastqout, kept);
+              if (read2 != nullptr)
+                {
+                  print_read(batch, *read2, outputs_.fastaout_rev,
+                             outputs_.fastqout_rev, kept);
+                }
+            }
+        }
+      return true;
+    }
+
+    auto print_read(struct filter_batch const & batch, struct filter_read const & read,
+                    std::FILE * fp_fasta, std::FILE * fp_fastq, int64_t const ordinal) const -> void {
+      auto const * base = batch.text.data();
+      if (fp_fasta != nullptr)
+        {
+          fasta_print_general(fp_fasta,
+                              nullptr,
+                              base + read.seq + read.res.start,
+                              read.res.length,
+                              base + read.header,
+                              static_cast<int>(read.headerlen),
+                              static_cast<uint64_t>(read.abundance),
+                              ordinal,
+                              read.res.ee,
+                              -1,
+                              -1,
+                              nullptr,
+                              0.0,
+                              0,
+                              parameters_);
+        }
+
+      if (fp_fastq != nullptr)
+        {
+          fastq_print_general(fp_fastq,
+                              base + read.seq + read.res.start,
+                              read.res.length,
+                              base + read.header,
+                              static_cast<int>(read.headerlen),
+                              base + read.qual + read.res.start,
+                              static_cast<uint64_t>(read.abundance),
+                              ordinal,
+                              read.res.ee,
+                              parameters_);
+        }
+    }
+
+    fastx_handle forward_handle_;
+    fastx_handle reverse_handle_;
+    std::size_t threads_;
+    struct filter_outputs outputs_;
+    struct Parameters const & parameters_;
+    std::array<struct filter_batch, 3> batches_;
+    struct filter_batch * reading_ = nullptr;
+    struct filter_batch * analysing_ = nullptr;
+    struct filter_batch * writing_ = nullptr;
+    Progress * progress_ = nullptr;
+    bool finished_reading_ = false;
+    bool reverse_missing_ = false;
+    bool bad_quality_ = false;
+    int quality_score_ = 0;
+  };
+
 }  // end of anonymous namespace
 
 
@@ -327,199 +658,45 @@ auto filter(bool const fastq_only, char const * filename, struct Parameters cons
   OutputFileHandle fp_fastaout_discarded_rev;
   OutputFileHandle fp_fastqout_discarded_rev;
 
-  fp_fastaout = open_optional_output_file(parameters.opt_fastaout, OutputOption{"--fastaout"});
-  fp_fastqout = open_optional_output_file(parameters.opt_fastqout, OutputOption{"--fastqout"});
-  fp_fastaout_discarded = open_optional_output_file(parameters.opt_fastaout_discarded, OutputOption{"--fastaout_discarded"});
-  fp_fastqout_discarded = open_optional_output_file(parameters.opt_fastqout_discarded, OutputOption{"--fastqout_discarded"});
+  fp_fastaout = compress_output(open_optional_output_file(parameters.opt_fastaout, OutputOption{"--fastaout"}), parameters);
+  fp_fastqout = compress_output(open_optional_output_file(parameters.opt_fastqout, OutputOption{"--fastqout"}), parameters);
+  fp_fastaout_discarded = compress_output(open_optional_output_file(parameters.opt_fastaout_discarded, OutputOption{"--fastaout_discarded"}), parameters);
+  fp_fastqout_discarded = compress_output(open_optional_output_file(parameters.opt_fastqout_discarded, OutputOption{"--fastqout_discarded"}), parameters);
 
   if (reverse_handle != nullptr)
     {
-      fp_fastaout_rev = open_optional_output_file(parameters.opt_fastaout_rev, OutputOption{"--fastaout_rev"});
-      fp_fastqout_rev = open_optional_output_file(parameters.opt_fastqout_rev, OutputOption{"--fastqout_rev"});
-      fp_fastaout_discarded_rev = open_optional_output_file(parameters.opt_fastaout_discarded_rev, OutputOption{"--fastaout_discarded_rev"});
-      fp_fastqout_discarded_rev = open_optional_output_file(parameters.opt_fastqout_discarded_rev, OutputOption{"--fastqout_discarded_rev"});
-    }
-
-  int64_t kept = 0;
-  int64_t discarded = 0;
-  int64_t truncated = 0;
+      fp_fastaout_rev = compress_output(open_optional_output_file(parameters.opt_fastaout_rev, OutputOption{"--fastaout_rev"}), parameters);
+      fp_fastqout_rev = compress_output(open_optional_output_file(parameters.opt_fastqout_rev, OutputOption{"--fastqout_rev"}), parameters);
+      fp_fastaout_discarded_rev = compress_output(open_optional_output_file(parameters.opt_fastaout_discarded_rev, OutputOption{"--fastaout_discarded_rev"}), parameters);
+      fp_fastqout_discarded_rev = compress_output(open_optional_output_file(parameters.opt_fastqout_discarded_rev, OutputOption{"--fastqout_discarded_rev"}), parameters);
+    }
+
+  struct filter_outputs outputs;
+  outputs.fastaout = fp_fastaout.get();
+  outputs.fastqout = fp_fastqout.get();
+  outputs.fastaout_discarded = fp_fastaout_discarded.get();
+  outputs.fastqout_discarded = fp_fastqout_discarded.get();
+  outputs.fastaout_rev = fp_fastaout_rev.get();
+  outputs.fastqout_rev = fp_fastqout_rev.get();
+  outputs.fastaout_discarded_rev = fp_fastaout_discarded_rev.get();
+  outputs.fastqout_discarded_rev = fp_fastqout_discarded_rev.get();
+
+  Filter_pipeline pipeline(forward_handle, reverse_handle,
+                           static_cast<std::size_t>(parameters.opt_threads),
+                           outputs, parameters);
 
   {
     Progress progress("Reading input file", filesize, parameters);
-    while (fastx_next(forward_handle, false, chrmap_no_change()))
+    pipeline.run(progress);
+
+    if (pipeline.bad_quality())
+      {
+        report_quality_error(pipeline.quality_score(), parameters);
+      }
+
+    if (pipeline.reverse_missing())
       {
-        if ((reverse_handle != nullptr) and not fastx_next(reverse_handle, false, chrmap_no_change()))
-          {
-            fatal("More forward reads than reverse reads");
-          }
-
-        struct analysis_res res1;
-        res1.ee = 0.0;
-        struct analysis_res res2;
-
-        res1 = analyse(forward_handle, parameters);
-        if (reverse_handle != nullptr)
-          {
-            res2 = analyse(reverse_handle, parameters);
-          }
-
-        if (res1.discarded or res2.discarded)
-          {
-            /* discard the sequence(s) */
-
-            ++discarded;
-
-            if (parameters.opt_fastaout_discarded != nullptr)
-              {
-                fasta_print_general(fp_fastaout_discarded.get(),
-                                    nullptr,
-                                    fastx_get_sequence(forward_handle) + res1.start,
-                                    res1.length,
-                                    fastx_get_header(forward_handle),
-                                    static_cast<int>(fastx_get_header_length(forward_handle)),
-                                    static_cast<uint64_t>(fastx_get_abundance(forward_handle)),
-                                    discarded,
-                                    res1.ee,
-                                    -1,
-                                    -1,
-                                    nullptr,
-                                    0.0,
-                                    0,
-                                    parameters);
-              }
-
-            if (parameters.opt_fastqout_discarded != nullptr)
-              {
-                fastq_print_general(fp_fastqout_discarded.get(),
-                                    fastx_get_sequence(forward_handle) + res1.start,
-                                    res1.length,
-                                    fastx_get_header(forward_handle),
-                                    static_cast<int>(fastx_get_header_length(forward_handle)),
-                                    fastx_get_quality(forward_handle) + res1.start,
-                                    static_cast<uint64_t>(fastx_get_abundance(forward_handle)),
-                                    discarded,
-                                    res1.ee,
-                                    parameters);
-              }
-
-            if (reverse_handle != nullptr)
-              {
-                if (parameters.opt_fastaout_discarded_rev != nullptr)
-                  {
-                    fasta_print_general(fp_fastaout_discarded_rev.get(),
-                                        nullptr,
-                                        fastx_get_sequence(reverse_handle) + res2.start,
-                                        res2.length,
-                                        fastx_get_header(reverse_handle),
-                                        static_cast<int>(fastx_get_header_length(reverse_handle)),
-                                        static_cast<uint64_t>(fastx_get_abundance(reverse_handle)),
-                                        discarded,
-                                        res2.ee,
-                                        -1,
-                                        -1,
-                                        nullptr,
-                                        0.0,
-                                        0,
-                                        parameters);
-                  }
-
-                if (parameters.opt_fastqout_discarded_rev != nullptr)
-                  {
-                    fastq_print_general(fp_fastqout_discarded_rev.get(),
-                                        fastx_get_sequence(reverse_handle) + res2.start,
-                                        res2.length,
-                                        fastx_get_header(reverse_handle),
-                                        static_cast<int>(fastx_get_header_length(reverse_handle)),
-                                        fastx_get_quality(reverse_handle) + res2.start,
-                                        static_cast<uint64_t>(fastx_get_abundance(reverse_handle)),
-                                        discarded,
-                                        res2.ee,
-                                        parameters);
-                  }
-              }
-          }
-        else
-          {
-            /* keep the sequence(s) */
-
-            ++kept;
-
-            if (res1.truncated or res2.truncated)
-              {
-                ++truncated;
-              }
-
-            if (parameters.opt_fastaout != nullptr)
-              {
-                fasta_print_general(fp_fastaout.get(),
-                                    nullptr,
-                                    fastx_get_sequence(forward_handle) + res1.start,
-                                    res1.length,
-                                    fastx_get_header(forward_handle),
-                                    static_cast<int>(fastx_get_header_length(forward_handle)),
-                                    static_cast<uint64_t>(fastx_get_abundance(forward_handle)),
-                                    kept,
-                                    res1.ee,
-                                    -1,
-                                    -1,
-                                    nullptr,
-                                    0.0,
-                                    0,
-                                    parameters);
-              }
-
-            if (parameters.opt_fastqout != nullptr)
-              {
-                fastq_print_general(fp_fastqout.get(),
-                                    fastx_get_sequence(forward_handle) + res1.start,
-                                    res1.length,
-                                    fastx_get_header(forward_handle),
-                                    static_cast<int>(fastx_get_header_length(forward_handle)),
-                                    fastx_get_quality(forward_handle) + res1.start,
-                                    static_cast<uint64_t>(fastx_get_abundance(forward_handle)),
-                                    kept,
-                                    res1.ee,
-                                    parameters);
-              }
-
-            if (reverse_handle != nullptr)
-              {
-                if (parameters.opt_fastaout_rev != nullptr)
-                  {
-                    fasta_print_general(fp_fastaout_rev.get(),
-                                        nullptr,
-                                        fastx_get_sequence(reverse_handle) + res2.start,
-                                        res2.length,
-                                        fastx_get_header(reverse_handle),
-                                        static_cast<int>(fastx_get_header_length(reverse_handle)),
-                                        static_cast<uint64_t>(fastx_get_abundance(reverse_handle)),
-                                        kept,
-                                        res2.ee,
-                                        -1,
-                                        -1,
-                                        nullptr,
-                                        0.0,
-                                        0,
-                                        parameters);
-                  }
-
-                if (parameters.opt_fastqout_rev != nullptr)
-                  {
-                    fastq_print_general(fp_fastqout_rev.get(),
-                                        fastx_get_sequence(reverse_handle) + res2.start,
-                                        res2.length,
-                                        fastx_get_header(reverse_handle),
-                                        static_cast<int>(fastx_get_header_length(reverse_handle)),
-                                        fastx_get_quality(reverse_handle) + res2.start,
-                                        static_cast<uint64_t>(fastx_get_abundance(reverse_handle)),
-                                        kept,
-                                        res2.ee,
-                                        parameters);
-                  }
-              }
-          }
-
-        progress.update(fastx_get_position(forward_handle));
+        fatal("More forward reads than reverse reads");
       }
   }
 
@@ -528,6 +705,10 @@ auto filter(bool const fastq_only, char const * filename, struct Parameters cons
       fatal("More reverse reads than forward reads");
     }
 
+  auto const kept = pipeline.kept;
+  auto const truncated = pipeline.truncated;
+  auto const discarded = pipeline.discarded;
+
   if (not parameters.opt_quiet)
     {
       std::fprintf(stderr,
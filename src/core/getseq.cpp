@@ -67,6 +67,7 @@
 #include "utils/compare_strings_nocase.hpp"
 #include "utils/fatal.hpp"
 #include "utils/maps.hpp"
+#include "core/block_compress.hpp"  // compress_output
 #include "utils/open_file.hpp"
 #include "utils/span.hpp"
 #include <algorithm>  // std::copy, std::max, std::min, std::search, std::equal
@@ -402,10 +403,10 @@ auto getseq(struct Parameters const & parameters, char const * filename) -> void
 
   uint64_t const filesize = fastx_get_size(h1);
 
-  auto fastaout_handle = open_optional_output_file(parameters.opt_fastaout, OutputOption{"--fastaout"});
-  auto fastqout_handle = open_optional_output_file(parameters.opt_fastqout, OutputOption{"--fastqout"});
-  auto notmatched_handle = open_optional_output_file(parameters.opt_notmatched, OutputOption{"--notmatched"});
-  auto notmatchedfq_handle = open_optional_output_file(parameters.opt_notmatchedfq, OutputOption{"--notmatchedfq"});
+  auto fastaout_handle = compress_output(open_optional_output_file(parameters.opt_fastaout, OutputOption{"--fastaout"}), parameters);
+  auto fastqout_handle = compress_output(open_optional_output_file(parameters.opt_fastqout, OutputOption{"--fastqout"}), parameters);
+  auto notmatched_handle = compress_output(open_optional_output_file(parameters.opt_notmatched, OutputOption{"--notmatched"}), parameters);
+  auto notmatchedfq_handle = compress_output(open_optional_output_file(parameters.opt_notmatchedfq, OutputOption{"--notmatchedfq"}), parameters);
   std::FILE * const fp_fastaout = fastaout_handle.get();
   std::FILE * const fp_fastqout = fastqout_handle.get();
   std::FILE * const fp_notmatched = notmatched_handle.get();
@@ -61,7 +61,7 @@
 #include "vsearch.h"
 #include "vendored/city.h"
 #include "utils/kmer_hash_struct.hpp"
-#include "utils/maps.hpp"
+#include "utils/pack_2bit.hpp"
 #include <algorithm>  // std::max
 #include <vector>
 
@@ -79,6 +79,13 @@ namespace {
     hash.resize(current_size);
   }
 
+
+  auto pack_sequence(struct kh_handle_s & kmer_hash, char const * seq, int const len) -> void {
+    kmer_hash.codes.resize(std::max(kmer_hash.codes.size(), packed_code_words(len)));
+    kmer_hash.masked.resize(std::max(kmer_hash.masked.size(), packed_mask_words(len)));
+    pack_2bit(seq, len, false, kmer_hash.codes.data(), kmer_hash.masked.data());
+  }
+
 }  // end of anonymous namespace
 
 
@@ -101,9 +108,6 @@ inline auto kh_insert_kmer(struct kh_handle_s & kmer_hash,
 
 auto kh_insert_kmers(struct kh_handle_s & kmer_hash, int const k_offset, char const * seq, int const len) -> void
 {
-  int const kmers = 1U << (2U * static_cast<unsigned int>(k_offset));
-  unsigned int const kmer_mask = static_cast<unsigned int>(kmers - 1);
-
   reset_buckets(kmer_hash.hash);
 
   /* reallocate hash table if necessary */
@@ -127,77 +131,41 @@ auto kh_insert_kmers(struct kh_handle_s & kmer_hash, int const k_offset, char co
 
   kmer_hash.maxpos = len;
 
-
-  unsigned int bad = kmer_mask;
-  unsigned int kmer = 0;
-  char const * s = seq;
-
-  for (int pos = 0; pos < len; pos++)
-    {
-      char const c = *s;
-      ++s;
-
-      bad <<= 2ULL;
-      bad |= map_mask_ambig(c);
-      bad &= kmer_mask;
-
-      kmer <<= 2ULL;
-      kmer |= map_2bit(c);
-      kmer &= kmer_mask;
-
-      if (bad == 0U)
-        {
-          /* 1-based pos of start of kmer */
-          kh_insert_kmer(kmer_hash, k_offset, kmer, static_cast<unsigned int>(pos - k_offset + 1 + 1));
-        }
-    }
+  pack_sequence(kmer_hash, seq, len);
+  for_each_packed_kmer(kmer_hash.codes.data(), kmer_hash.masked.data(), len,
+                       static_cast<unsigned int>(k_offset),
+                       [&kmer_hash, k_offset](unsigned int const kmer, int64_t const start) {
+                         /* 1-based pos of start of kmer */
+                         kh_insert_kmer(kmer_hash, k_offset, kmer, static_cast<unsigned int>(start + 1));
+                       });
 }
 
 
-auto kh_find_diagonals(struct kh_handle_s const & kmer_hash,
+auto kh_find_diagonals(struct kh_handle_s & kmer_hash,
                        int const k_offset,
                        char const * seq,
                        int const len,
                        std::vector<int> & diags) -> void
 {
-
-  int const kmers = 1U << (2U * static_cast<unsigned int>(k_offset));
-  unsigned int const kmer_mask = static_cast<unsigned int>(kmers - 1);
-
-  unsigned int bad = kmer_mask;
-  unsigned int kmer = 0;
-  char const * seq_cursor = seq + len - 1;
-
-  for (int pos = 0; pos < len; pos++)
-    {
-      char const nucleotide = *seq_cursor--;
-
-      bad <<= 2ULL;
-      bad |= map_mask_ambig(nucleotide);
-      bad &= kmer_mask;
-
-      kmer <<= 2ULL;
-      kmer |= map_2bit(map_complement(nucleotide));
-      kmer &= kmer_mask;
-
-      if (bad == 0U)
-        {
-          /* find matching buckets in hash */
-          unsigned int j = static_cast<unsigned int>(hash_function(reinterpret_cast<char const *>(&kmer), static_cast<std::size_t>((k_offset + 3) / 4)) & kmer_hash.hash_mask);
-          while (kmer_hash.hash[j].pos != 0U)
-            {
-              if (kmer_hash.hash[j].kmer == kmer)
-                {
-                  int const fpos = static_cast<int>(kmer_hash.hash[j].pos) - 1;
-                  int const diag = len + fpos - (pos - k_offset + 1);
-                  if (diag >= 0)
-                    {
-                      ++diags[static_cast<std::size_t>(diag)];
-                    }
-                }
-              j = (j + 1) & kmer_hash.hash_mask;
-            }
-        }
-    }
+  /* the kmers of the reverse complement of seq */
+  pack_sequence(kmer_hash, seq, len);
+  for_each_packed_rc_kmer(kmer_hash.codes.data(), kmer_hash.masked.data(), len,
+                          static_cast<unsigned int>(k_offset),
+                          [&](unsigned int const kmer, int64_t const start) {
+                            /* find matching buckets in hash */
+                            unsigned int j = static_cast<unsigned int>(hash_function(reinterpret_cast<char const *>(&kmer), static_cast<std::size_t>((k_offset + 3) / 4)) & kmer_hash.hash_mask);
+                            while (kmer_hash.hash[j].pos != 0U)
+                              {
+                                if (kmer_hash.hash[j].kmer == kmer)
+                                  {
+                                    int const fpos = static_cast<int>(kmer_hash.hash[j].pos) - 1;
+                                    int const diag = len + fpos - static_cast<int>(start);
+                                    if (diag >= 0)
+                                      {
+                                        ++diags[static_cast<std::size_t>(diag)];
+                                      }
+                                  }
+                                j = (j + 1) & kmer_hash.hash_mask;
+                              }
+                          });
 }
-
@@ -65,7 +65,7 @@
 
 auto kh_insert_kmers(struct kh_handle_s & kmer_hash, int k_offset, char const * seq, int len) -> void;
 
-auto kh_find_diagonals(struct kh_handle_s const & kmer_hash,
+auto kh_find_diagonals(struct kh_handle_s & kmer_hash,
                        int k_offset,
                        char const * seq,
                        int len,
@@ -76,11 +76,21 @@
 constexpr int dust_window = 64;
 
 
-auto wo(int len, const char *s, int *beg, int *end) -> int
+/* Score the DUST window of len triplet codes (words[k] is the triplet
+   ending at position k; words[0] and words[1] are not used). The score
+   of the region from i to i + j is 10 * pairs / j, where pairs is the
+   number of equal triplet pairs in it. Instead of recounting the
+   triplets for every start i, the pair counts of start i are derived
+   from those of start i - 1 by removing the pairs formed with the
+   triplet that leaves the region, and the score test is done by
+   multiplication, so the window costs a few operations per (i, j).
+   Evaluating regions that end on a new triplet does not change the
+   result: they score no higher than the shorter region before them. */
+
+auto wo(int len, unsigned char const * words, int *beg, int *end) -> int
 {
   static constexpr auto dust_word = 3;
   static constexpr auto word_count = 1U << (2U * dust_word);  // 64
-  static constexpr auto bitmask = word_count - 1;
   const auto l1 = len - dust_word + 1 - 5; /* smallest possible region is 8 */
   if (l1 < 0)
     {
@@ -90,40 +100,38 @@ auto wo(int len, const char *s, int *beg, int *end) -> int
   auto bestv = 0;
   auto besti = 0;
   auto bestj = 0;
-  std::array<int, word_count> counts {{}};
-  std::array<int, dust_window> words {{}};
-  auto word = 0U;
+  std::array<unsigned char, word_count> counts {{}};
+  std::array<int, dust_window + 1> pairs {{}};
+
+  auto const score = [&](int const i, int const j) {
+    auto const scaled = 10 * pairs[static_cast<std::size_t>(j)];
+    if (scaled >= (bestv + 1) * j)
+      {
+        bestv = scaled / j;
+        besti = i;
+        bestj = j;
+      }
+  };
 
-  for (auto j = 0; j < len; j++)
+  /* first start: count the pairs directly */
+  auto sum = 0;
+  for (auto j = dust_word - 1; l1 > 0 && j < len; j++)
     {
-      word <<= 2U;
-      word |= map_2bit(s[j]);
-      words[static_cast<std::size_t>(j)] = static_cast<int>(word & bitmask);
+      sum += counts[words[j]]++;
+      pairs[static_cast<std::size_t>(j)] = sum;
+      score(0, j);
     }
 
-  for (auto i = 0; i < l1; i++)
+  /* next starts: drop the pairs formed with the leaving triplet */
+  for (auto i = 1; i < l1; i++)
     {
-      counts.fill(0);  // reset counts to zero
-
-      auto sum = 0;
-
+      auto const leaving = words[i + dust_word - 2];
+      auto dropped = 0;
       for (auto j = dust_word - 1; j < len - i; j++)
         {
-          word = static_cast<unsigned int>(words[static_cast<std::size_t>(i + j)]);
-          const auto c = counts[word];
-          if (c != 0)
-            {
-              sum += c;
-              const auto v = 10 * sum / j;
-
-              if (v > bestv)
-                {
-                  bestv = v;
-                  besti = i;
-                  bestj = j;
-                }
-            }
-          ++counts[word];
+          dropped += static_cast<int>(words[i + j] == leaving);
+          pairs[static_cast<std::size_t>(j)] = pairs[static_cast<std::size_t>(j) + 1] - dropped;
+          score(i, j);
         }
     }
 
@@ -147,6 +155,16 @@ static auto dust_core(char * seq, int len, bool use_hardmask) -> void
   std::vector<char> local_seq(static_cast<std::size_t>(len) + 1);
   std::strcpy(local_seq.data(), seq);
 
+  /* code the triplets once, the windows overlap by half */
+  static constexpr auto bitmask = 63U;
+  std::vector<unsigned char> words(static_cast<std::size_t>(len));
+  auto word = 0U;
+  for (auto i = 0; i < len; i++)
+    {
+      word = ((word << 2U) | map_2bit(seq[i])) & bitmask;
+      words[static_cast<std::size_t>(i)] = static_cast<unsigned char>(word);
+    }
+
   if (!use_hardmask)
     {
       /* convert sequence to upper case unless hardmask in effect */
@@ -160,7 +178,7 @@ static auto dust_core(char * seq, int len, bool use_hardmask) -> void
   for (auto i = 0; i < len; i += half_dust_window)
     {
       const auto l = (len > i + dust_window) ? dust_window : len - i;
-      const auto v = wo(l, &local_seq[static_cast<std::size_t>(i)], &a, &b);
+      const auto v = wo(l, &words[static_cast<std::size_t>(i)], &a, &b);
 
       if (v > dust_level)
         {
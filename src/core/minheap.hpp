@@ -88,6 +88,7 @@ inline auto minheap_clear(minheap_t * a_minheap) -> void
   a_minheap->count = 0;
 }
 
+auto elem_smaller(elem_t const * lhs, elem_t const * rhs) -> int;
 auto minheap_poplast(minheap_t * a_minheap) -> elem_t;
 auto minheap_sort(minheap_t * a_minheap) -> void;
 auto minheap_init(int size) -> minheap_t *;
@@ -65,6 +65,7 @@
 #include "utils/cigar.hpp"
 #include "utils/fatal.hpp"
 #include "utils/maps.hpp"
+#include "utils/output_buffer.hpp"
 #include "utils/span.hpp"
 #include "utils/view.hpp"
 #include "utils/taxonomic_fields.h"
@@ -74,7 +75,7 @@
 #include <cinttypes>  // macros PRIu64 and PRId64
 #include <cstdint>  // int64_t, uint64_t
 #include <cstdio>  // std::FILE, std::fprintf, std::fclose, std::snprintf, std::sscanf
-#include <cstring>  // std::strlen, std::strncmp
+#include <cstring>  // std::strlen
 #include <string>  // std::string, std::to_string
 
 
@@ -97,7 +98,7 @@ namespace {
 }  // end of anonymous namespace
 
 
-auto results_show_fastapairs_one(std::FILE * output_handle,
+auto results_show_fastapairs_one(Output_buffer & output,
                                  struct hit const * hits,
                                  char const * query_head,
                                  char const * qsequence,
@@ -115,7 +116,7 @@ auto results_show_fastapairs_one(std::FILE * output_handle,
   auto const qrow = get_alignment_qrow(View<char>{query, std::strlen(query)},
                                  Span<char>{hits->nwalignment, std::strlen(hits->nwalignment)},
                                  hits->nwalignmentlength);
-  fasta_print_general(output_handle,
+  fasta_print_general(output,
                       nullptr,
                       &qrow[static_cast<std::size_t>(hits->trim_q_left + hits->trim_t_left)],
                       hits->internal_alignmentlength,
@@ -135,7 +136,7 @@ auto results_show_fastapairs_one(std::FILE * output_handle,
   auto const trow = get_alignment_trow(View<char>{db.getsequence(target), static_cast<std::size_t>(db.getsequencelen(target))},
                                  Span<char>{hits->nwalignment, std::strlen(hits->nwalignment)},
                                  hits->nwalignmentlength);
-  fasta_print_general(output_handle,
+  fasta_print_general(output,
                       nullptr,
                       &trow[static_cast<std::size_t>(hits->trim_q_left + hits->trim_t_left)],
                       hits->internal_alignmentlength,
@@ -151,11 +152,31 @@ auto results_show_fastapairs_one(std::FILE * output_handle,
                       0,
                       parameters);
 
-  std::fprintf(output_handle, "\n");
+  output.append('\n');
 }
 
 
-auto results_show_qsegout_one(std::FILE * output_handle,
+auto results_show_fastapairs_one(std::FILE * output_handle,
+                                 struct hit const * hits,
+                                 char const * query_head,
+                                 char const * qsequence,
+                                 char const * qsequence_rc,
+                                 struct Database const & db,
+                                 struct Parameters const & parameters) -> void
+{
+  Output_buffer output;
+  results_show_fastapairs_one(output,
+                              hits,
+                              query_head,
+                              qsequence,
+                              qsequence_rc,
+                              db,
+                              parameters);
+  output.write(output_handle);
+}
+
+
+auto results_show_qsegout_one(Output_buffer & output,
                               struct hit const * hits,
                               char const * query_head,
                               char const * qsequence,
@@ -170,7 +191,7 @@ auto results_show_qsegout_one(std::FILE * output_handle,
   char const * qseg = ((hits->strand != 0) ? qsequence_rc : qsequence) + hits->trim_q_left;
   int const qseglen = static_cast<int>(qseqlen - hits->trim_q_left - hits->trim_q_right);
 
-  fasta_print_general(output_handle,
+  fasta_print_general(output,
                       nullptr,
                       qseg,
                       qseglen,
@@ -188,7 +209,27 @@ auto results_show_qsegout_one(std::FILE * output_handle,
 }
 
 
-auto results_show_tsegout_one(std::FILE * output_handle,
+auto results_show_qsegout_one(std::FILE * output_handle,
+                              struct hit const * hits,
+                              char const * query_head,
+                              char const * qsequence,
+                              int64_t const qseqlen,
+                              char const * qsequence_rc,
+                              struct Parameters const & parameters) -> void
+{
+  Output_buffer output;
+  results_show_qsegout_one(output,
+                           hits,
+                           query_head,
+                           qsequence,
+                           qseqlen,
+                           qsequence_rc,
+                           parameters);
+  output.write(output_handle);
+}
+
+
+auto results_show_tsegout_one(Output_buffer & output,
                               struct hit const * hits,
                               struct Database const & db,
                               struct Parameters const & parameters) -> void
@@ -200,7 +241,7 @@ auto results_show_tsegout_one(std::FILE * output_handle,
   auto const * tseg = db.getsequence(target) + hits->trim_t_left;
   int const tseglen = static_cast<int>(db.getsequencelen(target)) - hits->trim_t_left - hits->trim_t_right;
 
-  fasta_print_general(output_handle,
+  fasta_print_general(output,
                       nullptr,
                       tseg,
                       tseglen,
@@ -218,7 +259,21 @@ auto results_show_tsegout_one(std::FILE * output_handle,
 }
 
 
-auto results_show_blast6out_one(std::FILE * output_handle,
+auto results_show_tsegout_one(std::FILE * output_handle,
+                              struct hit const * hits,
+                              struct Database const & db,
+                              struct Parameters const & parameters) -> void
+{
+  Output_buffer output;
+  results_show_tsegout_one(output,
+                           hits,
+                           db,
+                           parameters);
+  output.write(output_handle);
+}
+
+
+auto results_show_blast6out_one(Output_buffer & output,
                                 struct hit const * hits,
                                 char const * query_head,
                                 int64_t const qseqlen,
@@ -246,7 +301,8 @@ auto results_show_blast6out_one(std::FILE * output_handle,
   */
 
   if (hits == nullptr) {
-    std::fprintf(output_handle, "%s\t*\t0.0\t0\t0\t0\t0\t0\t0\t0\t-1\t0\n", query_head);
+    output.append(query_head);
+    output.append("\t*\t0.0\t0\t0\t0\t0\t0\t0\t0\t-1\t0\n");
     return;
   }
   // if 'hp->strand' then 'minus strand' else 'plus strand'
@@ -254,24 +310,44 @@ auto results_show_blast6out_one(std::FILE * output_handle,
   int const qstart = (hits->strand != 0) ? static_cast<int>(qseqlen) : 1;
   int const qend = (hits->strand != 0) ? 1 : static_cast<int>(qseqlen);
 
-  std::fprintf(output_handle,
-          "%s\t%s\t%.1f\t%d\t%d\t%d\t%d\t%d\t%d\t%" PRIu64 "\t%d\t%d\n",
-          query_head,
-          db.getheader(target),
-          hits->id,
-          hits->internal_alignmentlength,
-          hits->mismatches,
-          hits->internal_gaps,
-          qstart,
-          qend,
-          1,
-          db.getsequencelen(target),
-          -1,
-          0);
+  output.append(query_head);
+  output.append('\t');
+  output.append(db.getheader(target));
+  output.append('\t');
+  output.append_fixed1(hits->id);
+  output.append('\t');
+  output.append_integer(hits->internal_alignmentlength);
+  output.append('\t');
+  output.append_integer(hits->mismatches);
+  output.append('\t');
+  output.append_integer(hits->internal_gaps);
+  output.append('\t');
+  output.append_integer(qstart);
+  output.append('\t');
+  output.append_integer(qend);
+  output.append("\t1\t");
+  output.append_unsigned(db.getsequencelen(target));
+  output.append("\t-1\t0\n");
 }
 
 
-auto results_show_uc_one(std::FILE * output_handle,
+auto results_show_blast6out_one(std::FILE * output_handle,
+                                struct hit const * hits,
+                                char const * query_head,
+                                int64_t const qseqlen,
+                                struct Database const & db) -> void
+{
+  Output_buffer output;
+  results_show_blast6out_one(output,
+                             hits,
+                             query_head,
+                             qseqlen,
+                             db);
+  output.write(output_handle);
+}
+
+
+auto results_show_uc_one(Output_buffer & output,
                          struct hit const * hits,
                          char const * query_head,
                          int64_t const qseqlen,
@@ -296,38 +372,64 @@ auto results_show_uc_one(std::FILE * output_handle,
   */
 
   if (hits == nullptr) {
-    std::fprintf(output_handle, "N\t*\t*\t*\t.\t*\t*\t*\t%s\t*\n", query_head);
+    output.append("N\t*\t*\t*\t.\t*\t*\t*\t");
+    output.append(query_head);
+    output.append("\t*\n");
     return;
   }
 
   auto const is_perfect_match = check_if_perfect_match(parameters.opt_cluster_fast, hits);
 
-  std::fprintf(output_handle,
-          "H\t%d\t%" PRId64 "\t%.1f\t%c\t0\t0\t%s\t",
-          clusterno,
-          qseqlen,
-          hits->id,
-          (hits->strand != 0) ? '-' : '+',
-          is_perfect_match ? "=" : hits->nwalignment);
+  output.append("H\t");
+  output.append_integer(clusterno);
+  output.append('\t');
+  output.append_integer(qseqlen);
+  output.append('\t');
+  output.append_fixed1(hits->id);
+  output.append('\t');
+  output.append((hits->strand != 0) ? '-' : '+');
+  output.append("\t0\t0\t");
+  output.append(is_perfect_match ? "=" : hits->nwalignment);
+  output.append('\t');
   auto const target = static_cast<uint64_t>(hits->target);
-  header_fprint_strip(output_handle,
+  header_fprint_strip(output,
                       query_head,
                       static_cast<int>(std::strlen(query_head)),
                       parameters.opt_xsize,
                       parameters.opt_xee,
                       parameters.opt_xlength);
-  std::fprintf(output_handle, "\t");
-  header_fprint_strip(output_handle,
+  output.append('\t');
+  header_fprint_strip(output,
                       db.getheader(target),
                       static_cast<int>(db.getheaderlen(target)),
                       parameters.opt_xsize,
                       parameters.opt_xee,
                       parameters.opt_xlength);
-  std::fprintf(output_handle, "\n");
+  output.append('\n');
 }
 
 
-auto results_show_userout_one(std::FILE * output_handle, struct hit const * hits,
+auto results_show_uc_one(std::FILE * output_handle,
+                         struct hit const * hits,
+                         char const * query_head,
+                         int64_t const qseqlen,
+                         int const clusterno,
+                         struct Database const & db,
+                         struct Parameters const & parameters) -> void
+{
+  Output_buffer output;
+  results_show_uc_one(output,
+                      hits,
+                      query_head,
+                      qseqlen,
+                      clusterno,
+                      db,
+                      parameters);
+  output.write(output_handle);
+}
+
+
+auto results_show_userout_one(Output_buffer & output, struct hit const * hits,
                               char const * query_head,
                               char const * qsequence, int64_t const qseqlen,
                               char const * qsequence_rc,
@@ -346,7 +448,7 @@ auto results_show_userout_one(std::FILE * output_handle, struct hit const * hits
     {
       if (c != 0)
         {
-          std::fprintf(output_handle, "\t");
+          output.append('\t');
         }
 
       auto const field = userfields_requested[c];
@@ -367,93 +469,93 @@ auto results_show_userout_one(std::FILE * output_handle, struct hit const * hits
       switch (field)
         {
         case 0: /* query */
-          std::fprintf(output_handle, "%s", query_head);
+          output.append(query_head);
           break;
         case 1: /* target */
-          std::fprintf(output_handle, "%s", (hits != nullptr) ? t_head : "*");
+          output.append((hits != nullptr) ? t_head : "*");
           break;
         case 2: /* evalue */
-          std::fprintf(output_handle, "-1");
+          output.append("-1");
           break;
         case 3: /* id */
-          std::fprintf(output_handle, "%.1f", (hits != nullptr) ? hits->id : 0.0);
+          output.append_fixed1((hits != nullptr) ? hits->id : 0.0);
           break;
         case 4: /* pctpv */
-          std::fprintf(output_handle, "%.1f", ((hits != nullptr) and (hits->internal_alignmentlength > 0)) ? 100.0 * hits->matches / hits->internal_alignmentlength : 0.0);
+          output.append_fixed1(((hits != nullptr) and (hits->internal_alignmentlength > 0)) ? 100.0 * hits->matches / hits->internal_alignmentlength : 0.0);
           break;
         case 5: /* pctgaps */
-          std::fprintf(output_handle, "%.1f", ((hits != nullptr) and (hits->internal_alignmentlength > 0)) ? 100.0 * hits->internal_indels / hits->internal_alignmentlength : 0.0);
+          output.append_fixed1(((hits != nullptr) and (hits->internal_alignmentlength > 0)) ? 100.0 * hits->internal_indels / hits->internal_alignmentlength : 0.0);
           break;
         case 6: /* pairs */
-          std::fprintf(output_handle, "%d", (hits != nullptr) ? hits->matches + hits->mismatches : 0);
+          output.append_integer((hits != nullptr) ? hits->matches + hits->mismatches : 0);
           break;
         case 7: /* gaps */
-          std::fprintf(output_handle, "%d", (hits != nullptr) ? hits->internal_indels : 0);
+          output.append_integer((hits != nullptr) ? hits->internal_indels : 0);
           break;
         case 8: /* qlo */
-          std::fprintf(output_handle, "%" PRId64, (hits != nullptr) ? ((hits->strand != 0) ? qseqlen : 1) : 0);
+          output.append_integer((hits != nullptr) ? ((hits->strand != 0) ? qseqlen : 1) : 0);
           break;
         case 9: /* qhi */
-          std::fprintf(output_handle, "%" PRId64, (hits != nullptr) ? ((hits->strand != 0) ? 1 : qseqlen) : 0);
+          output.append_integer((hits != nullptr) ? ((hits->strand != 0) ? 1 : qseqlen) : 0);
           break;
         case 10: /* tlo */
-          std::fprintf(output_handle, "%d", (hits != nullptr) ? 1 : 0);
+          output.append_integer((hits != nullptr) ? 1 : 0);
           break;
         case 11: /* thi */
-          std::fprintf(output_handle, "%" PRId64, tseqlen);
+          output.append_integer(tseqlen);
           break;
         case 12: /* pv */
-          std::fprintf(output_handle, "%d", (hits != nullptr) ? hits->matches : 0);
+          output.append_integer((hits != nullptr) ? hits->matches : 0);
           break;
         case 13: /* ql */
-          std::fprintf(output_handle, "%" PRId64, qseqlen);
+          output.append_integer(qseqlen);
           break;
         case 14: /* tl */
-          std::fprintf(output_handle, "%" PRId64, (hits != nullptr) ? tseqlen : 0);
+          output.append_integer((hits != nullptr) ? tseqlen : 0);
           break;
         case 15: /* qs */
-          std::fprintf(output_handle, "%" PRId64, qseqlen);
+          output.append_integer(qseqlen);
           break;
         case 16: /* ts */
-          std::fprintf(output_handle, "%" PRId64, (hits != nullptr) ? tseqlen : 0);
+          output.append_integer((hits != nullptr) ? tseqlen : 0);
           break;
         case 17: /* alnlen */
-          std::fprintf(output_handle, "%d", (hits != nullptr) ? hits->internal_alignmentlength : 0);
+          output.append_integer((hits != nullptr) ? hits->internal_alignmentlength : 0);
           break;
         case 18: /* opens */
-          std::fprintf(output_handle, "%d", (hits != nullptr) ? hits->internal_gaps : 0);
+          output.append_integer((hits != nullptr) ? hits->internal_gaps : 0);
           break;
         case 19: /* exts */
-          std::fprintf(output_handle, "%d", (hits != nullptr) ? hits->internal_indels - hits->internal_gaps : 0);
+          output.append_integer((hits != nullptr) ? hits->internal_indels - hits->internal_gaps : 0);
           break;
         case 20: /* raw */
-          std::fprintf(output_handle, "%d", (hits != nullptr) ? hits->nwscore : 0);
+          output.append_integer((hits != nullptr) ? hits->nwscore : 0);
           break;
         case 21: /* bits */
-          std::fprintf(output_handle, "%d", 0);
+          output.append_integer(0);
           break;
         case 22: /* aln */
           if (hits != nullptr)
             {
-              print_uncompressed_cigar(output_handle, Span<char>{hits->nwalignment, std::strlen(hits->nwalignment)});
+              print_uncompressed_cigar(output, Span<char>{hits->nwalignment, std::strlen(hits->nwalignment)});
             }
           break;
         case 23: /* caln */
           if (hits != nullptr)
             {
-              std::fprintf(output_handle, "%s", hits->nwalignment);
+              output.append(hits->nwalignment);
             }
           break;
         case 24: /* qstrand */
           if (hits != nullptr)
             {
-              std::fprintf(output_handle, "%c", (hits->strand != 0) ? '-' : '+');
+              output.append((hits->strand != 0) ? '-' : '+');
             }
           break;
         case 25: /* tstrand */
           if (hits != nullptr)
             {
-              std::fprintf(output_handle, "%c", '+');
+              output.append('+');
             }
           break;
         case 26: /* qrow */
@@ -463,9 +565,8 @@ auto results_show_userout_one(std::FILE * output_handle, struct hit const * hits
               auto const qrow = get_alignment_qrow(View<char>{query, std::strlen(query)},
                                              Span<char>{hits->nwalignment, std::strlen(hits->nwalignment)},
                                              hits->nwalignmentlength);
-              std::fprintf(output_handle, "%.*s",
-                      hits->internal_alignmentlength,
-                      &qrow[static_cast<std::size_t>(hits->trim_q_left + hits->trim_t_left)]);
+              output.append(&qrow[static_cast<std::size_t>(hits->trim_q_left + hits->trim_t_left)],
+                            static_cast<std::size_t>(hits->internal_alignmentlength));
             }
           break;
         case 27: /* trow */
@@ -474,60 +575,57 @@ auto results_show_userout_one(std::FILE * output_handle, struct hit const * hits
               auto const trow = get_alignment_trow(View<char>{tsequence, std::strlen(tsequence)},
                                              Span<char>{hits->nwalignment, std::strlen(hits->nwalignment)},
                                              hits->nwalignmentlength);
-              std::fprintf(output_handle, "%.*s",
-                      hits->internal_alignmentlength,
-                      &trow[static_cast<std::size_t>(hits->trim_q_left + hits->trim_t_left)]);
+              output.append(&trow[static_cast<std::size_t>(hits->trim_q_left + hits->trim_t_left)],
+                            static_cast<std::size_t>(hits->internal_alignmentlength));
             }
           break;
         case 28: /* qframe */
-          std::fprintf(output_handle, "+0");
+          output.append("+0");
           break;
         case 29: /* tframe */
-          std::fprintf(output_handle, "+0");
+          output.append("+0");
           break;
         case 30: /* mism */
-          std::fprintf(output_handle, "%d", (hits != nullptr) ? hits->mismatches : 0);
+          output.append_integer((hits != nullptr) ? hits->mismatches : 0);
           break;
         case 31: /* ids */
-          std::fprintf(output_handle, "%d", (hits != nullptr) ? hits->matches : 0);
+          output.append_integer((hits != nullptr) ? hits->matches : 0);
           break;
         case 32: /* qcov */
-          std::fprintf(output_handle, "%.1f",
-                  (hits != nullptr) ? 100.0 * (hits->matches + hits->mismatches) / static_cast<double>(qseqlen) : 0.0);
+          output.append_fixed1((hits != nullptr) ? 100.0 * (hits->matches + hits->mismatches) / static_cast<double>(qseqlen) : 0.0);
           break;
         case 33: /* tcov */
-          std::fprintf(output_handle, "%.1f",
-                  (hits != nullptr) ? 100.0 * (hits->matches + hits->mismatches) / static_cast<double>(tseqlen) : 0.0);
+          output.append_fixed1((hits != nullptr) ? 100.0 * (hits->matches + hits->mismatches) / static_cast<double>(tseqlen) : 0.0);
           break;
         case 34: /* id0 */
-          std::fprintf(output_handle, "%.1f", (hits != nullptr) ? hits->id0 : 0.0);
+          output.append_fixed1((hits != nullptr) ? hits->id0 : 0.0);
           break;
         case 35: /* id1 */
-          std::fprintf(output_handle, "%.1f", (hits != nullptr) ? hits->id1 : 0.0);
+          output.append_fixed1((hits != nullptr) ? hits->id1 : 0.0);
           break;
         case 36: /* id2 */
-          std::fprintf(output_handle, "%.1f", (hits != nullptr) ? hits->id2 : 0.0);
+          output.append_fixed1((hits != nullptr) ? hits->id2 : 0.0);
           break;
         case 37: /* id3 */
-          std::fprintf(output_handle, "%.1f", (hits != nullptr) ? hits->id3 : 0.0);
+          output.append_fixed1((hits != nullptr) ? hits->id3 : 0.0);
           break;
         case 38: /* id4 */
-          std::fprintf(output_handle, "%.1f", (hits != nullptr) ? hits->id4 : 0.0);
+          output.append_fixed1((hits != nullptr) ? hits->id4 : 0.0);
           break;
 
           /* new internal alignment coordinates */
 
         case 39: /* qilo */
-          std::fprintf(output_handle, "%d", (hits != nullptr) ? hits->trim_q_left + 1 : 0);
+          output.append_integer((hits != nullptr) ? hits->trim_q_left + 1 : 0);
           break;
         case 40: /* qihi */
-          std::fprintf(output_handle, "%" PRId64, (hits != nullptr) ? qseqlen - hits->trim_q_right : 0);
+          output.append_integer((hits != nullptr) ? qseqlen - hits->trim_q_right : 0);
           break;
         case 41: /* tilo */
-          std::fprintf(output_handle, "%d", (hits != nullptr) ? hits->trim_t_left + 1 : 0);
+          output.append_integer((hits != nullptr) ? hits->trim_t_left + 1 : 0);
           break;
         case 42: /* tihi */
-          std::fprintf(output_handle, "%" PRId64, (hits != nullptr) ? tseqlen - hits->trim_t_right : 0);
+          output.append_integer((hits != nullptr) ? tseqlen - hits->trim_t_right : 0);
           break;
         default:
           /* userfields_requested only ever holds validated indices (0..42),
@@ -538,15 +636,35 @@ auto results_show_userout_one(std::FILE * output_handle, struct hit const * hits
           fatal("Internal error: unknown userfield index in results_show_userout_one");
         }
     }
-  std::fprintf(output_handle, "\n");
+  output.append('\n');
 }
 
 
-auto results_show_lcaout(std::FILE * output_handle,
+auto results_show_userout_one(std::FILE * output_handle, struct hit const * hits,
+                              char const * query_head,
+                              char const * qsequence, int64_t const qseqlen,
+                              char const * qsequence_rc,
+                              struct Database const & db,
+                              struct Parameters const & parameters) -> void
+{
+  Output_buffer output;
+  results_show_userout_one(output,
+                           hits,
+                           query_head,
+                           qsequence,
+                           qseqlen,
+                           qsequence_rc,
+                           db,
+                           parameters);
+  output.write(output_handle);
+}
+
+
+auto results_show_lcaout(Output_buffer & output,
                          struct hit const * hits,
                          int const hitcount,
                          char const * query_head,
-                         struct Database const & db,
+                         Taxonomy const & taxonomy,
                          struct Parameters const & parameters) -> void
 {
   /* Output last common ancestor (LCA) of the hits,
@@ -555,24 +673,33 @@ auto results_show_lcaout(std::FILE * output_handle,
   /* Use a modified Boyer-Moore majority voting algorithm at each taxonomic
      level to find the most common name at each level */
 
-  std::fprintf(output_handle, "%s\t", query_head);
+  output.appendf("%s\t", query_head);
 
   if (hitcount == 0) {
-    std::fprintf(output_handle, "\n");
+    output.append('\n');
     return;
   }
 
   constexpr auto levels = static_cast<std::size_t>(tax_levels);
   std::array<int, tax_levels> votes {{}};
-  std::array<int, tax_levels> cand;
-  cand.fill(-1);
-  std::array<std::array<int, tax_levels>, tax_levels> cand_level_start {{}};
-  std::array<std::array<int, tax_levels>, tax_levels> cand_level_len {{}};
+  std::array<std::array<unsigned int, tax_levels>, tax_levels> cand_level_name {{}};
   std::array<int, tax_levels> level_match {{}};
 
   auto const top_hit_id = hits[0].id;
   auto tophitcount = 0;
 
+  /* do the names of a hit match those of a candidate up to level k? */
+  auto const matches = [&](uint64_t const seqno, std::size_t const k) -> bool {
+    for (std::size_t j = 0; j <= k; ++j)
+      {
+        if (taxonomy.name_id(seqno, static_cast<int>(j)) != cand_level_name[k][j])
+          {
+            return false;
+          }
+      }
+    return true;
+  };
+
   for (auto t = 0; t < hitcount; ++t)
     {
       struct hit const * hp = hits + t;
@@ -584,45 +711,25 @@ auto results_show_lcaout(std::FILE * output_handle,
 
       ++tophitcount;
 
-      int const seqno = hp->target;
-      std::array<int, tax_levels> new_level_start {{}};  // refactoring: std::array<struct a_level{.start, .length}, tax_levels>
-      std::array<int, tax_levels> new_level_len {{}};
-      tax_split(seqno, new_level_start.data(), new_level_len.data(), db);
+      auto const seqno = static_cast<uint64_t>(hp->target);
 
       for (std::size_t k = 0; k < levels; ++k)
         {
           if (votes[k] == 0)
             {
-              cand[k] = seqno;
               votes[k] = 1;
               for (std::size_t j = 0; j < levels; ++j)
                 {
-                  cand_level_start[k][j] = new_level_start[j];
-                  cand_level_len[k][j] = new_level_len[j];
+                  cand_level_name[k][j] = taxonomy.name_id(seqno, static_cast<int>(j));
                 }
             }
+          else if (matches(seqno, k))
+            {
+              ++votes[k];
+            }
           else
             {
-              auto match = true;
-              for (std::size_t j = 0; j <= k; ++j)
-                {
-                  if ((new_level_len[j] != cand_level_len[k][j]) or
-                      (std::strncmp(db.getheader(static_cast<uint64_t>(cand[k])) + cand_level_start[k][j],
-                               db.getheader(static_cast<uint64_t>(seqno)) + new_level_start[j],
-                               static_cast<std::size_t>(new_level_len[j])) != 0))
-                    {
-                      match = false;
-                      break;
-                    }
-                }
-              if (match)
-                {
-                  ++votes[k];
-                }
-              else
-                {
-                  --votes[k];
-                }
+              --votes[k];
             }
         }
     }
@@ -631,26 +738,11 @@ auto results_show_lcaout(std::FILE * output_handle,
 
   for (auto t = 0; t < tophitcount; ++t)
     {
-      auto const seqno = hits[t].target;
-      std::array<int, tax_levels> new_level_start {{}};
-      std::array<int, tax_levels> new_level_len {{}};
-      tax_split(seqno, new_level_start.data(), new_level_len.data(), db);
+      auto const seqno = static_cast<uint64_t>(hits[t].target);
 
       for (std::size_t k = 0; k < levels; ++k)
         {
-          auto match = true;
-          for (std::size_t j = 0; j <= k; ++j)
-            {
-              if ((new_level_len[j] != cand_level_len[k][j]) or
-                  (std::strncmp(db.getheader(static_cast<uint64_t>(cand[k])) + cand_level_start[k][j],
-                           db.getheader(static_cast<uint64_t>(seqno)) + new_level_start[j],
-                           static_cast<std::size_t>(new_level_len[j])) != 0))
-                {
-                  match = false;
-                  break;
-                }
-            }
-          if (match)
+          if (matches(seqno, k))
             {
               ++level_match[k];
             }
@@ -660,7 +752,7 @@ auto results_show_lcaout(std::FILE * output_handle,
   /* output results */
 
   if (tophitcount == 0) {
-    std::fprintf(output_handle, "\n");
+    output.append('\n');
     return;
   }
   auto comma = false;
@@ -671,23 +763,42 @@ auto results_show_lcaout(std::FILE * output_handle,
           break;
         }
 
-      if (cand_level_len[j][j] > 0)
+      auto const name = cand_level_name[j][j];
+      if (taxonomy.name_length(name) > 0)
         {
-          std::fprintf(output_handle,
+          output.appendf(
                   "%s%c:%.*s",
                   (comma ? "," : ""),
                   taxonomic_fields[j],
-                  cand_level_len[j][j],
-                  db.getheader(static_cast<uint64_t>(cand[j])) + cand_level_start[j][j]);
+                  taxonomy.name_length(name),
+                  taxonomy.name(name));
           comma = true;
         }
     }
 
-  std::fprintf(output_handle, "\n");
+  output.append('\n');
 }
 
 
-auto results_show_alnout(std::FILE * output_handle,
+auto results_show_lcaout(std::FILE * output_handle,
+                         struct hit const * hits,
+                         int const hitcount,
+                         char const * query_head,
+                         Taxonomy const & taxonomy,
+                         struct Parameters const & parameters) -> void
+{
+  Output_buffer output;
+  results_show_lcaout(output,
+                      hits,
+                      hitcount,
+                      query_head,
+                      taxonomy,
+                      parameters);
+  output.write(output_handle);
+}
+
+
+auto results_show_alnout(Output_buffer & output,
                          struct hit const * hits,
                          int const hitcount,
                          char const * query_head,
@@ -700,18 +811,18 @@ auto results_show_alnout(std::FILE * output_handle,
 
   if (hitcount == 0) {
     if (parameters.opt_output_no_hits != 0) {
-      std::fprintf(output_handle, "\n");
-      std::fprintf(output_handle,"Query >%s\n", query_head);
-      std::fprintf(output_handle, "No hits\n");
+      output.append('\n');
+      output.appendf("Query >%s\n", query_head);
+      output.append("No hits\n");
     }
     return;
   }
 
 
-  std::fprintf(output_handle, "\n");
+  output.append('\n');
 
-  std::fprintf(output_handle,"Query >%s\n", query_head);
-  std::fprintf(output_handle," %%Id   TLen  Target\n");
+  output.appendf("Query >%s\n", query_head);
+  output.appendf(" %%Id   TLen  Target\n");
 
   auto const top_hit_id = hits[0].id;
 
@@ -725,7 +836,7 @@ auto results_show_alnout(std::FILE * output_handle,
         }
 
       auto const target = static_cast<uint64_t>(hp->target);
-      std::fprintf(output_handle,"%3.0f%% %6" PRIu64 "  %s\n",
+      output.appendf("%3.0f%% %6" PRIu64 "  %s\n",
               hp->id,
               db.getsequencelen(target),
               db.getheader(target));
@@ -740,7 +851,7 @@ auto results_show_alnout(std::FILE * output_handle,
           break;
         }
 
-      std::fprintf(output_handle,"\n");
+      output.append('\n');
 
 
       auto const target = static_cast<uint64_t>(hp->target);
@@ -751,14 +862,14 @@ auto results_show_alnout(std::FILE * output_handle,
       auto const tlenlen = std::snprintf(nullptr, 0, "%" PRId64, dseqlen);
       auto const numwidth = std::max(qlenlen, tlenlen);
 
-      std::fprintf(output_handle," Query %*" PRId64 "nt >%s\n", numwidth,
+      output.appendf(" Query %*" PRId64 "nt >%s\n", numwidth,
               qseqlen, query_head);
-      std::fprintf(output_handle,"Target %*" PRId64 "nt >%s\n", numwidth,
+      output.appendf("Target %*" PRId64 "nt >%s\n", numwidth,
               dseqlen, db.getheader(target));
 
       int64_t const rowlen = (parameters.opt_rowlen == 0) ? (qseqlen + dseqlen) : parameters.opt_rowlen;
 
-      align_show(output_handle,
+      align_show(output,
                  qsequence,
                  qseqlen,
                  hp->trim_q_left,
@@ -776,7 +887,7 @@ auto results_show_alnout(std::FILE * output_handle,
                  hp->strand,
                  parameters);
 
-      std::fprintf(output_handle, "\n%d cols, %d ids (%3.1f%%), %d gaps (%3.1f%%)\n",
+      output.appendf("\n%d cols, %d ids (%3.1f%%), %d gaps (%3.1f%%)\n",
               hp->internal_alignmentlength,
               hp->matches,
               hp->id,
@@ -788,6 +899,28 @@ auto results_show_alnout(std::FILE * output_handle,
 }
 
 
+auto results_show_alnout(std::FILE * output_handle,
+                         struct hit const * hits,
+                         int const hitcount,
+                         char const * query_head,
+                         char const * qsequence,
+                         int64_t const qseqlen,
+                         struct Database const & db,
+                         struct Parameters const & parameters) -> void
+{
+  Output_buffer output;
+  results_show_alnout(output,
+                      hits,
+                      hitcount,
+                      query_head,
+                      qsequence,
+                      qseqlen,
+                      db,
+                      parameters);
+  output.write(output_handle);
+}
+
+
 auto build_sam_strings(char const * alignment,
                        char const * queryseq,
                        int64_t const queryseqlen,
@@ -951,7 +1084,7 @@ auto results_show_samheader(std::FILE * output_handle,
 }
 
 
-auto results_show_samout(std::FILE * output_handle,
+auto results_show_samout(Output_buffer & output,
                          struct hit const * hits,
                          int const hitcount,
                          char const * query_head,
@@ -999,7 +1132,7 @@ auto results_show_samout(std::FILE * output_handle,
 
   if (hitcount == 0) {
     if (parameters.opt_output_no_hits != 0) {
-      std::fprintf(output_handle,
+      output.appendf(
               "%s\t%d\t%s\t%" PRIu64 "\t%d\t%s\t%s\t%" PRIu64 "\t%" PRIu64 "\t%s\t%s\n",
               query_head,
               0x04,
@@ -1041,7 +1174,7 @@ auto results_show_samout(std::FILE * output_handle,
                         cigar,
                         md);
 
-      std::fprintf(output_handle,
+      output.appendf(
               "%s\t%d\t%s\t%" PRIu64
               "\t%d\t%s\t%s\t%" PRIu64
               "\t%" PRIu64
@@ -1069,3 +1202,25 @@ auto results_show_samout(std::FILE * output_handle,
               "UU");
     }
 }
+
+
+auto results_show_samout(std::FILE * output_handle,
+                         struct hit const * hits,
+                         int const hitcount,
+                         char const * query_head,
+                         char const * qsequence,
+                         char const * qsequence_rc,
+                         struct Database const & db,
+                         struct Parameters const & parameters) -> void
+{
+  Output_buffer output;
+  results_show_samout(output,
+                      hits,
+                      hitcount,
+                      query_head,
+                      qsequence,
+                      qsequence_rc,
+                      db,
+                      parameters);
+  output.write(output_handle);
+}
@@ -60,11 +60,25 @@
 
 #pragma once
 
+#include "utils/output_buffer.hpp"
 #include <cstdio>  // std::FILE
 #include <cstdint>  // int64_t
 
 
 struct Database;
+class Taxonomy;
+
+/* The result formatters append to an output buffer; the overloads taking
+   a file write the same text to it directly. */
+
+auto results_show_alnout(Output_buffer & output,
+                         struct hit const * hits,
+                         int hitcount,
+                         char const * query_head,
+                         char const * qsequence,
+                         int64_t qseqlen,
+                         struct Database const & db,
+                         struct Parameters const & parameters) -> void;
 
 auto results_show_alnout(std::FILE * output_handle,
                          struct hit const * hits,
@@ -75,19 +89,40 @@ auto results_show_alnout(std::FILE * output_handle,
                          struct Database const & db,
                          struct Parameters const & parameters) -> void;
 
+auto results_show_lcaout(Output_buffer & output,
+                         struct hit const * hits,
+                         int hitcount,
+                         char const * query_head,
+                         Taxonomy const & taxonomy,
+                         struct Parameters const & parameters) -> void;
+
 auto results_show_lcaout(std::FILE * output_handle,
                          struct hit const * hits,
                          int hitcount,
                          char const * query_head,
-                         struct Database const & db,
+                         Taxonomy const & taxonomy,
                          struct Parameters const & parameters) -> void;
 
+auto results_show_blast6out_one(Output_buffer & output,
+                                struct hit const * hits,
+                                char const * query_head,
+                                int64_t qseqlen,
+                                struct Database const & db) -> void;
+
 auto results_show_blast6out_one(std::FILE * output_handle,
                                 struct hit const * hits,
                                 char const * query_head,
                                 int64_t qseqlen,
                                 struct Database const & db) -> void;
 
+auto results_show_uc_one(Output_buffer & output,
+                         struct hit const * hits,
+                         char const * query_head,
+                         int64_t qseqlen,
+                         int clusterno,
+                         struct Database const & db,
+                         struct Parameters const & parameters) -> void;
+
 auto results_show_uc_one(std::FILE * output_handle,
                          struct hit const * hits,
                          char const * query_head,
@@ -96,6 +131,15 @@ auto results_show_uc_one(std::FILE * output_handle,
                          struct Database const & db,
                          struct Parameters const & parameters) -> void;
 
+auto results_show_userout_one(Output_buffer & output,
+                              struct hit const * hits,
+                              char const * query_head,
+                              char const * qsequence,
+                              int64_t qseqlen,
+                              char const * qsequence_rc,
+                              struct Database const & db,
+                              struct Parameters const & parameters) -> void;
+
 auto results_show_userout_one(std::FILE * output_handle,
                               struct hit const * hits,
                               char const * query_head,
@@ -105,6 +149,14 @@ auto results_show_userout_one(std::FILE * output_handle,
                               struct Database const & db,
                               struct Parameters const & parameters) -> void;
 
+auto results_show_fastapairs_one(Output_buffer & output,
+                                 struct hit const * hits,
+                                 char const * query_head,
+                                 char const * qsequence,
+                                 char const * qsequence_rc,
+                                 struct Database const & db,
+                                 struct Parameters const & parameters) -> void;
+
 auto results_show_fastapairs_one(std::FILE * output_handle,
                                  struct hit const * hits,
                                  char const * query_head,
@@ -113,6 +165,14 @@ auto results_show_fastapairs_one(std::FILE * output_handle,
                                  struct Database const & db,
                                  struct Parameters const & parameters) -> void;
 
+auto results_show_qsegout_one(Output_buffer & output,
+                              struct hit const * hits,
+                              char const * query_head,
+                              char const * qsequence,
+                              int64_t qseqlen,
+                              char const * qsequence_rc,
+                              struct Parameters const & parameters) -> void;
+
 auto results_show_qsegout_one(std::FILE * output_handle,
                               struct hit const * hits,
                               char const * query_head,
@@ -121,6 +181,11 @@ auto results_show_qsegout_one(std::FILE * output_handle,
                               char const * qsequence_rc,
                               struct Parameters const & parameters) -> void;
 
+auto results_show_tsegout_one(Output_buffer & output,
+                              struct hit const * hits,
+                              struct Database const & db,
+                              struct Parameters const & parameters) -> void;
+
 auto results_show_tsegout_one(std::FILE * output_handle,
                               struct hit const * hits,
                               struct Database const & db,
@@ -131,6 +196,15 @@ auto results_show_samheader(std::FILE * output_handle,
                             struct Database const & db,
                             struct Parameters const & parameters) -> void;
 
+auto results_show_samout(Output_buffer & output,
+                         struct hit const * hits,
+                         int hitcount,
+                         char const * query_head,
+                         char const * qsequence,
+                         char const * qsequence_rc,
+                         struct Database const & db,
+                         struct Parameters const & parameters) -> void;
+
 auto results_show_samout(std::FILE * output_handle,
                          struct hit const * hits,
                          int hitcount,
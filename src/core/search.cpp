@@ -72,6 +72,8 @@
 #include "utils/threads.hpp"
 #include "utils/worker_loop.hpp"
 #include "utils/reverse_complement.hpp"
+#include <algorithm>  // std::min, std::max
+#include <array>
 #include <cstdint>  // uint64_t, int64_t
 #include <cstring>  // std::strlen, std::strcpy
 #include <memory>  // std::unique_ptr
@@ -125,7 +127,7 @@ auto populate_si(struct searchinfo_s * si,
 }
 
 
-auto search_thread_init(struct searchinfo_s * si, int const seqcount, int const tophits,
+auto search_thread_init(struct searchinfo_s * si, int const tophits,
                         struct Parameters const & parameters,
                         struct Dbindex const & dbindex,
                         struct Database const & db) -> void
@@ -135,7 +137,7 @@ auto search_thread_init(struct searchinfo_s * si, int const seqcount, int const
   si->dbindex = &dbindex;  /* searchcore reads the k-mer index through the si */
   si->db = &db;  /* searchcore reads the sequences through the si */
   si->uh = unique_init();
-  si->kmers = static_cast<count_t *>(xmalloc((static_cast<size_t>(seqcount) * sizeof(count_t)) + 32));
+  si->kmers = nullptr;  // allocated by search_topscores when first needed
   si->m = minheap_init(tophits);
   si->hits = static_cast<struct hit *>(xmalloc
     (sizeof(struct hit) * static_cast<size_t>(tophits) * static_cast<size_t>(number_of_strands(parameters.opt_strand))));
@@ -158,7 +160,8 @@ auto search_thread_init(struct searchinfo_s * si, int const seqcount, int const
                         parameters.opt_gap_extension_target_interior,
                         parameters.opt_gap_extension_query_right,
                         parameters.opt_gap_extension_target_right,
-                        parameters.opt_n_mismatch);
+                        parameters.opt_n_mismatch,
+                        search16_select_channels(parameters));
 }
 
 
@@ -169,7 +172,10 @@ auto search_thread_exit(struct searchinfo_s * si) -> void
   unique_exit(si->uh);
   xfree(si->hits);
   minheap_exit(si->m);
-  xfree(si->kmers);
+  if (si->kmers != nullptr)
+    {
+      xfree(si->kmers);
+    }
   if (si->query_head != nullptr)
     {
       xfree(si->query_head);
@@ -181,6 +187,42 @@ auto search_thread_exit(struct searchinfo_s * si) -> void
 }
 
 
+auto search_find_candidates(struct searchinfo_s * si_plus,
+                            struct searchinfo_s * si_minus,
+                            int const queries,
+                            struct Parameters const & parameters) -> void
+{
+  static_assert(2 * search_queries_per_batch <= topscores_batch_max,
+                "both strands of a batch must fit search_topscores_batch");
+
+  std::array<struct searchinfo_s *, topscores_batch_max> batch {{}};
+  unsigned int count = 0;
+
+  for (int q = 0; q < queries; q++)
+    {
+      /* Mask and search each strand independently */
+      for (int s = 0; s < number_of_strands(parameters.opt_strand); s++)
+        {
+          struct searchinfo_s * si = (s != 0) ? si_minus + q : si_plus + q;
+
+          if (parameters.opt_qmask == Masking::dust)
+            {
+              dust(si->qsequence, si->qseqlen, parameters);
+            }
+          else if ((parameters.opt_qmask == Masking::soft) && (parameters.opt_hardmask))
+            {
+              hardmask(si->qsequence, si->qseqlen);
+            }
+
+          search_query_kmers(si, parameters.opt_qmask);
+          batch[count++] = si;
+        }
+    }
+
+  search_topscores_batch(batch.data(), count);
+}
+
+
 /* === Session-based search API (supports both-strand search) === */
 
 
@@ -239,13 +281,13 @@ auto search_session_init(struct search_session_s * ss, struct Parameters const &
     }
 
   ss->si_plus = make_unique<searchinfo_s>();
-  search_thread_init(ss->si_plus.get(), ss->seqcount, ss->tophits, parameters, *ss->dbindex, *ss->db);
+  search_thread_init(ss->si_plus.get(), ss->tophits, parameters, *ss->dbindex, *ss->db);
   ss->si_plus->strand = 0;
 
   if (parameters.opt_strand)
     {
       ss->si_minus = make_unique<searchinfo_s>();
-      search_thread_init(ss->si_minus.get(), ss->seqcount, ss->tophits, parameters, *ss->dbindex, *ss->db);
+      search_thread_init(ss->si_minus.get(), ss->tophits, parameters, *ss->dbindex, *ss->db);
       ss->si_minus->strand = 1;
     }
 }
@@ -380,7 +422,8 @@ struct search_batch_context_s {
   int max_results_per_query;
   int * result_counts;
 
-  /* per-thread search state arrays (sized to opt_threads) */
+  /* per-thread search state arrays (search_queries_per_batch slots per
+     thread) */
   struct searchinfo_s * batch_si_plus;
   struct searchinfo_s * batch_si_minus;  /* nullptr when searching the plus strand only */
 
@@ -391,120 +434,130 @@ struct search_batch_context_s {
   /* work-stealing counter */
   std::mutex mutex;
   int next_query;
+  int threads;
 };
 
 
 static auto search_batch_worker_fn(struct search_batch_context_s & ctx,
                                    uint64_t tid) -> void
 {
-  struct searchinfo_s * my_si_plus = ctx.batch_si_plus + tid;
+  /* search_queries_per_batch searchinfo slots per thread and strand */
+  struct searchinfo_s * my_si_plus = ctx.batch_si_plus + (tid * search_queries_per_batch);
   struct searchinfo_s * my_si_minus =
-    (ctx.batch_si_minus != nullptr) ? ctx.batch_si_minus + tid : nullptr;
+    (ctx.batch_si_minus != nullptr) ? ctx.batch_si_minus + (tid * search_queries_per_batch) : nullptr;
   struct Parameters const & parameters = *ctx.parameters;
 
-  /* grab next query */
-  int qi {0};
+  /* grab the next queries, fewer near the end so that every thread
+     still gets some */
+  int first {0};
+  int claimed {0};
 
   auto const has_work_to_claim = [&]() -> bool {
-    qi = ctx.next_query++;
-    return qi < ctx.query_count;
+    first = ctx.next_query;
+    int const remaining = ctx.query_count - first;
+    claimed = std::min(search_queries_per_batch,
+                       std::max(1, remaining / ctx.threads));
+    ctx.next_query += claimed;
+    return remaining > 0;
   };
 
-  auto const process_query = [&]() {
-    char const * qseq = ctx.query_seqs[qi];
-    char const * qhead = ctx.query_heads[qi];
-    int const qlen = ctx.query_lens[qi];
-    int64_t const qsize = ctx.query_sizes[qi];
-    int const head_len = static_cast<int>(std::strlen(qhead));
-
-    populate_si(my_si_plus,
-                qhead,
-                head_len,
-                qseq,
-                qlen,
-                qi,
-                qsize,
-                0);
-
-    if (my_si_minus != nullptr)
+  auto const process_queries = [&]() {
+    for (int j = 0; j < claimed; j++)
       {
-        populate_si(my_si_minus,
+        int const qi = first + j;
+        char const * qseq = ctx.query_seqs[qi];
+        char const * qhead = ctx.query_heads[qi];
+        int const qlen = ctx.query_lens[qi];
+        int64_t const qsize = ctx.query_sizes[qi];
+        int const head_len = static_cast<int>(std::strlen(qhead));
+
+        populate_si(my_si_plus + j,
                     qhead,
                     head_len,
                     qseq,
                     qlen,
                     qi,
                     qsize,
-                    1);
+                    0);
+
+        if (my_si_minus != nullptr)
+          {
+            populate_si(my_si_minus + j,
+                        qhead,
+                        head_len,
+                        qseq,
+                        qlen,
+                        qi,
+                        qsize,
+                        1);
+          }
       }
 
-    /* Mask and search each strand independently */
-    for (int s = 0; s < number_of_strands(parameters.opt_strand); s++)
+    search_find_candidates(my_si_plus, my_si_minus, claimed, parameters);
+
+    for (int j = 0; j < claimed; j++)
       {
-        struct searchinfo_s * strand_si =
-          (s != 0) ? my_si_minus : my_si_plus;
+        int const qi = first + j;
+        int const qlen = ctx.query_lens[qi];
+        struct searchinfo_s * query_si_plus = my_si_plus + j;
+        struct searchinfo_s * query_si_minus =
+          (my_si_minus != nullptr) ? my_si_minus + j : nullptr;
 
-        if (parameters.opt_qmask == Masking::dust)
-          {
-            dust(strand_si->qsequence, strand_si->qseqlen, parameters);
-          }
-        else if ((parameters.opt_qmask == Masking::soft) && (parameters.opt_hardmask))
+        for (int s = 0; s < number_of_strands(parameters.opt_strand); s++)
           {
-            hardmask(strand_si->qsequence, strand_si->qseqlen);
+            search_align_candidates((s != 0) ? query_si_minus : query_si_plus);
           }
 
-        search_onequery(strand_si, parameters.opt_qmask);
-      }
-
-    /* Merge hits from both strands */
-    std::vector<struct hit> hits;
-    search_joinhits(my_si_plus,
-                    parameters.opt_strand ? my_si_minus : nullptr,
-                    hits);
-
-    /* Populate results for this query */
-    struct search_result_s * qresults =
-      ctx.results + qi * ctx.max_results_per_query;
-    int count = 0;
-    for (auto const & h : hits)
-      {
-        if (count >= ctx.max_results_per_query)
+        /* Merge hits from both strands */
+        std::vector<struct hit> hits;
+        search_joinhits(query_si_plus,
+                        parameters.opt_strand ? query_si_minus : nullptr,
+                        hits);
+
+        /* Populate results for this query */
+        struct search_result_s * qresults =
+          ctx.results + qi * ctx.max_results_per_query;
+        int count = 0;
+        for (auto const & h : hits)
           {
-            break;
+            if (count >= ctx.max_results_per_query)
+              {
+                break;
+              }
+            auto & r = qresults[count];
+            r.target = h.target;
+            r.id = h.id;
+            r.matches = h.matches;
+            r.mismatches = h.mismatches;
+            r.gaps = h.nwgaps;
+            r.alignment_length = h.nwalignmentlength;
+            r.query_length = qlen;
+            r.target_length = static_cast<int>(query_si_plus->db->getsequencelen(static_cast<uint64_t>(h.target)));
+            r.accepted = h.accepted;
+            r.strand = h.strand;
+            ++count;
           }
-        auto & r = qresults[count];
-        r.target = h.target;
-        r.id = h.id;
-        r.matches = h.matches;
-        r.mismatches = h.mismatches;
-        r.gaps = h.nwgaps;
-        r.alignment_length = h.nwalignmentlength;
-        r.query_length = qlen;
-        r.target_length = static_cast<int>(my_si_plus->db->getsequencelen(static_cast<uint64_t>(h.target)));
-        r.accepted = h.accepted;
-        r.strand = h.strand;
-        ++count;
-      }
-    ctx.result_counts[qi] = count;
+        ctx.result_counts[qi] = count;
 
-    /* Free alignment strings from si->hits directly */
-    for (int s = 0; s < number_of_strands(parameters.opt_strand); s++)
-      {
-        struct searchinfo_s * strand_si =
-          (s != 0) ? my_si_minus : my_si_plus;
-        for (int i = 0; i < strand_si->hit_count; ++i)
+        /* Free alignment strings from si->hits directly */
+        for (int s = 0; s < number_of_strands(parameters.opt_strand); s++)
           {
-            if (strand_si->hits[i].aligned &&
-                strand_si->hits[i].nwalignment != nullptr)
+            struct searchinfo_s * strand_si =
+              (s != 0) ? query_si_minus : query_si_plus;
+            for (int i = 0; i < strand_si->hit_count; ++i)
               {
-                xfree(strand_si->hits[i].nwalignment);
-                strand_si->hits[i].nwalignment = nullptr;
+                if (strand_si->hits[i].aligned &&
+                    strand_si->hits[i].nwalignment != nullptr)
+                  {
+                    xfree(strand_si->hits[i].nwalignment);
+                    strand_si->hits[i].nwalignment = nullptr;
+                  }
               }
           }
       }
   };
 
-  run_worker_loop(ctx.mutex, has_work_to_claim, process_query);
+  run_worker_loop(ctx.mutex, has_work_to_claim, process_queries);
 }
 
 
@@ -545,11 +598,13 @@ auto search_batch(struct Parameters const & parameters,
   ctx.result_counts = result_counts;
   ctx.parameters = &parameters;
   ctx.next_query = 0;
+  ctx.threads = nthreads;
 
-  ctx.batch_si_plus = new searchinfo_s[nthreads]{};
+  int const slots = nthreads * search_queries_per_batch;
+  ctx.batch_si_plus = new searchinfo_s[slots]{};
   if (parameters.opt_strand)
     {
-      ctx.batch_si_minus = new searchinfo_s[nthreads]{};
+      ctx.batch_si_minus = new searchinfo_s[slots]{};
     }
   else
     {
@@ -557,12 +612,12 @@ auto search_batch(struct Parameters const & parameters,
     }
 
   /* Init per-thread search state before the workers start */
-  for (int t = 0; t < nthreads; t++)
+  for (int t = 0; t < slots; t++)
     {
-      search_thread_init(ctx.batch_si_plus + t, seqcount, tophits, parameters, dbindex, db);
+      search_thread_init(ctx.batch_si_plus + t, tophits, parameters, dbindex, db);
       if (ctx.batch_si_minus != nullptr)
         {
-          search_thread_init(ctx.batch_si_minus + t, seqcount, tophits, parameters, dbindex, db);
+          search_thread_init(ctx.batch_si_minus + t, tophits, parameters, dbindex, db);
         }
     }
 
@@ -576,7 +631,7 @@ auto search_batch(struct Parameters const & parameters,
   }
 
   /* clean up per-thread search state */
-  for (int t = 0; t < nthreads; t++)
+  for (int t = 0; t < slots; t++)
     {
       search_thread_exit(ctx.batch_si_plus + t);
       if (ctx.batch_si_minus != nullptr)
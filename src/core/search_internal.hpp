@@ -67,6 +67,13 @@
 
 #include <cstdint>  // int64_t
 
+
+struct Parameters;
+
+/* the number of queries a search worker claims at a time, so that
+   search_find_candidates() counts their k-mers together */
+constexpr auto search_queries_per_batch = 8;
+
 auto populate_si(struct searchinfo_s * si,
                  const char * head,
                  int head_len,
@@ -76,9 +83,18 @@ auto populate_si(struct searchinfo_s * si,
                  int64_t qsize,
                  int strand) -> void;
 
-auto search_thread_init(struct searchinfo_s * si, int const seqcount, int const tophits,
+auto search_thread_init(struct searchinfo_s * si, int const tophits,
                         struct Parameters const & parameters,
                         struct Dbindex const & dbindex,
                         struct Database const & db) -> void;
 
 auto search_thread_exit(struct searchinfo_s * si) -> void;
+
+/* Mask the queries in si_plus[0 .. queries-1] (and their minus strands in
+   si_minus, unless null), extract their k-mers and find their candidate
+   targets in one search_topscores_batch() pass. The caller then aligns
+   each strand with search_align_candidates(). */
+auto search_find_candidates(struct searchinfo_s * si_plus,
+                            struct searchinfo_s * si_minus,
+                            int queries,
+                            struct Parameters const & parameters) -> void;
@@ -65,6 +65,7 @@
 #include "core/minheap.hpp"
 #include "core/otutable.hpp"
 #include "core/unique.hpp"
+#include "utils/maps.hpp"
 #include "utils/seqcmp.hpp"
 #include "utils/span.hpp"
 #include "utils/string_alloc.hpp"
@@ -78,6 +79,7 @@
 #include <cstdlib>  // std::qsort
 #include <cstring>  // std::strlen, std::memset, std::strcmp
 #include <limits>
+#include <utility>  // std::pair
 #include <vector>
 
 
@@ -124,6 +126,90 @@ namespace {
     }
   }
 
+
+  /* sequences per flag of the searchinfo_s touched array; a byte per
+     flag, as a bitmap would chain the updates through memory */
+  constexpr auto touched_block = 16U;
+
+
+  inline auto mark_touched(unsigned char * touched, unsigned int const index) -> void {
+    touched[index / touched_block] = 1;
+  }
+
+
+  /* Whether to track the touched blocks of the query: only when its
+     posting lists are short enough to touch fewer blocks than a scan of
+     all the counters costs. A k-mer with a bitmap matches at least one in
+     eight of the sequences. Never when no k-mer match is required (a
+     query without unmasked k-mers), as every sequence is then a
+     candidate, touched or not. */
+  auto sparse_counting(struct searchinfo_s const * searchinfo,
+                       unsigned int const indexed_count) -> bool {
+    auto const minmatches = std::min(static_cast<unsigned int>(searchinfo->parameters->opt_minwordmatches),
+                                     searchinfo->kmersamplecount);
+    if (minmatches == 0)
+      {
+        return false;
+      }
+    auto postings = std::size_t{0};
+    for (auto i = 0U; i < searchinfo->kmersamplecount; i++)
+      {
+        auto const kmer = searchinfo->kmersample[i];
+        postings += (searchinfo->dbindex->getbitmap(kmer) != nullptr) ?
+          indexed_count : searchinfo->dbindex->getmatchcount(kmer);
+      }
+    return postings * touched_block < indexed_count;
+  }
+
+
+  /* number of touched flags for a number of sequences */
+  auto touched_blocks(unsigned int const sequences) -> std::size_t {
+    return (sequences + touched_block - 1) / touched_block;
+  }
+
+
+  /* offer the indexed sequence to the heap of top k-mer matches */
+  auto add_candidate(struct searchinfo_s * searchinfo, unsigned int const indexed,
+                     count_t const count) -> void {
+    auto const seqno = searchinfo->dbindex->getmapping(indexed);
+    elem_t novel;
+    novel.count = count;
+    novel.seqno = seqno;
+    novel.length = static_cast<unsigned int>(searchinfo->db->getsequencelen(seqno));
+    minheap_add(searchinfo->m, & novel);
+  }
+
+
+  /* offer the sequences of the touched blocks among the sequences
+     [start, start + length) with counters[0 .. length-1] to the heap, and
+     clear their counters and touched flags */
+  auto add_touched_candidates(struct searchinfo_s * searchinfo,
+                              count_t * counters,
+                              unsigned int const start,
+                              unsigned int const length,
+                              unsigned int const minmatches) -> void {
+    auto * touched = searchinfo->touched.data();
+    for (auto block = 0UL; block < touched_blocks(length); block++)
+      {
+        if (touched[block] == 0)
+          {
+            continue;
+          }
+        touched[block] = 0;
+        auto const first = block * touched_block;
+        auto const last = std::min(first + touched_block, static_cast<std::size_t>(length));
+        for (auto i = first; i < last; i++)
+          {
+            auto const count = counters[i];
+            counters[i] = 0;
+            if (count >= minmatches)
+              {
+                add_candidate(searchinfo, start + static_cast<unsigned int>(i), count);
+              }
+          }
+      }
+  }
+
 }  // end of anonymous namespace
 
 
@@ -270,10 +356,41 @@ auto search_topscores(struct searchinfo_s * searchinfo) -> void
   /* count kmer hits in the database sequences */
   unsigned int const indexed_count = searchinfo->dbindex->getcount();
 
-  /* zero counts */
-  std::memset(searchinfo->kmers, 0, indexed_count * sizeof(count_t));
+  /* allocated on first use, search_topscores_batch() needs none */
+  if (searchinfo->kmers == nullptr)
+    {
+      searchinfo->kmers = static_cast<count_t *>(xmalloc((indexed_count * sizeof(count_t)) + 32));
+      std::memset(searchinfo->kmers, 0, indexed_count * sizeof(count_t));
+    }
+
+  /*
+    The counters are zero on entry and are cleared again on exit. When
+    the posting lists of the query are short (sparse_counting()), only the
+    blocks of sequences they touch are thresholded and cleared, not the
+    whole database.
+  */
 
   minheap_clear(searchinfo->m);
+  if (searchinfo->touched.size() < touched_blocks(indexed_count))
+    {
+      searchinfo->touched.resize(touched_blocks(indexed_count), 0);
+    }
+  auto const sparse = sparse_counting(searchinfo, indexed_count);
+  auto * touched = sparse ? searchinfo->touched.data() : nullptr;
+
+  auto const count_match = [searchinfo, touched](unsigned int const indexed) -> void {
+    /* Saturate at INT16_MAX (32767) rather than letting the
+       unsigned-short counter wrap at 65536. The SIMD bitmap path
+       (increment_counters_from_bitmap*) increments these counters
+       with signed saturation and so caps at 32767; matching that
+       here keeps every counter in [0, 32767], where the two paths
+       agree and neither can wrap a high-overlap target's count back
+       to ~0 and silently drop it from the candidate set (the cap is
+       far above any realistic minwordmatches). */
+    count_t & counter = searchinfo->kmers[indexed];
+    if (counter < INT16_MAX) { ++counter; }
+    if (touched != nullptr) { mark_touched(touched, indexed); }
+  };
 
   for (auto i = 0U; i < searchinfo->kmersamplecount; i++)
     {
@@ -297,46 +414,319 @@ auto search_topscores(struct searchinfo_s * searchinfo) -> void
           increment_counters_from_bitmap(searchinfo->kmers, bitmap, indexed_count);
 #endif
         }
+      else if (searchinfo->dbindex->is_packed())
+        {
+          auto const * packed = searchinfo->dbindex->getpackedlist(kmer);
+          auto const count = searchinfo->dbindex->getmatchcount(kmer);
+          auto indexed = 0U;
+          for (auto j = 0U; j < count; j++)
+            {
+              indexed += unpack_gap(packed);
+              count_match(indexed);
+            }
+        }
       else
         {
           auto const * list = searchinfo->dbindex->getmatchlist(kmer);
           auto const count = searchinfo->dbindex->getmatchcount(kmer);
           for (auto j = 0U; j < count; j++)
             {
-              /* Saturate at INT16_MAX (32767) rather than letting the
-                 unsigned-short counter wrap at 65536. The SIMD bitmap path
-                 (increment_counters_from_bitmap*) increments these counters
-                 with signed saturation and so caps at 32767; matching that
-                 here keeps every counter in [0, 32767], where the two paths
-                 agree and neither can wrap a high-overlap target's count back
-                 to ~0 and silently drop it from the candidate set (the cap is
-                 far above any realistic minwordmatches). */
-              count_t & counter = searchinfo->kmers[list[j]];
-              if (counter < INT16_MAX) { ++counter; }
+              count_match(list[j]);
             }
         }
     }
 
   auto const minmatches = std::min(static_cast<unsigned int>(parameters.opt_minwordmatches), searchinfo->kmersamplecount);
 
-  for (auto i = 0U; i < indexed_count; i++)
+  if (sparse)
+    {
+      add_touched_candidates(searchinfo, searchinfo->kmers, 0, indexed_count, minmatches);
+    }
+  else
     {
-      auto const count = searchinfo->kmers[i];
-      if (count >= minmatches)
+      for (auto i = 0U; i < indexed_count; i++)
         {
-          auto const seqno = searchinfo->dbindex->getmapping(i);
-          unsigned int const length = static_cast<unsigned int>(searchinfo->db->getsequencelen(seqno));
+          auto const count = searchinfo->kmers[i];
+          searchinfo->kmers[i] = 0;
+          if (count >= minmatches)
+            {
+              add_candidate(searchinfo, i, count);
+            }
+        }
+    }
+
+  minheap_sort(searchinfo->m);
+}
+
+
+namespace {
+
+  /* number of counters of one tile of search_topscores_batch(): 256 kB,
+     so that a tile and the pieces of posting lists it reads stay in the
+     level 2 cache */
+  constexpr auto topscores_tile_counters = 131072U;
+
+
+  /* posting lists walked ahead of the current one within a tile */
+  constexpr auto topscores_prefetch_distance = 8UL;
 
-          elem_t novel;
-          novel.count = count;
-          novel.seqno = seqno;
-          novel.length = length;
 
-          minheap_add(searchinfo->m, & novel);
+  /* a k-mer sampled by some of the queries of a batch */
+  struct batch_kmer {
+    unsigned int kmer;
+    uint64_t queries;  // bit q: sampled by query q
+  };
+
+
+  /* the part of a posting list not yet counted: from next to last, or
+     in a packed index the remaining entries from current on */
+  struct batch_list {
+    unsigned int const * next;
+    unsigned int const * last;
+    uint64_t queries;
+    size_t piece;  // bytes of the list expected per tile
+    unsigned char const * packed;  // after current
+    unsigned int remaining;
+    unsigned int current;
+  };
+
+
+  /* call match with the indexed sequences of the list below end */
+  template <typename Function>
+  inline auto walk_list(batch_list & entry, unsigned int const end, Function match) -> void
+  {
+    if (entry.packed == nullptr)
+      {
+        for (; (entry.next < entry.last) and (*entry.next < end); ++entry.next)
+          {
+            match(*entry.next);
+          }
+        return;
+      }
+    while ((entry.remaining != 0) and (entry.current < end))
+      {
+        match(entry.current);
+        --entry.remaining;
+        if (entry.remaining != 0)
+          {
+            entry.current += unpack_gap(entry.packed);
+          }
+      }
+  }
+
+
+  /* add one to the counter of the indexed sequence of each query in the
+     set, in rows of stride counters starting at sequence start, and
+     mark its block as touched for the queries in the sparse set */
+  inline auto increment_queries(struct searchinfo_s * const * searchinfos,
+                                count_t * counters, unsigned int const stride,
+                                unsigned int const start, unsigned int const indexed,
+                                uint64_t queries, uint64_t const sparse) -> void
+  {
+    auto marked = queries & sparse;
+    while (queries != 0)
+      {
+        count_t & counter = counters[(static_cast<size_t>(__builtin_ctzll(queries)) * stride) + (indexed - start)];
+        if (counter < INT16_MAX) { ++counter; }
+        queries &= queries - 1;
+      }
+    while (marked != 0)
+      {
+        mark_touched(searchinfos[__builtin_ctzll(marked)]->touched.data(), indexed - start);
+        marked &= marked - 1;
+      }
+  }
+
+}  // end of anonymous namespace
+
+
+auto search_topscores_batch(struct searchinfo_s * const * searchinfos,
+                            unsigned int const count) -> void
+{
+  /*
+    The same as search_topscores() for a batch of queries (or query
+    strands), but the posting list or bitmap of each k-mer is read once for
+    the whole batch, and no counter array the size of the database is
+    cleared and scanned per query. The database is processed in tiles;
+    the counters of a tile form one row per query, so that the bitmap
+    k-mers use the same SIMD counters as search_topscores(). The posting
+    lists are strictly increasing (the index adds sequences in order, and
+    udb_read() rejects files whose lists are not), so a cursor per k-mer
+    walks its list once across the tiles.
+  */
+
+  assert(count <= topscores_batch_max);
+
+  if (count == 0)
+    {
+      return;
+    }
+
+  struct Dbindex const & dbindex = *searchinfos[0]->dbindex;
+  unsigned int const indexed_count = dbindex.getcount();
+
+  /* distinct k-mers of the batch, with the queries sampling them */
+  std::vector<std::pair<unsigned int, unsigned int>> samples;
+  std::array<unsigned int, topscores_batch_max> minmatches {{}};
+  for (auto q = 0U; q < count; q++)
+    {
+      struct searchinfo_s * const searchinfo = searchinfos[q];
+      for (auto i = 0U; i < searchinfo->kmersamplecount; i++)
+        {
+          samples.emplace_back(searchinfo->kmersample[i], q);
+        }
+      minmatches[q] = std::min(static_cast<unsigned int>(searchinfo->parameters->opt_minwordmatches),
+                               searchinfo->kmersamplecount);
+      minheap_clear(searchinfo->m);
+    }
+  std::sort(samples.begin(), samples.end());
+
+  /* a multiple of 16 sequences, as the bitmap counters process 16 bits
+     at a time; one row of counters per query, 64-byte aligned */
+  unsigned int const tile = std::max(16U, (topscores_tile_counters / count) & ~15U);
+  std::vector<batch_list> listed;
+  std::vector<batch_kmer> bitmapped;
+  for (auto i = 0UL; i < samples.size(); )
+    {
+      batch_kmer entry {samples[i].first, 0};
+      for (; (i < samples.size()) and (samples[i].first == entry.kmer); i++)
+        {
+          entry.queries |= uint64_t{1} << samples[i].second;
+        }
+      if (dbindex.getbitmap(entry.kmer) != nullptr)
+        {
+          bitmapped.push_back(entry);
+        }
+      else if (dbindex.is_packed() and (dbindex.getmatchcount(entry.kmer) != 0))
+        {
+          auto const * packed = dbindex.getpackedlist(entry.kmer);
+          auto const bytes = static_cast<size_t>(dbindex.getpackedlist(entry.kmer + 1) - packed);
+          auto const current = unpack_gap(packed);
+          listed.push_back({nullptr, nullptr, entry.queries, (bytes * tile) / indexed_count,
+                            packed, dbindex.getmatchcount(entry.kmer), current});
+        }
+      else if (dbindex.getmatchcount(entry.kmer) != 0)
+        {
+          auto const * list = dbindex.getmatchlist(entry.kmer);
+          auto const length = dbindex.getmatchcount(entry.kmer);
+          listed.push_back({list, list + length, entry.queries,
+                            (static_cast<size_t>(length) * tile * sizeof(unsigned int)) / indexed_count,
+                            nullptr, 0, 0});
         }
     }
 
-  minheap_sort(searchinfo->m);
+  auto const tile_size = static_cast<size_t>(tile) * count * sizeof(count_t);
+  auto * counters = static_cast<count_t *>(xmalloc(tile_size));
+  std::memset(counters, 0, tile_size);
+
+  /* as in search_topscores(), only the blocks of counters touched by the
+     posting lists of the sparse queries are thresholded and cleared */
+  auto sparse = uint64_t{0};
+  for (auto q = 0U; q < count; q++)
+    {
+      if (sparse_counting(searchinfos[q], indexed_count))
+        {
+          sparse |= uint64_t{1} << q;
+          searchinfos[q]->touched.assign(touched_blocks(tile), 0);
+        }
+    }
+
+  for (auto start = 0U; start < indexed_count; start += tile)
+    {
+      unsigned int const end = std::min(indexed_count - start, tile) + start;
+
+      /* each tile reads a short piece of every list: fetch the pieces
+         of the lists a few steps ahead, as the hardware prefetcher
+         cannot follow that many streams */
+      for (auto k = 0UL; k < listed.size(); k++)
+        {
+          if (k + topscores_prefetch_distance < listed.size())
+            {
+              auto const & ahead = listed[k + topscores_prefetch_distance];
+              auto const * fetch = (ahead.packed != nullptr) ?
+                reinterpret_cast<char const *>(ahead.packed) :
+                reinterpret_cast<char const *>(ahead.next);
+              for (auto offset = 0UL; offset <= ahead.piece; offset += 64)
+                {
+                  __builtin_prefetch(fetch + offset);
+                }
+            }
+          auto & entry = listed[k];
+          if ((entry.queries & (entry.queries - 1)) == 0)
+            {
+              /* sampled by one query only */
+              auto const q = static_cast<unsigned int>(__builtin_ctzll(entry.queries));
+              auto * row = counters + (static_cast<size_t>(q) * tile);
+              if (((sparse >> q) & 1U) == 0)
+                {
+                  walk_list(entry, end, [row, start](unsigned int const indexed) -> void {
+                    count_t & counter = row[indexed - start];
+                    if (counter < INT16_MAX) { ++counter; }
+                  });
+                  continue;
+                }
+              auto * touched = searchinfos[q]->touched.data();
+              walk_list(entry, end, [row, start, touched](unsigned int const indexed) -> void {
+                count_t & counter = row[indexed - start];
+                if (counter < INT16_MAX) { ++counter; }
+                mark_touched(touched, indexed - start);
+              });
+              continue;
+            }
+          walk_list(entry, end, [&](unsigned int const indexed) -> void {
+            increment_queries(searchinfos, counters, tile, start, indexed,
+                              entry.queries, sparse);
+          });
+        }
+
+      for (auto const & entry : bitmapped)
+        {
+          auto * bitmap = dbindex.getbitmap(entry.kmer) + (start / 8);
+          auto queries = entry.queries;
+          while (queries != 0)
+            {
+              auto * row = counters + (static_cast<size_t>(__builtin_ctzll(queries)) * tile);
+#ifdef __x86_64__
+              if (searchinfos[0]->parameters->ssse3_present != 0)
+                {
+                  increment_counters_from_bitmap_ssse3(row, bitmap, end - start);
+                }
+              else
+                {
+                  increment_counters_from_bitmap_sse2(row, bitmap, end - start);
+                }
+#else
+              increment_counters_from_bitmap(row, bitmap, end - start);
+#endif
+              queries &= queries - 1;
+            }
+        }
+
+      for (auto q = 0U; q < count; q++)
+        {
+          auto * row = counters + (static_cast<size_t>(q) * tile);
+          if (((sparse >> q) & 1U) != 0)
+            {
+              add_touched_candidates(searchinfos[q], row, start, end - start, minmatches[q]);
+              continue;
+            }
+          for (auto i = start; i < end; i++)
+            {
+              if (row[i - start] >= minmatches[q])
+                {
+                  add_candidate(searchinfos[q], i, row[i - start]);
+                }
+            }
+          std::memset(row, 0, tile * sizeof(count_t));
+        }
+    }
+
+  xfree(counters);
+
+  for (auto q = 0U; q < count; q++)
+    {
+      minheap_sort(searchinfos[q]->m);
+    }
 }
 
 
@@ -737,6 +1127,103 @@ auto search_acceptable_aligned(struct searchinfo_s const & searchinfo,
 }
 
 
+namespace {
+
+  /* Whether align_delayed() screens the targets with the 8-bit score
+     bounds of search16_bounds() first. A target whose bound shows that it
+     cannot reach the --weak_id identity would be rejected (and not be a
+     weak hit) after alignment, so it is rejected without one. Only sound
+     when the identity is relative to the length of the shorter (--iddef 0)
+     or longer sequence (--iddef 1 and 4): without terminal gaps (--iddef 2,
+     the default, and 3) a short alignment may reach any identity whatever
+     its score. */
+  auto score_prefilter_enabled(struct searchinfo_s const & searchinfo) -> bool
+  {
+    struct Parameters const & parameters = *searchinfo.parameters;
+    return (search16_bounds_channels(searchinfo.s) != 0)
+      and (parameters.opt_weak_id > 0.0)
+      and (not parameters.opt_gap_penalty_has_infinite)
+      and ((parameters.opt_iddef == 0) or (parameters.opt_iddef == 1) or
+           (parameters.opt_iddef == 4));
+  }
+
+
+  /* number of targets collected before align_delayed() is called */
+  auto delayed_batch_size(struct searchinfo_s const & searchinfo) -> unsigned int
+  {
+    if (score_prefilter_enabled(searchinfo))
+      {
+        return search16_bounds_channels(searchinfo.s);
+      }
+    return search16_channels(searchinfo.s);
+  }
+
+
+  auto count_ambiguous(char const * sequence, int64_t const length) -> int64_t
+  {
+    return std::count_if(sequence, sequence + length,
+                         [](char const nucleotide) -> bool {
+                           return is_ambiguous_4bit(map_4bit(nucleotide));
+                         });
+  }
+
+
+  /* Whether no alignment of the query with the target scoring at most
+     'bound' reaches the --weak_id identity. An alignment with M matches,
+     X mismatches and G gap columns (qlen + dlen = 2M + 2X + G) scores at
+     least match * (M - K) + min(mismatch, 0) * X - c * G, where K is the
+     number of ambiguous symbols of both sequences (these match for 0) and
+     c the largest gap opening plus extension penalty. That is increasing
+     in M and linear in X, so it is smallest for the fewest matches the
+     identity allows (less one, against rounding) and for X either 0 or as
+     large as possible. query_ambiguous caches K for the query (-1: not
+     counted yet). */
+  auto below_weak_id(struct searchinfo_s const & searchinfo,
+                     uint64_t const target,
+                     int64_t const bound,
+                     int64_t & query_ambiguous) -> bool
+  {
+    struct Parameters const & parameters = *searchinfo.parameters;
+    int64_t const qlen = searchinfo.qseqlen;
+    int64_t const dlen = static_cast<int64_t>(searchinfo.db->getsequencelen(target));
+    int64_t const shortest = std::min(qlen, dlen);
+    int64_t const length = (parameters.opt_iddef == 0) ? shortest : std::max(qlen, dlen);
+    int64_t const matches_min = std::max(int64_t{0}, static_cast<int64_t>(parameters.opt_weak_id * static_cast<double>(length)) - 1);
+
+    if (matches_min > shortest)
+      {
+        return true;
+      }
+    if (bound == std::numeric_limits<short>::max())
+      {
+        return false;
+      }
+
+    if (query_ambiguous < 0)
+      {
+        query_ambiguous = count_ambiguous(searchinfo.qsequence, qlen);
+      }
+    int64_t const ambiguous = query_ambiguous + count_ambiguous(searchinfo.db->getsequence(target), dlen);
+
+    int64_t const gap_max = std::max({
+        parameters.opt_gap_open_query_left + parameters.opt_gap_extension_query_left,
+        parameters.opt_gap_open_target_left + parameters.opt_gap_extension_target_left,
+        parameters.opt_gap_open_query_interior + parameters.opt_gap_extension_query_interior,
+        parameters.opt_gap_open_target_interior + parameters.opt_gap_extension_target_interior,
+        parameters.opt_gap_open_query_right + parameters.opt_gap_extension_query_right,
+        parameters.opt_gap_open_target_right + parameters.opt_gap_extension_target_right });
+    int64_t const mismatch = std::min(parameters.opt_mismatch, int64_t{0});
+    int64_t const mismatches = (mismatch + (2 * gap_max) >= 0) ? 0 : shortest - matches_min;
+    int64_t const gap_columns = qlen + dlen - (2 * matches_min) - (2 * mismatches);
+    int64_t const score_min = (parameters.opt_match * std::max(int64_t{0}, matches_min - ambiguous))
+      + (mismatch * mismatches) - (gap_max * gap_columns);
+
+    return bound < score_min;
+  }
+
+}  // end of anonymous namespace
+
+
 auto align_delayed(struct searchinfo_s * searchinfo) -> void
 {
   /* opt_maxaccepts/opt_maxrejects are read through searchinfo->parameters: each
@@ -751,6 +1238,9 @@ auto align_delayed(struct searchinfo_s * searchinfo) -> void
   std::array<unsigned short, MAXDELAYED> nwmismatches_list {{}};
   std::array<unsigned short, MAXDELAYED> nwgaps_list {{}};
   std::array<char *, MAXDELAYED> nwcigar_list {{}};
+  std::array<unsigned int, MAXDELAYED> align_list {{}};
+  std::array<CELL, MAXDELAYED> bound_list {{}};
+  std::array<bool, MAXDELAYED> pruned {{}};
 
   unsigned int target_count = 0;
 
@@ -763,11 +1253,35 @@ auto align_delayed(struct searchinfo_s * searchinfo) -> void
         }
     }
 
-  if (target_count != 0)
+  /* align only the targets that may reach --weak_id */
+  unsigned int align_count = 0;
+
+  if ((target_count != 0) and score_prefilter_enabled(*searchinfo))
+    {
+      search16_bounds(searchinfo->s, target_count, target_list.data(),
+                      bound_list.data(), *searchinfo->db);
+
+      int64_t query_ambiguous = -1;
+      for (auto j = 0U; j < target_count; j++)
+        {
+          pruned[j] = below_weak_id(*searchinfo, target_list[j], bound_list[j], query_ambiguous);
+          if (not pruned[j])
+            {
+              align_list[align_count++] = target_list[j];
+            }
+        }
+    }
+  else
+    {
+      std::copy(target_list.begin(), target_list.begin() + target_count, align_list.begin());
+      align_count = target_count;
+    }
+
+  if (align_count != 0)
     {
       search16(searchinfo->s,
-               target_count,
-               target_list.data(),
+               align_count,
+               align_list.data(),
                nwscore_list.data(),
                nwalignmentlength_list.data(),
                nwmatches_list.data(),
@@ -777,7 +1291,8 @@ auto align_delayed(struct searchinfo_s * searchinfo) -> void
                *searchinfo->db);
     }
 
-  unsigned int i = 0;
+  unsigned int i = 0;  // next alignment
+  unsigned int t = 0;  // next target
 
   for (int x = searchinfo->finalized; x < searchinfo->hit_count; x++)
     {
@@ -790,6 +1305,13 @@ auto align_delayed(struct searchinfo_s * searchinfo) -> void
             {
               searchinfo->rejects++;
             }
+          else if (pruned[t++])
+            {
+              /* as search_acceptable_aligned() would after alignment */
+              hit->rejected = true;
+              hit->weak = false;
+              searchinfo->rejects++;
+            }
           else
             {
               int64_t const target = hit->target;
@@ -872,7 +1394,7 @@ auto align_delayed(struct searchinfo_s * searchinfo) -> void
     }
 
   /* free ignored alignments */
-  while (i < target_count)
+  while (i < align_count)
     {
       xfree(nwcigar_list[i++]);
     }
@@ -882,11 +1404,33 @@ auto align_delayed(struct searchinfo_s * searchinfo) -> void
 
 
 auto search_onequery(struct searchinfo_s * searchinfo, Masking seqmask) -> void
+{
+  search_query_kmers(searchinfo, seqmask);
+
+  /* find database sequences with the most kmer hits */
+  search_topscores(searchinfo);
+
+  search_align_candidates(searchinfo);
+}
+
+
+auto search_query_kmers(struct searchinfo_s * searchinfo, Masking seqmask) -> void
+{
+  /* Query kmers are extracted at searchinfo->dbindex->wordlength, the
+     effective index width. */
+
+  /* extract unique kmer samples from query*/
+  unique_count(searchinfo->uh, static_cast<int>(searchinfo->dbindex->wordlength),
+               searchinfo->qseqlen, searchinfo->qsequence,
+               &searchinfo->kmersamplecount, &searchinfo->kmersample, seqmask);
+}
+
+
+auto search_align_candidates(struct searchinfo_s * searchinfo) -> void
 {
   /* opt_maxaccepts/opt_maxrejects are read through searchinfo->parameters: each
      caller threads a copy carrying its adjustment (search/cluster the seqcount
-     clamp, chimera the detection defaults), so no global is mutated (E1). Query
-     kmers are extracted at searchinfo->dbindex->wordlength, the effective index width. */
+     clamp, chimera the detection defaults), so no global is mutated (E1). */
   searchinfo->hit_count = 0;
 
   search16_qprep(searchinfo->s, searchinfo->qsequence, searchinfo->qseqlen);
@@ -897,14 +1441,6 @@ auto search_onequery(struct searchinfo_s * searchinfo, Masking seqmask) -> void
   searchinfo->lma = new LinearMemoryAligner(scoring);
 
 
-  /* extract unique kmer samples from query*/
-  unique_count(searchinfo->uh, static_cast<int>(searchinfo->dbindex->wordlength),
-               searchinfo->qseqlen, searchinfo->qsequence,
-               &searchinfo->kmersamplecount, &searchinfo->kmersample, seqmask);
-
-  /* find database sequences with the most kmer hits */
-  search_topscores(searchinfo);
-
   /* analyse targets with the highest number of kmer hits */
   searchinfo->accepts = 0;
   searchinfo->rejects = 0;
@@ -942,7 +1478,7 @@ auto search_onequery(struct searchinfo_s * searchinfo, Masking seqmask) -> void
 
       searchinfo->hit_count++;
 
-      if (delayed == MAXDELAYED)
+      if (static_cast<unsigned int>(delayed) == delayed_batch_size(*searchinfo))
         {
           align_delayed(searchinfo);
           delayed = 0;
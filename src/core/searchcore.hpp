@@ -68,8 +68,15 @@
 
 struct uhandle_s;
 
-/* the number of alignments that can be delayed */
-constexpr auto MAXDELAYED = 8U;
+/* the maximum number of alignments that can be delayed: the widest
+   search16_bounds lane count (AVX-512BW); the actual batch size is the
+   lane count of the aligner in use, see search16_channels() and
+   search16_bounds_channels() */
+constexpr auto MAXDELAYED = 64U;
+
+/* the largest number of queries (or query strands) that
+   search_topscores_batch() handles at once */
+constexpr auto topscores_batch_max = 64U;
 
 /* Default minimum number of word matches for word lengths 3-15 */
 constexpr std::array<int, 16> minwordmatches_defaults =
@@ -143,7 +150,10 @@ struct searchinfo_s
   unsigned int kmersamplecount = 0; /* number of kmer samples from query */
   unsigned int const * kmersample = nullptr;    /* list of kmers sampled from query */
   std::vector<count_t> kmers_v {}; /* vector of kmer counts */
-  count_t * kmers = nullptr;              /* list of kmer counts for each db seq */
+  count_t * kmers = nullptr;              /* list of kmer counts for each db seq,
+                                             zero between searches */
+  std::vector<unsigned char> touched {};  /* flags for the blocks of 16 db seqs
+                                             with nonzero kmer counts */
   std::vector<struct hit> hits_v {}; /* vector of hits */
   struct hit * hits = nullptr;            /* list of hits */
   int hit_count = 0;                /* number of hits in the above list */
@@ -177,8 +187,19 @@ struct searchinfo_s
 
 auto search_topscores(struct searchinfo_s * searchinfo) -> void;
 
+auto search_topscores_batch(struct searchinfo_s * const * searchinfos,
+                            unsigned int count) -> void;
+
+/* search_onequery() is search_query_kmers(), search_topscores() and
+   search_align_candidates() in turn; the steps are separate for callers
+   that find the candidates of several queries at once with
+   search_topscores_batch() */
 auto search_onequery(struct searchinfo_s * searchinfo, Masking seqmask) -> void;
 
+auto search_query_kmers(struct searchinfo_s * searchinfo, Masking seqmask) -> void;
+
+auto search_align_candidates(struct searchinfo_s * searchinfo) -> void;
+
 auto search_findbest2_byid(struct searchinfo_s const * si_p,
                            struct searchinfo_s const * si_m) -> struct hit *;
 
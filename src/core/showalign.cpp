@@ -62,13 +62,13 @@
 #include "utils/cigar.hpp"
 #include "utils/fatal.hpp"
 #include "utils/maps.hpp"
+#include "utils/output_buffer.hpp"
 #include "utils/span.hpp"
 #include "utils/view.hpp"
 #include <algorithm>  // std::copy, std::fill_n, std::min
 #include <cassert>
 #include <cinttypes>  // macros PRIu64 and PRId64
 #include <cstdint>  // int64_t
-#include <cstdio>  // std::FILE
 #include <cstring>  // std::strlen
 #include <iterator>  // std::next
 #include <vector>
@@ -77,9 +77,13 @@
 // anonymous namespace: limit visibility and usage to this translation unit
 namespace {
 
-  std::vector<char> q_line;  // query
-  std::vector<char> a_line;  // alignment symbols (|)
-  std::vector<char> d_line;  // target
+  /* the rows of the alignment block being built, one per call so that
+     threads can format alignments concurrently */
+  struct Rows {
+    std::vector<char> q_line;  // query
+    std::vector<char> a_line;  // alignment symbols (|)
+    std::vector<char> d_line;  // target
+  };
 
 
   enum struct Viewpoint : char {
@@ -108,7 +112,7 @@ namespace {
   struct Alignment {
     static constexpr auto poswidth_default = 3;
     static constexpr auto headwidth_default = 5;
-    std::FILE * output_handle = nullptr;
+    Output_buffer * output = nullptr;
     Sequence query;
     Sequence target;
     int64_t width = 0;
@@ -190,45 +194,41 @@ namespace {
   }
 
 
-  auto print_alignment_block(Alignment const & alignment, Position const & position) -> void {
+  auto print_alignment_block(Alignment const & alignment, Position const & position,
+                             Rows const & rows) -> void {
     // current query and target starting and ending positions
     auto const query_start = std::min(position.query_start + 1, alignment.query.length);
     auto const query_end = alignment.is_reverse_strand ? position.query + 2 : position.query;
     auto const target_start = std::min(position.target_start + 1, alignment.target.length);
     auto const target_end = position.target;
 
-    static_cast<void>(
-    std::fprintf(alignment.output_handle,
-                 "\n%*s %*" PRId64 " %c %s %" PRId64 "\n",
-                 alignment.headwidth,
-                 alignment.query.name,
-                 alignment.poswidth,
-                 query_start,
-                 alignment.is_reverse_strand ? '-' : '+',
-                 q_line.data(),
-                 query_end));
-    static_cast<void>(
-    std::fprintf(alignment.output_handle,
-                 "%*s %*s   %s\n",
-                 alignment.headwidth,
-                 "",
-                 alignment.poswidth,
-                 "",
-                 a_line.data()));
-    static_cast<void>(
-    std::fprintf(alignment.output_handle,
-                 "%*s %*" PRId64 " %c %s %" PRId64 "\n",
-                 alignment.headwidth,
-                 alignment.target.name,
-                 alignment.poswidth,
-                 target_start,
-                 '+',
-                 d_line.data(),
-                 target_end));
+    alignment.output->appendf("\n%*s %*" PRId64 " %c %s %" PRId64 "\n",
+                              alignment.headwidth,
+                              alignment.query.name,
+                              alignment.poswidth,
+                              query_start,
+                              alignment.is_reverse_strand ? '-' : '+',
+                              rows.q_line.data(),
+                              query_end);
+    alignment.output->appendf("%*s %*s   %s\n",
+                              alignment.headwidth,
+                              "",
+                              alignment.poswidth,
+                              "",
+                              rows.a_line.data());
+    alignment.output->appendf("%*s %*" PRId64 " %c %s %" PRId64 "\n",
+                              alignment.headwidth,
+                              alignment.target.name,
+                              alignment.poswidth,
+                              target_start,
+                              '+',
+                              rows.d_line.data(),
+                              target_end);
   }
 
 
-  inline auto putop(Alignment const & alignment, Position & position, Operation const operation, int64_t const runlength) -> void {
+  inline auto putop(Alignment const & alignment, Position & position, Rows & rows,
+                    Operation const operation, int64_t const runlength) -> void {
     int64_t const delta = alignment.is_reverse_strand ? -1 : +1;
 
     for (auto count = runlength; count != 0; --count) {
@@ -247,25 +247,25 @@ namespace {
       case Operation::match:
         position.query += delta;
         position.target += 1;
-        q_line[line_index] = query_nuc;
-        a_line[line_index] = get_aligment_symbol(query_nuc, target_nuc, alignment.n_mismatch);
-        d_line[line_index] = target_nuc;
+        rows.q_line[line_index] = query_nuc;
+        rows.a_line[line_index] = get_aligment_symbol(query_nuc, target_nuc, alignment.n_mismatch);
+        rows.d_line[line_index] = target_nuc;
         ++position.line;
         break;
 
       case Operation::deletion:  // gap in target (insertion in query)
         position.query += delta;
-        q_line[line_index] = query_nuc;
-        a_line[line_index] = ' ';
-        d_line[line_index] = '-';
+        rows.q_line[line_index] = query_nuc;
+        rows.a_line[line_index] = ' ';
+        rows.d_line[line_index] = '-';
         ++position.line;
         break;
 
       case Operation::insertion:  // insertion in target (gap in query)
         position.target += 1;
-        q_line[line_index] = '-';
-        a_line[line_index] = ' ';
-        d_line[line_index] = target_nuc;
+        rows.q_line[line_index] = '-';
+        rows.a_line[line_index] = ' ';
+        rows.d_line[line_index] = target_nuc;
         ++position.line;
         break;
       }
@@ -273,29 +273,29 @@ namespace {
       if (position.line == alignment.width) {
         // maximal alignment width is reached, print alignment block
         auto const terminator_index = static_cast<size_t>(position.line);
-        q_line[terminator_index] = '\0';
-        a_line[terminator_index] = '\0';
-        d_line[terminator_index] = '\0';
-        print_alignment_block(alignment, position);
+        rows.q_line[terminator_index] = '\0';
+        rows.a_line[terminator_index] = '\0';
+        rows.d_line[terminator_index] = '\0';
+        print_alignment_block(alignment, position, rows);
         position.line = 0;  // needed to avoid out-of-bounds
       }
     }
   }
 
 
-  auto putop_final(Alignment const & alignment, Position const & position) -> void {
+  auto putop_final(Alignment const & alignment, Position const & position, Rows & rows) -> void {
     if (position.line == 0) { return; }  // final block already printed
     auto const terminator_index = static_cast<size_t>(position.line);
-    q_line[terminator_index] = '\0';
-    a_line[terminator_index] = '\0';
-    d_line[terminator_index] = '\0';
-    print_alignment_block(alignment, position);
+    rows.q_line[terminator_index] = '\0';
+    rows.a_line[terminator_index] = '\0';
+    rows.d_line[terminator_index] = '\0';
+    print_alignment_block(alignment, position, rows);
   }
 
 }  // end of anonymous namespace
 
 
-auto align_show(std::FILE * output_handle,
+auto align_show(Output_buffer & output,
                 char const * seq1,
                 int64_t const seq1len,
                 int64_t const seq1off,
@@ -314,7 +314,7 @@ auto align_show(std::FILE * output_handle,
 {
 
   Alignment alignment;
-  alignment.output_handle = output_handle;
+  alignment.output = &output;
   alignment.query.sequence = seq1;
   alignment.query.length = seq1len;
   alignment.query.offset = seq1off;
@@ -332,7 +332,7 @@ auto align_show(std::FILE * output_handle,
   // C++14 refactoring: aggregate initialization of a struct with
   // default member initializers
   // Alignment const alignment = {
-  //   output_handle,
+  //   &output,
   //   {seq1, seq1len, seq1off, seq1name},
   //   {seq2, seq2len, seq2off, seq2name},
   //   numwidth,
@@ -347,23 +347,20 @@ auto align_show(std::FILE * output_handle,
   position.query_start = position.query;
   position.target_start = position.target;
 
-  q_line.resize(static_cast<size_t>(alignment.width) + 1);
-  a_line.resize(static_cast<size_t>(alignment.width) + 1);
-  d_line.resize(static_cast<size_t>(alignment.width) + 1);
+  Rows rows;
+  rows.q_line.resize(static_cast<size_t>(alignment.width) + 1);
+  rows.a_line.resize(static_cast<size_t>(alignment.width) + 1);
+  rows.d_line.resize(static_cast<size_t>(alignment.width) + 1);
 
   // cigar string can be trimmed (left and right): cigarlen maybe != std::strlen(cigar)
   auto const cigar_pairs = parse_cigar_string(Span<char>{cigar, static_cast<size_t>(cigarlen)});
   for (auto const & a_pair: cigar_pairs) {
     auto const operation = a_pair.first;
     auto const runlength = a_pair.second;
-    putop(alignment, position, operation, runlength);
+    putop(alignment, position, rows, operation, runlength);
   }
 
-  putop_final(alignment, position);
-
-  q_line.clear();
-  a_line.clear();
-  d_line.clear();
+  putop_final(alignment, position, rows);
 }
 
 
@@ -58,10 +58,10 @@
 
 */
 
+#include "utils/output_buffer.hpp"
 #include "utils/span.hpp"
 #include "utils/view.hpp"
 #include <cstdint>  // int64_t
-#include <cstdio>  // std::FILE
 #include <vector>
 
 
@@ -73,7 +73,7 @@ auto get_alignment_trow(View<char> seq_view,
                         Span<char> cigar_view,
                         int alignlen) -> std::vector<char>;
 
-auto align_show(std::FILE * output_handle,
+auto align_show(Output_buffer & output,
                 char const * seq1,
                 int64_t seq1len,
                 int64_t seq1off,
@@ -59,11 +59,14 @@
 */
 
 #include "vsearch.h"
+#include "core/tax.hpp"
 #include "utils/taxonomic_fields.h"
-#include <algorithm>  // std::find
+#include <algorithm>  // std::find, std::equal
+#include <array>
 #include <cctype>  // std::tolower
 #include <cstring>  // std::strlen, std::strstr, std::strchr
 #include <iterator>  // std::distance
+#include <utility>  // std::move
 
 
 // very similar to header_find_attribute() in attributes.cc
@@ -184,3 +187,104 @@ auto tax_split(int seqno, int * level_start, int * level_len, struct Database co
         }
     }
 }
+
+
+auto Taxonomy::parse(struct Database const & db) -> void
+{
+  auto const seqcount = db.getsequencecount();
+  ids_.assign(seqcount * tax_levels, 0);
+  names_.clear();
+  name_start_.assign(2, 0);
+
+  /* open addressing hash table of the name ids, 0 for a free slot */
+  std::vector<unsigned int> slots(1024, 0);
+  auto const hash = [](char const * name, int const length) -> uint64_t {
+    auto value = uint64_t{14695981039346656037U};  // FNV-1a
+    for (auto i = 0; i < length; i++)
+      {
+        value = (value ^ static_cast<unsigned char>(name[i])) * uint64_t{1099511628211U};
+      }
+    return value;
+  };
+  auto const stored_length = [&](unsigned int const id) -> int {
+    return static_cast<int>(name_start_[id + 1] - name_start_[id]);
+  };
+  auto const stored_name = [&](unsigned int const id) -> char const * {
+    return names_.data() + name_start_[id];
+  };
+  auto const slot_of = [&](char const * name, int const length) -> unsigned int & {
+    auto const mask = slots.size() - 1;
+    auto slot = hash(name, length) & mask;
+    while (slots[slot] != 0)
+      {
+        auto const id = slots[slot];
+        if ((stored_length(id) == length) and
+            std::equal(name, name + length, stored_name(id)))
+          {
+            break;
+          }
+        slot = (slot + 1) & mask;
+      }
+    return slots[slot];
+  };
+
+  for (uint64_t seqno = 0; seqno < seqcount; seqno++)
+    {
+      std::array<int, tax_levels> level_start {{}};
+      std::array<int, tax_levels> level_len {{}};
+      tax_split(static_cast<int>(seqno), level_start.data(), level_len.data(), db);
+      auto const * header = db.getheader(seqno);
+
+      for (auto level = 0; level < tax_levels; level++)
+        {
+          auto const length = level_len[static_cast<std::size_t>(level)];
+          if (length == 0)
+            {
+              continue;
+            }
+          auto const * name = header + level_start[static_cast<std::size_t>(level)];
+          auto & slot = slot_of(name, length);
+          if (slot == 0)
+            {
+              /* a new name */
+              slot = static_cast<unsigned int>(name_start_.size() - 1);
+              names_.insert(names_.end(), name, name + length);
+              name_start_.push_back(names_.size());
+
+              if (2 * name_start_.size() > slots.size())
+                {
+                  /* keep the table at most half full */
+                  slots.assign(2 * slots.size(), 0);
+                  for (auto id = 1U; id + 1 < name_start_.size(); id++)
+                    {
+                      slot_of(stored_name(id), stored_length(id)) = id;
+                    }
+                }
+            }
+          ids_[(seqno * tax_levels) + static_cast<uint64_t>(level)] = slot_of(name, length);
+        }
+    }
+
+  mapping_.reset();
+  ids_view_ = ids_.data();
+  names_view_ = names_.data();
+  name_start_view_ = name_start_.data();
+  name_count_ = name_start_.size() - 1;
+}
+
+
+auto Taxonomy::map(std::shared_ptr<void> mapping,
+                   unsigned int const * ids,
+                   char const * names,
+                   uint64_t const * name_start,
+                   uint64_t const name_count) -> void
+{
+  ids_.clear();
+  names_.clear();
+  name_start_.assign(2, 0);
+  mapping_ = std::move(mapping);
+  ids_view_ = ids;
+  names_view_ = names;
+  name_start_view_ = name_start;
+  name_count_ = name_count;
+}
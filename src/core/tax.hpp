@@ -59,6 +59,67 @@
 */
 
 
+#include "utils/taxonomic_fields.h"
+#include <cstddef>  // std::size_t
+#include <cstdint>  // uint64_t
+#include <memory>  // std::shared_ptr
+#include <vector>
+
+
 struct Database;
 
 auto tax_split(int seqno, int * level_start, int * level_len, struct Database const & db) -> void;
+
+
+/* The taxonomy of the database sequences, parsed once from the tax=
+   annotations of their headers. The names are interned: equal names
+   have the same id, so that taxa are compared as integers. Id 0 is the
+   empty name, also given to the ranks missing from an annotation. The
+   arrays are read through views, which point either at the vectors
+   filled by parse() or at the taxonomy section of a mapped UDB v2 file
+   (see map() and udb_read_taxonomy()). */
+
+class Taxonomy {
+public:
+
+  Taxonomy() = default;
+  Taxonomy(Taxonomy const &) = delete;  /* the views point into *this */
+  auto operator=(Taxonomy const &) -> Taxonomy & = delete;
+
+  auto parse(struct Database const & db) -> void;
+
+  /* view the arrays of a UDB v2 file, kept alive by mapping */
+  auto map(std::shared_ptr<void> mapping,
+           unsigned int const * ids,
+           char const * names,
+           uint64_t const * name_start,
+           uint64_t name_count) -> void;
+
+  auto name_id(uint64_t const seqno, int const level) const -> unsigned int {
+    return ids_view_[(seqno * tax_levels) + static_cast<uint64_t>(level)];
+  }
+
+  auto name(unsigned int const id) const -> char const * {
+    return names_view_ + name_start_view_[id];
+  }
+
+  auto name_length(unsigned int const id) const -> int {
+    return static_cast<int>(name_start_view_[id + 1] - name_start_view_[id]);
+  }
+
+  /* the arrays, as stored in a UDB v2 file by makeudb_usearch */
+  auto ids() const -> unsigned int const * { return ids_view_; }
+  auto names() const -> char const * { return names_view_; }
+  auto name_starts() const -> uint64_t const * { return name_start_view_; }
+  auto name_count() const -> uint64_t { return name_count_; }  /* with id 0 */
+
+private:
+  std::vector<unsigned int> ids_;  /* tax_levels name ids per sequence */
+  std::vector<char> names_;  /* the names, one after the other */
+  std::vector<uint64_t> name_start_ {0, 0};  /* of each name, and the end */
+  unsigned int const * ids_view_ = nullptr;
+  char const * names_view_ = nullptr;
+  uint64_t const * name_start_view_ = name_start_.data();
+  uint64_t name_count_ = 1;
+  std::shared_ptr<void> mapping_;
+};
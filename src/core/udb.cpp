@@ -63,12 +63,16 @@
 #include "core/attributes.hpp"
 #include "core/bitmap.hpp"
 #include "core/dbindex.hpp"
+#include "core/tax.hpp"
+#include "core/udb.hpp"
 #include "core/unique.hpp"
 #include "utils/fatal.hpp"
 #include "utils/open_file.hpp"
 #include "utils/string_alloc.hpp"
+#include "utils/taxonomic_fields.h"
 #include <algorithm>  // std::min, std::max
 #include <array>
+#include <atomic>
 #include <cinttypes>  // macros PRIu64 and PRId64
 #include <cstdint>  // uint64_t
 #include <cstdio>  // std::FILE, std::fprintf, std::size_t
@@ -76,6 +80,8 @@
 #include <fstream>  // std::ifstream
 #include <istream>  // std::istream
 #include <limits>
+#include <memory>  // std::shared_ptr
+#include <type_traits>  // std::is_trivially_copyable
 #include <vector>
 
 
@@ -124,7 +130,6 @@ auto udb_detect_isudb(const char * filename) -> bool
     It must be an uncompressed regular file, not a pipe.
   */
 
-  constexpr static uint32_t udb_file_signature {0x55444246}; // 'FBDU UDBF'
   constexpr static uint64_t expected_n_bytes {sizeof(uint32_t)};
 
   /* Only a regular file can be probed here and then reopened from the
@@ -161,7 +166,8 @@ auto udb_detect_isudb(const char * filename) -> bool
   unsigned int magic = 0;
   auto const bytesread = std::fread(& magic, 1, static_cast<std::size_t>(expected_n_bytes), input.get());
 
-  if ((static_cast<uint64_t>(bytesread) == expected_n_bytes) and (magic == udb_file_signature))
+  if ((static_cast<uint64_t>(bytesread) == expected_n_bytes) and
+      ((magic == udb_signature) or (magic == udb2_signature)))
     {
       return true;
     }
@@ -190,6 +196,148 @@ namespace {
     return lhs + rhs;
   }
 
+
+  /* check that a section of count items of item_size bytes lies within
+     the mapped UDB v2 file, at an aligned offset */
+  auto udb2_check_section(uint64_t const offset, uint64_t const count,
+                          uint64_t const item_size, uint64_t const filesize) -> void
+  {
+    if (((offset % udb2_alignment) != 0) or
+        (count > std::numeric_limits<uint64_t>::max() / item_size) or
+        (udb_checked_add(offset, count * item_size) > filesize))
+      {
+        fatal("Invalid UDB file");
+      }
+  }
+
+
+  auto udb2_map(const char * filename,
+                uint64_t const filesize,
+                unsigned int const seqcount,
+                bool const parse_abundances,
+                struct Dbindex & dbindex,
+                struct Database & db) -> void
+  {
+    /* Map a UDB v2 file in place instead of reading it. The mapping is
+       private: its pages are shared with the page cache, and with other
+       processes mapping the same file, until written (masking). The
+       header fields are untrusted, as in udb_read(). Here, only the
+       table, the section bounds and the sequence records are checked,
+       which reads none of the k-mer lists and sequence data: each k-mer
+       list is checked when first used (Dbindex::check_list). */
+
+    static_assert(std::is_trivially_copyable<seqinfo_t>::value and (sizeof(seqinfo_t) == 40),
+                  "UDB v2 files store seqinfo_t records verbatim");
+
+    if (filesize < udb2_table_offset + sizeof(udb2_table_s))
+      {
+        fatal("Invalid UDB file");
+      }
+
+    auto const input = open_input_file(filename);
+    if (not input)
+      {
+        fatal("Unable to open UDB file for reading");
+      }
+    auto * const base = static_cast<char *>(xmmap_private(fileno(input.get()), filesize));
+    if (base == nullptr)
+      {
+        fatal("Unable to map UDB file into memory (%s)", filename);
+      }
+    std::shared_ptr<void> const mapping(base, [filesize](void * ptr) -> void { xmunmap(ptr, filesize); });
+
+    udb2_table_s table {};
+    std::memcpy(& table, base + udb2_table_offset, sizeof(udb2_table_s));
+
+    if ((table.signature != udb2_signature) or
+        (table.seqcount != seqcount) or
+        (table.hashsize != dbindex.hashsize) or
+        (table.filesize != filesize) or
+        (table.indexsize > filesize) or
+        (table.datasize < udb_checked_add(table.nucleotides, 2 * table.seqcount)))
+      {
+        fatal("Invalid UDB file");
+      }
+
+    auto const packed = ((table.flags & udb2_flag_packed) != 0);
+    if ((table.flags & ~(udb2_flag_packed | udb2_flag_taxonomy)) != 0)
+      {
+        fatal("Invalid UDB file");
+      }
+
+    udb2_check_section(table.kmercount_offset, table.hashsize, sizeof(unsigned int), filesize);
+    udb2_check_section(table.kmerhash_offset, table.hashsize + 1, sizeof(uint64_t), filesize);
+    udb2_check_section(table.seqindex_offset, table.seqcount, sizeof(seqinfo_t), filesize);
+    udb2_check_section(table.data_offset, table.datasize, 1, filesize);
+
+    auto * const kmercount = static_cast<unsigned int *>(static_cast<void *>(base + table.kmercount_offset));
+    auto * const kmerhash = static_cast<uint64_t *>(static_cast<void *>(base + table.kmerhash_offset));
+    auto * const kmerlists = base + table.kmerindex_offset;
+    auto * const seqindex = static_cast<seqinfo_t *>(static_cast<void *>(base + table.seqindex_offset));
+    auto * const datap = base + table.data_offset;
+
+    /* the k-mer lists must lie within the file */
+
+    if (packed)
+      {
+        udb2_check_section(table.kmerindex_offset, kmerhash[table.hashsize], 1, filesize);
+      }
+    else
+      {
+        udb2_check_section(table.kmerindex_offset, table.indexsize, sizeof(unsigned int), filesize);
+      }
+
+    /* every header and sequence must lie within the data, which must
+       end with a terminator, so that no string runs past it; the
+       records are only read, so that their pages stay shared */
+
+    if ((table.datasize == 0) or (datap[table.datasize - 1] != 0))
+      {
+        fatal("Invalid UDB file");
+      }
+
+    uint64_t nucleotides = 0;
+    for (auto i = 0U; i < seqcount; i++)
+      {
+        auto const & info = seqindex[i];
+        if ((static_cast<int64_t>(info.headerlen) > std::numeric_limits<int>::max() - buffer_headroom) or
+            (static_cast<int64_t>(info.seqlen) > std::numeric_limits<int>::max() - buffer_headroom) or
+            (info.header_p >= table.datasize) or
+            (info.headerlen >= table.datasize - info.header_p) or
+            (info.seq_p >= table.datasize) or
+            (info.seqlen >= table.datasize - info.seq_p) or
+            (info.size == 0))
+          {
+            fatal("Invalid UDB file");
+          }
+        nucleotides += info.seqlen;
+      }
+    if (nucleotides != table.nucleotides)
+      {
+        fatal("Invalid UDB file");
+      }
+
+    dbindex.udb_mapping = mapping;
+    dbindex.kmercount = kmercount;
+    dbindex.kmerhash = kmerhash;
+    if (packed)
+      {
+        dbindex.kmerpacked = static_cast<unsigned char *>(static_cast<void *>(kmerlists));
+      }
+    else
+      {
+        dbindex.kmerindex = static_cast<unsigned int *>(static_cast<void *>(kmerlists));
+      }
+    dbindex.indexsize = table.indexsize;
+    dbindex.count = seqcount;
+    dbindex.udb_checked = std::vector<std::atomic<uint64_t>>((table.hashsize + 63) / 64);
+
+    /* without abundances, the stored sizes are read as 1 */
+    db.udb_map(mapping, datap, seqindex, seqcount, nucleotides,
+               table.longest, table.shortest, table.longestheader,
+               not parse_abundances);
+  }
+
 }  // end of anonymous namespace
 
 
@@ -250,13 +398,14 @@ auto udb_read(const char * filename,
   uint64_t pos = 0;
 
   uint64_t longestheader = 0;
+  auto is_udb2 = false;
   auto shortest = std::numeric_limits<unsigned int>::max();
   auto longest = 0U;
   {
     Progress progress_bar(prompt, filesize, parameters);
     pos += largeread(in_stream, buffer.data(), 4 * 50, pos, progress_bar);
 
-    if ((buffer[0]  != 0x55444246) or
+    if (((buffer[0] != udb_signature) and (buffer[0] != udb2_signature)) or
         (buffer[2] != 32) or
         (buffer[4] < 3) or
         (buffer[4] > 15) or
@@ -267,6 +416,7 @@ auto udb_read(const char * filename,
         fatal("Invalid UDB file");
       }
 
+    is_udb2 = (buffer[0] == udb2_signature);
     udb_wordlength = buffer[4];
     seqcount = buffer[13];
     dbindex.dbaccel = buffer[6];
@@ -294,181 +444,200 @@ auto udb_read(const char * filename,
     /* word match counts */
 
     dbindex.hashsize = 1U << (2 * udb_wordlength);
-    dbindex.kmercount = static_cast<unsigned int *>(xmalloc(dbindex.hashsize * sizeof(unsigned int)));
-    dbindex.kmerhash = static_cast<uint64_t *>(xmalloc(dbindex.hashsize * sizeof(uint64_t)));
     dbindex.kmerbitmap = static_cast<struct bitmap_s **>(xmalloc(dbindex.hashsize * sizeof(struct bitmap_s **)));
 
     std::memset(dbindex.kmerbitmap, 0, dbindex.hashsize * sizeof(struct bitmap_s **));
 
-    pos += largeread(in_stream, dbindex.kmercount, 4 * dbindex.hashsize, pos, progress_bar);
-
-    dbindex.indexsize = 0;
-    for (uint64_t i = 0; i < dbindex.hashsize; i++)
+    if (is_udb2)
       {
-        dbindex.kmerhash[i] = dbindex.indexsize;
-        dbindex.indexsize = udb_checked_add(dbindex.indexsize, dbindex.kmercount[i]);
+        in_stream.close();
+        udb2_map(filename, filesize, seqcount, parse_abundances, dbindex, db);
+        progress_bar.update(filesize);
       }
+    else
+      {
+        dbindex.kmercount = static_cast<unsigned int *>(xmalloc(dbindex.hashsize * sizeof(unsigned int)));
+        dbindex.kmerhash = static_cast<uint64_t *>(xmalloc(dbindex.hashsize * sizeof(uint64_t)));
 
-    /* The word-list section stores 4 bytes per index entry, so a file can
-       hold at most filesize/4 entries; a larger total means the kmercount[]
-       values do not match the on-disk section (padded/corrupt file). */
+        pos += largeread(in_stream, dbindex.kmercount, 4 * dbindex.hashsize, pos, progress_bar);
 
-    if (dbindex.indexsize > filesize / 4)
-      {
-        fatal("Invalid UDB file");
-      }
+        dbindex.indexsize = 0;
+        for (uint64_t i = 0; i < dbindex.hashsize; i++)
+          {
+            dbindex.kmerhash[i] = dbindex.indexsize;
+            dbindex.indexsize = udb_checked_add(dbindex.indexsize, dbindex.kmercount[i]);
+          }
+
+        /* The word-list section stores 4 bytes per index entry, so a file can
+           hold at most filesize/4 entries; a larger total means the kmercount[]
+           values do not match the on-disk section (padded/corrupt file). */
+
+        if (dbindex.indexsize > filesize / 4)
+          {
+            fatal("Invalid UDB file");
+          }
 
-    /* signature */
+        /* signature */
 
-    pos += largeread(in_stream, buffer.data(), 4, pos, progress_bar);
+        pos += largeread(in_stream, buffer.data(), 4, pos, progress_bar);
 
-    if (buffer[0] != 0x55444233)
-      {
-        fatal("Invalid UDB file");
-      }
+        if (buffer[0] != 0x55444233)
+          {
+            fatal("Invalid UDB file");
+          }
 
-    /* sequence numbers for word matches */
+        /* sequence numbers for word matches */
 
-    dbindex.kmerindex = static_cast<unsigned int *>(xmalloc(dbindex.indexsize * 4));
+        dbindex.kmerindex = static_cast<unsigned int *>(xmalloc(dbindex.indexsize * 4));
 
-    pos += largeread(in_stream, dbindex.kmerindex, 4 * dbindex.indexsize, pos, progress_bar);
+        pos += largeread(in_stream, dbindex.kmerindex, 4 * dbindex.indexsize, pos, progress_bar);
 
-    /* Every entry is a sequence number used both as a bit offset in the
-       per-word bitmaps (bitmap_set writes bitmap[value >> 3], no bounds
-       check) and as an index into seqindex/dbindex_map during search. A
-       value >= seqcount is therefore an out-of-bounds write or read, so
-       reject it here rather than at use. */
+        /* Every entry is a sequence number used both as a bit offset in the
+           per-word bitmaps (bitmap_set writes bitmap[value >> 3], no bounds
+           check) and as an index into seqindex/dbindex_map during search. A
+           value >= seqcount is therefore an out-of-bounds write or read, so
+           reject it here rather than at use. The batched search and pack()
+           also rely on each list being strictly increasing, as when the
+           index is built. */
 
-    for (uint64_t i = 0; i < dbindex.indexsize; i++)
-      {
-        if (dbindex.kmerindex[i] >= seqcount)
+        for (uint64_t kmer = 0; kmer < dbindex.hashsize; kmer++)
           {
-            fatal("Invalid UDB file");
+            auto const * const list = dbindex.kmerindex + dbindex.kmerhash[kmer];
+            for (auto j = 0U; j < dbindex.kmercount[kmer]; j++)
+              {
+                if ((list[j] >= seqcount) or ((j != 0) and (list[j] <= list[j - 1])))
+                  {
+                    fatal("Invalid UDB file");
+                  }
+              }
           }
-      }
 
-    /* new header */
+        /* new header */
 
-    pos += largeread(in_stream, buffer.data(), 4 * 8, pos, progress_bar);
+        pos += largeread(in_stream, buffer.data(), 4 * 8, pos, progress_bar);
 
-    if ((buffer[0] != 0x55444234) or
-        (buffer[1] != 0x005e0db3) or
-        (buffer[2] != seqcount) or
-        (buffer[7] != 0x005e0db4))
-      {
-        fatal("Invalid UDB file");
-      }
+        if ((buffer[0] != 0x55444234) or
+            (buffer[1] != 0x005e0db3) or
+            (buffer[2] != seqcount) or
+            (buffer[7] != 0x005e0db4))
+          {
+            fatal("Invalid UDB file");
+          }
 
-    nucleotides = ((static_cast<uint64_t>(buffer[4])) << 32U) | buffer[3];
-    auto const udb_headerchars = ((static_cast<uint64_t>(buffer[6])) << 32U) | buffer[5];
+        nucleotides = ((static_cast<uint64_t>(buffer[4])) << 32U) | buffer[3];
+        auto const udb_headerchars = ((static_cast<uint64_t>(buffer[6])) << 32U) | buffer[5];
 
-    /* allocate the two database buffers up front; udb_read fills them in place */
+        /* allocate the two database buffers up front; udb_read fills them in place */
 
-    uint64_t const datap_bytes =
-      udb_checked_add(udb_checked_add(udb_headerchars, nucleotides), seqcount);
-    db.udb_reserve(seqcount, datap_bytes);
-    datap = db.data_.data();
-    seqindex = db.seqindex_.data();
+        uint64_t const datap_bytes =
+          udb_checked_add(udb_checked_add(udb_headerchars, nucleotides), seqcount);
+        db.udb_reserve(seqcount, datap_bytes);
+        datap = db.data_.data();
+        seqindex = db.seqindex_.data();
 
-    /* header index */
+        /* header index */
 
-    std::vector<unsigned int> header_index(seqcount + 1);
+        std::vector<unsigned int> header_index(seqcount + 1);
 
-    pos += largeread(in_stream, header_index.data(), 4 * seqcount, pos, progress_bar);
+        pos += largeread(in_stream, header_index.data(), 4 * seqcount, pos, progress_bar);
 
-    header_index[seqcount] = static_cast<unsigned int>(udb_headerchars);
+        header_index[seqcount] = static_cast<unsigned int>(udb_headerchars);
 
-    auto last = 0U;
-    for (auto i = 0U; i < seqcount; i++)
-      {
-        unsigned int const current_index = header_index[i];
-        if ((current_index < last) or (current_index >= udb_headerchars))
-          {
-            fatal("Invalid UDB file");
-          }
-        /* Header offsets must strictly increase: an equal (or smaller) next
-           offset would make headerlen (next - current - 1) underflow. */
-        if (header_index[i + 1] <= current_index)
+        auto last = 0U;
+        for (auto i = 0U; i < seqcount; i++)
           {
-            fatal("Invalid UDB file");
+            unsigned int const current_index = header_index[i];
+            if ((current_index < last) or (current_index >= udb_headerchars))
+              {
+                fatal("Invalid UDB file");
+              }
+            /* Header offsets must strictly increase: an equal (or smaller) next
+               offset would make headerlen (next - current - 1) underflow. */
+            if (header_index[i + 1] <= current_index)
+              {
+                fatal("Invalid UDB file");
+              }
+            seqindex[i].header_p = current_index;
+            seqindex[i].headerlen = header_index[i + 1] - current_index - 1;
+            if (static_cast<int64_t>(seqindex[i].headerlen) > std::numeric_limits<int>::max() - buffer_headroom)
+              {
+                fatal("UDB file contains a header too long for this version of vsearch");
+              }
+            seqindex[i].size = 1;
+            last = current_index;
           }
-        seqindex[i].header_p = current_index;
-        seqindex[i].headerlen = header_index[i + 1] - current_index - 1;
-        if (static_cast<int64_t>(seqindex[i].headerlen) > std::numeric_limits<int>::max() - buffer_headroom)
+
+
+        /* headers */
+
+        pos += largeread(in_stream, datap, udb_headerchars, pos, progress_bar);
+
+        for (auto i = 0U; i < seqcount; i++)
           {
-            fatal("UDB file contains a header too long for this version of vsearch");
+            longestheader = std::max<uint64_t>(seqindex[i].headerlen, longestheader);
           }
-        seqindex[i].size = 1;
-        last = current_index;
-      }
 
+        /* sequence lengths */
 
-    /* headers */
+        std::vector<unsigned int> sequence_lengths(seqcount);
 
-    pos += largeread(in_stream, datap, udb_headerchars, pos, progress_bar);
+        pos += largeread(in_stream, sequence_lengths.data(), 4 * seqcount, pos, progress_bar);
 
-    for (auto i = 0U; i < seqcount; i++)
-      {
-        longestheader = std::max<uint64_t>(seqindex[i].headerlen, longestheader);
-      }
+        uint64_t sum = 0;
 
-    /* sequence lengths */
+        for (auto i = 0U; i < seqcount; i++)
+          {
+            unsigned int const sequence_length = sequence_lengths[i];
 
-    std::vector<unsigned int> sequence_lengths(seqcount);
+            if (static_cast<int64_t>(sequence_length) > std::numeric_limits<int>::max() - buffer_headroom)
+              {
+                fatal("UDB file contains a sequence too long for this version of vsearch");
+              }
 
-    pos += largeread(in_stream, sequence_lengths.data(), 4 * seqcount, pos, progress_bar);
+            seqindex[i].seq_p = udb_headerchars + sum;
+            seqindex[i].seqlen = sequence_length;
+            seqindex[i].qual_p = 0;
 
-    uint64_t sum = 0;
+            shortest = std::min(sequence_length, shortest);
+            longest = std::max(sequence_length, longest);
 
-    for (auto i = 0U; i < seqcount; i++)
-      {
-        unsigned int const sequence_length = sequence_lengths[i];
+            sum += sequence_length;
 
-        if (static_cast<int64_t>(sequence_length) > std::numeric_limits<int>::max() - buffer_headroom)
-          {
-            fatal("UDB file contains a sequence too long for this version of vsearch");
+            if (sum > nucleotides)
+              {
+                fatal("Invalid UDB file");
+              }
           }
 
-        seqindex[i].seq_p = udb_headerchars + sum;
-        seqindex[i].seqlen = sequence_length;
-        seqindex[i].qual_p = 0;
-
-        shortest = std::min(sequence_length, shortest);
-        longest = std::max(sequence_length, longest);
-
-        sum += sequence_length;
 
-        if (sum > nucleotides)
+        if (sum != nucleotides)
           {
             fatal("Invalid UDB file");
           }
-      }
 
+        /* sequences */
 
-    if (sum != nucleotides)
-      {
-        fatal("Invalid UDB file");
-      }
+        pos += largeread(in_stream, datap + udb_headerchars, nucleotides, pos, progress_bar);
 
-    /* sequences */
+        if (pos != filesize)
+          {
+            fatal("Incorrect UDB file size");
+          }
 
-    pos += largeread(in_stream, datap + udb_headerchars, nucleotides, pos, progress_bar);
+        /* close UDB file */
 
-    if (pos != filesize)
-      {
-        fatal("Incorrect UDB file size");
+        in_stream.close();
       }
-
-    /* close UDB file */
-
-    in_stream.close();
   }
 
   xfree(prompt);
 
   /* reorganize the sequences in memory and record the database statistics */
 
-  db.udb_finalize(seqcount, nucleotides, longest, shortest, longestheader, parameters);
+  if (not is_udb2)
+    {
+      db.udb_finalize(seqcount, nucleotides, longest, shortest, longestheader, parameters);
+    }
 
   /* Create bitmaps for the most frequent words */
 
@@ -483,9 +652,23 @@ auto udb_read(const char * filename,
               {
                 dbindex.kmerbitmap[i] = bitmap_init(seqcount + 127); // pad for xmm
                 bitmap_reset_all(dbindex.kmerbitmap[i]);
-                for (auto j = 0U; j < dbindex.kmercount[i]; j++)
+                if (dbindex.is_packed())
+                  {
+                    auto const * packed = dbindex.getpackedlist(i);
+                    auto seqno = 0U;
+                    for (auto j = 0U; j < dbindex.kmercount[i]; j++)
+                      {
+                        seqno += unpack_gap(packed);
+                        bitmap_set(dbindex.kmerbitmap[i], seqno);
+                      }
+                  }
+                else
                   {
-                    bitmap_set(dbindex.kmerbitmap[i], dbindex.kmerindex[dbindex.kmerhash[i]+j]);
+                    auto const * list = dbindex.getmatchlist(i);
+                    for (auto j = 0U; j < dbindex.kmercount[i]; j++)
+                      {
+                        bitmap_set(dbindex.kmerbitmap[i], list[j]);
+                      }
                   }
               }
             progress.update(i + 1);
@@ -493,9 +676,9 @@ auto udb_read(const char * filename,
       }
     }
 
-  /* get abundances and longest header */
+  /* get abundances and longest header (stored in a UDB v2 file) */
 
-  if (parse_abundances)
+  if (parse_abundances and not is_udb2)
     {
       {
         Progress progress("Parsing abundances", seqcount, parameters);
@@ -576,3 +759,65 @@ auto udb_read(const char * filename,
         }
     }
 }
+
+
+auto udb_read_taxonomy(struct Dbindex const & dbindex,
+                       struct Database const & db,
+                       class Taxonomy & taxonomy) -> bool
+{
+  /* The taxonomy section is checked here rather than in udb2_map(), as
+     only the commands using it pay for the check: every name id must be
+     a valid id, and the names must lie consecutively in their section,
+     with only the name of id 0 empty. */
+
+  if (not dbindex.udb_mapping)
+    {
+      return false;
+    }
+
+  auto * const base = static_cast<char *>(dbindex.udb_mapping.get());
+  udb2_table_s table {};
+  std::memcpy(& table, base + udb2_table_offset, sizeof(udb2_table_s));
+  if ((table.flags & udb2_flag_taxonomy) == 0)
+    {
+      return false;
+    }
+
+  /* udb2_map() has checked the file size and the number of sequences */
+  auto const filesize = table.filesize;
+  auto const seqcount = db.getsequencecount();
+  if ((table.taxnames == 0) or (table.taxnames > filesize))
+    {
+      fatal("Invalid UDB file");
+    }
+  udb2_check_section(table.taxids_offset, seqcount, uint64_t{tax_levels} * sizeof(unsigned int), filesize);
+  udb2_check_section(table.taxname_start_offset, table.taxnames + 1, sizeof(uint64_t), filesize);
+
+  auto const * const ids = static_cast<unsigned int const *>(static_cast<void const *>(base + table.taxids_offset));
+  auto const * const name_start = static_cast<uint64_t const *>(static_cast<void const *>(base + table.taxname_start_offset));
+
+  if ((name_start[0] != 0) or (name_start[1] != 0))
+    {
+      fatal("Invalid UDB file");
+    }
+  for (uint64_t id = 1; id < table.taxnames; id++)
+    {
+      if (name_start[id + 1] <= name_start[id])
+        {
+          fatal("Invalid UDB file");
+        }
+    }
+  udb2_check_section(table.taxname_data_offset, name_start[table.taxnames], 1, filesize);
+
+  for (uint64_t i = 0; i < seqcount * uint64_t{tax_levels}; i++)
+    {
+      if (ids[i] >= table.taxnames)
+        {
+          fatal("Invalid UDB file");
+        }
+    }
+
+  taxonomy.map(dbindex.udb_mapping, ids, base + table.taxname_data_offset,
+               name_start, table.taxnames);
+  return true;
+}
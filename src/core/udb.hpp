@@ -60,6 +60,56 @@
 
 #pragma once
 
+#include <cstdint>  // uint32_t, uint64_t
+
+
+constexpr uint32_t udb_signature = 0x55444246;  // 'FBDU UDBF'
+constexpr uint32_t udb2_signature = 0x55444232;  // '2BDU UDB2'
+
+
+/* UDB v2 is a vsearch-specific layout that udb_read() maps into memory
+   instead of copying. It starts with the 200-byte main header of a UDB
+   file (with udb2_signature as magic number), followed at offset
+   udb2_table_offset by the table below. The sections it points to hold
+   the arrays of Dbindex and Database exactly as udb_read() builds them
+   from a UDB file, each starting at a multiple of udb2_alignment. */
+
+constexpr uint64_t udb2_table_offset = 256;
+constexpr uint64_t udb2_alignment = 64;
+
+/* flag of a packed index: the kmerindex section holds the packed lists of
+   Dbindex::pack() (for every k-mer) and kmerhash their byte offsets */
+constexpr uint64_t udb2_flag_packed = 1;
+
+/* flag of a file with a taxonomy section: the interned tax= names of
+   class Taxonomy, so that sintax and --lcaout need not parse headers */
+constexpr uint64_t udb2_flag_taxonomy = 2;
+
+struct udb2_table_s
+{
+  uint64_t signature;  /* udb2_signature */
+  uint64_t seqcount;
+  uint64_t hashsize;  /* 4^wordlength */
+  uint64_t indexsize;  /* entries in the kmerindex section */
+  uint64_t nucleotides;
+  uint64_t datasize;  /* bytes of headers and sequences, zero-terminated */
+  uint64_t longest;
+  uint64_t shortest;
+  uint64_t longestheader;
+  uint64_t kmercount_offset;  /* hashsize uint32_t */
+  uint64_t kmerhash_offset;  /* hashsize + 1 uint64_t */
+  uint64_t kmerindex_offset;  /* indexsize uint32_t, or kmerhash[hashsize] bytes */
+  uint64_t seqindex_offset;  /* seqcount seqinfo_t */
+  uint64_t data_offset;  /* datasize bytes */
+  uint64_t filesize;
+  uint64_t flags;
+  uint64_t taxnames;  /* interned names, with the empty name (id 0) */
+  uint64_t taxids_offset;  /* seqcount * tax_levels uint32_t */
+  uint64_t taxname_start_offset;  /* taxnames + 1 uint64_t */
+  uint64_t taxname_data_offset;  /* taxname_start[taxnames] bytes */
+};
+
+
 auto udb_detect_isudb(const char * filename) -> bool;
 auto udb_read(const char * filename,
               bool create_bitmaps,
@@ -67,3 +117,9 @@ auto udb_read(const char * filename,
               struct Dbindex & dbindex,
               struct Database & db,
               struct Parameters const & parameters) -> void;
+
+/* view the taxonomy section of the UDB v2 file mapped by udb_read(), if
+   it has one, and return whether it had */
+auto udb_read_taxonomy(struct Dbindex const & dbindex,
+                       struct Database const & db,
+                       class Taxonomy & taxonomy) -> bool;
@@ -61,11 +61,11 @@
 #include "vsearch.h"
 #include "vendored/city.h"
 #include "core/mask.hpp"
-#include "utils/maps.hpp"
-#include <algorithm>  // std::min
+#include "utils/fatal.hpp"
+#include "utils/pack_2bit.hpp"
+#include <algorithm>  // std::max
 #include <cstdint> // uint64_t
 #include <cstring>  // std::memset
-#include <functional>  // std::function
 
 
 /*
@@ -94,6 +94,11 @@ namespace {
   };
 
 
+  /* words shorter than this are marked in a bitmap of 4^k bits,
+     longer words in a hash table sized after the sequence */
+  constexpr auto min_hashed_wordlength = 10;
+  constexpr auto max_wordlength = 15;
+
 }  // end of anonymous namespace
 
 
@@ -110,6 +115,14 @@ struct uhandle_s
 
   uint64_t bitmap_size;
   uint64_t * bitmap;
+  // number of kmers at the start of list that are marked in the bitmap,
+  // or -1 when the bitmap must be cleared in full before its next use
+  int64_t bitmap_marked;
+
+  // the sequence, packed (see pack_2bit), with room for packed_alloc symbols
+  int64_t packed_alloc;
+  uint64_t * codes;
+  uint64_t * masked;
 };
 
 
@@ -129,6 +142,11 @@ auto unique_init() -> struct uhandle_s *
 
   unique_handle->bitmap_size = 0;
   unique_handle->bitmap = nullptr;
+  unique_handle->bitmap_marked = 0;
+
+  unique_handle->packed_alloc = 0;
+  unique_handle->codes = nullptr;
+  unique_handle->masked = nullptr;
 
   return unique_handle;
 }
@@ -148,190 +166,234 @@ auto unique_exit(struct uhandle_s * unique_handle) -> void
     {
       xfree(unique_handle->list);
     }
-  xfree(unique_handle);
-}
-
-
-auto unique_count_bitmap(struct uhandle_s * unique_handle,
-                         int const wordlength,
-                         int const seqlen,
-                         char const * seq,
-                         unsigned int * listlen,
-                         unsigned int const * * list,
-                         Masking const seqmask) -> void
-{
-  /* if necessary, reallocate list of unique kmers */
-
-  if (unique_handle->alloc < seqlen)
+  if (unique_handle->codes != nullptr)
     {
-      while (unique_handle->alloc < seqlen)
-        {
-          unique_handle->alloc *= 2;
-        }
-      // failed refactoring 2025-08-19: unique_handle is passed as
-      // pointer to another struct, ownership is not clear,
-      // multithreading fails
-      unique_handle->list = static_cast<unsigned int *>(
-        xrealloc(unique_handle->list, sizeof(unsigned int) * static_cast<size_t>(unique_handle->alloc)));
-    }
-
-  uint64_t const size = 1ULL << (wordlength << 1ULL);
-
-  /* reallocate bitmap arrays if necessary */
-
-  if (unique_handle->bitmap_size < size)
-    {
-      unique_handle->bitmap = static_cast<uint64_t *>(xrealloc(unique_handle->bitmap, size >> 3ULL));
-      unique_handle->bitmap_size = size;
-    }
-
-  std::memset(unique_handle->bitmap, 0, size >> 3ULL);
-
-  uint64_t bad = 0;
-  uint64_t kmer = 0;
-  uint64_t const mask = size - 1ULL;
-  auto const * s = seq;
-  auto const * e1 = s + wordlength - 1;
-  auto const * e2 = s + seqlen;
-  e1 = std::min(e2, e1);
-
-  std::function<unsigned int(char)> const maskmap = (seqmask != Masking::none) ?
-    map_mask_lower : map_mask_ambig;
-
-  while (s < e1)
-    {
-      bad <<= 2ULL;
-      bad |= maskmap(*s);
-
-      kmer <<= 2ULL;
-      kmer |= map_2bit(*s);
-      ++s;
-    }
-
-  auto unique = 0;
-
-  while (s < e2)
-    {
-      bad <<= 2ULL;
-      bad |= maskmap(*s);
-      bad &= mask;
-
-      kmer <<= 2ULL;
-      kmer |= map_2bit(*s);
-      ++s;
-      kmer &= mask;
-
-      if (bad == 0U)
-        {
-          uint64_t const x = kmer >> 6ULL;
-          uint64_t const y = 1ULL << (kmer & 63ULL);
-          if ((unique_handle->bitmap[x] & y) == 0U)
-            {
-              /* not seen before */
-              unique_handle->list[unique] = static_cast<unsigned int>(kmer);
-              ++unique;
-              unique_handle->bitmap[x] |= y;
-            }
-        }
+      xfree(unique_handle->codes);
+      xfree(unique_handle->masked);
     }
-
-  *listlen = static_cast<unsigned int>(unique);
-  *list = unique_handle->list;
+  xfree(unique_handle);
 }
 
 
-auto unique_count_hash(struct uhandle_s * unique_handle,
-                       int const wordlength,
-                       int const seqlen,
-                       char const * seq,
-                       unsigned int * listlen,
-                       unsigned int const * * list,
-                       Masking const seqmask) -> void
-{
-  /* if necessary, reallocate hash table and list of unique kmers */
-
-  int64_t const needed = 2 * static_cast<int64_t>(seqlen);
-  if (unique_handle->alloc < needed)
-    {
-      while (unique_handle->alloc < needed)
-        {
-          unique_handle->alloc *= 2;
-        }
-      unique_handle->hash = static_cast<struct bucket_s *>(
-        xrealloc(unique_handle->hash, sizeof(struct bucket_s) * static_cast<size_t>(unique_handle->alloc)));
-      unique_handle->list = static_cast<unsigned int *>(
-        xrealloc(unique_handle->list, sizeof(unsigned int) * static_cast<size_t>(unique_handle->alloc)));
-    }
-
-  /* hashtable variant */
-
-  unique_handle->size = 1;
-  while (unique_handle->size < needed)
-    {
-      unique_handle->size *= 2;
-    }
-  unique_handle->hash_mask = static_cast<unsigned int>(unique_handle->size - 1);
+// anonymous namespace: limit visibility and usage to this translation unit
+namespace {
 
-  std::memset(unique_handle->hash, 0, sizeof(struct bucket_s) * static_cast<size_t>(unique_handle->size));
+  /* pack the sequence, growing the buffers if necessary */
+  auto pack_sequence(struct uhandle_s * unique_handle, char const * seq,
+                     int const seqlen, bool const soft_masked) -> void {
+    if (unique_handle->packed_alloc < seqlen)
+      {
+        unique_handle->packed_alloc = std::max<int64_t>(seqlen, 2 * unique_handle->packed_alloc);
+        unique_handle->codes = static_cast<uint64_t *>(
+          xrealloc(unique_handle->codes, sizeof(uint64_t) * packed_code_words(unique_handle->packed_alloc)));
+        unique_handle->masked = static_cast<uint64_t *>(
+          xrealloc(unique_handle->masked, sizeof(uint64_t) * packed_mask_words(unique_handle->packed_alloc)));
+      }
+    pack_2bit(seq, seqlen, soft_masked, unique_handle->codes, unique_handle->masked);
+  }
+
+
+  /* grow the list of unique kmers to hold at least n entries */
+  auto reserve_list(struct uhandle_s * unique_handle, int64_t const n) -> void {
+    if (unique_handle->alloc >= n)
+      {
+        return;
+      }
+    while (unique_handle->alloc < n)
+      {
+        unique_handle->alloc *= 2;
+      }
+    // failed refactoring 2025-08-19: unique_handle is passed as
+    // pointer to another struct, ownership is not clear,
+    // multithreading fails
+    unique_handle->list = static_cast<unsigned int *>(
+      xrealloc(unique_handle->list, sizeof(unsigned int) * static_cast<size_t>(unique_handle->alloc)));
+  }
+
+
+  /* Return a cleared bitmap of at least 4^k bits. Instead of clearing
+     all 4^k bits on each call, only the words marked by the previous
+     call are reset, unless they are too many. */
+  template <int wordlength>
+  auto clear_bitmap(struct uhandle_s * unique_handle) -> uint64_t * {
+    static constexpr auto size = uint64_t{1} << (2U * wordlength);
+    static constexpr auto words = (size + 63U) / 64U;
+
+    if (unique_handle->bitmap_size < size)
+      {
+        if (unique_handle->bitmap != nullptr)
+          {
+            xfree(unique_handle->bitmap);
+          }
+        unique_handle->bitmap = static_cast<uint64_t *>(xmalloc(words * sizeof(uint64_t)));
+        unique_handle->bitmap_size = size;
+        unique_handle->bitmap_marked = -1;
+      }
+
+    auto * bitmap = unique_handle->bitmap;
+    auto const marked = unique_handle->bitmap_marked;
+    if ((marked < 0) or (static_cast<uint64_t>(marked) > words))
+      {
+        std::memset(bitmap, 0, (unique_handle->bitmap_size + 63U) / 64U * sizeof(uint64_t));
+      }
+    else
+      {
+        for (auto i = int64_t{0}; i < marked; ++i)
+          {
+            bitmap[unique_handle->list[i] >> 6U] = 0;
+          }
+      }
+    unique_handle->bitmap_marked = 0;
+    return bitmap;
+  }
+
+
+  template <int wordlength, bool soft_masked>
+  auto unique_count_bitmap(struct uhandle_s * unique_handle,
+                           int const seqlen,
+                           char const * seq,
+                           unsigned int * listlen,
+                           unsigned int const * * list) -> void
+  {
+    auto * bitmap = clear_bitmap<wordlength>(unique_handle);
 
-  uint64_t bad = 0;
-  uint64_t j = 0;
-  auto kmer = 0U;
-  unsigned int const mask = static_cast<unsigned int>((1ULL << (2ULL * static_cast<unsigned int>(wordlength))) - 1ULL);
-  auto const * s = seq;
-  auto const * e1 = s + wordlength - 1;
-  auto const * e2 = s + seqlen;
-  e1 = std::min(e2, e1);
+    /* if necessary, reallocate list of unique kmers */
 
-  std::function<unsigned int(char)> const maskmap = (seqmask != Masking::none) ?
-    map_mask_lower : map_mask_ambig;
+    reserve_list(unique_handle, seqlen);
+    auto * unique_list = unique_handle->list;
 
-  while (s < e1)
-    {
-      bad <<= 2ULL;
-      bad |= maskmap(*s);
+    pack_sequence(unique_handle, seq, seqlen, soft_masked);
 
-      kmer <<= 2ULL;
-      kmer |= map_2bit(*s);
-      ++s;
-    }
+    auto unique = 0U;
 
-  uint64_t unique = 0;
+    for_each_packed_kmer(unique_handle->codes, unique_handle->masked, seqlen, wordlength,
+                         [bitmap, unique_list, &unique](unsigned int const kmer, int64_t const /* start */) {
+                           auto const x = kmer >> 6U;
+                           auto const y = uint64_t{1} << (kmer & 63U);
+                           if ((bitmap[x] & y) == 0U)
+                             {
+                               /* not seen before */
+                               unique_list[unique] = kmer;
+                               ++unique;
+                               bitmap[x] |= y;
+                             }
+                         });
 
-  while (s < e2)
-    {
-      bad <<= 2ULL;
-      bad |= maskmap(*s);
-      bad &= mask;
+    unique_handle->bitmap_marked = unique;
+    *listlen = unique;
+    *list = unique_list;
+  }
 
-      kmer <<= 2ULL;
-      kmer |= map_2bit(*s);
-      ++s;
-      kmer &= mask;
 
-      if (bad == 0U)
-        {
-          /* find free appropriate bucket in hash */
-          j = hash_function(reinterpret_cast<char const *>(&kmer), static_cast<size_t>((wordlength + 3) / 4)) & unique_handle->hash_mask;
-          while ((unique_handle->hash[j].count != 0U) && (unique_handle->hash[j].kmer != kmer))
-            {
-              j = (j + 1) & unique_handle->hash_mask;
-            }
-
-          if (unique_handle->hash[j].count == 0U)
-            {
-              /* not seen before */
-              unique_handle->list[unique] = kmer;
-              ++unique;
-              unique_handle->hash[j].kmer = kmer;
-              unique_handle->hash[j].count = 1;
-            }
-        }
-    }
+  template <int wordlength, bool soft_masked>
+  auto unique_count_hash(struct uhandle_s * unique_handle,
+                         int const seqlen,
+                         char const * seq,
+                         unsigned int * listlen,
+                         unsigned int const * * list) -> void
+  {
+    static constexpr auto hashed_bytes = static_cast<size_t>((wordlength + 3) / 4);
+
+    /* the list is overwritten, so the bitmap can no longer be reset
+       from it */
+    if (unique_handle->bitmap_marked != 0)
+      {
+        unique_handle->bitmap_marked = -1;
+      }
+
+    /* if necessary, reallocate hash table and list of unique kmers */
+
+    int64_t const needed = 2 * static_cast<int64_t>(seqlen);
+    if (unique_handle->alloc < needed)
+      {
+        while (unique_handle->alloc < needed)
+          {
+            unique_handle->alloc *= 2;
+          }
+        unique_handle->hash = static_cast<struct bucket_s *>(
+          xrealloc(unique_handle->hash, sizeof(struct bucket_s) * static_cast<size_t>(unique_handle->alloc)));
+        unique_handle->list = static_cast<unsigned int *>(
+          xrealloc(unique_handle->list, sizeof(unsigned int) * static_cast<size_t>(unique_handle->alloc)));
+      }
+
+    /* hashtable variant */
+
+    unique_handle->size = 1;
+    while (unique_handle->size < needed)
+      {
+        unique_handle->size *= 2;
+      }
+    unique_handle->hash_mask = static_cast<unsigned int>(unique_handle->size - 1);
+
+    std::memset(unique_handle->hash, 0, sizeof(struct bucket_s) * static_cast<size_t>(unique_handle->size));
+
+    auto * hash = unique_handle->hash;
+    auto * unique_list = unique_handle->list;
+    auto const hash_mask = unique_handle->hash_mask;
+
+    pack_sequence(unique_handle, seq, seqlen, soft_masked);
+
+    uint64_t unique = 0;
+
+    for_each_packed_kmer(unique_handle->codes, unique_handle->masked, seqlen, wordlength,
+                         [hash, unique_list, hash_mask, &unique](unsigned int const kmer, int64_t const /* start */) {
+                           /* find free appropriate bucket in hash */
+                           auto j = hash_function(reinterpret_cast<char const *>(&kmer), hashed_bytes) & hash_mask;
+                           while ((hash[j].count != 0U) && (hash[j].kmer != kmer))
+                             {
+                               j = (j + 1) & hash_mask;
+                             }
+
+                           if (hash[j].count == 0U)
+                             {
+                               /* not seen before */
+                               unique_list[unique] = kmer;
+                               ++unique;
+                               hash[j].kmer = kmer;
+                               hash[j].count = 1;
+                             }
+                         });
+
+    *listlen = static_cast<unsigned int>(unique);
+    *list = unique_list;
+  }
+
+
+  using unique_counter = void (*)(struct uhandle_s * unique_handle,
+                                  int seqlen,
+                                  char const * seq,
+                                  unsigned int * listlen,
+                                  unsigned int const * * list);
+
+
+  template <int wordlength, bool soft_masked>
+  auto unique_counter_for() -> unique_counter {
+    return (wordlength < min_hashed_wordlength) ?
+      &unique_count_bitmap<wordlength, soft_masked> :
+      &unique_count_hash<wordlength, soft_masked>;
+  }
+
+
+  /* the extractor specialized for a word length and masking mode */
+  template <int wordlength>
+  auto select_unique_counter(int const k, bool const soft_masked) -> unique_counter {
+    if (k != wordlength)
+      {
+        return select_unique_counter<wordlength + 1>(k, soft_masked);
+      }
+    return soft_masked ?
+      unique_counter_for<wordlength, true>() :
+      unique_counter_for<wordlength, false>();
+  }
+
+
+  template <>
+  auto select_unique_counter<max_wordlength + 1>(int const /* k */, bool const /* soft_masked */) -> unique_counter {
+    fatal("Unsupported word length");
+    return nullptr;
+  }
 
-  *listlen = static_cast<unsigned int>(unique);
-  *list = unique_handle->list;
-}
+}  // end of anonymous namespace
 
 
 auto unique_count(struct uhandle_s * unique_handle,
@@ -342,14 +404,8 @@ auto unique_count(struct uhandle_s * unique_handle,
                   unsigned int const * * list,
                   Masking const seqmask) -> void
 {
-  if (wordlength < 10)
-    {
-      unique_count_bitmap(unique_handle, wordlength, seqlen, seq, listlen, list, seqmask);
-    }
-  else
-    {
-      unique_count_hash(unique_handle, wordlength, seqlen, seq, listlen, list, seqmask);
-    }
+  auto const counter = select_unique_counter<1>(wordlength, seqmask != Masking::none);
+  counter(unique_handle, seqlen, seq, listlen, list);
 }
 
 
@@ -362,7 +418,7 @@ auto unique_count_shared(struct uhandle_s const & unique_handle,
      (already computed) hash or bitmap */
 
   auto count = 0U;
-  if (wordlength < 10)
+  if (wordlength < min_hashed_wordlength)
     {
       for (auto i = 0; i < listlen; i++)
         {
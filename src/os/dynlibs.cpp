@@ -103,7 +103,29 @@ DynamicLibraries::DynamicLibraries() noexcept
         dynlib::symbol(gz_lib, "gzclose"));
       gzread_p = reinterpret_cast<int (*)(gzFile, void*, unsigned)>(
         dynlib::symbol(gz_lib, "gzread"));
-      if (not ((gzdopen_p != nullptr) && (gzclose_p != nullptr) && (gzread_p != nullptr)))
+      inflateInit2_p = reinterpret_cast<int (*)(z_streamp, int, char const *, int)>(
+        dynlib::symbol(gz_lib, "inflateInit2_"));
+      inflate_p = reinterpret_cast<int (*)(z_streamp, int)>(
+        dynlib::symbol(gz_lib, "inflate"));
+      inflateReset_p = reinterpret_cast<int (*)(z_streamp)>(
+        dynlib::symbol(gz_lib, "inflateReset"));
+      inflateEnd_p = reinterpret_cast<int (*)(z_streamp)>(
+        dynlib::symbol(gz_lib, "inflateEnd"));
+      deflateInit2_p = reinterpret_cast<int (*)(z_streamp, int, int, int, int, int, char const *, int)>(
+        dynlib::symbol(gz_lib, "deflateInit2_"));
+      deflate_p = reinterpret_cast<int (*)(z_streamp, int)>(
+        dynlib::symbol(gz_lib, "deflate"));
+      deflateReset_p = reinterpret_cast<int (*)(z_streamp)>(
+        dynlib::symbol(gz_lib, "deflateReset"));
+      deflateEnd_p = reinterpret_cast<int (*)(z_streamp)>(
+        dynlib::symbol(gz_lib, "deflateEnd"));
+      crc32_p = reinterpret_cast<uLong (*)(uLong, Bytef const *, uInt)>(
+        dynlib::symbol(gz_lib, "crc32"));
+      if (not ((gzdopen_p != nullptr) && (gzclose_p != nullptr) && (gzread_p != nullptr) &&
+               (inflateInit2_p != nullptr) && (inflate_p != nullptr) &&
+               (inflateReset_p != nullptr) && (inflateEnd_p != nullptr) &&
+               (deflateInit2_p != nullptr) && (deflate_p != nullptr) &&
+               (deflateReset_p != nullptr) && (deflateEnd_p != nullptr) && (crc32_p != nullptr)))
         {
           fatal("Invalid compression library (zlib)");
         }
@@ -120,7 +142,17 @@ DynamicLibraries::DynamicLibraries() noexcept
         dynlib::symbol(bz2_lib, "BZ2_bzReadClose"));
       BZ2_bzRead_p = reinterpret_cast<int (*)(int*, BZFILE*, void*, int)>(
         dynlib::symbol(bz2_lib, "BZ2_bzRead"));
-      if (not ((BZ2_bzReadOpen_p != nullptr) && (BZ2_bzReadClose_p != nullptr) && (BZ2_bzRead_p != nullptr)))
+      BZ2_bzReadGetUnused_p = reinterpret_cast<void (*)(int*, BZFILE*, void**, int*)>(
+        dynlib::symbol(bz2_lib, "BZ2_bzReadGetUnused"));
+      BZ2_bzDecompressInit_p = reinterpret_cast<int (*)(bz_stream*, int, int)>(
+        dynlib::symbol(bz2_lib, "BZ2_bzDecompressInit"));
+      BZ2_bzDecompress_p = reinterpret_cast<int (*)(bz_stream*)>(
+        dynlib::symbol(bz2_lib, "BZ2_bzDecompress"));
+      BZ2_bzDecompressEnd_p = reinterpret_cast<int (*)(bz_stream*)>(
+        dynlib::symbol(bz2_lib, "BZ2_bzDecompressEnd"));
+      if (not ((BZ2_bzReadOpen_p != nullptr) && (BZ2_bzReadClose_p != nullptr) && (BZ2_bzRead_p != nullptr) &&
+               (BZ2_bzReadGetUnused_p != nullptr) && (BZ2_bzDecompressInit_p != nullptr) &&
+               (BZ2_bzDecompress_p != nullptr) && (BZ2_bzDecompressEnd_p != nullptr)))
         {
           fatal("Invalid compression library (bz2)");
         }
@@ -91,6 +91,21 @@ public:
   auto gzclose(gzFile file) const noexcept -> int { return gzclose_p(file); }
   auto gzread(gzFile file, void * buffer, unsigned length) const noexcept -> int
   { return gzread_p(file, buffer, length); }
+  auto inflate_init2(z_stream * stream, int window_bits) const noexcept -> int
+  { return inflateInit2_p(stream, window_bits, ZLIB_VERSION, static_cast<int>(sizeof(z_stream))); }
+  auto inflate(z_stream * stream, int flush) const noexcept -> int
+  { return inflate_p(stream, flush); }
+  auto inflate_reset(z_stream * stream) const noexcept -> int { return inflateReset_p(stream); }
+  auto inflate_end(z_stream * stream) const noexcept -> int { return inflateEnd_p(stream); }
+  auto deflate_init2(z_stream * stream, int level, int window_bits) const noexcept -> int
+  { return deflateInit2_p(stream, level, Z_DEFLATED, window_bits, default_mem_level,
+                          Z_DEFAULT_STRATEGY, ZLIB_VERSION, static_cast<int>(sizeof(z_stream))); }
+  auto deflate(z_stream * stream, int flush) const noexcept -> int
+  { return deflate_p(stream, flush); }
+  auto deflate_reset(z_stream * stream) const noexcept -> int { return deflateReset_p(stream); }
+  auto deflate_end(z_stream * stream) const noexcept -> int { return deflateEnd_p(stream); }
+  auto crc32(unsigned long crc, unsigned char const * buffer, unsigned int length) const noexcept -> unsigned long
+  { return crc32_p(crc, buffer, length); }
   auto gzip_version() const noexcept -> char const *;
   auto gzip_compile_flags() const noexcept -> unsigned long;
 #endif
@@ -104,6 +119,12 @@ public:
   { BZ2_bzReadClose_p(bzerror, file); }
   auto bz_read(int * bzerror, BZFILE * file, void * buffer, int length) const noexcept -> int
   { return BZ2_bzRead_p(bzerror, file, buffer, length); }
+  auto bz_read_get_unused(int * bzerror, BZFILE * file, void ** unused, int * unused_length) const noexcept -> void
+  { BZ2_bzReadGetUnused_p(bzerror, file, unused, unused_length); }
+  auto bz_decompress_init(bz_stream * stream, int verbosity, int use_small) const noexcept -> int
+  { return BZ2_bzDecompressInit_p(stream, verbosity, use_small); }
+  auto bz_decompress(bz_stream * stream) const noexcept -> int { return BZ2_bzDecompress_p(stream); }
+  auto bz_decompress_end(bz_stream * stream) const noexcept -> int { return BZ2_bzDecompressEnd_p(stream); }
 #endif
 
 private:
@@ -112,11 +133,25 @@ private:
   gzFile ZEXPORT (*gzdopen_p) OF((int, char const *)) = nullptr;
   int ZEXPORT (*gzclose_p) OF((gzFile)) = nullptr;
   int ZEXPORT (*gzread_p) OF((gzFile, void *, unsigned)) = nullptr;
+  int ZEXPORT (*inflateInit2_p) OF((z_streamp, int, char const *, int)) = nullptr;
+  int ZEXPORT (*inflate_p) OF((z_streamp, int)) = nullptr;
+  int ZEXPORT (*inflateReset_p) OF((z_streamp)) = nullptr;
+  int ZEXPORT (*inflateEnd_p) OF((z_streamp)) = nullptr;
+  int ZEXPORT (*deflateInit2_p) OF((z_streamp, int, int, int, int, int, char const *, int)) = nullptr;
+  int ZEXPORT (*deflate_p) OF((z_streamp, int)) = nullptr;
+  int ZEXPORT (*deflateReset_p) OF((z_streamp)) = nullptr;
+  int ZEXPORT (*deflateEnd_p) OF((z_streamp)) = nullptr;
+  uLong ZEXPORT (*crc32_p) OF((uLong, Bytef const *, uInt)) = nullptr;
+  static constexpr int default_mem_level = 8;  // as deflateInit()
 #endif
 #ifdef HAVE_BZLIB_H
   void * bz2_lib = nullptr;
   BZFILE * (*BZ2_bzReadOpen_p)(int *, FILE *, int, int, void *, int) = nullptr;
   void (*BZ2_bzReadClose_p)(int *, BZFILE *) = nullptr;
   int (*BZ2_bzRead_p)(int *, BZFILE *, void *, int) = nullptr;
+  void (*BZ2_bzReadGetUnused_p)(int *, BZFILE *, void **, int *) = nullptr;
+  int (*BZ2_bzDecompressInit_p)(bz_stream *, int, int) = nullptr;
+  int (*BZ2_bzDecompress_p)(bz_stream *) = nullptr;
+  int (*BZ2_bzDecompressEnd_p)(bz_stream *) = nullptr;
 #endif
 };
@@ -65,7 +65,9 @@
 #include <cstdint>  // uint64_t
 #include <cstdio>  // std::FILE, std::size_t
 #include <cstdlib>  // posix_memalign, std::realloc, std::free
+#include <sys/mman.h>  // mmap, munmap, posix_madvise
 #include <sys/stat.h>  // fstat, stat, struct stat
+#include <sys/types.h>  // ssize_t
 #include <unistd.h>  // sysconf, _SC_NPROCESSORS_ONLN, lseek, off_t
 
 /* system_get_memused()/system_get_memtotal() are genuinely per-OS and live in
@@ -73,7 +75,8 @@
    uniform POSIX. */
 
 
-constexpr auto vsearch_memalignment = 16;
+/* 64 bytes: the widest vector loaded/stored aligned by search16 (AVX-512) */
+constexpr auto vsearch_memalignment = 64;
 
 
 auto system_get_cores() -> long
@@ -103,8 +106,8 @@ auto xrealloc(void * ptr, std::size_t size) -> void *
 {
   /* NOTE: unlike xmalloc (posix_memalign), the POSIX branch here uses plain
      realloc, which only guarantees max_align_t alignment, not xmalloc's
-     vsearch_memalignment (16 bytes). Buffers that require 16-byte alignment
-     for aligned SIMD loads/stores (the align_simd.cc VECTOR_SHORT arrays) must
+     vsearch_memalignment (64 bytes). Buffers that require that alignment for
+     aligned SIMD loads/stores (the search16 profile and H/E arrays) must
      therefore be allocated with xmalloc and never grown through xrealloc. As
      audited, no such buffer currently passes through xrealloc — every caller
      resizes byte/scalar data (input buffers, sequence storage, query strings,
@@ -161,3 +164,100 @@ auto xftello(std::FILE * stream) -> uint64_t
   assert(position != static_cast<off_t>(-1));  // unchecked: -1 would widen to a huge uint64_t
   return static_cast<uint64_t>(position);
 }
+
+
+auto xmmap_private(int file_descriptor, uint64_t size) -> void *
+{
+  void * ptr = mmap(nullptr, static_cast<std::size_t>(size), PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE, file_descriptor, 0);
+  if (ptr == MAP_FAILED)
+    {
+      return nullptr;
+    }
+  return ptr;
+}
+
+
+auto xmmap_sequential(int file_descriptor, uint64_t size) -> void *
+{
+  void * ptr = mmap(nullptr, static_cast<std::size_t>(size), PROT_READ,
+                    MAP_PRIVATE, file_descriptor, 0);
+  if (ptr == MAP_FAILED)
+    {
+      return nullptr;
+    }
+  static_cast<void>(posix_madvise(ptr, static_cast<std::size_t>(size), POSIX_MADV_SEQUENTIAL));
+  return ptr;
+}
+
+
+auto xmunmap(void * ptr, uint64_t size) -> void
+{
+  munmap(ptr, static_cast<std::size_t>(size));
+}
+
+
+namespace {
+
+  struct stream_callbacks
+  {
+    void * cookie;
+    xstream_write_t write_function;
+    xstream_close_t close_function;
+  };
+
+
+  auto close_stream(void * callbacks) -> int
+  {
+    auto * const stream = static_cast<stream_callbacks *>(callbacks);
+    auto const success = stream->close_function(stream->cookie);
+    delete stream;
+    return success ? 0 : -1;
+  }
+
+#if defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+
+  auto write_stream(void * callbacks, char const * buffer, int size) -> int
+  {
+    auto const * const stream = static_cast<stream_callbacks const *>(callbacks);
+    if (not stream->write_function(stream->cookie, buffer, static_cast<std::size_t>(size)))
+      {
+        return -1;
+      }
+    return size;
+  }
+
+#else
+
+  auto write_stream(void * callbacks, char const * buffer, std::size_t size) -> ssize_t
+  {
+    auto const * const stream = static_cast<stream_callbacks const *>(callbacks);
+    if (not stream->write_function(stream->cookie, buffer, size))
+      {
+        return -1;
+      }
+    return static_cast<ssize_t>(size);
+  }
+
+#endif
+
+}  // end of anonymous namespace
+
+
+auto xfopen_writer(void * cookie,
+                   xstream_write_t write_function,
+                   xstream_close_t close_function) -> std::FILE *
+{
+  auto * const callbacks = new stream_callbacks{cookie, write_function, close_function};
+#if defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+  auto * const stream = funopen(callbacks, nullptr, write_stream, nullptr, close_stream);
+#else
+  cookie_io_functions_t const functions {nullptr, write_stream, nullptr, close_stream};
+  auto * const stream = fopencookie(callbacks, "w", functions);
+#endif
+  if (stream == nullptr)
+    {
+      delete callbacks;
+    }
+  return stream;
+}
@@ -87,3 +87,22 @@ auto xfstat(int file_descriptor, xstat_t * buf) -> int;
 auto xstat(const char * path, xstat_t  * buf) -> int;
 auto xlseek(int file_descriptor, uint64_t offset, int whence) -> uint64_t;
 auto xftello(std::FILE * stream) -> uint64_t;
+
+/* copy-on-write mapping of the first size bytes of an open file: pages
+   are shared with the page cache until written; nullptr on failure */
+auto xmmap_private(int file_descriptor, uint64_t size) -> void *;
+/* read-only mapping of the first size bytes of an open file that will be
+   read once from start to end (the system is advised to read ahead);
+   nullptr on failure */
+auto xmmap_sequential(int file_descriptor, uint64_t size) -> void *;
+auto xmunmap(void * ptr, uint64_t size) -> void;
+
+/* write-only stdio stream handing its output to write_function(cookie, ...);
+   close_function(cookie) runs when the stream is closed. Both return false
+   on error, which std::fflush()/std::fclose() then report. nullptr when the
+   system has no custom streams. */
+using xstream_write_t = auto (*)(void * cookie, char const * buffer, std::size_t size) -> bool;
+using xstream_close_t = auto (*)(void * cookie) -> bool;
+auto xfopen_writer(void * cookie,
+                   xstream_write_t write_function,
+                   xstream_close_t close_function) -> std::FILE *;
@@ -58,12 +58,12 @@
 
 */
 
-#include <windows.h>  // SYSTEM_INFO, GetSystemInfo
+#include <windows.h>  // SYSTEM_INFO, GetSystemInfo, CreateFileMapping, MapViewOfFile
 #include <algorithm>  // std::max
 #include <cassert>  // assert
 #include <cstdint>  // uint64_t
 #include <cstdio>  // std::FILE, _ftelli64
-#include <io.h>  // _lseeki64
+#include <io.h>  // _lseeki64, _get_osfhandle
 #include <malloc.h>  // _aligned_malloc, _aligned_realloc, _aligned_free
 #include <sys/stat.h>  // _fstat64, _stat64
 // <sys/stat.h> must precede "system.h": it defines the "#define __stat64
@@ -78,7 +78,8 @@
    Win32-specific but not memory-related. */
 
 
-constexpr auto vsearch_memalignment = 16;
+/* 64 bytes: the widest vector loaded/stored aligned by search16 (AVX-512) */
+constexpr auto vsearch_memalignment = 64;
 
 
 auto system_get_cores() -> long
@@ -104,10 +105,10 @@ auto xmalloc(std::size_t size) -> void *
 
 auto xrealloc(void * ptr, std::size_t size) -> void *
 {
-  /* NOTE: _aligned_realloc preserves the vsearch_memalignment (16-byte)
+  /* NOTE: _aligned_realloc preserves the vsearch_memalignment (64-byte)
      alignment that _aligned_malloc gave the block, so this Windows branch,
      unlike the POSIX xrealloc (plain realloc, only max_align_t), is safe for
-     the 16-byte-aligned SIMD buffers (the align_simd.cc VECTOR_SHORT arrays).
+     the 64-byte-aligned SIMD buffers (the search16 profile and H/E arrays).
      The portable contract nevertheless still holds: those buffers are
      allocated with xmalloc and, as audited, never grown through xrealloc —
      every caller resizes byte/scalar data (input buffers, sequence storage,
@@ -164,3 +165,56 @@ auto xftello(std::FILE * stream) -> uint64_t
   assert(position != -1);  // unchecked: -1 would widen to a huge uint64_t
   return position;
 }
+
+
+auto xmmap_private(int file_descriptor, uint64_t size) -> void *
+{
+  /* FILE_MAP_COPY gives the copy-on-write semantics of MAP_PRIVATE; the
+     view keeps the mapping object alive after its handle is closed */
+  auto * const file = reinterpret_cast<HANDLE>(_get_osfhandle(file_descriptor));
+  if (file == INVALID_HANDLE_VALUE)
+    {
+      return nullptr;
+    }
+  HANDLE const mapping = CreateFileMapping(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+  if (mapping == nullptr)
+    {
+      return nullptr;
+    }
+  void * ptr = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, size);
+  CloseHandle(mapping);
+  return ptr;
+}
+
+
+auto xmmap_sequential(int file_descriptor, uint64_t size) -> void *
+{
+  auto * const file = reinterpret_cast<HANDLE>(_get_osfhandle(file_descriptor));
+  if (file == INVALID_HANDLE_VALUE)
+    {
+      return nullptr;
+    }
+  HANDLE const mapping = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping == nullptr)
+    {
+      return nullptr;
+    }
+  void * ptr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+  CloseHandle(mapping);
+  return ptr;
+}
+
+
+auto xmunmap(void * ptr, uint64_t /* size */) -> void
+{
+  UnmapViewOfFile(ptr);
+}
+
+
+auto xfopen_writer(void * /* cookie */,
+                   xstream_write_t /* write_function */,
+                   xstream_close_t /* close_function */) -> std::FILE *
+{
+  /* the C runtime has no user-defined streams */
+  return nullptr;
+}
@@ -60,6 +60,7 @@
 
 #include "cigar_operations.hpp"
 #include "fatal.hpp"
+#include "output_buffer.hpp"
 #include "span.hpp"
 #include <algorithm>  // std::max
 #include <cassert>
@@ -170,15 +171,12 @@ auto parse_cigar_string(Span<char> const cigar_string) -> std::vector<std::pair<
 // refactoring: run-length decoding: this is not cigar-specific,
 // extract to its own header? check if I need a run-length encoding
 // function (see swarm:cigar.cc for an example)
-auto print_uncompressed_cigar(std::FILE * output_handle, Span<char> const cigar_string) -> void {
+auto print_uncompressed_cigar(Output_buffer & output, Span<char> const cigar_string) -> void {
   auto const cigar_pairs = parse_cigar_string(cigar_string);
   for (auto const & a_pair: cigar_pairs) {
     auto const operation = convert_from_operation(a_pair.first);
     auto const runlength = a_pair.second;
-    // refactoring? std::fprintf("%s", std::string(runlength, operation).c_str());
-    for (auto i = 0LL; i < runlength; ++i) {
-      static_cast<void>(std::fprintf(output_handle, "%c", operation));
-    }
+    output.append(static_cast<std::size_t>(runlength), operation);
   }
 }
 
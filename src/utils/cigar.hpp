@@ -59,6 +59,7 @@
 */
 
 #include "cigar_operations.hpp"
+#include "output_buffer.hpp"
 #include "span.hpp"
 #include <vector>
 #include <utility>  // std::pair
@@ -69,4 +70,4 @@ auto find_runlength_of_leftmost_operation(char const * first_character,
 
 auto parse_cigar_string(Span<char> cigar_string) -> std::vector<std::pair<Operation, long long>>;
 
-auto print_uncompressed_cigar(std::FILE * output_handle, Span<char> cigar_string) -> void;
+auto print_uncompressed_cigar(Output_buffer & output, Span<char> cigar_string) -> void;
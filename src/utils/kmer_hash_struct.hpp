@@ -58,7 +58,7 @@
 
 */
 
-#include <cstdint>  // int64_t
+#include <cstdint>  // int64_t, uint64_t
 #include <vector>
 
 
@@ -80,4 +80,7 @@ struct kh_handle_s
   int64_t size = 0;
   int64_t alloc = kmer_hash_allocation;
   int maxpos = 0;
+  /* the sequence being hashed or searched, packed (see pack_2bit) */
+  std::vector<uint64_t> codes;
+  std::vector<uint64_t> masked;
 };
@@ -0,0 +1,179 @@
+/*
+
+  VSEARCH: a versatile open source tool for metagenomics
+
+  Copyright (C) 2014-2026, Torbjorn Rognes, Frederic Mahe and Tomas Flouri
+  All rights reserved.
+
+  Contact: Torbjorn Rognes <torognes@ifi.uio.no>,
+  Department of Informatics, University of Oslo,
+  PO Box 1080 Blindern, NO-0316 Oslo, Norway
+
+  This software is dual-licensed and available under a choice
+  of one of two licenses, either under the terms of the GNU
+  General Public License version 3 or the BSD 2-Clause License.
+
+
+  GNU General Public License version 3
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+  The BSD 2-Clause License
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "output_buffer.hpp"
+#include "fatal.hpp"  // fatal
+#include <array>
+#include <cmath>  // std::floor, std::signbit, std::fabs
+#include <cstdarg>  // std::va_list, va_start, va_end
+#include <cstddef>  // std::size_t
+#include <cstdint>  // int64_t, uint64_t
+#include <cstdio>  // std::FILE, std::fwrite, std::vsnprintf, std::snprintf
+
+
+// anonymous namespace: limit visibility and usage to this translation unit
+namespace {
+
+  constexpr auto max_digits = std::size_t{20};  // of a 64-bit integer
+  constexpr auto decimal_base = uint64_t{10};
+
+  /* largest value formatted without snprintf by append_fixed1: ten
+     times the value keeps an absolute rounding error far below the
+     tie margin below */
+  constexpr auto max_fast_fixed1 = 1e6;
+  constexpr auto tie_margin = 1e-6;
+
+}  // end of anonymous namespace
+
+
+auto Output_buffer::append_unsigned(uint64_t value) -> void {
+  std::array<char, max_digits> digits;
+  auto position = digits.size();
+  do
+    {
+      --position;
+      digits[position] = static_cast<char>('0' + (value % decimal_base));
+      value /= decimal_base;
+    }
+  while (value != 0);
+  append(digits.data() + position, digits.size() - position);
+}
+
+
+auto Output_buffer::append_integer(int64_t const value) -> void {
+  if (value < 0)
+    {
+      append('-');
+      /* negate as unsigned: -INT64_MIN does not fit in an int64_t */
+      append_unsigned(uint64_t{0} - static_cast<uint64_t>(value));
+      return;
+    }
+  append_unsigned(static_cast<uint64_t>(value));
+}
+
+
+auto Output_buffer::append_fixed1(double const value) -> void {
+  /* printf rounds the exact binary value to the nearest tenth, ties to
+     even. Ten times the value, rounded to the nearest integer, gives the
+     same tenths unless the product lies close to a tie, where the
+     rounding of the product itself may matter: leave those values (and
+     large, infinite or NaN ones) to snprintf. */
+  auto const magnitude = std::fabs(value);
+  if (not (magnitude < max_fast_fixed1))
+    {
+      appendf("%.1f", value);
+      return;
+    }
+  auto const tenths = magnitude * 10.0;
+  auto const whole = std::floor(tenths);
+  auto const fraction = tenths - whole;
+  if (std::fabs(fraction - 0.5) < tie_margin)
+    {
+      appendf("%.1f", value);
+      return;
+    }
+  auto const rounded = static_cast<uint64_t>(whole) + ((fraction > 0.5) ? 1U : 0U);
+  if (std::signbit(value))
+    {
+      append('-');
+    }
+  append_unsigned(rounded / decimal_base);
+  append('.');
+  append(static_cast<char>('0' + (rounded % decimal_base)));
+}
+
+
+auto Output_buffer::appendf(char const * format, ...) -> void {
+  std::array<char, 256> small;
+  std::va_list args;
+  va_start(args, format);
+  auto const length = std::vsnprintf(small.data(), small.size(), format, args);
+  va_end(args);
+  if (length < 0)
+    {
+      fatal("Error with vsnprintf in Output_buffer::appendf");
+    }
+  auto const size = static_cast<std::size_t>(length);
+  if (size < small.size())
+    {
+      append(small.data(), size);
+      return;
+    }
+  auto const offset = text_.size();
+  text_.resize(offset + size + 1);
+  va_start(args, format);
+  std::vsnprintf(&text_[offset], size + 1, format, args);
+  va_end(args);
+  text_.pop_back();  // the terminating null character
+}
+
+
+auto Output_buffer::write(std::FILE * output_handle) const -> void {
+  write(output_handle, 0, text_.size());
+}
+
+
+auto Output_buffer::write(std::FILE * output_handle, std::size_t const begin,
+                          std::size_t const end) const -> void {
+  if (end > begin)
+    {
+      std::fwrite(text_.data() + begin, 1, end - begin, output_handle);
+    }
+}
@@ -0,0 +1,112 @@
+/*
+
+  VSEARCH: a versatile open source tool for metagenomics
+
+  Copyright (C) 2014-2026, Torbjorn Rognes, Frederic Mahe and Tomas Flouri
+  All rights reserved.
+
+  Contact: Torbjorn Rognes <torognes@ifi.uio.no>,
+  Department of Informatics, University of Oslo,
+  PO Box 1080 Blindern, NO-0316 Oslo, Norway
+
+  This software is dual-licensed and available under a choice
+  of one of two licenses, either under the terms of the GNU
+  General Public License version 3 or the BSD 2-Clause License.
+
+
+  GNU General Public License version 3
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+  The BSD 2-Clause License
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <cstdint>  // int64_t, uint64_t
+#include <cstdio>  // std::FILE
+#include <cstring>  // std::strlen
+#include <vector>
+
+
+/* Output_buffer collects formatted text, to be written to a file in a
+   single call (write). The append functions replace the most frequent
+   fprintf conversions with faster equivalents that produce the same
+   text; appendf covers the other conversions. Formatting into a buffer
+   needs no lock, so worker threads can prepare their output and leave
+   only the writing to be serialized. */
+
+class Output_buffer {
+public:
+
+  auto append(char const * text, std::size_t const length) -> void {
+    text_.insert(text_.end(), text, text + length);
+  }
+
+  auto append(char const * text) -> void {
+    append(text, std::strlen(text));
+  }
+
+  auto append(char const symbol) -> void {
+    text_.push_back(symbol);
+  }
+
+  auto append(std::size_t const count, char const symbol) -> void {
+    text_.insert(text_.end(), count, symbol);
+  }
+
+  auto append_integer(int64_t value) -> void;  // as "%" PRId64
+  auto append_unsigned(uint64_t value) -> void;  // as "%" PRIu64
+  auto append_fixed1(double value) -> void;  // as "%.1f"
+  auto appendf(char const * format, ...) -> void __attribute__((format(printf, 2, 3)));
+
+  auto data() const -> char const * { return text_.data(); }
+  auto size() const -> std::size_t { return text_.size(); }
+  auto empty() const -> bool { return text_.empty(); }
+  auto clear() -> void { text_.clear(); }
+
+  /* write all of the text, or the text from offset begin to end */
+  auto write(std::FILE * output_handle) const -> void;
+  auto write(std::FILE * output_handle, std::size_t begin, std::size_t end) const -> void;
+
+private:
+  std::vector<char> text_;
+};
@@ -0,0 +1,214 @@
+/*
+
+  VSEARCH: a versatile open source tool for metagenomics
+
+  Copyright (C) 2014-2026, Torbjorn Rognes, Frederic Mahe and Tomas Flouri
+  All rights reserved.
+
+  Contact: Torbjorn Rognes <torognes@ifi.uio.no>,
+  Department of Informatics, University of Oslo,
+  PO Box 1080 Blindern, NO-0316 Oslo, Norway
+
+  This software is dual-licensed and available under a choice
+  of one of two licenses, either under the terms of the GNU
+  General Public License version 3 or the BSD 2-Clause License.
+
+
+  GNU General Public License version 3
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+  The BSD 2-Clause License
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "pack_2bit.hpp"
+#include <algorithm>  // std::min
+#include <array>
+#include <cstdint>  // int64_t, uint64_t
+#include <cstring>  // std::memcpy
+
+
+/* The symbols are classified eight at a time, one per byte of a 64-bit
+   word (SIMD within a register), so the same code runs on every
+   architecture. */
+
+// anonymous namespace: limit visibility and usage to this translation unit
+namespace {
+
+  constexpr auto ones = uint64_t{0x0101010101010101};
+  constexpr auto low7 = uint64_t{0x7F7F7F7F7F7F7F7F};
+  constexpr auto high1 = uint64_t{0x8080808080808080};
+  constexpr auto case_bits = uint64_t{0x2020202020202020};
+  constexpr auto symbols_per_block = 8;
+
+
+  /* the high bit of each byte of x that equals symbol */
+  inline auto bytes_equal(uint64_t const x, unsigned char const symbol) -> uint64_t {
+    auto const diff = x ^ (ones * symbol);
+    return ~(((diff & low7) + low7) | diff | low7);
+  }
+
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+  constexpr auto little_endian = false;
+#else
+  constexpr auto little_endian = true;
+#endif
+
+
+  /* eight symbols, the first one in the most significant byte; the
+     missing symbols of a short block are zero */
+  inline auto load_block(char const * seq) -> uint64_t {
+    uint64_t block = 0;
+    std::memcpy(&block, seq, sizeof(block));
+    if (little_endian)
+      {
+        block = ((block & uint64_t{0x00FF00FF00FF00FF}) << 8U) | ((block >> 8U) & uint64_t{0x00FF00FF00FF00FF});
+        block = ((block & uint64_t{0x0000FFFF0000FFFF}) << 16U) | ((block >> 16U) & uint64_t{0x0000FFFF0000FFFF});
+        block = (block << 32U) | (block >> 32U);
+      }
+    return block;
+  }
+
+
+  inline auto load_short_block(char const * seq, int const count) -> uint64_t {
+    uint64_t block = 0;
+    for (auto i = 0; i < count; ++i)
+      {
+        block = (block << 8U) | static_cast<unsigned char>(seq[i]);
+      }
+    return block << (8U * static_cast<unsigned int>(symbols_per_block - count));
+  }
+
+
+  /* bits 0 and 1 of each byte, most significant byte first, as 16 bits */
+  inline auto gather_codes(uint64_t x) -> uint64_t {
+    x = (x | (x >> 6U)) & uint64_t{0x000F000F000F000F};
+    x = (x | (x >> 12U)) & uint64_t{0x000000FF000000FF};
+    return (x | (x >> 24U)) & uint64_t{0xFFFF};
+  }
+
+
+  /* the high bit of each byte, most significant byte first, as 8 bits */
+  inline auto gather_flags(uint64_t const x) -> uint64_t {
+    return (((x >> 7U) & ones) * uint64_t{0x0102040810204080}) >> 56U;
+  }
+
+
+  /* the 2-bit codes (16 bits) and the masked flags (8 bits) of a block */
+  inline auto pack_block(uint64_t const block, bool const soft_masked,
+                         uint64_t & codes, uint64_t & masked) -> void {
+    /* A, C, G, T and U, in either case */
+    auto const upper = block & ~case_bits;
+    auto const valid = bytes_equal(upper, 'A') | bytes_equal(upper, 'C') |
+      bytes_equal(upper, 'G') | bytes_equal(upper, 'T') | bytes_equal(upper, 'U');
+    auto bad = ~valid & high1;
+    if (soft_masked)
+      {
+        bad |= valid & ((block & case_bits) << 2U);
+      }
+
+    /* bits 3 to 1 of A, C, G, T and U are 000, 001, 011, 010 and
+       010: the low bit of their code is bit 1 xor bit 2, the high
+       bit is bit 2 xor bit 3 */
+    auto const code = ((block >> 1U) ^ (block >> 2U)) & uint64_t{0x0303030303030303};
+
+    codes = gather_codes(code);
+    masked = gather_flags(bad);
+  }
+
+}  // end of anonymous namespace
+
+
+auto pack_2bit(char const * seq, int64_t const len, bool const soft_masked,
+               uint64_t * codes, uint64_t * masked) -> void
+{
+  static constexpr auto blocks_per_code_word = packed_codes_per_word / symbols_per_block;
+
+  /* whole words of 64 symbols */
+  auto const full = len / packed_masks_per_word;
+  for (int64_t word = 0; word < full; ++word)
+    {
+      auto const * chunk = seq + (word * packed_masks_per_word);
+      uint64_t mask_word = 0;
+      std::array<uint64_t, 2> code_word {{0, 0}};
+      for (auto i = 0; i < packed_masks_per_word / symbols_per_block; ++i)
+        {
+          uint64_t block_codes = 0;
+          uint64_t block_masked = 0;
+          pack_block(load_block(chunk + (i * symbols_per_block)), soft_masked,
+                     block_codes, block_masked);
+          auto & half = code_word[static_cast<std::size_t>(i / blocks_per_code_word)];
+          half = (half << 16U) | block_codes;
+          mask_word = (mask_word << 8U) | block_masked;
+        }
+      codes[2 * word] = code_word[0];
+      codes[(2 * word) + 1] = code_word[1];
+      masked[word] = mask_word;
+    }
+
+  /* the last symbols, then masked padding */
+  auto const code_words = packed_code_words(len);
+  auto const mask_words = packed_mask_words(len);
+  for (auto i = static_cast<std::size_t>(2 * full); i < code_words; ++i)
+    {
+      codes[i] = 0;
+    }
+  for (auto i = static_cast<std::size_t>(full); i < mask_words; ++i)
+    {
+      masked[i] = ~uint64_t{0};
+    }
+  for (auto start = full * packed_masks_per_word; start < len; start += symbols_per_block)
+    {
+      auto const count = static_cast<int>(std::min<int64_t>(symbols_per_block, len - start));
+      uint64_t block_codes = 0;
+      uint64_t block_masked = 0;
+      pack_block(load_short_block(seq + start, count), soft_masked,
+                 block_codes, block_masked);
+      block_masked |= 0xFFU >> static_cast<unsigned int>(count);
+
+      auto const n = (start % packed_masks_per_word) / symbols_per_block;
+      auto const code_shift = 48U - (16U * static_cast<unsigned int>(n % blocks_per_code_word));
+      auto const mask_shift = 56U - (8U * static_cast<unsigned int>(n));
+      codes[start / packed_codes_per_word] |= block_codes << code_shift;
+      auto & mask_word = masked[start / packed_masks_per_word];
+      mask_word = (mask_word & ~(uint64_t{0xFF} << mask_shift)) | (block_masked << mask_shift);
+    }
+}
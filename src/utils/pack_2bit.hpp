@@ -0,0 +1,193 @@
+/*
+
+  VSEARCH: a versatile open source tool for metagenomics
+
+  Copyright (C) 2014-2026, Torbjorn Rognes, Frederic Mahe and Tomas Flouri
+  All rights reserved.
+
+  Contact: Torbjorn Rognes <torognes@ifi.uio.no>,
+  Department of Informatics, University of Oslo,
+  PO Box 1080 Blindern, NO-0316 Oslo, Norway
+
+  This software is dual-licensed and available under a choice
+  of one of two licenses, either under the terms of the GNU
+  General Public License version 3 or the BSD 2-Clause License.
+
+
+  GNU General Public License version 3
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+  The BSD 2-Clause License
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  1. Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#pragma once
+
+#include <algorithm>  // std::min
+#include <cstddef>  // std::size_t
+#include <cstdint>  // int64_t, uint64_t
+
+
+/* Packed nucleotide sequences, shared by the k-mer producers.
+
+   pack_2bit() converts a sequence, eight symbols at a time, into two
+   bit streams:
+     codes   2-bit codes (A = 0, C = 1, G = 2, T/U = 3), 32 symbols
+             per word
+     masked  one bit per symbol, set for symbols that cannot be part of
+             a k-mer: anything but A, C, G, T and U, and also lowercase
+             symbols with soft masking; 64 symbols per word
+   Both streams are most significant bit first, so that the k symbols
+   read from the stream form a k-mer with its first symbol in the high
+   bits, as in the indices. Codes of masked symbols are undefined.
+
+   The buffers must hold packed_code_words(len) and
+   packed_mask_words(len) words; the last word of each is padding, so
+   that a k-mer can always be read from two consecutive words. */
+
+constexpr auto packed_codes_per_word = 32;
+constexpr auto packed_masks_per_word = 64;
+
+inline auto packed_code_words(int64_t const len) -> std::size_t {
+  return static_cast<std::size_t>(len / packed_codes_per_word) + 2;
+}
+
+inline auto packed_mask_words(int64_t const len) -> std::size_t {
+  return static_cast<std::size_t>(len / packed_masks_per_word) + 2;
+}
+
+auto pack_2bit(char const * seq, int64_t len, bool soft_masked,
+               uint64_t * codes, uint64_t * masked) -> void;
+
+
+/* reverse complement of a k-mer of k symbols, k <= 16 */
+inline auto reverse_complement_kmer(unsigned int const kmer, unsigned int const k) -> unsigned int {
+  auto rev = ~kmer;
+  rev = ((rev >> 2U) & 0x33333333U) | ((rev & 0x33333333U) << 2U);
+  rev = ((rev >> 4U) & 0x0F0F0F0FU) | ((rev & 0x0F0F0F0FU) << 4U);
+  rev = ((rev >> 8U) & 0x00FF00FFU) | ((rev & 0x00FF00FFU) << 8U);
+  rev = (rev >> 16U) | (rev << 16U);
+  return rev >> (32U - (2U * k));
+}
+
+
+// anonymous namespace: limit visibility and usage to this translation unit
+namespace {
+
+  /* Bit i of the result is set when symbols start + i to start + i + k - 1
+     are all unmasked (most significant bit first, i < 32). */
+  inline auto packed_clean_starts(uint64_t const * masked, int64_t const start,
+                                  unsigned int const k) -> uint64_t {
+    auto const word = static_cast<std::size_t>(start / packed_masks_per_word);
+    auto const shift = static_cast<unsigned int>(start % packed_masks_per_word);
+    auto dirty = (masked[word] << shift) | ((masked[word + 1] >> 1U) >> (63U - shift));
+    for (auto span = 1U; span < k; )
+      {
+        auto const step = std::min(span, k - span);
+        dirty |= dirty << step;
+        span += step;
+      }
+    return ~dirty & ~(~uint64_t{0} >> 32U);
+  }
+
+
+  /* the k symbols from symbol i of a window of two code words */
+  inline auto packed_kmer(uint64_t const high, uint64_t const low,
+                          unsigned int const i, unsigned int const k) -> unsigned int {
+    auto const shift = 2U * i;
+    auto const bits = (high << shift) | ((low >> 1U) >> (63U - shift));
+    return static_cast<unsigned int>(bits >> (64U - (2U * k)));
+  }
+
+}  // end of anonymous namespace
+
+
+/* Call visit(kmer, pos) for each unmasked k-mer of k symbols (k <= 16)
+   of a packed sequence of len symbols, in order, pos being the 0-based
+   start of the k-mer. The k-mers are read directly from the stream, 32
+   start positions at a time, skipping the masked ones. */
+template <typename Visit>
+auto for_each_packed_kmer(uint64_t const * codes, uint64_t const * masked,
+                          int64_t const len, unsigned int const k,
+                          Visit visit) -> void {
+  for (int64_t start = 0; start < len; start += packed_codes_per_word)
+    {
+      auto const word = static_cast<std::size_t>(start / packed_codes_per_word);
+      auto const high = codes[word];
+      auto const low = codes[word + 1];
+      auto const clean = packed_clean_starts(masked, start, k);
+      for (auto i = 0U; i < packed_codes_per_word; ++i)
+        {
+          if (((clean << i) >> 63U) != 0U)
+            {
+              visit(packed_kmer(high, low, i, k), start + i);
+            }
+        }
+    }
+}
+
+
+/* Same for the reverse complement strand: its k-mers in order along
+   that strand, pos being the 0-based start on that strand. */
+template <typename Visit>
+auto for_each_packed_rc_kmer(uint64_t const * codes, uint64_t const * masked,
+                             int64_t const len, unsigned int const k,
+                             Visit visit) -> void {
+  if (len <= 0)
+    {
+      return;
+    }
+  for (auto start = ((len - 1) / packed_codes_per_word) * packed_codes_per_word;
+       start >= 0; start -= packed_codes_per_word)
+    {
+      auto const word = static_cast<std::size_t>(start / packed_codes_per_word);
+      auto const high = codes[word];
+      auto const low = codes[word + 1];
+      auto clean = packed_clean_starts(masked, start, k);
+      while (clean != 0U)
+        {
+          auto const bit = static_cast<unsigned int>(__builtin_ctzll(clean));
+          clean &= clean - 1U;
+          auto const i = 63U - bit;
+          visit(reverse_complement_kmer(packed_kmer(high, low, i, k), k),
+                len - (start + i) - k);
+        }
+    }
+}
@@ -180,3 +180,19 @@ auto fprint_seq_digest_md5(std::FILE * output_handle, char const * seq, int cons
   get_hex_seq_digest_md5(hex_digest.data(), seq, seqlen);
   std::fprintf(output_handle, "%s", hex_digest.data());
 }
+
+
+auto fprint_seq_digest_sha1(Output_buffer & output, char const * seq, int const seqlen) -> void
+{
+  std::vector<char> hex_digest(len_hex_dig_sha1);
+  get_hex_seq_digest_sha1(hex_digest.data(), seq, seqlen);
+  output.append(hex_digest.data());
+}
+
+
+auto fprint_seq_digest_md5(Output_buffer & output, char const * seq, int const seqlen) -> void
+{
+  std::vector<char> hex_digest(len_hex_dig_md5);
+  get_hex_seq_digest_md5(hex_digest.data(), seq, seqlen);
+  output.append(hex_digest.data());
+}
@@ -60,6 +60,7 @@
 
 #pragma once
 
+#include "output_buffer.hpp"
 #include <cstdio>  // std::FILE
 
 
@@ -73,3 +74,5 @@ auto get_hex_seq_digest_md5(char * hex, char const * seq, int seqlen) -> void;
 
 auto fprint_seq_digest_sha1(std::FILE * output_handle, char const * seq, int seqlen) -> void;
 auto fprint_seq_digest_md5(std::FILE * output_handle, char const * seq, int seqlen) -> void;
+auto fprint_seq_digest_sha1(Output_buffer & output, char const * seq, int seqlen) -> void;
+auto fprint_seq_digest_md5(Output_buffer & output, char const * seq, int seqlen) -> void;
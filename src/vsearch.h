@@ -237,7 +237,8 @@ struct Parameters {
   int64_t sse42_present {0};    // unused
   int64_t popcnt_present {0};   // unused
   int64_t avx_present {0};      // unused
-  int64_t avx2_present {0};     // unused
+  int64_t avx2_present {0};
+  int64_t avx512bw_present {0};
   char * opt_allpairs_global = nullptr;
   char * opt_chimeras_denovo = nullptr;
   char * opt_cluster_fast = nullptr;
@@ -338,6 +339,7 @@ struct Parameters {
   int64_t opt_randseed = 0;
   int64_t opt_sample_size = 0;
   int64_t opt_threads = 0;
+  int64_t opt_threads_per_query = 1;
   int64_t opt_topn = int64_max;
   bool opt_bzip2_decompress = false;
   bool opt_clusterout_id = false;
@@ -348,6 +350,7 @@ struct Parameters {
   bool opt_fastq_eeout = false;
   bool opt_fastq_nostagger = true;
   bool opt_fastq_qout_max = false;
+  bool opt_gzip_compress = false;
   bool opt_gzip_decompress = false;
   bool opt_hardmask = false;
   bool opt_label_substr_match = false;
@@ -356,6 +359,7 @@ struct Parameters {
   bool opt_help = false;
   bool opt_join_padgapq_set_by_user = false;
   bool opt_notrunclabels = false;
+  bool opt_pack_index = false;
   bool opt_quiet = true;   // library default (quiet); the CLI overrides in args_init
   bool opt_relabel_keep = false;
   bool opt_relabel_md5 = false;
@@ -370,6 +374,7 @@ struct Parameters {
   bool opt_stderr_is_tty = false;
   bool opt_strand = false;
   bool opt_uc_allhits = false;
+  bool opt_udb_mmap = false;
   bool opt_version = false;
   bool opt_xee = false;
   bool opt_xlength = false;